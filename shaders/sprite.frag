@@ -0,0 +1,12 @@
+#version 450
+
+// one atlas page per draw, see GameRenderer::createSpriteResources
+layout(binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) in vec2 fragUv;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(atlas, fragUv);
+}
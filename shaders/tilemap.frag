@@ -0,0 +1,23 @@
+#version 450
+
+// atlas of 16x16 equally sized tiles, tile id i is in column i % 16, row i / 16
+const uint ATLAS_COLUMNS = 16u;
+
+layout(binding = 0) uniform usampler2D tileIds;
+layout(binding = 1) uniform sampler2D atlas;
+
+layout(location = 0) in vec2 tileCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    uint id = texelFetch(tileIds, ivec2(floor(tileCoord)), 0).r;
+    if (id == 0u) {
+        discard;
+    }
+
+    // tile rows go up, atlas rows go down
+    vec2 inTile = vec2(fract(tileCoord.x), 1.0 - fract(tileCoord.y));
+    vec2 atlasCell = vec2(float(id % ATLAS_COLUMNS), float(id / ATLAS_COLUMNS));
+    outColor = texture(atlas, (atlasCell + inTile) / float(ATLAS_COLUMNS));
+}
@@ -0,0 +1,19 @@
+#version 450
+
+// one quad over a whole chunk tile texture, the corners come from the vertex index
+layout(push_constant) uniform TilemapQuad {
+    // clip space position of the texture's bottom left (xy) and top right (zw) corners
+    vec4 clipRect;
+    // texture size in tiles
+    vec2 tileExtent;
+} quad;
+
+layout(location = 0) out vec2 tileCoord;
+
+const vec2 CORNERS[6] = vec2[](vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 0.0), vec2(0.0, 1.0));
+
+void main() {
+    vec2 corner = CORNERS[gl_VertexIndex];
+    gl_Position = vec4(mix(quad.clipRect.xy, quad.clipRect.zw, corner), 0.0, 1.0);
+    tileCoord = corner * quad.tileExtent;
+}
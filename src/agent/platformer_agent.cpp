@@ -0,0 +1,101 @@
+#include "platformer_agent.h"
+
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "game/agent_env.h"
+#include "game/level.h"
+
+struct PlatformerAgentEnv {
+    AgentEnv env;
+};
+
+static thread_local std::string lastError{};
+
+// exceptions must not cross the C boundary
+template <typename F>
+static int guarded(F&& f) noexcept {
+    try {
+        f();
+        return 0;
+    } catch (std::exception& exception) {
+        lastError = exception.what();
+        return -1;
+    }
+}
+
+extern "C" {
+
+int platformerAgentDefaultConfig(PlatformerAgentConfig* config) {
+    return guarded([&] {
+        if (config == nullptr) {
+            throw std::runtime_error("config is null");
+        }
+        AgentConfig defaults;
+        config->agents = defaults.agents;
+        config->tickRate = defaults.tickRate;
+        config->solidRadius = defaults.solidRadius;
+        config->maxSolids = defaults.maxSolids;
+        config->gridSize = defaults.gridSize;
+        config->gridCellSize = defaults.gridCellSize;
+    });
+}
+
+PlatformerAgentEnv* platformerAgentCreate(const char* levelPath, const PlatformerAgentConfig* config) {
+    PlatformerAgentEnv* env = nullptr;
+    guarded([&] {
+        // checked before anything is read, a null pointer is the caller's error rather than a crash
+        if (config == nullptr) {
+            throw std::runtime_error("config is null");
+        }
+        AgentConfig agentConfig;
+        agentConfig.agents = config->agents;
+        agentConfig.tickRate = config->tickRate;
+        agentConfig.solidRadius = config->solidRadius;
+        agentConfig.maxSolids = config->maxSolids;
+        agentConfig.gridSize = config->gridSize;
+        agentConfig.gridCellSize = config->gridCellSize;
+        auto level = levelPath != nullptr ? Level::map(levelPath) : Level::builtIn();
+        env = new PlatformerAgentEnv{AgentEnv(std::move(level), agentConfig)};
+    });
+    return env;
+}
+
+void platformerAgentDestroy(PlatformerAgentEnv* env) {
+    delete env;
+}
+
+int platformerAgentGetLayout(const PlatformerAgentEnv* env, PlatformerAgentLayout* layout) {
+    return guarded([&] {
+        if (env == nullptr || layout == nullptr) {
+            throw std::runtime_error(env == nullptr ? "env is null" : "layout is null");
+        }
+        const AgentObservationLayout& l = env->env.layout();
+        *layout = {l.state, l.solidCount, l.solids, l.occupancy, l.size};
+    });
+}
+
+int platformerAgentReset(PlatformerAgentEnv* env, float* observations) {
+    return guarded([&] {
+        if (env == nullptr) {
+            throw std::runtime_error("env is null");
+        }
+        env->env.reset(observations);
+    });
+}
+
+int platformerAgentStep(PlatformerAgentEnv* env, const uint8_t* actions, uint32_t steps, float* observations) {
+    return guarded([&] {
+        if (env == nullptr || (actions == nullptr && steps != 0)) {
+            throw std::runtime_error(env == nullptr ? "env is null" : "actions is null");
+        }
+        env->env.step(actions, steps, observations);
+    });
+}
+
+const char* platformerAgentLastError(void) {
+    return lastError.c_str();
+}
+}
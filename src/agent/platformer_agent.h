@@ -0,0 +1,70 @@
+#pragma once
+
+/* C interface to AgentEnv, for driving headless games from other languages. See game/agent_env.h for the layout of an
+ * observation. Functions returning int return 0 on success and -1 on failure, platformerAgentLastError() then describes
+ * the failure. An environment must only be used by one thread at a time. */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(PLATFORMER_AGENT_BUILD)
+#define PLATFORMER_AGENT_API __declspec(dllexport)
+#else
+#define PLATFORMER_AGENT_API __declspec(dllimport)
+#endif
+#else
+#define PLATFORMER_AGENT_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    PLATFORMER_AGENT_LEFT = 1 << 0,
+    PLATFORMER_AGENT_RIGHT = 1 << 1,
+    PLATFORMER_AGENT_JUMP = 1 << 2,
+};
+
+typedef struct PlatformerAgentConfig {
+    uint32_t agents;
+    uint32_t tickRate;
+    float solidRadius;
+    uint32_t maxSolids;
+    uint32_t gridSize;
+    float gridCellSize;
+} PlatformerAgentConfig;
+
+/* offsets into one agent's observation and its size, in floats */
+typedef struct PlatformerAgentLayout {
+    uint32_t state;
+    uint32_t solidCount;
+    uint32_t solids;
+    uint32_t occupancy;
+    uint32_t size;
+} PlatformerAgentLayout;
+
+typedef struct PlatformerAgentEnv PlatformerAgentEnv;
+
+PLATFORMER_AGENT_API int platformerAgentDefaultConfig(PlatformerAgentConfig* config);
+
+/* levelPath is a level file or NULL for the built-in level, config must not be NULL. Returns NULL on failure. */
+PLATFORMER_AGENT_API PlatformerAgentEnv* platformerAgentCreate(const char* levelPath, const PlatformerAgentConfig* config);
+
+PLATFORMER_AGENT_API void platformerAgentDestroy(PlatformerAgentEnv* env);
+
+PLATFORMER_AGENT_API int platformerAgentGetLayout(const PlatformerAgentEnv* env, PlatformerAgentLayout* layout);
+
+/* observations, if not NULL, receives one observation per agent */
+PLATFORMER_AGENT_API int platformerAgentReset(PlatformerAgentEnv* env, float* observations);
+
+/* Runs steps ticks. actions holds steps * agents bytes of PLATFORMER_AGENT_* bits, tick major. observations, if not NULL,
+ * receives steps * agents observations in the same order. */
+PLATFORMER_AGENT_API int platformerAgentStep(PlatformerAgentEnv* env, const uint8_t* actions, uint32_t steps, float* observations);
+
+/* the last failure on the calling thread */
+PLATFORMER_AGENT_API const char* platformerAgentLastError(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,34 +2,40 @@
 
 #include "../math/vec.h"
 
-class AABB {
-    Vec2 _v0;
-    Vec2 _v1;
+template <typename T>
+class BasicAABB {
+    BasicVec2<T> _v0;
+    BasicVec2<T> _v1;
 
 public:
-    AABB() : _v0(), _v1() {}
+    BasicAABB() : _v0(), _v1() {}
 
-    AABB(Vec2 v0, Vec2 v1) : _v0(v0), _v1(v1) {}
+    BasicAABB(BasicVec2<T> v0, BasicVec2<T> v1) : _v0(v0), _v1(v1) {}
 
-    AABB(float x0, float x1, float y0, float y1) : _v0(x0, y0), _v1(x1, y1) {}
+    BasicAABB(T x0, T x1, T y0, T y1) : _v0(x0, y0), _v1(x1, y1) {}
 
-    const Vec2& v0() const noexcept {
+    template <typename U>
+    explicit BasicAABB(const BasicAABB<U>& other) : _v0(other.v0()), _v1(other.v1()) {}
+
+    const BasicVec2<T>& v0() const noexcept {
         return _v0;
     }
 
-    Vec2& v0() noexcept {
+    BasicVec2<T>& v0() noexcept {
         return _v0;
     }
 
-    const Vec2& v1() const noexcept {
+    const BasicVec2<T>& v1() const noexcept {
         return _v1;
     }
 
-    Vec2& v1() noexcept {
+    BasicVec2<T>& v1() noexcept {
         return _v1;
     }
 
-    Vec2 size() const noexcept {
+    BasicVec2<T> size() const noexcept {
         return _v1 - _v0;
     }
 };
+
+using AABB = BasicAABB<float>;
@@ -0,0 +1,170 @@
+#include "agent_env.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "world.h"
+#include "../util/profiler.h"
+
+static constexpr uint32_t MAX_AGENT_GRID_SIZE = 256;
+
+static AgentObservationLayout observationLayout(const AgentConfig& config) {
+    AgentObservationLayout layout;
+    layout.state = 0;
+    layout.solidCount = AgentObservationLayout::STATE_SIZE;
+    layout.solids = layout.solidCount + 1;
+    layout.occupancy = layout.solids + 4 * config.maxSolids;
+    layout.size = layout.occupancy + config.gridSize * config.gridSize;
+    return layout;
+}
+
+static const AgentConfig& checkedConfig(const AgentConfig& config) {
+    if (config.agents == 0) {
+        throw std::runtime_error("agent env needs at least one agent");
+    }
+    if (config.tickRate == 0) {
+        throw std::runtime_error("agent tick rate must not be zero");
+    }
+    if (config.gridSize > MAX_AGENT_GRID_SIZE || !(config.gridCellSize > 0.0f) || !(config.solidRadius >= 0.0f)) {
+        throw std::runtime_error("invalid agent observation config");
+    }
+    return config;
+}
+
+AgentEnv::AgentEnv(std::shared_ptr<const Level> level, const AgentConfig& config)
+    : level(std::move(level)),
+      config(checkedConfig(config)),
+      _layout(observationLayout(config)),
+      batch(this->level, config.agents),
+      tickDelta(1000.0f / static_cast<float>(config.tickRate)) {} // game time is in milliseconds
+
+void AgentEnv::reset(float* observations) {
+    batch.reset();
+    if (observations != nullptr) {
+        for (uint32_t agent = 0; agent < config.agents; agent++) {
+            observe(agent, observations + static_cast<size_t>(agent) * _layout.size);
+        }
+    }
+}
+
+void AgentEnv::step(const uint8_t* actions, uint32_t steps, float* observations) {
+    PROFILE_ZONE("AgentEnv::step");
+
+    for (uint32_t s = 0; s < steps; s++) {
+        const uint8_t* tickActions = actions + static_cast<size_t>(s) * config.agents;
+        for (uint32_t agent = 0; agent < config.agents; agent++) {
+            uint8_t bits = tickActions[agent];
+            // same order as a session tick: the jump lands before the movement keys are applied
+            if ((bits & AGENT_ACTION_JUMP) != 0) {
+                batch.jump(agent);
+            }
+            batch.setInput(agent, (bits & AGENT_ACTION_LEFT) != 0, (bits & AGENT_ACTION_RIGHT) != 0);
+        }
+
+        batch.process(tickDelta);
+
+        if (observations != nullptr) {
+            float* tickObservations = observations + static_cast<size_t>(s) * config.agents * _layout.size;
+            for (uint32_t agent = 0; agent < config.agents; agent++) {
+                observe(agent, tickObservations + static_cast<size_t>(agent) * _layout.size);
+            }
+        }
+    }
+}
+
+void AgentEnv::observe(uint32_t agent, float* out) {
+    const auto& geometry = level->geometry();
+    Vec2 pos = batch.pos(agent);
+    Vec2 vel = batch.vel(agent);
+
+    out[_layout.state + 0] = pos.x;
+    out[_layout.state + 1] = pos.y;
+    out[_layout.state + 2] = vel.x;
+    out[_layout.state + 3] = vel.y;
+    out[_layout.state + 4] = batch.isOnGround(agent) ? 1.0f : 0.0f;
+
+    // nearby solids, ordered by distance from the player position to the box, then by index
+    nearby.clear();
+    float r = config.solidRadius;
+    AABB window(pos.x - r, pos.x + r, pos.y - r, pos.y + r);
+    geometry.grid.query(window, candidates);
+    for (uint32_t i : candidates) {
+        AABB box = geometry.solids.aabb(i);
+        if (!aabbOverlaps(box, window)) {
+            continue;
+        }
+        float dx = std::max({box.v0().x - pos.x, 0.0f, pos.x - box.v1().x});
+        float dy = std::max({box.v0().y - pos.y, 0.0f, pos.y - box.v1().y});
+        nearby.emplace_back(dx * dx + dy * dy, i);
+    }
+    auto reported = static_cast<uint32_t>(std::min<size_t>(nearby.size(), config.maxSolids));
+    std::partial_sort(nearby.begin(), nearby.begin() + reported, nearby.end());
+
+    out[_layout.solidCount] = static_cast<float>(reported);
+    float* solids = out + _layout.solids;
+    for (uint32_t n = 0; n < reported; n++) {
+        AABB box = geometry.solids.aabb(nearby[n].second);
+        solids[n * 4 + 0] = box.v0().x - pos.x;
+        solids[n * 4 + 1] = box.v1().x - pos.x;
+        solids[n * 4 + 2] = box.v0().y - pos.y;
+        solids[n * 4 + 3] = box.v1().y - pos.y;
+    }
+    std::fill(solids + reported * 4, solids + config.maxSolids * 4, 0.0f);
+
+    // occupancy
+    float* grid = out + _layout.occupancy;
+    uint32_t size = config.gridSize;
+    std::fill(grid, grid + size * size, 0.0f);
+    if (size == 0) {
+        return;
+    }
+    float cell = config.gridCellSize;
+    float extent = static_cast<float>(size) * cell;
+    float gx0 = pos.x - extent / 2;
+    float gy0 = pos.y - extent / 2;
+    AABB gridBox(gx0, gx0 + extent, gy0, gy0 + extent);
+
+    // cells whose interior the box overlaps
+    auto mark = [&](const AABB& box) {
+        if (box.v1().x <= gridBox.v0().x || box.v0().x >= gridBox.v1().x || box.v1().y <= gridBox.v0().y || box.v0().y >= gridBox.v1().y) {
+            return;
+        }
+        auto toCell = [&](float v) { return static_cast<int32_t>(std::clamp(v, 0.0f, static_cast<float>(size - 1))); };
+        int32_t cx0 = toCell(std::floor((box.v0().x - gx0) / cell));
+        int32_t cx1 = toCell(std::ceil((box.v1().x - gx0) / cell) - 1.0f);
+        int32_t cy0 = toCell(std::floor((box.v0().y - gy0) / cell));
+        int32_t cy1 = toCell(std::ceil((box.v1().y - gy0) / cell) - 1.0f);
+        for (int32_t cy = cy0; cy <= cy1; cy++) {
+            std::fill(grid + cy * size + cx0, grid + cy * size + cx1 + 1, 1.0f);
+        }
+    };
+
+    geometry.grid.query(gridBox, candidates);
+    for (uint32_t i : candidates) {
+        mark(geometry.solids.aabb(i));
+    }
+
+    const TileMap& tiles = geometry.tiles;
+    if (!tiles.isEmpty()) {
+        // only the part of the grid that lies over stored tile blocks can hold tiles
+        AABB bounds = tiles.bounds();
+        float x0 = std::max(gridBox.v0().x, bounds.v0().x);
+        float x1 = std::min(gridBox.v1().x, bounds.v1().x);
+        float y0 = std::max(gridBox.v0().y, bounds.v0().y);
+        float y1 = std::min(gridBox.v1().y, bounds.v1().y);
+        if (x0 < x1 && y0 < y1) {
+            auto tx0 = static_cast<int32_t>(std::floor((x0 - tiles.originX) / tiles.tileSize));
+            auto tx1 = static_cast<int32_t>(std::floor((x1 - tiles.originX) / tiles.tileSize));
+            auto ty0 = static_cast<int32_t>(std::floor((y0 - tiles.originY) / tiles.tileSize));
+            auto ty1 = static_cast<int32_t>(std::floor((y1 - tiles.originY) / tiles.tileSize));
+            for (int32_t ty = ty0; ty <= ty1; ty++) {
+                for (int32_t tx = tx0; tx <= tx1; tx++) {
+                    if (tiles.isSolid(tx, ty)) {
+                        mark(tiles.tileAABB(tx, ty));
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "level.h"
+#include "world_batch.h"
+
+enum AgentActionBits : uint8_t {
+    AGENT_ACTION_LEFT = 1 << 0,
+    AGENT_ACTION_RIGHT = 1 << 1,
+    AGENT_ACTION_JUMP = 1 << 2,
+};
+
+struct AgentConfig {
+    uint32_t agents = 1;
+    uint32_t tickRate = 60;
+    // solids overlapping the square of this half size around the player are reported, nearest first
+    float solidRadius = 400.0f;
+    uint32_t maxSolids = 16;
+    // occupancy of solids and solid tiles in gridSize x gridSize cells centred on the player
+    uint32_t gridSize = 16;
+    float gridCellSize = 50.0f;
+};
+
+// Where things are in one agent's observation, in floats:
+//   state: pos x, pos y, vel x, vel y, on ground (0 or 1)
+//   solid count, then maxSolids boxes as x0, x1, y0, y1 relative to the player position, unused ones zeroed
+//   occupancy: gridSize rows of gridSize cells, 1 where anything solid overlaps the cell, bottom row first
+struct AgentObservationLayout {
+    static inline constexpr uint32_t STATE_SIZE = 5;
+
+    uint32_t state = 0;
+    uint32_t solidCount = 0;
+    uint32_t solids = 0;
+    uint32_t occupancy = 0;
+    uint32_t size = 0;
+};
+
+// Headless environment for bots: every agent plays its own copy of one level. A call runs any number of ticks and
+// writes the observations straight into the caller's buffer, so a driver on the other side of an ABI or language
+// boundary crosses it once per batch of ticks rather than once per tick and agent.
+class AgentEnv {
+    std::shared_ptr<const Level> level;
+    AgentConfig config;
+    AgentObservationLayout _layout{};
+    WorldBatch batch;
+    float tickDelta;
+
+    // scratch for observations
+    std::vector<uint32_t> candidates{};
+    std::vector<std::pair<float, uint32_t>> nearby{};
+
+public:
+    AgentEnv(std::shared_ptr<const Level> level, const AgentConfig& config);
+
+    const AgentObservationLayout& layout() const noexcept {
+        return _layout;
+    }
+
+    uint32_t agentCount() const noexcept {
+        return config.agents;
+    }
+
+    // Puts every agent back at the spawn point. Writes agentCount() observations when observations is not null.
+    void reset(float* observations);
+
+    // Runs steps ticks. actions holds one AgentActionBits byte per agent and tick, tick major. When observations is not
+    // null it receives steps * agentCount() observations in the same order, each layout().size floats.
+    void step(const uint8_t* actions, uint32_t steps, float* observations);
+
+private:
+    void observe(uint32_t agent, float* out);
+};
@@ -0,0 +1,545 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "AABB.h"
+#include "../math/float4.h"
+
+// Bounding volume hierarchy over boxes. Leaves hold up to four boxes as structure of arrays, so that a leaf is tested
+// with one Float4 slab test. Nodes are stored depth first, the first child right after its parent.
+//
+// A ray hits a box under the same rule as doRayCast2D, and the lanes run the same float operations, so the tree finds
+// exactly the boxes and times testing every box with doRayCast2D would. Every method is const but build and refit,
+// any number of threads may query a tree that is not being changed.
+class BoxTree {
+public:
+    static inline constexpr uint32_t LEAF_SIZE = 4;
+    // splitting at the median halves the boxes at every level, so a tree of 2^32 boxes is 31 levels deep
+    static inline constexpr uint32_t MAX_DEPTH = 64;
+    static inline constexpr uint32_t NONE = UINT32_MAX;
+
+    // Up to LEAF_SIZE rays cast together, ray k in lane k
+    struct RayPacket {
+        Vec2 origin[LEAF_SIZE]{};
+        Vec2 dir[LEAF_SIZE]{};
+        Vec2 grow[LEAF_SIZE]{};
+        uint32_t count = 0;
+    };
+
+private:
+    struct Node {
+        AABB bounds;
+        // the second child of an inner node, the first lane of a leaf
+        uint32_t index;
+        bool leaf;
+    };
+
+    std::vector<Node> nodes{};
+    // lane k of the leaf starting at lane l is at l + k, lanes past a leaf's boxes are marked invalid
+    std::vector<float> x0{};
+    std::vector<float> x1{};
+    std::vector<float> y0{};
+    std::vector<float> y1{};
+    // all ones for lanes holding a box, so that they load as Mask4
+    std::vector<uint32_t> valid{};
+    // the box each lane holds, NONE for invalid lanes
+    std::vector<uint32_t> items{};
+    uint32_t itemCount = 0;
+
+public:
+    bool empty() const noexcept {
+        return nodes.empty();
+    }
+
+    uint32_t size() const noexcept {
+        return itemCount;
+    }
+
+    uint32_t nodeCount() const noexcept {
+        return static_cast<uint32_t>(nodes.size());
+    }
+
+    // Replaces the tree with one over boxes, splitting the longer axis of the box centres at the median
+    void build(const std::vector<AABB>& boxes) {
+        nodes.clear();
+        x0.clear();
+        x1.clear();
+        y0.clear();
+        y1.clear();
+        valid.clear();
+        items.clear();
+        itemCount = static_cast<uint32_t>(boxes.size());
+        if (itemCount == 0) {
+            return;
+        }
+
+        std::vector<uint32_t> order(itemCount);
+        for (uint32_t i = 0; i < itemCount; i++) {
+            order[i] = i;
+        }
+        nodes.reserve(2 * (itemCount / LEAF_SIZE + 1));
+        buildNode(boxes, order, 0, itemCount);
+    }
+
+    // Moves the boxes without changing the tree's shape, boxes has to hold as many as the tree was built over. The
+    // tree gets looser as boxes wander from where they were built, which for platforms on short paths never matters.
+    void refit(const std::vector<AABB>& boxes) {
+        if (boxes.size() != itemCount) {
+            throw std::runtime_error("box tree refit with a different number of boxes");
+        }
+        for (size_t lane = 0; lane < items.size(); lane++) {
+            if (items[lane] != NONE) {
+                const AABB& box = boxes[items[lane]];
+                x0[lane] = box.v0().x;
+                x1[lane] = box.v1().x;
+                y0[lane] = box.v0().y;
+                y1[lane] = box.v1().y;
+            }
+        }
+        // children come after their parent, so going backwards every child is done before its parent
+        for (size_t i = nodes.size(); i-- > 0;) {
+            Node& node = nodes[i];
+            node.bounds = node.leaf ? leafBounds(node.index) : merge(nodes[i + 1].bounds, nodes[node.index].bounds);
+        }
+    }
+
+    // Finds the box that origin + dir * t hits first for t in [0, maxT], with every box grown by grow on each side.
+    // Ties go to the lower box index. Returns NONE when nothing is hit.
+    uint32_t raycastFirst(Vec2 origin, Vec2 dir, float maxT, Vec2 grow, float& t) const noexcept {
+        uint32_t best = NONE;
+        float bestT = maxT;
+        if (nodes.empty()) {
+            return best;
+        }
+
+        struct Entry {
+            uint32_t node;
+            float tEntry;
+        };
+        Entry stack[MAX_DEPTH + 1];
+        uint32_t depth = 0;
+        float tEntry;
+        if (enters(nodes[0].bounds, origin, dir, maxT, grow, tEntry)) {
+            stack[depth++] = {0, tEntry};
+        }
+
+        while (depth != 0) {
+            Entry entry = stack[--depth];
+            if (entry.tEntry > bestT) {
+                continue;
+            }
+            const Node& node = nodes[entry.node];
+            if (node.leaf) {
+                float times[LEAF_SIZE];
+                uint32_t hits = leafRaycast(node.index, origin, dir, bestT, grow, times);
+                for (uint32_t k = 0; k < LEAF_SIZE; k++) {
+                    uint32_t item = items[node.index + k];
+                    if ((hits >> k & 1u) != 0 && (times[k] < bestT || (times[k] == bestT && item < best))) {
+                        bestT = times[k];
+                        best = item;
+                    }
+                }
+                continue;
+            }
+
+            // the nearer child is searched first, so that it shrinks bestT before the farther one is looked at
+            uint32_t first = entry.node + 1;
+            uint32_t second = node.index;
+            float tFirst, tSecond;
+            bool enterFirst = enters(nodes[first].bounds, origin, dir, bestT, grow, tFirst);
+            bool enterSecond = enters(nodes[second].bounds, origin, dir, bestT, grow, tSecond);
+            if (enterFirst && enterSecond && tSecond < tFirst) {
+                std::swap(first, second);
+                std::swap(tFirst, tSecond);
+            }
+            if (enterSecond) {
+                stack[depth++] = {second, tSecond};
+            }
+            if (enterFirst) {
+                stack[depth++] = {first, tFirst};
+            }
+        }
+        t = bestT;
+        return best;
+    }
+
+    // raycastFirst for every ray of packet at once, ray k looks up to maxT[k] and its box and time go to hits[k] and
+    // t[k]. The rays walk the tree together: a node is loaded once and tested against every ray still looking with one
+    // Float4 slab test, and only the leaves are tested ray by ray. Rays that start near each other and point the same
+    // way mostly visit the same nodes, for them this is cheaper than casting one ray at a time. The results are the
+    // same either way.
+    void raycastFirst(const RayPacket& packet, const float* maxT, uint32_t* hits, float* t) const noexcept {
+        float bestT[LEAF_SIZE];
+        for (uint32_t k = 0; k < LEAF_SIZE; k++) {
+            hits[k] = NONE;
+            bestT[k] = k < packet.count ? maxT[k] : -INFINITY;
+        }
+        uint32_t lanes = (1u << packet.count) - 1;
+        if (nodes.empty() || lanes == 0) {
+            std::copy(bestT, bestT + packet.count, t);
+            return;
+        }
+
+        Rays4 rays = lanesOf(packet);
+        struct Entry {
+            Float4 tEntry;
+            uint32_t node;
+            uint32_t lanes;
+        };
+        Entry stack[MAX_DEPTH + 1];
+        uint32_t depth = 0;
+        Float4 tEntry;
+        lanes &= enters(nodes[0].bounds, rays, Float4::load(bestT), tEntry);
+        if (lanes != 0) {
+            stack[depth++] = {tEntry, 0, lanes};
+        }
+
+        while (depth != 0) {
+            Entry entry = stack[--depth];
+            uint32_t live = entry.lanes & (entry.tEntry <= Float4::load(bestT)).bits();
+            if (live == 0) {
+                continue;
+            }
+            const Node& node = nodes[entry.node];
+            if (node.leaf) {
+                for (uint32_t k = 0; k < packet.count; k++) {
+                    if ((live >> k & 1u) == 0) {
+                        continue;
+                    }
+                    float times[LEAF_SIZE];
+                    uint32_t leafHits = leafRaycast(node.index, packet.origin[k], packet.dir[k], bestT[k], packet.grow[k], times);
+                    for (uint32_t j = 0; j < LEAF_SIZE; j++) {
+                        uint32_t item = items[node.index + j];
+                        if ((leafHits >> j & 1u) != 0 && (times[j] < bestT[k] || (times[j] == bestT[k] && item < hits[k]))) {
+                            bestT[k] = times[j];
+                            hits[k] = item;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            // the child nearest to any of the rays is searched first
+            uint32_t first = entry.node + 1;
+            uint32_t second = node.index;
+            Float4 tFirst, tSecond;
+            Float4 limit = Float4::load(bestT);
+            uint32_t firstLanes = live & enters(nodes[first].bounds, rays, limit, tFirst);
+            uint32_t secondLanes = live & enters(nodes[second].bounds, rays, limit, tSecond);
+            if (firstLanes != 0 && secondLanes != 0 && nearest(tSecond, secondLanes) < nearest(tFirst, firstLanes)) {
+                std::swap(first, second);
+                std::swap(tFirst, tSecond);
+                std::swap(firstLanes, secondLanes);
+            }
+            if (secondLanes != 0) {
+                stack[depth++] = {tSecond, second, secondLanes};
+            }
+            if (firstLanes != 0) {
+                stack[depth++] = {tFirst, first, firstLanes};
+            }
+        }
+        std::copy(bestT, bestT + packet.count, t);
+    }
+
+    // Calls f(box, t) for every box the ray hits for t in [0, maxT], in no particular order
+    template <typename F>
+    void raycastAll(Vec2 origin, Vec2 dir, float maxT, Vec2 grow, F&& f) const {
+        forEachLeaf([&](const AABB& bounds) {
+            float tEntry;
+            return enters(bounds, origin, dir, maxT, grow, tEntry);
+        }, [&](uint32_t lane) {
+            float times[LEAF_SIZE];
+            uint32_t hits = leafRaycast(lane, origin, dir, maxT, grow, times);
+            for (uint32_t k = 0; k < LEAF_SIZE; k++) {
+                if ((hits >> k & 1u) != 0) {
+                    f(items[lane + k], times[k]);
+                }
+            }
+        });
+    }
+
+    // raycastAll for every ray of packet at once, calls f(k, box, t) for every box ray k hits for t in [0, maxT[k]]
+    template <typename F>
+    void raycastAll(const RayPacket& packet, const float* maxT, F&& f) const {
+        uint32_t lanes = (1u << packet.count) - 1;
+        if (nodes.empty() || lanes == 0) {
+            return;
+        }
+        float limits[LEAF_SIZE];
+        for (uint32_t k = 0; k < LEAF_SIZE; k++) {
+            limits[k] = k < packet.count ? maxT[k] : -INFINITY;
+        }
+        Rays4 rays = lanesOf(packet);
+        Float4 limit = Float4::load(limits);
+        Float4 tEntry;
+
+        struct Entry {
+            uint32_t node;
+            uint32_t lanes;
+        };
+        Entry stack[MAX_DEPTH + 1];
+        uint32_t depth = 0;
+        lanes &= enters(nodes[0].bounds, rays, limit, tEntry);
+        if (lanes != 0) {
+            stack[depth++] = {0, lanes};
+        }
+        while (depth != 0) {
+            Entry entry = stack[--depth];
+            const Node& node = nodes[entry.node];
+            if (node.leaf) {
+                for (uint32_t k = 0; k < packet.count; k++) {
+                    if ((entry.lanes >> k & 1u) == 0) {
+                        continue;
+                    }
+                    float times[LEAF_SIZE];
+                    uint32_t hits = leafRaycast(node.index, packet.origin[k], packet.dir[k], maxT[k], packet.grow[k], times);
+                    for (uint32_t j = 0; j < LEAF_SIZE; j++) {
+                        if ((hits >> j & 1u) != 0) {
+                            f(k, items[node.index + j], times[j]);
+                        }
+                    }
+                }
+                continue;
+            }
+            uint32_t secondLanes = entry.lanes & enters(nodes[node.index].bounds, rays, limit, tEntry);
+            if (secondLanes != 0) {
+                stack[depth++] = {node.index, secondLanes};
+            }
+            uint32_t firstLanes = entry.lanes & enters(nodes[entry.node + 1].bounds, rays, limit, tEntry);
+            if (firstLanes != 0) {
+                stack[depth++] = {entry.node + 1, firstLanes};
+            }
+        }
+    }
+
+    // Calls f(box) for every box that overlaps or touches region, in no particular order
+    template <typename F>
+    void overlap(const AABB& region, F&& f) const {
+        forEachLeaf([&](const AABB& bounds) {
+            return bounds.v0().x <= region.v1().x && region.v0().x <= bounds.v1().x && bounds.v0().y <= region.v1().y &&
+                   region.v0().y <= bounds.v1().y;
+        }, [&](uint32_t lane) {
+            Mask4 hits = (Float4::load(&x0[lane]) <= Float4::splat(region.v1().x)) & (Float4::splat(region.v0().x) <= Float4::load(&x1[lane])) &
+                         (Float4::load(&y0[lane]) <= Float4::splat(region.v1().y)) & (Float4::splat(region.v0().y) <= Float4::load(&y1[lane])) &
+                         Mask4::load(&valid[lane]);
+            uint32_t bits = hits.bits();
+            for (uint32_t k = 0; k < LEAF_SIZE; k++) {
+                if ((bits >> k & 1u) != 0) {
+                    f(items[lane + k]);
+                }
+            }
+        });
+    }
+
+private:
+    static AABB merge(const AABB& a, const AABB& b) noexcept {
+        return {
+            std::min(a.v0().x, b.v0().x),
+            std::max(a.v1().x, b.v1().x),
+            std::min(a.v0().y, b.v0().y),
+            std::max(a.v1().y, b.v1().y),
+        };
+    }
+
+    AABB leafBounds(uint32_t lane) const noexcept {
+        AABB bounds(x0[lane], x1[lane], y0[lane], y1[lane]);
+        for (uint32_t k = 1; k < LEAF_SIZE && items[lane + k] != NONE; k++) {
+            bounds = merge(bounds, {x0[lane + k], x1[lane + k], y0[lane + k], y1[lane + k]});
+        }
+        return bounds;
+    }
+
+    uint32_t buildNode(const std::vector<AABB>& boxes, std::vector<uint32_t>& order, uint32_t begin, uint32_t end) {
+        auto index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back({});
+
+        if (end - begin <= LEAF_SIZE) {
+            auto lane = static_cast<uint32_t>(items.size());
+            for (uint32_t k = 0; k < LEAF_SIZE; k++) {
+                bool used = begin + k < end;
+                const AABB& box = boxes[order[used ? begin + k : begin]];
+                x0.push_back(box.v0().x);
+                x1.push_back(box.v1().x);
+                y0.push_back(box.v0().y);
+                y1.push_back(box.v1().y);
+                valid.push_back(used ? 0xffffffff : 0);
+                items.push_back(used ? order[begin + k] : NONE);
+            }
+            nodes[index] = {leafBounds(lane), lane, true};
+            return index;
+        }
+
+        float minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY;
+        for (uint32_t i = begin; i < end; i++) {
+            const AABB& box = boxes[order[i]];
+            float cx = box.v0().x + box.v1().x;
+            float cy = box.v0().y + box.v1().y;
+            minX = std::min(minX, cx);
+            maxX = std::max(maxX, cx);
+            minY = std::min(minY, cy);
+            maxY = std::max(maxY, cy);
+        }
+        bool alongX = maxX - minX >= maxY - minY;
+        uint32_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](uint32_t a, uint32_t b) {
+            const AABB& boxA = boxes[a];
+            const AABB& boxB = boxes[b];
+            return alongX ? boxA.v0().x + boxA.v1().x < boxB.v0().x + boxB.v1().x : boxA.v0().y + boxA.v1().y < boxB.v0().y + boxB.v1().y;
+        });
+
+        uint32_t first = buildNode(boxes, order, begin, middle);
+        uint32_t second = buildNode(boxes, order, middle, end);
+        nodes[index] = {merge(nodes[first].bounds, nodes[second].bounds), second, false};
+        return index;
+    }
+
+    // Whether the ray may hit anything inside bounds grown by grow, and from when. Subtracting and dividing keep the
+    // order of their operands, so a node's interval always contains those doRayCast2D computes for its boxes.
+    static bool enters(const AABB& bounds, Vec2 origin, Vec2 dir, float maxT, Vec2 grow, float& tEntry) noexcept {
+        float t0 = 0.0f;
+        float t1 = maxT;
+        auto slab = [&](float o, float d, float low, float high) {
+            if (d == 0.0f) {
+                return low <= o && o <= high;
+            }
+            float a = (low - o) / d;
+            float b = (high - o) / d;
+            if (a > b) {
+                std::swap(a, b);
+            }
+            t0 = std::max(t0, a);
+            t1 = std::min(t1, b);
+            return t0 <= t1;
+        };
+        if (!slab(origin.x, dir.x, bounds.v0().x - grow.x, bounds.v1().x + grow.x) ||
+            !slab(origin.y, dir.y, bounds.v0().y - grow.y, bounds.v1().y + grow.y)) {
+            return false;
+        }
+        tEntry = t0;
+        return true;
+    }
+
+    struct Rays4 {
+        Float4 originX, originY;
+        Float4 dirX, dirY;
+        Float4 growX, growY;
+    };
+
+    // lanes past count repeat the first ray and are never looked at
+    static Rays4 lanesOf(const RayPacket& packet) noexcept {
+        auto lane = [&](auto get) {
+            float values[LEAF_SIZE];
+            for (uint32_t k = 0; k < LEAF_SIZE; k++) {
+                values[k] = get(k < packet.count ? k : 0);
+            }
+            return Float4::load(values);
+        };
+        return {
+            lane([&](uint32_t k) { return packet.origin[k].x; }),
+            lane([&](uint32_t k) { return packet.origin[k].y; }),
+            lane([&](uint32_t k) { return packet.dir[k].x; }),
+            lane([&](uint32_t k) { return packet.dir[k].y; }),
+            lane([&](uint32_t k) { return packet.grow[k].x; }),
+            lane([&](uint32_t k) { return packet.grow[k].y; }),
+        };
+    }
+
+    // enters for four rays, bit k of the result is set when ray k may hit something inside bounds. A zero direction
+    // keeps the ray's whole interval when the origin is inside the slab, the way the scalar test skips the division.
+    static uint32_t enters(const AABB& bounds, const Rays4& rays, Float4 maxT, Float4& tEntry) noexcept {
+        Float4 t0 = Float4::splat(0.0f);
+        Float4 t1 = maxT;
+        Mask4 inside = Mask4::set(true, true, true, true);
+        auto slab = [&](Float4 o, Float4 d, Float4 low, Float4 high) {
+            Mask4 still = d == Float4::splat(0.0f);
+            Float4 a = (low - o) / d;
+            Float4 b = (high - o) / d;
+            t0 = select(still, t0, max4(t0, min4(a, b)));
+            t1 = select(still, t1, min4(t1, max4(a, b)));
+            inside = inside & (~still | ((low <= o) & (o <= high)));
+        };
+        slab(rays.originX, rays.dirX, Float4::splat(bounds.v0().x) - rays.growX, Float4::splat(bounds.v1().x) + rays.growX);
+        slab(rays.originY, rays.dirY, Float4::splat(bounds.v0().y) - rays.growY, Float4::splat(bounds.v1().y) + rays.growY);
+        tEntry = t0;
+        return (inside & (t0 <= t1)).bits();
+    }
+
+    // the smallest of the lanes of t set in lanes
+    static float nearest(Float4 t, uint32_t lanes) noexcept {
+        float times[LEAF_SIZE];
+        t.store(times);
+        float result = INFINITY;
+        for (uint32_t k = 0; k < LEAF_SIZE; k++) {
+            if ((lanes >> k & 1u) != 0) {
+                result = std::min(result, times[k]);
+            }
+        }
+        return result;
+    }
+
+    // doRayCast2D on the four grown boxes of a leaf, bit k of the result is set when lane k is hit by maxT
+    uint32_t leafRaycast(uint32_t lane, Vec2 origin, Vec2 dir, float maxT, Vec2 grow, float* times) const noexcept {
+        Float4 growX = Float4::splat(grow.x);
+        Float4 growY = Float4::splat(grow.y);
+        Float4 originX = Float4::splat(origin.x);
+        Float4 originY = Float4::splat(origin.y);
+        Float4 dirX = Float4::splat(dir.x);
+        Float4 dirY = Float4::splat(dir.y);
+
+        Float4 pos0X = (Float4::load(&x0[lane]) - growX) - originX;
+        Float4 pos0Y = (Float4::load(&y0[lane]) - growY) - originY;
+        Float4 posX = (Float4::load(&x1[lane]) + growX) - originX;
+        Float4 posY = (Float4::load(&y1[lane]) + growY) - originY;
+
+        Float4 nearY = pos0X / dirX;
+        Float4 nearX = posY / dirY;
+        Float4 farY = posX / dirX;
+        Float4 farX = pos0Y / dirY;
+
+        Mask4 swapX = farX < nearX;
+        Float4 lowX = select(swapX, farX, nearX);
+        farX = select(swapX, nearX, farX);
+        nearX = lowX;
+        Mask4 swapY = farY < nearY;
+        Float4 lowY = select(swapY, farY, nearY);
+        farY = select(swapY, nearY, farY);
+        nearY = lowY;
+
+        Float4 zero = Float4::splat(0.0f);
+        Float4 tNear = max4(nearX, nearY);
+        Float4 tFar = min4(farX, farY);
+        Mask4 hits = (nearY < farX) & (nearX < farY) & ~(tNear < zero) & ~(tFar < zero) & (tNear <= Float4::splat(maxT)) &
+                     Mask4::load(&valid[lane]);
+        tNear.store(times);
+        return hits.bits();
+    }
+
+    // Calls leaf(lane) for every leaf under nodes for which enter(bounds) holds
+    template <typename E, typename L>
+    void forEachLeaf(E&& enter, L&& leaf) const {
+        if (nodes.empty() || !enter(nodes[0].bounds)) {
+            return;
+        }
+        uint32_t stack[MAX_DEPTH + 1];
+        uint32_t depth = 0;
+        stack[depth++] = 0;
+        while (depth != 0) {
+            uint32_t index = stack[--depth];
+            const Node& node = nodes[index];
+            if (node.leaf) {
+                leaf(node.index);
+                continue;
+            }
+            if (enter(nodes[node.index].bounds)) {
+                stack[depth++] = node.index;
+            }
+            if (enter(nodes[index + 1].bounds)) {
+                stack[depth++] = index + 1;
+            }
+        }
+    }
+};
@@ -0,0 +1,186 @@
+#include "chunk_streamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <utility>
+
+#include "../util/numbers.h"
+#include "../util/profiler.h"
+
+static float distanceToBounds(Vec2 point, const AABB& bounds) noexcept {
+    float dx = std::max({bounds.v0().x - point.x, 0.0f, point.x - bounds.v1().x});
+    float dy = std::max({bounds.v0().y - point.y, 0.0f, point.y - bounds.v1().y});
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+ChunkStreamer::ChunkStreamer(std::shared_ptr<const ChunkedLevelIndex> index, ChunkStreamerSettings settings)
+    : index(std::move(index)), settings(settings) {
+    resident.assign(this->index->chunks().size(), false);
+}
+
+void ChunkStreamer::prime(World& world, Vec2 focus) {
+    std::ifstream in(index->path(), std::ios::binary);
+    streamAround(in, focus);
+    lastNotifiedFocus = focus;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& event : events) {
+        apply(world, event);
+    }
+    events.clear();
+}
+
+void ChunkStreamer::start() {
+    stopRequested = false;
+    ioThread = std::thread([this] { ioLoop(); });
+}
+
+void ChunkStreamer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wakeUp.notify_one();
+    if (ioThread.joinable()) {
+        ioThread.join();
+    }
+}
+
+void ChunkStreamer::setFocus(Vec2 newFocus) {
+    // waking the I/O thread every tick for sub-chunk movement would only burn CPU
+    Vec2 moved = newFocus - lastNotifiedFocus;
+    bool notify = std::abs(moved.x) + std::abs(moved.y) > index->chunkSize() * 0.25f;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        focus = newFocus;
+        focusMoved = focusMoved || notify;
+    }
+
+    if (notify) {
+        lastNotifiedFocus = newFocus;
+        wakeUp.notify_one();
+    }
+}
+
+void ChunkStreamer::update(World& world) {
+    PROFILE_ZONE("ChunkStreamer::update");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ioException != nullptr) {
+        std::rethrow_exception(ioException);
+    }
+
+    uint32_t loads = 0;
+    while (!events.empty()) {
+        auto& event = events.front();
+        if (event.load) {
+            if (loads == settings.maxChunksPerUpdate) {
+                break;
+            }
+            loads++;
+        }
+        apply(world, event);
+        events.pop_front();
+    }
+}
+
+void ChunkStreamer::apply(World& world, ChunkEvent& event) {
+    const ChunkTableEntry& entry = index->chunks()[event.chunk];
+    uint64_t id = chunkId(entry.cx, entry.cy);
+    if (event.load) {
+        world.addChunk({id, entry.bounds(), std::move(event.level)});
+    } else {
+        world.removeChunk(id);
+    }
+}
+
+void ChunkStreamer::ioLoop() {
+    PROFILE_THREAD_NAME("chunk io");
+
+    try {
+        std::ifstream in(index->path(), std::ios::binary);
+
+        while (true) {
+            Vec2 currentFocus;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait_for(lock, std::chrono::nanoseconds(IO_POLL_INTERVAL_NS), [this] { return stopRequested || focusMoved; });
+                if (stopRequested) {
+                    return;
+                }
+                currentFocus = focus;
+                focusMoved = false;
+            }
+
+            streamAround(in, currentFocus);
+        }
+    } catch (...) {
+        // surfaced on the simulation thread by the next update
+        std::lock_guard<std::mutex> lock(mutex);
+        ioException = std::current_exception();
+    }
+}
+
+void ChunkStreamer::streamAround(std::istream& in, Vec2 currentFocus) {
+    PROFILE_ZONE("ChunkStreamer::streamAround");
+
+    const auto& chunks = index->chunks();
+
+    std::vector<std::pair<float, uint32_t>> wanted;
+    std::vector<std::pair<float, uint32_t>> evictable;
+    for (uint32_t i = 0; i < chunks.size(); i++) {
+        float distance = distanceToBounds(currentFocus, chunks[i].bounds());
+        if (resident[i]) {
+            if (distance > settings.evictRadius) {
+                evictable.emplace_back(NUM_MAX<float>, i);
+            } else if (distance > settings.loadRadius) {
+                evictable.emplace_back(distance, i);
+            }
+        } else if (distance <= settings.loadRadius) {
+            wanted.emplace_back(distance, i);
+        }
+    }
+
+    // beyond evictRadius chunks always go, between the radii only when the budget needs the room, farthest first
+    std::sort(evictable.begin(), evictable.end(), std::greater<>());
+    std::sort(wanted.begin(), wanted.end());
+
+    auto evict = [&](uint32_t i) {
+        resident[i] = false;
+        residentBytes -= chunks[i].size;
+        _stats.evictedChunks.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back({false, i, nullptr});
+    };
+
+    size_t nextEvictable = 0;
+    for (; nextEvictable < evictable.size() && evictable[nextEvictable].first == NUM_MAX<float>; nextEvictable++) {
+        evict(evictable[nextEvictable].second);
+    }
+
+    for (const auto& [distance, i] : wanted) {
+        while (residentBytes + chunks[i].size > settings.residentBytesBudget && nextEvictable < evictable.size()) {
+            evict(evictable[nextEvictable++].second);
+        }
+        if (residentBytes + chunks[i].size > settings.residentBytesBudget) {
+            _stats.budgetRejections.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        auto level = index->readChunk(in, i);
+        resident[i] = true;
+        residentBytes += chunks[i].size;
+        _stats.loadedChunks.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back({true, i, std::move(level)});
+        if (stopRequested) {
+            break;
+        }
+    }
+
+    _stats.residentBytes.store(residentBytes, std::memory_order_relaxed);
+}
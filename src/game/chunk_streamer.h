@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "chunked_level.h"
+#include "world.h"
+#include "../platform/time.h"
+
+struct ChunkStreamerSettings {
+    // distances from the focus point to chunk bounds, the gap between them keeps chunks at the edge from thrashing
+    float loadRadius = 3000.0f;
+    float evictRadius = 4500.0f;
+
+    // chunks handed to the world per update, so a burst of loads is spread over several ticks
+    uint32_t maxChunksPerUpdate = 2;
+
+    // loaded and queued chunk bytes
+    uint64_t residentBytesBudget = 256ull << 20;
+};
+
+struct ChunkStreamerStats {
+    std::atomic<uint64_t> loadedChunks{0};
+    std::atomic<uint64_t> evictedChunks{0};
+    std::atomic<uint64_t> residentBytes{0};
+    std::atomic<uint64_t> budgetRejections{0};
+};
+
+// Loads and evicts the chunks of a streamed world around a focus point on a background I/O thread.
+// The simulation thread only ever applies finished loads, so streaming never blocks a tick on disk.
+class ChunkStreamer {
+public:
+    static inline constexpr uint64_t IO_POLL_INTERVAL_NS = 50 * NSECS_PER_MSEC;
+
+private:
+    struct ChunkEvent {
+        bool load;
+        uint32_t chunk;
+        std::shared_ptr<const Level> level;
+    };
+
+    std::shared_ptr<const ChunkedLevelIndex> index;
+    ChunkStreamerSettings settings;
+    ChunkStreamerStats _stats{};
+
+    std::mutex mutex{};
+    std::condition_variable wakeUp{};
+    bool stopRequested = false;
+    bool focusMoved = false;
+    Vec2 focus{};
+    std::deque<ChunkEvent> events{};
+    std::exception_ptr ioException{};
+
+    std::thread ioThread{};
+
+    // owned by the I/O thread once started
+    std::vector<bool> resident{};
+    uint64_t residentBytes = 0;
+
+    // owned by the simulation thread
+    Vec2 lastNotifiedFocus{};
+
+public:
+    ChunkStreamer(std::shared_ptr<const ChunkedLevelIndex> index, ChunkStreamerSettings settings = {});
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    ~ChunkStreamer() {
+        stop();
+    }
+
+    // Synchronously loads everything around focus into world, for use before start() so the player does not
+    // spawn above geometry that is still on disk.
+    void prime(World& world, Vec2 focus);
+
+    void start();
+
+    void stop();
+
+    void setFocus(Vec2 focus);
+
+    // Applies finished evictions and at most maxChunksPerUpdate loads to world. Rethrows I/O thread failures.
+    void update(World& world);
+
+    const ChunkStreamerStats& stats() const noexcept {
+        return _stats;
+    }
+
+private:
+    void ioLoop();
+
+    void streamAround(std::istream& in, Vec2 focus);
+
+    void apply(World& world, ChunkEvent& event);
+};
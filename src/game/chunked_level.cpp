@@ -0,0 +1,194 @@
+#include "chunked_level.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "../util/numbers.h"
+
+static_assert(std::is_trivially_copyable_v<ChunkedLevelHeader>);
+static_assert(sizeof(ChunkedLevelHeader) == 48, "chunked level header layout changed, bump CHUNKED_LEVEL_FORMAT_VERSION");
+static_assert(sizeof(ChunkTableEntry) == 40, "chunk table layout changed, bump CHUNKED_LEVEL_FORMAT_VERSION");
+
+static void writePadding(std::ostream& out, uint64_t& offset) {
+    static const char zeros[LEVEL_SECTION_ALIGNMENT] = {};
+    uint64_t aligned = alignSection(offset);
+    out.write(zeros, static_cast<std::streamsize>(aligned - offset));
+    offset = aligned;
+}
+
+void writeChunkedLevel(std::ostream& out, const LevelDescription& description, float chunkSize) {
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("level files can only be written on little-endian hosts");
+    }
+    if (!(chunkSize > 0.0f)) {
+        throw std::runtime_error("chunk size must be positive");
+    }
+
+    // (cy, cx) keys iterate in chunk id order
+    std::map<std::pair<int32_t, int32_t>, LevelDescription> partition;
+    for (const auto& solid : description.solids) {
+        Vec2 center = (solid.v0() + solid.v1()) * 0.5f;
+        auto cx = static_cast<int32_t>(std::floor(center.x / chunkSize));
+        auto cy = static_cast<int32_t>(std::floor(center.y / chunkSize));
+        auto& chunk = partition[{cy, cx}];
+        chunk.gridCellSize = description.gridCellSize;
+        chunk.solids.push_back(solid);
+    }
+    for (const auto& tile : description.tiles) {
+        float centerX = description.tileOriginX + (static_cast<float>(tile.tx) + 0.5f) * description.tileSize;
+        float centerY = description.tileOriginY + (static_cast<float>(tile.ty) + 0.5f) * description.tileSize;
+        auto cx = static_cast<int32_t>(std::floor(centerX / chunkSize));
+        auto cy = static_cast<int32_t>(std::floor(centerY / chunkSize));
+        auto& chunk = partition[{cy, cx}];
+        chunk.gridCellSize = description.gridCellSize;
+        chunk.tileOriginX = description.tileOriginX;
+        chunk.tileOriginY = description.tileOriginY;
+        chunk.tileSize = description.tileSize;
+        chunk.tiles.push_back(tile);
+    }
+
+    ChunkedLevelHeader header{};
+    memcpy(header.magic, CHUNKED_LEVEL_MAGIC, sizeof(CHUNKED_LEVEL_MAGIC));
+    header.version = CHUNKED_LEVEL_FORMAT_VERSION;
+    header.chunkSize = chunkSize;
+    header.chunkCount = static_cast<uint32_t>(partition.size());
+    header.spawnCount = static_cast<uint32_t>(description.spawns.size());
+    header.chunkTableOffset = alignSection(sizeof(ChunkedLevelHeader));
+    header.spawnsOffset = alignSection(header.chunkTableOffset + sizeof(ChunkTableEntry) * header.chunkCount);
+
+    // chunks are serialized one at a time, the table is patched in once their sizes are known
+    std::vector<ChunkTableEntry> table;
+    table.reserve(partition.size());
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t offset = sizeof(header);
+    writePadding(out, offset);
+    std::vector<char> tablePlaceholder(sizeof(ChunkTableEntry) * header.chunkCount, 0);
+    out.write(tablePlaceholder.data(), static_cast<std::streamsize>(tablePlaceholder.size()));
+    offset += tablePlaceholder.size();
+    writePadding(out, offset);
+    out.write(reinterpret_cast<const char*>(description.spawns.data()), static_cast<std::streamsize>(sizeof(SpawnPoint) * header.spawnCount));
+    offset += sizeof(SpawnPoint) * header.spawnCount;
+
+    for (const auto& [key, chunk] : partition) {
+        writePadding(out, offset);
+
+        ChunkTableEntry entry{};
+        entry.cy = key.first;
+        entry.cx = key.second;
+        entry.boundsX0 = NUM_MAX<float>;
+        entry.boundsX1 = -NUM_MAX<float>;
+        entry.boundsY0 = NUM_MAX<float>;
+        entry.boundsY1 = -NUM_MAX<float>;
+        auto include = [&](const AABB& aabb) {
+            entry.boundsX0 = std::min(entry.boundsX0, aabb.v0().x);
+            entry.boundsX1 = std::max(entry.boundsX1, aabb.v1().x);
+            entry.boundsY0 = std::min(entry.boundsY0, aabb.v0().y);
+            entry.boundsY1 = std::max(entry.boundsY1, aabb.v1().y);
+        };
+        for (const auto& solid : chunk.solids) {
+            include(solid.aabb());
+        }
+        for (const auto& tile : chunk.tiles) {
+            include(AABB(
+                chunk.tileOriginX + static_cast<float>(tile.tx) * chunk.tileSize,
+                chunk.tileOriginX + static_cast<float>(tile.tx + 1) * chunk.tileSize,
+                chunk.tileOriginY + static_cast<float>(tile.ty) * chunk.tileSize,
+                chunk.tileOriginY + static_cast<float>(tile.ty + 1) * chunk.tileSize
+            ));
+        }
+
+        std::vector<uint8_t> bytes = serializeLevel(chunk);
+        entry.offset = offset;
+        entry.size = bytes.size();
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        offset += bytes.size();
+        table.push_back(entry);
+    }
+
+    header.fileSize = offset;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.seekp(static_cast<std::streamoff>(header.chunkTableOffset));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(sizeof(ChunkTableEntry) * table.size()));
+    out.seekp(static_cast<std::streamoff>(offset));
+
+    if (!out) {
+        throw std::runtime_error("failed to write chunked level");
+    }
+}
+
+static ChunkedLevelHeader readHeader(std::istream& in) {
+    ChunkedLevelHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || memcmp(header.magic, CHUNKED_LEVEL_MAGIC, sizeof(CHUNKED_LEVEL_MAGIC)) != 0) {
+        throw std::runtime_error("not a chunked level file");
+    }
+    return header;
+}
+
+bool ChunkedLevelIndex::isChunkedLevel(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    in.read(magic, sizeof(magic));
+    return in && memcmp(magic, CHUNKED_LEVEL_MAGIC, sizeof(CHUNKED_LEVEL_MAGIC)) == 0;
+}
+
+std::shared_ptr<const ChunkedLevelIndex> ChunkedLevelIndex::open(const std::string& path) {
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("level files can only be loaded on little-endian hosts");
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("failed to open file " + path);
+    }
+
+    ChunkedLevelHeader header = readHeader(in);
+    if (header.version != CHUNKED_LEVEL_FORMAT_VERSION) {
+        throw std::runtime_error(path + ": unsupported chunked level format version " + std::to_string(header.version));
+    }
+
+    auto index = std::make_shared<ChunkedLevelIndex>();
+    index->_path = path;
+    index->_chunkSize = header.chunkSize;
+
+    index->_chunks.resize(header.chunkCount);
+    in.seekg(static_cast<std::streamoff>(header.chunkTableOffset));
+    in.read(reinterpret_cast<char*>(index->_chunks.data()), static_cast<std::streamsize>(sizeof(ChunkTableEntry) * header.chunkCount));
+
+    index->_spawns.resize(header.spawnCount);
+    in.seekg(static_cast<std::streamoff>(header.spawnsOffset));
+    in.read(reinterpret_cast<char*>(index->_spawns.data()), static_cast<std::streamsize>(sizeof(SpawnPoint) * header.spawnCount));
+
+    if (!in) {
+        throw std::runtime_error(path + ": chunked level file is truncated");
+    }
+
+    for (const auto& chunk : index->_chunks) {
+        if (chunk.offset > header.fileSize || chunk.size > header.fileSize - chunk.offset) {
+            throw std::runtime_error(path + ": chunk is out of bounds");
+        }
+    }
+
+    return index;
+}
+
+std::shared_ptr<const Level> ChunkedLevelIndex::readChunk(std::istream& in, uint32_t i) const {
+    const ChunkTableEntry& entry = _chunks.at(i);
+
+    std::vector<uint8_t> bytes(entry.size);
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(entry.offset));
+    in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!in) {
+        throw std::runtime_error(_path + ": failed to read chunk " + std::to_string(i));
+    }
+
+    return Level::fromBytes(std::move(bytes));
+}
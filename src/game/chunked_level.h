@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "level.h"
+
+// Streamed world file, version 1. Static geometry is partitioned into square chunks by solid center, every chunk
+// is stored as a complete level file so a loaded chunk is used exactly like a single-file level.
+//
+//   ChunkedLevelHeader
+//   ChunkTableEntry[chunkCount]    sorted by id
+//   SpawnPoint[spawnCount]
+//   chunk level files              LEVEL_SECTION_ALIGNMENT aligned
+
+inline constexpr char CHUNKED_LEVEL_MAGIC[4] = {'P', 'W', 'L', 'D'};
+inline constexpr uint32_t CHUNKED_LEVEL_FORMAT_VERSION = 1;
+
+struct ChunkedLevelHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t fileSize;
+
+    float chunkSize;
+    uint32_t chunkCount;
+    uint32_t spawnCount;
+    uint32_t reserved;
+
+    uint64_t chunkTableOffset;
+    uint64_t spawnsOffset;
+};
+
+struct ChunkTableEntry {
+    int32_t cx;
+    int32_t cy;
+
+    // exact bounds of the chunk's solids, which may reach past the chunk square
+    float boundsX0;
+    float boundsX1;
+    float boundsY0;
+    float boundsY1;
+
+    uint64_t offset;
+    uint64_t size;
+
+    AABB bounds() const noexcept {
+        return {boundsX0, boundsX1, boundsY0, boundsY1};
+    }
+};
+
+// Chunk ids order chunks row by row, the order the table and the world chunk list are kept in
+inline uint64_t chunkId(int32_t cx, int32_t cy) noexcept {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cy) ^ 0x80000000u) << 32) | (static_cast<uint32_t>(cx) ^ 0x80000000u);
+}
+
+void writeChunkedLevel(std::ostream& out, const LevelDescription& description, float chunkSize);
+
+// Chunk table of a streamed world. Only the table and spawn points are read up front.
+class ChunkedLevelIndex {
+    std::string _path{};
+    float _chunkSize = 0.0f;
+    std::vector<ChunkTableEntry> _chunks{};
+    std::vector<SpawnPoint> _spawns{};
+
+public:
+    static bool isChunkedLevel(const std::string& path);
+
+    static std::shared_ptr<const ChunkedLevelIndex> open(const std::string& path);
+
+    const std::string& path() const noexcept {
+        return _path;
+    }
+
+    float chunkSize() const noexcept {
+        return _chunkSize;
+    }
+
+    const std::vector<ChunkTableEntry>& chunks() const noexcept {
+        return _chunks;
+    }
+
+    const std::vector<SpawnPoint>& spawns() const noexcept {
+        return _spawns;
+    }
+
+    // Reads chunk i from a stream opened on path(), blocking
+    std::shared_ptr<const Level> readChunk(std::istream& in, uint32_t i) const;
+};
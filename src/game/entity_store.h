@@ -0,0 +1,370 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../util/spsc_ring.h"
+
+// Stays valid for the entity's whole life, a destroyed entity's slot is reused with the next generation
+struct Entity {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity& rhs) const noexcept {
+        return index == rhs.index && generation == rhs.generation;
+    }
+};
+
+using ComponentMask = uint64_t;
+
+inline constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+
+inline uint32_t nextComponentId() {
+    static std::atomic<uint32_t> lastId{0};
+    uint32_t id = lastId.fetch_add(1, std::memory_order_relaxed);
+    if (id >= MAX_COMPONENT_TYPES) {
+        throw std::runtime_error("too many component types");
+    }
+    return id;
+}
+
+// Numbered on first use, so the numbers differ between runs but never within one
+template <typename C>
+inline uint32_t componentId() {
+    static const uint32_t id = nextComponentId();
+    return id;
+}
+
+template <typename... Cs>
+inline ComponentMask componentMask() {
+    return ((ComponentMask(1) << componentId<Cs>()) | ... | ComponentMask(0));
+}
+
+// A run of entities of one archetype, handed to systems so that they can split the work between threads
+struct EntityChunk {
+    uint32_t archetype;
+    uint32_t chunk;
+};
+
+// Archetype entity component storage. Entities with the same set of components share an archetype, which keeps them
+// in fixed size chunks with one array per component, each array starting on a cache line. Chunks stay packed: creating
+// an entity appends to the last chunk and destroying one moves the archetype's last entity into its row, both O(1).
+//
+// Components have to be trivially copyable, they are moved around with memcpy. Creating or destroying entities
+// invalidates component references and EntityChunks, iterating from several threads is fine as long as nothing does.
+class EntityStore {
+public:
+    static inline constexpr size_t CHUNK_SIZE = 16 * 1024;
+    static inline constexpr size_t ALIGNMENT = CACHE_LINE_SIZE;
+
+private:
+    struct ChunkDeleter {
+        void operator()(std::byte* p) const noexcept {
+            ::operator delete[](p, std::align_val_t(ALIGNMENT));
+        }
+    };
+    using ChunkStorage = std::unique_ptr<std::byte[], ChunkDeleter>;
+
+    struct Column {
+        uint32_t component;
+        uint32_t size;
+        // from the chunk's start
+        size_t offset;
+    };
+
+    struct Archetype {
+        ComponentMask mask;
+        // ascending by component, the entities' handles first
+        std::vector<Column> columns;
+        uint32_t capacity;
+        uint32_t count = 0;
+        // chunks past count / capacity are empty and kept for reuse
+        std::vector<ChunkStorage> chunks{};
+    };
+
+    struct Location {
+        uint32_t archetype;
+        uint32_t row;
+        uint32_t generation;
+        bool alive;
+    };
+
+    std::vector<Archetype> archetypes{};
+    std::vector<Location> locations{};
+    std::vector<uint32_t> freeIndices{};
+    uint32_t _size = 0;
+
+public:
+    EntityStore() = default;
+
+    EntityStore(const EntityStore& other) : locations(other.locations), freeIndices(other.freeIndices), _size(other._size) {
+        archetypes.reserve(other.archetypes.size());
+        for (const auto& archetype : other.archetypes) {
+            Archetype copy{archetype.mask, archetype.columns, archetype.capacity, archetype.count};
+            for (const auto& chunk : archetype.chunks) {
+                copy.chunks.push_back(allocateChunk());
+                std::memcpy(copy.chunks.back().get(), chunk.get(), CHUNK_SIZE);
+            }
+            archetypes.push_back(std::move(copy));
+        }
+    }
+
+    EntityStore(EntityStore&&) noexcept = default;
+
+    EntityStore& operator=(const EntityStore& other) {
+        if (this != &other) {
+            *this = EntityStore(other);
+        }
+        return *this;
+    }
+
+    EntityStore& operator=(EntityStore&&) noexcept = default;
+
+    uint32_t size() const noexcept {
+        return _size;
+    }
+
+    bool empty() const noexcept {
+        return _size == 0;
+    }
+
+    // How many entities have all of Cs
+    template <typename... Cs>
+    uint32_t count() const {
+        ComponentMask mask = componentMask<Cs...>();
+        uint32_t total = 0;
+        for (const auto& archetype : archetypes) {
+            if ((archetype.mask & mask) == mask) {
+                total += archetype.count;
+            }
+        }
+        return total;
+    }
+
+    template <typename... Cs>
+    Entity create(const Cs&... components) {
+        static_assert(sizeof...(Cs) != 0, "an entity needs components");
+        static_assert((std::is_trivially_copyable_v<Cs> && ...), "components are moved with memcpy");
+        static_assert(((alignof(Cs) <= ALIGNMENT) && ...), "components are aligned to cache lines at most");
+
+        uint32_t a = archetypeFor<Cs...>();
+        Archetype& archetype = archetypes[a];
+        uint32_t row = archetype.count;
+        if (row / archetype.capacity == archetype.chunks.size()) {
+            archetype.chunks.push_back(allocateChunk());
+        }
+        archetype.count++;
+
+        uint32_t index;
+        if (!freeIndices.empty()) {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+        } else {
+            index = static_cast<uint32_t>(locations.size());
+            locations.push_back({0, 0, 0, false});
+        }
+        Location& location = locations[index];
+        location = {a, row, location.generation, true};
+        Entity entity{index, location.generation};
+
+        *static_cast<Entity*>(columnAt(archetype, 0, row)) = entity;
+        (write(archetype, row, components), ...);
+        _size++;
+        return entity;
+    }
+
+    // Returns false when entity was already destroyed
+    bool destroy(Entity entity) {
+        if (!isAlive(entity)) {
+            return false;
+        }
+        Location& location = locations[entity.index];
+        Archetype& archetype = archetypes[location.archetype];
+        uint32_t last = archetype.count - 1;
+        if (location.row != last) {
+            for (uint32_t c = 0; c < archetype.columns.size(); c++) {
+                std::memcpy(columnAt(archetype, c, location.row), columnAt(archetype, c, last), archetype.columns[c].size);
+            }
+            Entity moved = *static_cast<Entity*>(columnAt(archetype, 0, location.row));
+            locations[moved.index].row = location.row;
+        }
+        archetype.count = last;
+
+        location.alive = false;
+        location.generation++;
+        freeIndices.push_back(entity.index);
+        _size--;
+        return true;
+    }
+
+    bool isAlive(Entity entity) const noexcept {
+        return entity.index < locations.size() && locations[entity.index].alive && locations[entity.index].generation == entity.generation;
+    }
+
+    template <typename C>
+    bool has(Entity entity) const {
+        return isAlive(entity) && (archetypes[locations[entity.index].archetype].mask & componentMask<C>()) != 0;
+    }
+
+    template <typename C>
+    C& get(Entity entity) {
+        if (!has<C>(entity)) {
+            throw std::runtime_error("entity " + std::to_string(entity.index) + " has no such component");
+        }
+        const Location& location = locations[entity.index];
+        Archetype& archetype = archetypes[location.archetype];
+        return *static_cast<C*>(columnAt(archetype, columnOf(archetype, componentId<C>()), location.row));
+    }
+
+    template <typename C>
+    const C& get(Entity entity) const {
+        return const_cast<EntityStore*>(this)->get<C>(entity);
+    }
+
+    // Replaces out with the chunks of every archetype that has all of Cs, for splitting a system between threads
+    template <typename... Cs>
+    void chunks(std::vector<EntityChunk>& out) const {
+        out.clear();
+        ComponentMask mask = componentMask<Cs...>();
+        for (uint32_t a = 0; a < archetypes.size(); a++) {
+            const Archetype& archetype = archetypes[a];
+            if ((archetype.mask & mask) != mask) {
+                continue;
+            }
+            for (uint32_t c = 0; c * archetype.capacity < archetype.count; c++) {
+                out.push_back({a, c});
+            }
+        }
+    }
+
+    // Calls f(entity, components...) for every entity of the chunk
+    template <typename... Cs, typename F>
+    void forEach(const EntityChunk& chunk, F&& f) {
+        Archetype& archetype = archetypes[chunk.archetype];
+        uint32_t first = chunk.chunk * archetype.capacity;
+        uint32_t count = std::min(archetype.capacity, archetype.count - first);
+        std::byte* storage = archetype.chunks[chunk.chunk].get();
+        const Entity* entities = reinterpret_cast<const Entity*>(storage + archetype.columns[0].offset);
+        forEachRow(entities, count, f, reinterpret_cast<Cs*>(storage + archetype.columns[columnOf(archetype, componentId<Cs>())].offset)...);
+    }
+
+    // Calls f(entity, components...) for every entity that has all of Cs, archetype by archetype and chunk by chunk
+    template <typename... Cs, typename F>
+    void forEach(F&& f) {
+        ComponentMask mask = componentMask<Cs...>();
+        for (uint32_t a = 0; a < archetypes.size(); a++) {
+            const Archetype& archetype = archetypes[a];
+            if ((archetype.mask & mask) != mask) {
+                continue;
+            }
+            for (uint32_t c = 0; c * archetype.capacity < archetype.count; c++) {
+                forEach<Cs...>(EntityChunk{a, c}, f);
+            }
+        }
+    }
+
+    template <typename... Cs, typename F>
+    void forEach(const EntityChunk& chunk, F&& f) const {
+        const_cast<EntityStore*>(this)->forEach<Cs...>(chunk, [&](Entity entity, Cs&... components) { f(entity, static_cast<const Cs&>(components)...); });
+    }
+
+    template <typename... Cs, typename F>
+    void forEach(F&& f) const {
+        const_cast<EntityStore*>(this)->forEach<Cs...>([&](Entity entity, Cs&... components) { f(entity, static_cast<const Cs&>(components)...); });
+    }
+
+    // Entities that fit a chunk with these components
+    template <typename... Cs>
+    static uint32_t chunkCapacity() {
+        return capacityFor({sizeof(Entity), sizeof(Cs)...});
+    }
+
+private:
+    static ChunkStorage allocateChunk() {
+        return ChunkStorage(static_cast<std::byte*>(::operator new[](CHUNK_SIZE, std::align_val_t(ALIGNMENT))));
+    }
+
+    static size_t alignUp(size_t v) noexcept {
+        return (v + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    // every array is padded to a cache line, so a chunk holds a little less than CHUNK_SIZE over the entity size
+    static uint32_t capacityFor(std::initializer_list<size_t> sizes) {
+        size_t perEntity = 0;
+        for (size_t size : sizes) {
+            perEntity += size;
+        }
+        auto capacity = static_cast<uint32_t>((CHUNK_SIZE - sizes.size() * ALIGNMENT) / perEntity);
+        if (capacity == 0) {
+            throw std::runtime_error("components too large for a chunk");
+        }
+        return capacity;
+    }
+
+    template <typename... Cs>
+    uint32_t archetypeFor() {
+        ComponentMask mask = componentMask<Cs...>();
+        uint32_t distinct = 0;
+        for (ComponentMask m = mask; m != 0; m &= m - 1) {
+            distinct++;
+        }
+        if (distinct != sizeof...(Cs)) {
+            throw std::runtime_error("an entity cannot have the same component twice");
+        }
+        for (uint32_t a = 0; a < archetypes.size(); a++) {
+            if (archetypes[a].mask == mask) {
+                return a;
+            }
+        }
+
+        Archetype archetype{mask, {}, chunkCapacity<Cs...>()};
+        archetype.columns.push_back({UINT32_MAX, static_cast<uint32_t>(sizeof(Entity)), 0});
+        std::vector<Column> components = {{componentId<Cs>(), static_cast<uint32_t>(sizeof(Cs)), 0}...};
+        std::sort(components.begin(), components.end(), [](const Column& a, const Column& b) { return a.component < b.component; });
+        archetype.columns.insert(archetype.columns.end(), components.begin(), components.end());
+        size_t offset = 0;
+        for (auto& column : archetype.columns) {
+            column.offset = offset;
+            offset = alignUp(offset + static_cast<size_t>(column.size) * archetype.capacity);
+        }
+        archetypes.push_back(std::move(archetype));
+        return static_cast<uint32_t>(archetypes.size() - 1);
+    }
+
+    static uint32_t columnOf(const Archetype& archetype, uint32_t component) {
+        for (uint32_t c = 1; c < archetype.columns.size(); c++) {
+            if (archetype.columns[c].component == component) {
+                return c;
+            }
+        }
+        throw std::runtime_error("archetype has no such component");
+    }
+
+    static void* columnAt(Archetype& archetype, uint32_t column, uint32_t row) noexcept {
+        const Column& c = archetype.columns[column];
+        std::byte* storage = archetype.chunks[row / archetype.capacity].get();
+        return storage + c.offset + static_cast<size_t>(c.size) * (row % archetype.capacity);
+    }
+
+    template <typename C>
+    void write(Archetype& archetype, uint32_t row, const C& component) {
+        std::memcpy(columnAt(archetype, columnOf(archetype, componentId<C>()), row), &component, sizeof(C));
+    }
+
+    template <typename F, typename... Cs>
+    static void forEachRow(const Entity* entities, uint32_t count, F& f, Cs*... arrays) {
+        for (uint32_t i = 0; i < count; i++) {
+            f(entities[i], arrays[i]...);
+        }
+    }
+};
@@ -1,40 +1,112 @@
+#include <algorithm>
 #include <cmath>
 
 #include "game.h"
+#include "../util/profiler.h"
 
-Game::Game() {
-    world.objects.emplace_back(100, 900, 200, 250);
-    world.player.setPos(150, 300);
-//    world.player.vel() = {0.8f, 2.5f};
+template <typename T>
+BasicGame<T>::BasicGame() {
+    world.objects.emplace_back(T(100), T(900), T(200), T(250));
+    world.markLevelDirty();
+    world.player().setPos(T(150), T(300));
+//    world.player().vel() = {0.8f, 2.5f};
 }
 
-void Game::process(float delta) {
-    if (delta > PHYSICS_SUBSTEP_DELTA_MAX) {
-        float substeps = std::trunc(delta / PHYSICS_SUBSTEP_DELTA_MAX); // TODO: maybe replace with multiplication
-        float leftDelta = delta - substeps * PHYSICS_SUBSTEP_DELTA_MAX;
+template <typename T>
+BasicGame<T>::BasicGame(std::shared_ptr<const Level> level)
+    : BasicGame(level, level != nullptr && level->spawnCount() != 0 ? Vec2(level->spawns()[0].x, level->spawns()[0].y) : Vec2(150, 300)) {}
+
+template <typename T>
+BasicGame<T>::BasicGame(std::shared_ptr<const Level> level, Vec2 spawn) {
+    world.player().setPos(BasicVec2<T>(spawn));
+    world.setLevel(std::move(level));
+}
+
+template <typename T>
+void BasicGame<T>::process(T delta) {
+    PROFILE_ZONE("Game::process");
+
+    if (!world.triggers.empty()) {
+        world.startTriggerFrame();
+    }
+    if (!world.kinematics.empty()) {
+        world.stepKinematics(delta);
+    }
+
+    const T substepMax = T(world.resolver == ContactResolver::SWEEP ? PHYSICS_SWEEP_SUBSTEP_DELTA_MAX : PHYSICS_SUBSTEP_DELTA_MAX);
+    if (adaptiveSubsteps) {
+        uint32_t substeps = adaptiveSubstepCount(delta, static_cast<uint32_t>(delta / substepMax) + 1);
+        T substep = delta / T(static_cast<int32_t>(substeps));
+        for (uint32_t i = 0; i < substeps; i++) {
+            process_(substep);
+        }
+    } else if (delta > substepMax) {
+        using std::trunc;
+        T substeps = trunc(delta / substepMax); // TODO: maybe replace with multiplication
+        T leftDelta = delta - substeps * substepMax;
 
         for (uint32_t i = 0; i < static_cast<uint32_t>(substeps); i++) {
-            process_(PHYSICS_SUBSTEP_DELTA_MAX);
+            process_(substepMax);
         }
         process_(leftDelta);
     } else {
         process_(delta);
     }
+
+    if (!world.projectiles.empty()) {
+        world.stepProjectiles(delta);
+    }
+    if (!world.triggers.empty()) {
+        world.detectTriggers();
+    }
 }
 
-void Game::process_(float delta) {
+template <typename T>
+void BasicGame<T>::process_(T delta) {
     if (moveLeft && !moveRight) {
-        world.addVelocityX(-0.011f * delta, 0.8f);
+        world.addVelocityX(T(-0.011f) * delta, T(0.8f));
     } else if (!moveLeft && moveRight) {
-        world.addVelocityX(0.011f * delta, 0.8f);
-    } else if (world.player.isOnGround()) {
-        world.slowDown(0.005f * delta);
+        world.addVelocityX(T(0.011f) * delta, T(0.8f));
+    } else if (world.player().isOnGround()) {
+        world.slowDown(T(0.005f) * delta);
     }
 
     world.tick(delta);
 }
 
-void Game::playerJump() {
-    world.player.vel().y = 2.5f;
-    world.player.setOnGround(false);
+// Every body gets the substeps it needs and the frame takes the most any of them does. A body's distance is an upper
+// bound of how far it can get this frame: its speed plus what gravity and the controls can add, on both axes.
+template <typename T>
+uint32_t BasicGame<T>::adaptiveSubstepCount(T delta, uint32_t maxSubsteps) {
+    uint32_t substeps = 1;
+    world.entities.template forEach<BasicPlayer<T>>([&](Entity, const BasicPlayer<T>& body) {
+        if (substeps == maxSubsteps) {
+            return;
+        }
+        const BasicVec2<T>& vel = body.vel();
+        T speed = std::max(vel.x, -vel.x) + std::max(vel.y, -vel.y);
+        T reach = speed * delta + T(0.005f + 0.011f) * delta * delta;
+
+        BasicAABB<T> region = body.aabb();
+        region.v0() = region.v0() - BasicVec2<T>(reach, reach);
+        region.v1() = region.v1() + BasicVec2<T>(reach, reach);
+        T feature = world.smallestFeatureNear(region);
+        if (feature == T(0)) {
+            return;
+        }
+
+        // clamped before the conversion, a long frame over a thin feature does not fit in an integer
+        T needed = std::min(reach / (feature * T(PHYSICS_ADAPTIVE_FEATURE_FRACTION)), T(static_cast<int32_t>(maxSubsteps)));
+        substeps = std::max(substeps, std::min(static_cast<uint32_t>(needed) + 1, maxSubsteps));
+    });
+    return substeps;
+}
+
+template <typename T>
+void BasicGame<T>::playerJump() {
+    world.player().vel().y = T(2.5f);
+    world.player().setOnGround(false);
 }
+
+template struct BasicGame<float>;
+template struct BasicGame<Fixed>;
@@ -1,21 +1,46 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 
+#include "level.h"
 #include "world.h"
+#include "../math/fixed.h"
 
 const float PHYSICS_SUBSTEP_DELTA_MAX = 0.24f;
-
-struct Game {
-    World world{};
+// the sweep resolver does not snag or tunnel with longer substeps, only the arcs get slightly coarser
+const float PHYSICS_SWEEP_SUBSTEP_DELTA_MAX = 2.0f;
+// with adaptive substeps a body moves at most this fraction of the smallest solid near it per substep
+const float PHYSICS_ADAPTIVE_FEATURE_FRACTION = 0.5f;
+
+// T is float, or Fixed for results that are identical on every build and platform. Both are instantiated in game.cpp.
+template <typename T>
+struct BasicGame {
+    BasicWorld<T> world{};
     bool moveLeft = false;
     bool moveRight = false;
+    // Splits a frame into as few substeps as the speed of every body and the solids around each allow, from one up to
+    // what the fixed substep size would take
+    bool adaptiveSubsteps = false;
+
+    BasicGame();
+
+    // Starts at the level's first spawn point, or where the built-in level would
+    explicit BasicGame(std::shared_ptr<const Level> level);
 
-    Game();
+    BasicGame(std::shared_ptr<const Level> level, Vec2 spawn);
 
-    void process(float delta);
+    void process(T delta);
 
-    void process_(float delta);
+    void process_(T delta);
+
+    uint32_t adaptiveSubstepCount(T delta, uint32_t maxSubsteps);
 
     void playerJump();
 };
+
+extern template struct BasicGame<float>;
+extern template struct BasicGame<Fixed>;
+
+using Game = BasicGame<float>;
+using FixedGame = BasicGame<Fixed>;
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "AABB.h"
+#include "../math/fixed.h"
+
+enum class KinematicLoop {
+    // from the last waypoint straight back to the first
+    CYCLE,
+    // back through the waypoints in reverse
+    PING_PONG,
+};
+
+template <typename T>
+struct BasicKinematicWaypoint {
+    // from the platform's resting box
+    BasicVec2<T> offset;
+    // time to get from this waypoint to the next one, in milliseconds like the rest of the game
+    T duration;
+};
+
+// Scripted motion shared by any number of platforms, at constant speed between waypoints. A moving platform goes back
+// and forth, an elevator ping-pongs vertically and a crusher cycles through a short drop and a long rise. With Fixed
+// the period has to stay within Fixed's range, about 32 seconds.
+template <typename T>
+struct BasicKinematicPath {
+    std::vector<BasicKinematicWaypoint<T>> waypoints{};
+    KinematicLoop loop = KinematicLoop::PING_PONG;
+
+    // segments travelled forward, the last waypoint's duration only counts when cycling
+    size_t legCount() const noexcept {
+        if (waypoints.empty()) {
+            return 0;
+        }
+        return loop == KinematicLoop::CYCLE ? waypoints.size() : waypoints.size() - 1;
+    }
+
+    T period() const noexcept {
+        T forward = T(0);
+        for (size_t i = 0; i < legCount(); i++) {
+            forward += waypoints[i].duration;
+        }
+        return loop == KinematicLoop::CYCLE ? forward : forward + forward;
+    }
+
+    // time is in [0, period)
+    BasicVec2<T> offsetAt(T time, T period) const noexcept {
+        if (loop == KinematicLoop::PING_PONG) {
+            T forward = period / T(2);
+            if (time > forward) {
+                time = period - time;
+            }
+        }
+        size_t legs = legCount();
+        for (size_t i = 0; i < legs; i++) {
+            const auto& from = waypoints[i];
+            if (time < from.duration) {
+                const auto& to = waypoints[(i + 1) % waypoints.size()];
+                return from.offset + (to.offset - from.offset) * (time / from.duration);
+            }
+            time -= from.duration;
+        }
+        return waypoints[legs % waypoints.size()].offset;
+    }
+};
+
+template <typename T>
+struct BasicKinematicBody {
+    BasicAABB<T> rest;
+    BasicAABB<T> aabb;
+    // displacement during the last step, what a rider is carried by
+    BasicVec2<T> moved;
+    uint32_t path;
+    // position on the path, in [0, period)
+    T time;
+    // grid cells the box is listed in, inclusive
+    int32_t cx0;
+    int32_t cy0;
+    int32_t cx1;
+    int32_t cy1;
+};
+
+struct KinematicStats {
+    uint64_t steps = 0;
+    // bodies whose box moved into a different range of cells, the only ones the index is touched for
+    uint64_t cellRangeChanges = 0;
+};
+
+// Solids moving along scripted paths, indexed by a sparse hashed grid. A step only touches the cells of bodies that
+// left or entered one, so hundreds of platforms cost about as much as moving their boxes.
+template <typename T>
+class BasicKinematicSet {
+public:
+    static inline constexpr float DEFAULT_CELL_SIZE = 256.0f;
+
+private:
+    struct Path {
+        BasicKinematicPath<T> path;
+        T period;
+    };
+
+    std::vector<Path> paths{};
+    std::vector<BasicKinematicBody<T>> _bodies{};
+    float cellSize = DEFAULT_CELL_SIZE;
+    // emptied cells keep their storage, bodies moving back and forth keep using the same ones
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells{};
+    uint64_t _version = 0;
+    KinematicStats _stats{};
+
+public:
+    BasicKinematicSet() = default;
+
+    explicit BasicKinematicSet(float cellSize) : cellSize(cellSize) {
+        if (!(cellSize > 0.0f)) {
+            throw std::runtime_error("kinematic cell size must be positive");
+        }
+    }
+
+    uint32_t addPath(BasicKinematicPath<T> path) {
+        if (path.waypoints.empty()) {
+            throw std::runtime_error("kinematic path has no waypoints");
+        }
+        for (size_t i = 0; i < path.legCount(); i++) {
+            if (!(path.waypoints[i].duration > T(0))) {
+                throw std::runtime_error("kinematic path segment " + std::to_string(i) + " has no duration");
+            }
+        }
+        T period = path.period();
+        paths.push_back({std::move(path), period});
+        return static_cast<uint32_t>(paths.size() - 1);
+    }
+
+    // phase is how far along its path the body starts, in milliseconds
+    uint32_t add(const BasicAABB<T>& rest, uint32_t path, T phase = T(0)) {
+        if (path >= paths.size()) {
+            throw std::runtime_error("unknown kinematic path " + std::to_string(path));
+        }
+        BasicKinematicBody<T> body{};
+        body.rest = rest;
+        body.path = path;
+        body.time = wrap(phase, paths[path].period);
+        BasicVec2<T> offset = paths[path].path.offsetAt(body.time, paths[path].period);
+        body.aabb = {rest.v0() + offset, rest.v1() + offset};
+        cellRange(AABB(body.aabb), body.cx0, body.cy0, body.cx1, body.cy1);
+
+        auto index = static_cast<uint32_t>(_bodies.size());
+        _bodies.push_back(body);
+        forEachCell(body.cx0, body.cy0, body.cx1, body.cy1, [&](uint64_t key) { cells[key].push_back(index); });
+        markMoved();
+        return index;
+    }
+
+    void clear() {
+        paths.clear();
+        _bodies.clear();
+        cells.clear();
+        markMoved();
+    }
+
+    bool empty() const noexcept {
+        return _bodies.empty();
+    }
+
+    uint32_t size() const noexcept {
+        return static_cast<uint32_t>(_bodies.size());
+    }
+
+    const std::vector<BasicKinematicBody<T>>& bodies() const noexcept {
+        return _bodies;
+    }
+
+    // changes whenever a body moves, unique across sets like World::levelVersion
+    uint64_t version() const noexcept {
+        return _version;
+    }
+
+    const KinematicStats& stats() const noexcept {
+        return _stats;
+    }
+
+    void step(T delta) {
+        bool anyMoved = false;
+        for (uint32_t i = 0; i < _bodies.size(); i++) {
+            auto& body = _bodies[i];
+            const auto& path = paths[body.path];
+            body.time = wrap(body.time + delta, path.period);
+
+            // positions come from the path rather than adding up per step moves, so nothing drifts
+            BasicVec2<T> offset = path.path.offsetAt(body.time, path.period);
+            BasicAABB<T> aabb(body.rest.v0() + offset, body.rest.v1() + offset);
+            body.moved = aabb.v0() - body.aabb.v0();
+            if (body.moved == BasicVec2<T>(T(0), T(0))) {
+                continue;
+            }
+            body.aabb = aabb;
+            anyMoved = true;
+
+            int32_t cx0, cy0, cx1, cy1;
+            cellRange(AABB(aabb), cx0, cy0, cx1, cy1);
+            if (cx0 != body.cx0 || cy0 != body.cy0 || cx1 != body.cx1 || cy1 != body.cy1) {
+                relist(i, cx0, cy0, cx1, cy1);
+            }
+        }
+        _stats.steps++;
+        if (anyMoved) {
+            markMoved();
+        }
+    }
+
+    // Replaces out with the indices of bodies whose cells overlap region, ascending and without duplicates. Like
+    // SpatialGrid::query the cells are a conservative filter.
+    void query(const AABB& region, std::vector<uint32_t>& out) const {
+        out.clear();
+        int32_t cx0, cy0, cx1, cy1;
+        cellRange(region, cx0, cy0, cx1, cy1);
+
+        // a region wider than the occupied cells is cheaper to answer by walking them
+        auto cols = static_cast<uint64_t>(static_cast<int64_t>(cx1) - cx0 + 1);
+        auto rows = static_cast<uint64_t>(static_cast<int64_t>(cy1) - cy0 + 1);
+        if (cols * rows > cells.size()) {
+            for (const auto& [key, items] : cells) {
+                auto cx = static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+                auto cy = static_cast<int32_t>(static_cast<uint32_t>(key));
+                if (cx0 <= cx && cx <= cx1 && cy0 <= cy && cy <= cy1) {
+                    out.insert(out.end(), items.begin(), items.end());
+                }
+            }
+        } else {
+            forEachCell(cx0, cy0, cx1, cy1, [&](uint64_t key) {
+                auto it = cells.find(key);
+                if (it != cells.end()) {
+                    out.insert(out.end(), it->second.begin(), it->second.end());
+                }
+            });
+        }
+
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    // Drops and rebuilds the whole index, what step avoids doing every tick
+    void rebuildCells() {
+        cells.clear();
+        for (uint32_t i = 0; i < _bodies.size(); i++) {
+            auto& body = _bodies[i];
+            cellRange(AABB(body.aabb), body.cx0, body.cy0, body.cx1, body.cy1);
+            forEachCell(body.cx0, body.cy0, body.cx1, body.cy1, [&](uint64_t key) { cells[key].push_back(i); });
+        }
+    }
+
+private:
+    // in [0, period) in constant time, however far time is from it
+    static T wrap(T time, T period) noexcept {
+        if (!(period > T(0))) {
+            return T(0);
+        }
+        if constexpr (std::is_same_v<T, Fixed>) {
+            int32_t raw = time.raw() % period.raw();
+            return Fixed::fromRaw(raw < 0 ? raw + period.raw() : raw);
+        } else {
+            if (!std::isfinite(time)) {
+                return T(0);
+            }
+            time = std::fmod(time, period);
+            if (time < T(0)) {
+                time += period;
+            }
+            // a tiny negative remainder rounds up to period itself
+            return time < period ? time : T(0);
+        }
+    }
+
+    void markMoved() noexcept {
+        static std::atomic<uint64_t> lastVersion{0};
+        _version = lastVersion.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    int32_t cellOf(float v) const noexcept {
+        float cell = std::floor(v / cellSize);
+        if (!(cell > -1e9f)) {
+            return -1000000000;
+        }
+        if (cell > 1e9f) {
+            return 1000000000;
+        }
+        return static_cast<int32_t>(cell);
+    }
+
+    // cells come from the float box also for Fixed, queries of Fixed worlds are padded to cover the rounding
+    void cellRange(const AABB& aabb, int32_t& cx0, int32_t& cy0, int32_t& cx1, int32_t& cy1) const noexcept {
+        cx0 = cellOf(aabb.v0().x);
+        cy0 = cellOf(aabb.v0().y);
+        cx1 = cellOf(aabb.v1().x);
+        cy1 = cellOf(aabb.v1().y);
+    }
+
+    static uint64_t cellKey(int32_t cx, int32_t cy) noexcept {
+        return static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32 | static_cast<uint32_t>(cy);
+    }
+
+    template <typename F>
+    static void forEachCell(int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1, F&& f) {
+        for (int32_t cy = cy0; cy <= cy1; cy++) {
+            for (int32_t cx = cx0; cx <= cx1; cx++) {
+                f(cellKey(cx, cy));
+            }
+        }
+    }
+
+    // cells only the old range covers lose the body, cells only the new one covers gain it
+    void relist(uint32_t i, int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1) {
+        auto& body = _bodies[i];
+        for (int32_t cy = body.cy0; cy <= body.cy1; cy++) {
+            for (int32_t cx = body.cx0; cx <= body.cx1; cx++) {
+                if (cx0 <= cx && cx <= cx1 && cy0 <= cy && cy <= cy1) {
+                    continue;
+                }
+                auto& items = cells[cellKey(cx, cy)];
+                auto it = std::find(items.begin(), items.end(), i);
+                if (it != items.end()) {
+                    *it = items.back();
+                    items.pop_back();
+                }
+            }
+        }
+        for (int32_t cy = cy0; cy <= cy1; cy++) {
+            for (int32_t cx = cx0; cx <= cx1; cx++) {
+                if (!(body.cx0 <= cx && cx <= body.cx1 && body.cy0 <= cy && cy <= body.cy1)) {
+                    cells[cellKey(cx, cy)].push_back(i);
+                }
+            }
+        }
+        body.cx0 = cx0;
+        body.cy0 = cy0;
+        body.cx1 = cx1;
+        body.cy1 = cy1;
+        _stats.cellRangeChanges++;
+    }
+};
+
+using KinematicWaypoint = BasicKinematicWaypoint<float>;
+using KinematicPath = BasicKinematicPath<float>;
+using KinematicBody = BasicKinematicBody<float>;
+using KinematicSet = BasicKinematicSet<float>;
@@ -0,0 +1,349 @@
+#include "level.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "solid_merge.h"
+#include "../platform/mapped_file.h"
+
+static_assert(std::is_trivially_copyable_v<LevelFileHeader>);
+static_assert(sizeof(LevelFileHeader) == 224, "level header layout changed, bump LEVEL_FORMAT_VERSION");
+static_assert(sizeof(SpawnPoint) == 8);
+static_assert(sizeof(TileBlock) == 1152);
+
+static bool isSolidTileChar(char c) noexcept {
+    return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+LevelDescription parseLevelText(std::istream& in) {
+    LevelDescription description;
+    std::string line;
+    uint32_t lineNumber = 0;
+
+    while (std::getline(in, line)) {
+        lineNumber++;
+        auto comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.resize(comment);
+        }
+
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword)) {
+            continue;
+        }
+
+        bool ok;
+        if (keyword == "solid") {
+            float x0, x1, y0, y1;
+            ok = static_cast<bool>(words >> x0 >> x1 >> y0 >> y1) && x0 <= x1 && y0 <= y1;
+            if (ok) {
+                description.solids.emplace_back(x0, x1, y0, y1);
+            }
+        } else if (keyword == "spawn") {
+            SpawnPoint spawn{};
+            ok = static_cast<bool>(words >> spawn.x >> spawn.y);
+            if (ok) {
+                description.spawns.push_back(spawn);
+            }
+        } else if (keyword == "grid") {
+            ok = static_cast<bool>(words >> description.gridCellSize) && description.gridCellSize > 0.0f;
+        } else if (keyword == "tiles") {
+            ok = static_cast<bool>(words >> description.tileOriginX >> description.tileOriginY >> description.tileSize) &&
+                 description.tileSize > 0.0f;
+        } else if (keyword == "tilerow") {
+            int32_t ty, tx;
+            std::string row;
+            ok = static_cast<bool>(words >> ty >> tx >> row) && description.tileSize > 0.0f;
+            for (size_t i = 0; ok && i < row.size(); i++) {
+                if (row[i] != '.') {
+                    description.tiles.push_back({tx + static_cast<int32_t>(i), ty, static_cast<uint8_t>(row[i]), isSolidTileChar(row[i])});
+                }
+            }
+        } else {
+            throw std::runtime_error("level line " + std::to_string(lineNumber) + ": unknown keyword " + keyword);
+        }
+
+        std::string rest;
+        if (!ok || (words >> rest)) {
+            throw std::runtime_error("level line " + std::to_string(lineNumber) + ": malformed " + keyword);
+        }
+    }
+
+    return description;
+}
+
+void writeLevelText(std::ostream& out, const LevelDescription& description) {
+    // enough digits for the text to read back to the same floats
+    out.precision(std::numeric_limits<float>::max_digits10);
+    if (description.gridCellSize > 0.0f) {
+        out << "grid " << description.gridCellSize << '\n';
+    }
+    for (const auto& spawn : description.spawns) {
+        out << "spawn " << spawn.x << ' ' << spawn.y << '\n';
+    }
+    for (const auto& solid : description.solids) {
+        out << "solid " << solid.v0().x << ' ' << solid.v1().x << ' ' << solid.v0().y << ' ' << solid.v1().y << '\n';
+    }
+
+    if (description.tileSize > 0.0f && !description.tiles.empty()) {
+        out << "tiles " << description.tileOriginX << ' ' << description.tileOriginY << ' ' << description.tileSize << '\n';
+
+        auto tiles = description.tiles;
+        std::sort(tiles.begin(), tiles.end(), [](const TilePlacement& a, const TilePlacement& b) {
+            return a.ty != b.ty ? a.ty < b.ty : a.tx < b.tx;
+        });
+        for (size_t i = 0; i < tiles.size();) {
+            size_t end = i + 1;
+            while (end < tiles.size() && tiles[end].ty == tiles[i].ty) {
+                end++;
+            }
+            std::string row(static_cast<size_t>(tiles[end - 1].tx - tiles[i].tx + 1), '.');
+            for (size_t j = i; j < end; j++) {
+                row[static_cast<size_t>(tiles[j].tx - tiles[i].tx)] = static_cast<char>(tiles[j].id);
+            }
+            out << "tilerow " << tiles[i].ty << ' ' << tiles[i].tx << ' ' << row << '\n';
+            i = end;
+        }
+    }
+}
+
+std::vector<uint8_t> serializeLevel(const LevelDescription& description) {
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("level files can only be written on little-endian hosts");
+    }
+
+    StaticGeometryBuilder builder;
+    builder.build(description.solids, description.gridCellSize);
+
+    TileMapBuilder tiles;
+    if (description.tileSize > 0.0f) {
+        tiles.build(description.tiles, description.tileOriginX, description.tileOriginY, description.tileSize);
+    }
+
+    LevelFileHeader header{};
+    memcpy(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+    header.version = LEVEL_FORMAT_VERSION;
+    header.solidCount = static_cast<uint32_t>(builder.x0.size());
+    header.spawnCount = static_cast<uint32_t>(description.spawns.size());
+    header.gridOriginX = builder.gridOriginX;
+    header.gridOriginY = builder.gridOriginY;
+    header.gridCellSize = builder.gridCellSize;
+    header.gridCols = builder.gridCols;
+    header.gridRows = builder.gridRows;
+    header.gridItemCount = static_cast<uint32_t>(builder.cellItems.size());
+    header.tileOriginX = tiles.originX;
+    header.tileOriginY = tiles.originY;
+    header.tileSize = tiles.tileSize;
+    header.tileBlockX0 = tiles.blockX0;
+    header.tileBlockY0 = tiles.blockY0;
+    header.tileBlockCols = tiles.blockCols;
+    header.tileBlockRows = tiles.blockRows;
+    header.tileBlockCount = static_cast<uint32_t>(tiles.blocks.size());
+
+    const void* sources[LEVEL_SECTION_COUNT] = {
+        builder.x0.data(),
+        builder.x1.data(),
+        builder.y0.data(),
+        builder.y1.data(),
+        builder.cellStart.data(),
+        builder.cellItems.data(),
+        description.spawns.data(),
+        tiles.blockIndex.data(),
+        tiles.blocks.data(),
+    };
+    uint64_t sizes[LEVEL_SECTION_COUNT] = {
+        sizeof(float) * builder.x0.size(),
+        sizeof(float) * builder.x1.size(),
+        sizeof(float) * builder.y0.size(),
+        sizeof(float) * builder.y1.size(),
+        sizeof(uint32_t) * builder.cellStart.size(),
+        sizeof(uint32_t) * builder.cellItems.size(),
+        sizeof(SpawnPoint) * description.spawns.size(),
+        sizeof(uint32_t) * tiles.blockIndex.size(),
+        sizeof(TileBlock) * tiles.blocks.size(),
+    };
+
+    uint64_t offset = alignSection(sizeof(LevelFileHeader));
+    for (uint32_t i = 0; i < LEVEL_SECTION_COUNT; i++) {
+        header.sections[i] = {offset, sizes[i]};
+        offset = alignSection(offset + sizes[i]);
+    }
+    header.fileSize = offset;
+
+    std::vector<uint8_t> bytes(offset, 0);
+    memcpy(bytes.data(), &header, sizeof(header));
+    for (uint32_t i = 0; i < LEVEL_SECTION_COUNT; i++) {
+        if (sizes[i] != 0) {
+            memcpy(bytes.data() + header.sections[i].offset, sources[i], sizes[i]);
+        }
+    }
+    return bytes;
+}
+
+std::shared_ptr<const Level> Level::map(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(MappedFile::open(path));
+    const uint8_t* data = file->data();
+    size_t size = file->size();
+    try {
+        return fromMemory(std::move(file), data, size);
+    } catch (const std::runtime_error& error) {
+        throw std::runtime_error(path + ": " + error.what());
+    }
+}
+
+std::shared_ptr<const Level> Level::fromBytes(std::vector<uint8_t> bytes) {
+    auto owned = std::make_shared<std::vector<uint8_t>>(std::move(bytes));
+    const uint8_t* data = owned->data();
+    size_t size = owned->size();
+    return fromMemory(std::move(owned), data, size);
+}
+
+std::shared_ptr<const Level> Level::build(const LevelDescription& description) {
+    LevelDescription baked = description;
+    mergeSolids(baked.solids);
+    return fromBytes(serializeLevel(baked));
+}
+
+std::shared_ptr<const Level> Level::builtIn() {
+    LevelDescription description;
+    description.solids.emplace_back(100, 900, 200, 250);
+    description.spawns.push_back({150, 300});
+    return build(description);
+}
+
+std::shared_ptr<const Level> Level::fromMemory(std::shared_ptr<const void> backing, const uint8_t* data, size_t size) {
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("level files can only be loaded on little-endian hosts");
+    }
+    if (size < sizeof(LevelFileHeader)) {
+        throw std::runtime_error("level file is truncated");
+    }
+
+    // the header is small, copy it out instead of relying on the mapping alignment
+    LevelFileHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0) {
+        throw std::runtime_error("not a level file");
+    }
+    if (header.version != LEVEL_FORMAT_VERSION) {
+        throw std::runtime_error("unsupported level format version " + std::to_string(header.version));
+    }
+    if (header.fileSize != size) {
+        throw std::runtime_error("level file size does not match its header");
+    }
+    if (header.solidCount != 0 && (header.gridCols == 0 || header.gridRows == 0 || !(header.gridCellSize > 0.0f))) {
+        throw std::runtime_error("level file has no spatial index");
+    }
+
+    uint64_t cellCount = static_cast<uint64_t>(header.gridCols) * header.gridRows;
+    if (cellCount >= std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("level file spatial index is too large");
+    }
+
+    uint64_t tileBlockIndexCount = static_cast<uint64_t>(header.tileBlockCols) * header.tileBlockRows;
+    if (tileBlockIndexCount != 0 && !(header.tileSize > 0.0f)) {
+        throw std::runtime_error("level file tile layer has no tile size");
+    }
+    uint64_t expectedSizes[LEVEL_SECTION_COUNT] = {
+        sizeof(float) * static_cast<uint64_t>(header.solidCount),
+        sizeof(float) * static_cast<uint64_t>(header.solidCount),
+        sizeof(float) * static_cast<uint64_t>(header.solidCount),
+        sizeof(float) * static_cast<uint64_t>(header.solidCount),
+        sizeof(uint32_t) * (cellCount != 0 ? cellCount + 1 : 0),
+        sizeof(uint32_t) * static_cast<uint64_t>(header.gridItemCount),
+        sizeof(SpawnPoint) * static_cast<uint64_t>(header.spawnCount),
+        sizeof(uint32_t) * tileBlockIndexCount,
+        sizeof(TileBlock) * static_cast<uint64_t>(header.tileBlockCount),
+    };
+
+    for (uint32_t i = 0; i < LEVEL_SECTION_COUNT; i++) {
+        const LevelSection& section = header.sections[i];
+        if (section.size != expectedSizes[i] || section.offset % LEVEL_SECTION_ALIGNMENT != 0 || section.offset > size ||
+            section.size > size - section.offset) {
+            throw std::runtime_error("level file section " + std::to_string(i) + " is out of bounds");
+        }
+    }
+
+    auto section = [&](LevelSectionId id) { return data + header.sections[id].offset; };
+
+    // the CSR ends must agree with the item count, per cell ranges are checked by validate() below
+    const auto* cellStart = reinterpret_cast<const uint32_t*>(section(LEVEL_SECTION_GRID_CELL_START));
+    if (cellCount != 0 && (cellStart[0] != 0 || cellStart[cellCount] != header.gridItemCount)) {
+        throw std::runtime_error("level file spatial index is corrupted");
+    }
+
+    std::shared_ptr<Level> level(new Level());
+    level->backing = std::move(backing);
+
+    auto& solids = level->_geometry.solids;
+    solids.count = header.solidCount;
+    solids.x0 = reinterpret_cast<const float*>(section(LEVEL_SECTION_SOLIDS_X0));
+    solids.x1 = reinterpret_cast<const float*>(section(LEVEL_SECTION_SOLIDS_X1));
+    solids.y0 = reinterpret_cast<const float*>(section(LEVEL_SECTION_SOLIDS_Y0));
+    solids.y1 = reinterpret_cast<const float*>(section(LEVEL_SECTION_SOLIDS_Y1));
+
+    auto& grid = level->_geometry.grid;
+    grid.originX = header.gridOriginX;
+    grid.originY = header.gridOriginY;
+    grid.cellSize = header.gridCellSize;
+    grid.cols = cellCount != 0 ? header.gridCols : 0;
+    grid.rows = cellCount != 0 ? header.gridRows : 0;
+    grid.cellStart = cellStart;
+    grid.cellItems = reinterpret_cast<const uint32_t*>(section(LEVEL_SECTION_GRID_ITEMS));
+
+    auto& tiles = level->_geometry.tiles;
+    tiles.originX = header.tileOriginX;
+    tiles.originY = header.tileOriginY;
+    tiles.tileSize = tileBlockIndexCount != 0 ? header.tileSize : 1.0f;
+    tiles.blockX0 = header.tileBlockX0;
+    tiles.blockY0 = header.tileBlockY0;
+    tiles.blockCols = tileBlockIndexCount != 0 ? header.tileBlockCols : 0;
+    tiles.blockRows = tileBlockIndexCount != 0 ? header.tileBlockRows : 0;
+    tiles.blockCount = header.tileBlockCount;
+    tiles.blockIndex = reinterpret_cast<const uint32_t*>(section(LEVEL_SECTION_TILE_BLOCK_INDEX));
+    tiles.blocks = reinterpret_cast<const TileBlock*>(section(LEVEL_SECTION_TILE_BLOCKS));
+
+    level->_spawns = reinterpret_cast<const SpawnPoint*>(section(LEVEL_SECTION_SPAWNS));
+    level->_spawnCount = header.spawnCount;
+
+    // a truncated or corrupted file must fail here rather than with reads out of bounds during play
+    level->validate();
+    return level;
+}
+
+void Level::validate() const {
+    const auto& solids = _geometry.solids;
+    const auto& grid = _geometry.grid;
+
+    for (uint32_t i = 0; i < solids.count; i++) {
+        if (!(solids.x0[i] <= solids.x1[i] && solids.y0[i] <= solids.y1[i])) {
+            throw std::runtime_error("level solid " + std::to_string(i) + " is inverted or not finite");
+        }
+    }
+
+    for (uint32_t c = 0; c < grid.cellCount(); c++) {
+        uint32_t begin = grid.cellStart[c];
+        uint32_t end = grid.cellStart[c + 1];
+        if (begin > end) {
+            throw std::runtime_error("level grid cell " + std::to_string(c) + " has a negative range");
+        }
+        for (uint32_t i = begin; i < end; i++) {
+            if (grid.cellItems[i] >= solids.count || (i != begin && grid.cellItems[i] <= grid.cellItems[i - 1])) {
+                throw std::runtime_error("level grid cell " + std::to_string(c) + " is not a sorted list of solids");
+            }
+        }
+    }
+
+    const auto& tiles = _geometry.tiles;
+    for (uint32_t b = 0; b < tiles.blockCols * tiles.blockRows; b++) {
+        if (tiles.blockIndex[b] != TILE_BLOCK_EMPTY && tiles.blockIndex[b] >= tiles.blockCount) {
+            throw std::runtime_error("level tile block " + std::to_string(b) + " is out of range");
+        }
+    }
+}
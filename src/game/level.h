@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "solid.h"
+#include "static_geometry.h"
+#include "tilemap.h"
+
+// Binary level file, version 2. All values are little-endian, sections start on LEVEL_SECTION_ALIGNMENT
+// boundaries so that the SoA arrays can be used in place from a memory mapping.
+//
+//   LevelFileHeader
+//   SOLIDS_X0 .. SOLIDS_Y1   float[solidCount] each
+//   GRID_CELL_START          uint32[gridCols * gridRows + 1]
+//   GRID_ITEMS               uint32[gridItemCount]
+//   SPAWNS                   SpawnPoint[spawnCount]
+//   TILE_BLOCK_INDEX         uint32[tileBlockCols * tileBlockRows]
+//   TILE_BLOCKS              TileBlock[tileBlockCount]
+
+inline constexpr char LEVEL_MAGIC[4] = {'P', 'L', 'V', 'L'};
+inline constexpr uint32_t LEVEL_FORMAT_VERSION = 2;
+inline constexpr uint64_t LEVEL_SECTION_ALIGNMENT = 64;
+
+enum LevelSectionId : uint32_t {
+    LEVEL_SECTION_SOLIDS_X0,
+    LEVEL_SECTION_SOLIDS_X1,
+    LEVEL_SECTION_SOLIDS_Y0,
+    LEVEL_SECTION_SOLIDS_Y1,
+    LEVEL_SECTION_GRID_CELL_START,
+    LEVEL_SECTION_GRID_ITEMS,
+    LEVEL_SECTION_SPAWNS,
+    LEVEL_SECTION_TILE_BLOCK_INDEX,
+    LEVEL_SECTION_TILE_BLOCKS,
+    LEVEL_SECTION_COUNT,
+};
+
+struct LevelSection {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct LevelFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t fileSize;
+
+    uint32_t solidCount;
+    uint32_t spawnCount;
+
+    float gridOriginX;
+    float gridOriginY;
+    float gridCellSize;
+    uint32_t gridCols;
+    uint32_t gridRows;
+    uint32_t gridItemCount;
+
+    float tileOriginX;
+    float tileOriginY;
+    float tileSize;
+    int32_t tileBlockX0;
+    int32_t tileBlockY0;
+    uint32_t tileBlockCols;
+    uint32_t tileBlockRows;
+    uint32_t tileBlockCount;
+
+    LevelSection sections[LEVEL_SECTION_COUNT];
+};
+
+inline bool hostIsLittleEndian() noexcept {
+    uint16_t probe = 1;
+    uint8_t firstByte;
+    memcpy(&firstByte, &probe, 1);
+    return firstByte == 1;
+}
+
+inline uint64_t alignSection(uint64_t offset) noexcept {
+    return (offset + LEVEL_SECTION_ALIGNMENT - 1) & ~(LEVEL_SECTION_ALIGNMENT - 1);
+}
+
+struct SpawnPoint {
+    float x;
+    float y;
+};
+
+// Human-editable form of a level, see parseLevelText for the syntax.
+struct LevelDescription {
+    std::vector<Solid> solids{};
+    std::vector<SpawnPoint> spawns{};
+
+    // a single tile layer, tileSize <= 0 when the level has none
+    float tileOriginX = 0.0f;
+    float tileOriginY = 0.0f;
+    float tileSize = 0.0f;
+    std::vector<TilePlacement> tiles{};
+
+    // <= 0 lets the builder pick one
+    float gridCellSize = 0.0f;
+};
+
+// Line based text format, '#' starts a comment:
+//   solid <x0> <x1> <y0> <y1>
+//   spawn <x> <y>
+//   grid <cellSize>
+//   tiles <originX> <originY> <tileSize>
+//   tilerow <ty> <tx> <row>
+// Each row character is one tile starting at tx: '.' is empty, uppercase letters and digits are solid
+// tiles and other printable characters are decoration. The tile id is the character code.
+LevelDescription parseLevelText(std::istream& in);
+
+void writeLevelText(std::ostream& out, const LevelDescription& description);
+
+std::vector<uint8_t> serializeLevel(const LevelDescription& description);
+
+// Immutable static part of a level. The geometry points straight into the backing memory, which is
+// either a mapped file or a serialized buffer, so one Level can be shared between any number of worlds.
+class Level {
+    std::shared_ptr<const void> backing{};
+    StaticGeometry _geometry{};
+    const SpawnPoint* _spawns = nullptr;
+    uint32_t _spawnCount = 0;
+
+    Level() = default;
+
+public:
+    // Maps the file and validates it like validate(), loading never hands out a level that could read out of bounds
+    static std::shared_ptr<const Level> map(const std::string& path);
+
+    static std::shared_ptr<const Level> fromBytes(std::vector<uint8_t> bytes);
+
+    // Bakes the description the way level_convert does, merging solids, and loads the result
+    static std::shared_ptr<const Level> build(const LevelDescription& description);
+
+    // The level Game() builds for the windowed client when it has no level file
+    static std::shared_ptr<const Level> builtIn();
+
+    const StaticGeometry& geometry() const noexcept {
+        return _geometry;
+    }
+
+    const SpawnPoint* spawns() const noexcept {
+        return _spawns;
+    }
+
+    uint32_t spawnCount() const noexcept {
+        return _spawnCount;
+    }
+
+    // Conservative bounds of all solids, the extent of the spatial index
+    AABB bounds() const noexcept {
+        const auto& grid = _geometry.grid;
+        AABB gridBounds(
+            grid.originX,
+            grid.originX + static_cast<float>(grid.cols) * grid.cellSize,
+            grid.originY,
+            grid.originY + static_cast<float>(grid.rows) * grid.cellSize
+        );
+        if (_geometry.tiles.isEmpty()) {
+            return gridBounds;
+        }
+
+        AABB tileBounds = _geometry.tiles.bounds();
+        if (grid.isEmpty()) {
+            return tileBounds;
+        }
+        return {
+            std::min(gridBounds.v0().x, tileBounds.v0().x),
+            std::max(gridBounds.v1().x, tileBounds.v1().x),
+            std::min(gridBounds.v0().y, tileBounds.v0().y),
+            std::max(gridBounds.v1().y, tileBounds.v1().y),
+        };
+    }
+
+    // Full O(n) check of the solids, the grid index and the tile block table. Every load runs it, so files from disk
+    // and chunks from a stream are covered.
+    void validate() const;
+
+private:
+    static std::shared_ptr<const Level> fromMemory(std::shared_ptr<const void> backing, const uint8_t* data, size_t size);
+};
@@ -2,38 +2,39 @@
 
 #include "AABB.h"
 
-class Player {
-    Vec2 _pos;
-    Vec2 _vel;
+template <typename T>
+class BasicPlayer {
+    BasicVec2<T> _pos;
+    BasicVec2<T> _vel;
     bool onGround = false;
 
 public:
-    static inline constexpr Vec2 SIZE = {100.0f, 100.0f};
-    static inline constexpr Vec2 HALF_SIZE = {50.0f, 50.0f};
+    static inline constexpr BasicVec2<T> SIZE = {T(100.0f), T(100.0f)};
+    static inline constexpr BasicVec2<T> HALF_SIZE = {T(50.0f), T(50.0f)};
 
-    Player() : _pos(), _vel() {}
+    BasicPlayer() : _pos(), _vel() {}
 
     // AABB
 
-    AABB aabb() const {
+    BasicAABB<T> aabb() const {
         return {-HALF_SIZE + _pos, HALF_SIZE + _pos};
     }
 
     // POS
 
-    const Vec2& pos() const {
+    const BasicVec2<T>& pos() const {
         return _pos;
     }
 
-    Vec2& pos() {
+    BasicVec2<T>& pos() {
         return _pos;
     }
 
-    void setPos(Vec2 pos) {
+    void setPos(BasicVec2<T> pos) {
         _pos = pos;
     }
 
-    void setPos(float x, float y) {
+    void setPos(T x, T y) {
         setPos({x, y});
     }
 
@@ -49,15 +50,21 @@ public:
 
     // VEL
 
-    const Vec2& vel() const {
+    const BasicVec2<T>& vel() const {
         return _vel;
     }
 
-    Vec2& vel() {
+    BasicVec2<T>& vel() {
         return _vel;
     }
 
-    void setVel(Vec2 vel) {
+    void setVel(BasicVec2<T> vel) {
         _vel = vel;
     }
 };
+
+// Marks the body Game's controls move. World's bodies are entities with a BasicPlayer component, and the player is
+// the one that also has this.
+struct PlayerControlled {};
+
+using Player = BasicPlayer<float>;
@@ -4,14 +4,17 @@
 
 #include "solid.h"
 
-inline bool doRayCast2D(const AABB& object, Vec2 rayOrigin, Vec2 rayDir, Vec2& contactPoint, Vec2& contactNormal, float& tNear) noexcept {
-    Vec2 pos0 = object.v0() - rayOrigin;
-    Vec2 pos = object.v1() - rayOrigin;
-
-    float nearY = pos0.x / rayDir.x;
-    float nearX = pos.y / rayDir.y;
-    float farY = pos.x / rayDir.x;
-    float farX = pos0.y / rayDir.y;
+// A zero direction component relies on division by zero giving an infinity, which Fixed imitates
+template <typename T>
+inline bool doRayCast2D(const BasicAABB<T>& object, BasicVec2<T> rayOrigin, BasicVec2<T> rayDir, BasicVec2<T>& contactPoint,
+                        BasicVec2<T>& contactNormal, T& tNear) noexcept {
+    BasicVec2<T> pos0 = object.v0() - rayOrigin;
+    BasicVec2<T> pos = object.v1() - rayOrigin;
+
+    T nearY = pos0.x / rayDir.x;
+    T nearX = pos.y / rayDir.y;
+    T farY = pos.x / rayDir.x;
+    T farX = pos0.y / rayDir.y;
 
     if (nearX > farX) {
         std::swap(nearX, farX);
@@ -25,9 +28,9 @@ inline bool doRayCast2D(const AABB& object, Vec2 rayOrigin, Vec2 rayDir, Vec2& c
     }
 
     tNear = std::max(nearX, nearY);
-    float tFar = std::min(farX, farY);
+    T tFar = std::min(farX, farY);
 
-    if (tNear < 0.0f || tFar < 0.0f) {
+    if (tNear < T(0) || tFar < T(0)) {
         return false;
     }
 
@@ -35,9 +38,9 @@ inline bool doRayCast2D(const AABB& object, Vec2 rayOrigin, Vec2 rayDir, Vec2& c
     contactPoint.y = rayOrigin.y + tNear * rayDir.y;
 
     if (nearY >= nearX) {
-        contactNormal = rayDir.x < 0 ? Vec2(1.0f, 0.0f) : Vec2(-1.0f, 0.0f);
+        contactNormal = rayDir.x < T(0) ? BasicVec2<T>(T(1), T(0)) : BasicVec2<T>(T(-1), T(0));
     } else {
-        contactNormal = rayDir.y < 0 ? Vec2(0.0f, 1.0f) : Vec2(0.0f, -1.0f);
+        contactNormal = rayDir.y < T(0) ? BasicVec2<T>(T(0), T(1)) : BasicVec2<T>(T(0), T(-1));
     }
 
     return true;
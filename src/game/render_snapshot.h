@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AABB.h"
+#include "solid.h"
+#include "world.h"
+
+// Immutable view of a simulated frame handed from the simulation thread to the renderer.
+// Static geometry is shared between snapshots and only replaced when the world's level changes.
+struct RenderSnapshot {
+    uint64_t tick = 0;
+    uint64_t simTimeNs = 0;
+
+    // player first, then other dynamic bodies
+    std::vector<AABB> bodies{};
+    // projectiles are points, these are small squares around them
+    std::vector<AABB> projectiles{};
+
+    // moving platforms in the world's order, the renderer only rewrites the ones that moved
+    std::vector<AABB> kinematics{};
+    uint64_t kinematicsVersion = 0;
+
+    // freeform world objects, then the resident level chunks sorted by id
+    std::shared_ptr<const std::vector<Solid>> objects{};
+    std::shared_ptr<const std::vector<StaticChunk>> chunks{};
+    uint64_t levelVersion = 0;
+};
+
+class RenderSnapshotBuilder {
+    static inline constexpr Vec2 PROJECTILE_HALF_SIZE = {5.0f, 5.0f};
+
+    std::shared_ptr<const std::vector<Solid>> cachedObjects{};
+    std::shared_ptr<const std::vector<StaticChunk>> cachedChunks{};
+    uint64_t cachedLevelVersion = 0;
+
+public:
+    // Reuses the storage already owned by out, so steady state publishing does not allocate
+    void build(const World& world, uint64_t tick, uint64_t simTimeNs, RenderSnapshot& out) {
+        if (cachedObjects == nullptr || cachedLevelVersion != world.levelVersion) {
+            // streaming changes chunks far more often than objects, keep the objects identity when possible
+            if (cachedObjects == nullptr || !sameSolids(*cachedObjects, world.objects)) {
+                cachedObjects = std::make_shared<const std::vector<Solid>>(world.objects);
+            }
+            cachedChunks = std::make_shared<const std::vector<StaticChunk>>(world.chunks);
+            cachedLevelVersion = world.levelVersion;
+        }
+
+        out.tick = tick;
+        out.simTimeNs = simTimeNs;
+        out.bodies.clear();
+        world.entities.forEach<Player>([&](Entity, const Player& body) { out.bodies.push_back(body.aabb()); });
+        out.projectiles.clear();
+        world.projectiles.forEach([&](PoolHandle, const Projectile& projectile) {
+            out.projectiles.push_back({projectile.pos - PROJECTILE_HALF_SIZE, projectile.pos + PROJECTILE_HALF_SIZE});
+        });
+        // a reused snapshot may already hold this version
+        if (out.kinematicsVersion != world.kinematics.version()) {
+            out.kinematics.clear();
+            for (const auto& body : world.kinematics.bodies()) {
+                out.kinematics.push_back(body.aabb);
+            }
+            out.kinematicsVersion = world.kinematics.version();
+        }
+        out.objects = cachedObjects;
+        out.chunks = cachedChunks;
+        out.levelVersion = cachedLevelVersion;
+    }
+
+private:
+    static bool sameSolids(const std::vector<Solid>& a, const std::vector<Solid>& b) noexcept {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Solid& x, const Solid& y) {
+            return x.v0() == y.v0() && x.v1() == y.v1();
+        });
+    }
+};
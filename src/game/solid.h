@@ -2,41 +2,44 @@
 
 #include "AABB.h"
 
-class Solid {
-    AABB _aabb;
+template <typename T>
+class BasicSolid {
+    BasicAABB<T> _aabb;
 
 public:
-    Solid() : _aabb() {}
+    BasicSolid() : _aabb() {}
 
-    explicit Solid(AABB aabb) : _aabb(aabb) {}
+    explicit BasicSolid(BasicAABB<T> aabb) : _aabb(aabb) {}
 
-    Solid(float x0, float x1, float y0, float y1) : _aabb(x0, x1, y0, y1) {}
+    BasicSolid(T x0, T x1, T y0, T y1) : _aabb(x0, x1, y0, y1) {}
 
-    const AABB& aabb() const noexcept {
+    const BasicAABB<T>& aabb() const noexcept {
         return _aabb;
     }
 
-    AABB& aabb() noexcept {
+    BasicAABB<T>& aabb() noexcept {
         return _aabb;
     }
 
-    const Vec2& v0() const noexcept {
+    const BasicVec2<T>& v0() const noexcept {
         return _aabb.v0();
     }
 
-    Vec2& v0() noexcept {
+    BasicVec2<T>& v0() noexcept {
         return _aabb.v0();
     }
 
-    const Vec2& v1() const noexcept {
+    const BasicVec2<T>& v1() const noexcept {
         return _aabb.v1();
     }
 
-    Vec2& v1() noexcept {
+    BasicVec2<T>& v1() noexcept {
         return _aabb.v1();
     }
 
-    Vec2 size() const noexcept {
+    BasicVec2<T> size() const noexcept {
         return _aabb.size();
     }
 };
+
+using Solid = BasicSolid<float>;
@@ -0,0 +1,249 @@
+#include "solid_merge.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+
+#include "static_geometry.h"
+
+// a cluster with more cells than this, edges of thousands of unaligned boxes all touching, is only merged in runs
+static constexpr uint64_t MAX_MESH_CELLS = 1 << 22;
+
+static bool isWellFormed(const Solid& solid) noexcept {
+    return solid.v0().x <= solid.v1().x && solid.v0().y <= solid.v1().y;
+}
+
+static bool contains(const AABB& outer, const AABB& inner) noexcept {
+    return outer.v0().x <= inner.v0().x && inner.v1().x <= outer.v1().x && outer.v0().y <= inner.v0().y && inner.v1().y <= outer.v1().y;
+}
+
+static void dropContained(std::vector<Solid>& solids) {
+    StaticGeometryBuilder builder;
+    builder.build(solids);
+    StaticGeometry geometry = builder.view();
+
+    std::vector<uint32_t> candidates;
+    std::vector<bool> dropped(solids.size(), false);
+    for (uint32_t i = 0; i < solids.size(); i++) {
+        const AABB& inner = solids[i].aabb();
+        geometry.grid.query(inner, candidates);
+        for (uint32_t j : candidates) {
+            if (j == i || dropped[j] || !contains(solids[j].aabb(), inner)) {
+                continue;
+            }
+            // of two identical boxes the first one stays
+            if (contains(inner, solids[j].aabb()) && j > i) {
+                continue;
+            }
+            dropped[i] = true;
+            break;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < solids.size(); i++) {
+        if (!dropped[i]) {
+            solids[kept++] = solids[i];
+        }
+    }
+    solids.resize(kept);
+}
+
+// Merges boxes with the same extent on the other axis whose ranges on this axis touch or overlap, what is left to do
+// for clusters too large to mesh
+static bool mergeAlong(std::vector<Solid>& solids, bool alongX) {
+    auto key = [alongX](const Solid& s) {
+        return alongX ? std::make_tuple(s.v0().y, s.v1().y, s.v0().x, s.v1().x) : std::make_tuple(s.v0().x, s.v1().x, s.v0().y, s.v1().y);
+    };
+    std::sort(solids.begin(), solids.end(), [&](const Solid& a, const Solid& b) { return key(a) < key(b); });
+
+    size_t merged = 0;
+    for (size_t i = 0; i < solids.size(); i++) {
+        if (merged != 0) {
+            auto [low, high, start, end] = key(solids[merged - 1]);
+            auto [nextLow, nextHigh, nextStart, nextEnd] = key(solids[i]);
+            if (low == nextLow && high == nextHigh && nextStart <= end) {
+                if (nextEnd > end) {
+                    (alongX ? solids[merged - 1].v1().x : solids[merged - 1].v1().y) = nextEnd;
+                }
+                continue;
+            }
+        }
+        solids[merged++] = solids[i];
+    }
+
+    bool changed = merged != solids.size();
+    solids.resize(merged);
+    return changed;
+}
+
+static bool touches(const AABB& a, const AABB& b) noexcept {
+    return a.v0().x <= b.v1().x && b.v0().x <= a.v1().x && a.v0().y <= b.v1().y && b.v0().y <= a.v1().y;
+}
+
+static uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t i) noexcept {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Groups of solids that touch or overlap each other, the only ones a merged box can span
+static std::vector<std::vector<Solid>> touchingClusters(const std::vector<Solid>& solids) {
+    StaticGeometryBuilder builder;
+    builder.build(solids);
+    StaticGeometry geometry = builder.view();
+
+    std::vector<uint32_t> parent(solids.size());
+    for (uint32_t i = 0; i < solids.size(); i++) {
+        parent[i] = i;
+    }
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < solids.size(); i++) {
+        geometry.grid.query(solids[i].aabb(), candidates);
+        for (uint32_t j : candidates) {
+            if (j > i && touches(solids[i].aabb(), solids[j].aabb())) {
+                parent[findRoot(parent, j)] = findRoot(parent, i);
+            }
+        }
+    }
+
+    std::vector<std::vector<Solid>> clusters;
+    std::vector<uint32_t> clusterOf(solids.size(), UINT32_MAX);
+    for (uint32_t i = 0; i < solids.size(); i++) {
+        uint32_t root = findRoot(parent, i);
+        if (clusterOf[root] == UINT32_MAX) {
+            clusterOf[root] = static_cast<uint32_t>(clusters.size());
+            clusters.emplace_back();
+        }
+        clusters[clusterOf[root]].push_back(solids[i]);
+    }
+    return clusters;
+}
+
+static uint32_t edgeIndex(const std::vector<float>& edges, float v) noexcept {
+    return static_cast<uint32_t>(std::lower_bound(edges.begin(), edges.end(), v) - edges.begin());
+}
+
+// Greedy meshing over the grid the cluster's own edges make. Cells covered by any solid are taken row by row from the
+// bottom left: a box grows right as far as covered cells go, then up as long as the whole row above is covered. The
+// boxes do not overlap and cover exactly the cluster's area. Returns false, leaving out untouched, when the grid would
+// have more than MAX_MESH_CELLS cells.
+static bool meshCluster(const std::vector<Solid>& cluster, std::vector<Solid>& out) {
+    std::vector<float> xs, ys;
+    for (const auto& solid : cluster) {
+        xs.push_back(solid.v0().x);
+        xs.push_back(solid.v1().x);
+        ys.push_back(solid.v0().y);
+        ys.push_back(solid.v1().y);
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    size_t cols = xs.size() - 1;
+    size_t rows = ys.size() - 1;
+    if (static_cast<uint64_t>(cols) * rows > MAX_MESH_CELLS) {
+        return false;
+    }
+
+    // coverage counts through a 2D difference array, one pass per solid and one over the grid
+    size_t stride = cols + 1;
+    std::vector<int32_t> coverage(stride * (rows + 1), 0);
+    for (const auto& solid : cluster) {
+        uint32_t x0 = edgeIndex(xs, solid.v0().x), x1 = edgeIndex(xs, solid.v1().x);
+        uint32_t y0 = edgeIndex(ys, solid.v0().y), y1 = edgeIndex(ys, solid.v1().y);
+        coverage[y0 * stride + x0]++;
+        coverage[y0 * stride + x1]--;
+        coverage[y1 * stride + x0]--;
+        coverage[y1 * stride + x1]++;
+    }
+    std::vector<uint8_t> open(cols * rows);
+    for (size_t y = 0; y < rows; y++) {
+        for (size_t x = 0; x < cols; x++) {
+            size_t i = y * stride + x;
+            if (x != 0) {
+                coverage[i] += coverage[i - 1];
+            }
+            if (y != 0) {
+                coverage[i] += coverage[i - stride] - (x != 0 ? coverage[i - stride - 1] : 0);
+            }
+        }
+    }
+    for (size_t y = 0; y < rows; y++) {
+        for (size_t x = 0; x < cols; x++) {
+            open[y * cols + x] = coverage[y * stride + x] > 0;
+        }
+    }
+
+    for (size_t y = 0; y < rows; y++) {
+        for (size_t x = 0; x < cols; x++) {
+            if (!open[y * cols + x]) {
+                continue;
+            }
+            size_t width = 1;
+            while (x + width < cols && open[y * cols + x + width]) {
+                width++;
+            }
+            size_t height = 1;
+            while (y + height < rows) {
+                const uint8_t* row = &open[(y + height) * cols + x];
+                if (!std::all_of(row, row + width, [](uint8_t o) { return o != 0; })) {
+                    break;
+                }
+                height++;
+            }
+            for (size_t dy = 0; dy < height; dy++) {
+                std::fill_n(&open[(y + dy) * cols + x], width, 0);
+            }
+            out.emplace_back(xs[x], xs[x + width], ys[y], ys[y + height]);
+        }
+    }
+    return true;
+}
+
+static bool hasArea(const Solid& solid) noexcept {
+    return solid.v0().x < solid.v1().x && solid.v0().y < solid.v1().y;
+}
+
+SolidMergeStats mergeSolids(std::vector<Solid>& solids) {
+    SolidMergeStats stats;
+    stats.solidsBefore = static_cast<uint32_t>(solids.size());
+
+    // inverted or NaN boxes are passed through untouched for validation to reject
+    auto malformed = std::stable_partition(solids.begin(), solids.end(), isWellFormed);
+    std::vector<Solid> rejected(malformed, solids.end());
+    solids.erase(malformed, solids.end());
+
+    dropContained(solids);
+
+    // boxes without area cover no cell of a mesh, they are kept as they are
+    auto flat = std::stable_partition(solids.begin(), solids.end(), hasArea);
+    std::vector<Solid> merged(flat, solids.end());
+    solids.erase(flat, solids.end());
+
+    for (auto& cluster : touchingClusters(solids)) {
+        stats.clusters++;
+        if (meshCluster(cluster, merged)) {
+            continue;
+        }
+        // a column merge can line up boxes for a new row merge and the other way around
+        stats.oversized++;
+        bool changed;
+        do {
+            changed = mergeAlong(cluster, true);
+            changed = mergeAlong(cluster, false) || changed;
+        } while (changed);
+        merged.insert(merged.end(), cluster.begin(), cluster.end());
+    }
+    solids = std::move(merged);
+
+    std::sort(solids.begin(), solids.end(), [](const Solid& a, const Solid& b) {
+        return std::make_tuple(a.v0().y, a.v0().x, a.v1().y, a.v1().x) < std::make_tuple(b.v0().y, b.v0().x, b.v1().y, b.v1().x);
+    });
+    solids.insert(solids.end(), rejected.begin(), rejected.end());
+
+    stats.solidsAfter = static_cast<uint32_t>(solids.size());
+    return stats;
+}
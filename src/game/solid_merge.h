@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "solid.h"
+
+struct SolidMergeStats {
+    uint32_t solidsBefore = 0;
+    uint32_t solidsAfter = 0;
+    // groups of touching solids, meshed one at a time
+    uint32_t clusters = 0;
+    // clusters whose grid was too large to mesh, only runs of boxes with the same span were merged in them
+    uint32_t oversized = 0;
+};
+
+// Replaces solids with fewer, larger boxes covering exactly the same area. Boxes inside another box are dropped,
+// then every group of touching boxes is greedy meshed on the grid its own edges make: covered cells are taken row by
+// row into boxes as wide and then as tall as they can grow, so an L of three tiles becomes two boxes and the result
+// never overlaps. Coordinates are only ever copied, never computed, so the result is exact. The output is sorted by
+// y0, x0.
+SolidMergeStats mergeSolids(std::vector<Solid>& solids);
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "AABB.h"
+#include "solid.h"
+#include "tilemap.h"
+
+// Structure of arrays view over static solids. The arrays are not owned, they usually point into a mapped level file.
+struct SolidTable {
+    uint32_t count = 0;
+    const float* x0 = nullptr;
+    const float* x1 = nullptr;
+    const float* y0 = nullptr;
+    const float* y1 = nullptr;
+
+    AABB aabb(uint32_t i) const noexcept {
+        return {x0[i], x1[i], y0[i], y1[i]};
+    }
+};
+
+// Uniform grid over a SolidTable in compressed sparse row form: solids touching cell c are
+// cellItems[cellStart[c]] .. cellItems[cellStart[c + 1]], in ascending order.
+struct SpatialGrid {
+    float originX = 0.0f;
+    float originY = 0.0f;
+    float cellSize = 1.0f;
+    uint32_t cols = 0;
+    uint32_t rows = 0;
+    const uint32_t* cellStart = nullptr;
+    const uint32_t* cellItems = nullptr;
+
+    bool isEmpty() const noexcept {
+        return cols == 0 || rows == 0;
+    }
+
+    uint32_t cellCount() const noexcept {
+        return cols * rows;
+    }
+
+    uint32_t cellX(float x) const noexcept {
+        return clampCell(std::floor((x - originX) / cellSize), cols);
+    }
+
+    uint32_t cellY(float y) const noexcept {
+        return clampCell(std::floor((y - originY) / cellSize), rows);
+    }
+
+    // Replaces out with the indices of solids whose cells overlap region, ascending and without duplicates.
+    // Cells are a conservative filter: callers still have to test the solids themselves.
+    void query(const AABB& region, std::vector<uint32_t>& out) const {
+        out.clear();
+        if (isEmpty()) {
+            return;
+        }
+
+        uint32_t cx0 = cellX(region.v0().x);
+        uint32_t cx1 = cellX(region.v1().x);
+        uint32_t cy0 = cellY(region.v0().y);
+        uint32_t cy1 = cellY(region.v1().y);
+
+        for (uint32_t cy = cy0; cy <= cy1; cy++) {
+            for (uint32_t cx = cx0; cx <= cx1; cx++) {
+                uint32_t cell = cy * cols + cx;
+                out.insert(out.end(), cellItems + cellStart[cell], cellItems + cellStart[cell + 1]);
+            }
+        }
+
+        // solids spanning several cells are listed once per cell
+        if (cx0 != cx1 || cy0 != cy1) {
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+        }
+    }
+
+private:
+    static uint32_t clampCell(float cell, uint32_t count) noexcept {
+        if (!(cell >= 0.0f)) {
+            return 0;
+        }
+        if (cell >= static_cast<float>(count - 1)) {
+            return count - 1;
+        }
+        return static_cast<uint32_t>(cell);
+    }
+};
+
+struct StaticGeometry {
+    SolidTable solids{};
+    SpatialGrid grid{};
+    TileMap tiles{};
+
+    bool isEmpty() const noexcept {
+        return solids.count == 0 && tiles.isEmpty();
+    }
+};
+
+// Owning storage for StaticGeometry built at runtime: level conversion, generated levels and streamed chunks.
+class StaticGeometryBuilder {
+public:
+    // keeps the index from degenerating into millions of empty cells for sparse levels
+    static inline constexpr uint32_t MAX_CELLS_PER_SOLID = 4;
+
+    std::vector<float> x0{};
+    std::vector<float> x1{};
+    std::vector<float> y0{};
+    std::vector<float> y1{};
+    std::vector<uint32_t> cellStart{};
+    std::vector<uint32_t> cellItems{};
+
+    float gridOriginX = 0.0f;
+    float gridOriginY = 0.0f;
+    float gridCellSize = 1.0f;
+    uint32_t gridCols = 0;
+    uint32_t gridRows = 0;
+
+    // cellSize <= 0 picks one from the solid sizes
+    void build(const std::vector<Solid>& solids, float cellSize = 0.0f) {
+        uint32_t count = static_cast<uint32_t>(solids.size());
+        x0.resize(count);
+        x1.resize(count);
+        y0.resize(count);
+        y1.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            const AABB& aabb = solids[i].aabb();
+            x0[i] = aabb.v0().x;
+            x1[i] = aabb.v1().x;
+            y0[i] = aabb.v0().y;
+            y1[i] = aabb.v1().y;
+        }
+
+        cellStart.clear();
+        cellItems.clear();
+        gridCols = 0;
+        gridRows = 0;
+        if (count == 0) {
+            return;
+        }
+
+        float minX = *std::min_element(x0.begin(), x0.end());
+        float maxX = *std::max_element(x1.begin(), x1.end());
+        float minY = *std::min_element(y0.begin(), y0.end());
+        float maxY = *std::max_element(y1.begin(), y1.end());
+        float width = std::max(maxX - minX, 1.0f);
+        float height = std::max(maxY - minY, 1.0f);
+
+        if (!(cellSize > 0.0f)) {
+            double extent = 0.0;
+            for (uint32_t i = 0; i < count; i++) {
+                extent += std::max(x1[i] - x0[i], y1[i] - y0[i]);
+            }
+            cellSize = std::max(static_cast<float>(extent / count), 1.0f);
+        }
+
+        double maxCells = static_cast<double>(count) * MAX_CELLS_PER_SOLID + 16.0;
+        while (std::ceil(width / cellSize) * std::ceil(height / cellSize) > maxCells) {
+            cellSize *= 2.0f;
+        }
+
+        gridOriginX = minX;
+        gridOriginY = minY;
+        gridCellSize = cellSize;
+        gridCols = static_cast<uint32_t>(std::ceil(width / cellSize));
+        gridRows = static_cast<uint32_t>(std::ceil(height / cellSize));
+
+        SpatialGrid grid = view().grid;
+
+        // counting sort into cells, iterating solids in order keeps every cell ascending
+        cellStart.assign(static_cast<size_t>(gridCols) * gridRows + 1, 0);
+        for (uint32_t i = 0; i < count; i++) {
+            forEachCell(grid, i, [&](uint32_t cell) { cellStart[cell + 1]++; });
+        }
+        for (size_t c = 1; c < cellStart.size(); c++) {
+            cellStart[c] += cellStart[c - 1];
+        }
+
+        cellItems.resize(cellStart.back());
+        std::vector<uint32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+        for (uint32_t i = 0; i < count; i++) {
+            forEachCell(grid, i, [&](uint32_t cell) { cellItems[cursor[cell]++] = i; });
+        }
+    }
+
+    StaticGeometry view() const noexcept {
+        StaticGeometry geometry;
+        geometry.solids = {static_cast<uint32_t>(x0.size()), x0.data(), x1.data(), y0.data(), y1.data()};
+        geometry.grid = {gridOriginX, gridOriginY, gridCellSize, gridCols, gridRows, cellStart.data(), cellItems.data()};
+        return geometry;
+    }
+
+private:
+    template <typename F>
+    void forEachCell(const SpatialGrid& grid, uint32_t i, F&& f) const {
+        uint32_t cx0 = grid.cellX(x0[i]);
+        uint32_t cx1 = grid.cellX(x1[i]);
+        uint32_t cy0 = grid.cellY(y0[i]);
+        uint32_t cy1 = grid.cellY(y1[i]);
+        for (uint32_t cy = cy0; cy <= cy1; cy++) {
+            for (uint32_t cx = cx0; cx <= cx1; cx++) {
+                f(cy * grid.cols + cx);
+            }
+        }
+    }
+};
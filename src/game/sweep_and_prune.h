@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "AABB.h"
+
+struct BodyPair {
+    // a < b
+    uint32_t a;
+    uint32_t b;
+};
+
+struct SweepAndPruneStats {
+    // endpoint swaps the insertion sort needed, a measure of how much the order changed
+    uint64_t swaps = 0;
+    // times the pair buffer was too small and had to grow, zero in steady state
+    uint64_t pairBufferGrowths = 0;
+};
+
+// Sort and sweep broadphase along x. The box endpoints stay sorted between updates and are repaired with an insertion
+// sort, which is close to linear while bodies move little relative to each other. Pairs go into a buffer that is
+// sized up front and reused, so a steady state update does not allocate.
+template <typename T>
+class BasicSweepAndPrune {
+public:
+    // pair buffer capacity reserved per body, a pile of boxes touches fewer neighbours than this
+    static inline constexpr uint32_t PAIRS_PER_BODY = 8;
+
+private:
+    struct Endpoint {
+        T x;
+        // body << 1, low bit set for the box's upper end
+        uint32_t tag;
+
+        uint32_t body() const noexcept {
+            return tag >> 1;
+        }
+
+        bool isMax() const noexcept {
+            return (tag & 1) != 0;
+        }
+
+        // on equal values lower ends go first, so that touching boxes are paired
+        bool before(const Endpoint& rhs) const noexcept {
+            if (x != rhs.x) {
+                return x < rhs.x;
+            }
+            return !isMax() && rhs.isMax();
+        }
+    };
+
+    std::vector<BasicAABB<T>> _boxes{};
+    std::vector<Endpoint> endpoints{};
+    // bodies whose lower end the sweep has passed and upper end not yet, with each body's slot in it
+    std::vector<uint32_t> active{};
+    std::vector<uint32_t> activeSlot{};
+    std::vector<BodyPair> pairBuffer{};
+    uint32_t _pairCount = 0;
+    SweepAndPruneStats _stats{};
+
+public:
+    // Replaces the boxes and finds every pair that overlaps or touches. When the number of bodies changes the order is
+    // sorted from scratch.
+    void update(const std::vector<BasicAABB<T>>& boxes) {
+        auto count = static_cast<uint32_t>(boxes.size());
+        _boxes.assign(boxes.begin(), boxes.end());
+        if (endpoints.size() != 2 * static_cast<size_t>(count)) {
+            rebuild(count);
+        } else {
+            for (auto& endpoint : endpoints) {
+                const auto& box = _boxes[endpoint.body()];
+                endpoint.x = endpoint.isMax() ? box.v1().x : box.v0().x;
+            }
+            insertionSort();
+        }
+        sweep();
+    }
+
+    const std::vector<BasicAABB<T>>& boxes() const noexcept {
+        return _boxes;
+    }
+
+    const BodyPair* pairs() const noexcept {
+        return pairBuffer.data();
+    }
+
+    uint32_t pairCount() const noexcept {
+        return _pairCount;
+    }
+
+    const SweepAndPruneStats& stats() const noexcept {
+        return _stats;
+    }
+
+private:
+    void rebuild(uint32_t count) {
+        endpoints.resize(2 * static_cast<size_t>(count));
+        for (uint32_t i = 0; i < count; i++) {
+            endpoints[2 * i] = {_boxes[i].v0().x, i << 1};
+            endpoints[2 * i + 1] = {_boxes[i].v1().x, i << 1 | 1};
+        }
+        std::stable_sort(endpoints.begin(), endpoints.end(), [](const Endpoint& a, const Endpoint& b) { return a.before(b); });
+
+        active.clear();
+        active.reserve(count);
+        activeSlot.resize(count);
+        if (pairBuffer.size() < static_cast<size_t>(count) * PAIRS_PER_BODY) {
+            pairBuffer.resize(static_cast<size_t>(count) * PAIRS_PER_BODY);
+        }
+    }
+
+    void insertionSort() {
+        for (size_t i = 1; i < endpoints.size(); i++) {
+            Endpoint endpoint = endpoints[i];
+            size_t j = i;
+            while (j > 0 && endpoint.before(endpoints[j - 1])) {
+                endpoints[j] = endpoints[j - 1];
+                j--;
+            }
+            _stats.swaps += i - j;
+            endpoints[j] = endpoint;
+        }
+    }
+
+    void sweep() {
+        _pairCount = 0;
+        active.clear();
+        for (const auto& endpoint : endpoints) {
+            uint32_t body = endpoint.body();
+            if (endpoint.isMax()) {
+                uint32_t slot = activeSlot[body];
+                active[slot] = active.back();
+                activeSlot[active[slot]] = slot;
+                active.pop_back();
+                continue;
+            }
+
+            const auto& box = _boxes[body];
+            for (uint32_t other : active) {
+                const auto& otherBox = _boxes[other];
+                if (box.v0().y <= otherBox.v1().y && otherBox.v0().y <= box.v1().y) {
+                    addPair(std::min(body, other), std::max(body, other));
+                }
+            }
+            activeSlot[body] = static_cast<uint32_t>(active.size());
+            active.push_back(body);
+        }
+    }
+
+    void addPair(uint32_t a, uint32_t b) {
+        if (_pairCount == pairBuffer.size()) {
+            pairBuffer.resize(std::max<size_t>(2 * pairBuffer.size(), 16));
+            _stats.pairBufferGrowths++;
+        }
+        pairBuffer[_pairCount++] = {a, b};
+    }
+};
+
+using SweepAndPrune = BasicSweepAndPrune<float>;
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "AABB.h"
+#include "../util/numbers.h"
+
+inline constexpr int32_t TILE_BLOCK_SIZE = 32;
+inline constexpr uint32_t TILE_BLOCK_EMPTY = 0xffffffffu;
+
+// 32x32 tiles: one id byte per tile plus one solid bit, 1.125 bytes per tile
+struct TileBlock {
+    // 0 is an empty tile
+    uint8_t ids[TILE_BLOCK_SIZE * TILE_BLOCK_SIZE];
+    // bit x of row y is set when the tile is solid
+    uint32_t solidRows[TILE_BLOCK_SIZE];
+};
+
+struct TilePlacement {
+    int32_t tx;
+    int32_t ty;
+    uint8_t id;
+    bool solid;
+};
+
+inline int32_t floorDiv(int32_t a, int32_t b) noexcept {
+    int32_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Sparse tile layer view: blocks that contain no tiles are not stored. Tile (tx, ty) covers
+// [origin + t * tileSize, origin + (t + 1) * tileSize] on each axis.
+struct TileMap {
+    float originX = 0.0f;
+    float originY = 0.0f;
+    float tileSize = 1.0f;
+    int32_t blockX0 = 0;
+    int32_t blockY0 = 0;
+    uint32_t blockCols = 0;
+    uint32_t blockRows = 0;
+    uint32_t blockCount = 0;
+    const uint32_t* blockIndex = nullptr;
+    const TileBlock* blocks = nullptr;
+
+    bool isEmpty() const noexcept {
+        return blockCols == 0 || blockRows == 0;
+    }
+
+    const TileBlock* block(int32_t bx, int32_t by) const noexcept {
+        int64_t col = static_cast<int64_t>(bx) - blockX0;
+        int64_t row = static_cast<int64_t>(by) - blockY0;
+        if (col < 0 || row < 0 || col >= blockCols || row >= blockRows) {
+            return nullptr;
+        }
+        uint32_t index = blockIndex[row * blockCols + col];
+        return index != TILE_BLOCK_EMPTY ? &blocks[index] : nullptr;
+    }
+
+    bool isSolid(int32_t tx, int32_t ty) const noexcept {
+        const TileBlock* b = block(floorDiv(tx, TILE_BLOCK_SIZE), floorDiv(ty, TILE_BLOCK_SIZE));
+        if (b == nullptr) {
+            return false;
+        }
+        int32_t x = tx - floorDiv(tx, TILE_BLOCK_SIZE) * TILE_BLOCK_SIZE;
+        int32_t y = ty - floorDiv(ty, TILE_BLOCK_SIZE) * TILE_BLOCK_SIZE;
+        return (b->solidRows[y] >> x) & 1u;
+    }
+
+    uint8_t tileId(int32_t tx, int32_t ty) const noexcept {
+        const TileBlock* b = block(floorDiv(tx, TILE_BLOCK_SIZE), floorDiv(ty, TILE_BLOCK_SIZE));
+        if (b == nullptr) {
+            return 0;
+        }
+        int32_t x = tx - floorDiv(tx, TILE_BLOCK_SIZE) * TILE_BLOCK_SIZE;
+        int32_t y = ty - floorDiv(ty, TILE_BLOCK_SIZE) * TILE_BLOCK_SIZE;
+        return b->ids[y * TILE_BLOCK_SIZE + x];
+    }
+
+    AABB tileAABB(int32_t tx, int32_t ty) const noexcept {
+        float x0 = originX + static_cast<float>(tx) * tileSize;
+        float y0 = originY + static_cast<float>(ty) * tileSize;
+        return {x0, x0 + tileSize, y0, y0 + tileSize};
+    }
+
+    AABB bounds() const noexcept {
+        float size = static_cast<float>(TILE_BLOCK_SIZE) * tileSize;
+        float x0 = originX + static_cast<float>(blockX0) * size;
+        float y0 = originY + static_cast<float>(blockY0) * size;
+        return {x0, x0 + static_cast<float>(blockCols) * size, y0, y0 + static_cast<float>(blockRows) * size};
+    }
+
+    // Calls f(tx, ty) for every solid tile the box touches while moving by move, walking the path tile by tile
+    // along its dominant axis from the start position, DDA style. Touching counts, like it does for solids.
+    template <typename F>
+    void sweep(const AABB& box, Vec2 move, F&& f) const {
+        if (isEmpty()) {
+            return;
+        }
+
+        bool alongX = std::abs(move.x) >= std::abs(move.y);
+        float a0 = alongX ? box.v0().x : box.v0().y;
+        float a1 = alongX ? box.v1().x : box.v1().y;
+        float b0 = alongX ? box.v0().y : box.v0().x;
+        float b1 = alongX ? box.v1().y : box.v1().x;
+        float moveA = alongX ? move.x : move.y;
+        float moveB = alongX ? move.y : move.x;
+        float originA = alongX ? originX : originY;
+        float originB = alongX ? originY : originX;
+
+        // tiles outside the stored blocks are empty, so both walks are clipped to them
+        int32_t minA = (alongX ? blockX0 : blockY0) * TILE_BLOCK_SIZE;
+        int32_t maxA = minA + static_cast<int32_t>(alongX ? blockCols : blockRows) * TILE_BLOCK_SIZE - 1;
+        int32_t minB = (alongX ? blockY0 : blockX0) * TILE_BLOCK_SIZE;
+        int32_t maxB = minB + static_cast<int32_t>(alongX ? blockRows : blockCols) * TILE_BLOCK_SIZE - 1;
+
+        int32_t step = moveA >= 0.0f ? 1 : -1;
+        int32_t first = moveA >= 0.0f ? lowTile(a0, originA, minA, maxA) : highTile(a1, originA, minA, maxA);
+        int32_t last = moveA >= 0.0f ? highTile(a1 + moveA, originA, minA, maxA) : lowTile(a0 + moveA, originA, minA, maxA);
+        if (!clipWalk(first, last, step, minA, maxA)) {
+            return;
+        }
+
+        for (int32_t ta = first;; ta += step) {
+            // part of the move during which the box overlaps this column (or row)
+            float tEnter = 0.0f;
+            float tExit = 1.0f;
+            if (moveA != 0.0f) {
+                float lineLow = originA + static_cast<float>(ta) * tileSize;
+                float lineHigh = lineLow + tileSize;
+                float t0 = ((moveA > 0.0f ? lineLow : lineHigh) - (moveA > 0.0f ? a1 : a0)) / moveA;
+                float t1 = ((moveA > 0.0f ? lineHigh : lineLow) - (moveA > 0.0f ? a0 : a1)) / moveA;
+                tEnter = std::clamp(t0, 0.0f, 1.0f);
+                tExit = std::clamp(t1, 0.0f, 1.0f);
+            }
+
+            float low = b0 + moveB * (moveB >= 0.0f ? tEnter : tExit);
+            float high = b1 + moveB * (moveB >= 0.0f ? tExit : tEnter);
+            int32_t bStep = moveB >= 0.0f ? 1 : -1;
+            int32_t bFirst = moveB >= 0.0f ? lowTile(low, originB, minB, maxB) : highTile(high, originB, minB, maxB);
+            int32_t bLast = moveB >= 0.0f ? highTile(high, originB, minB, maxB) : lowTile(low, originB, minB, maxB);
+
+            if (clipWalk(bFirst, bLast, bStep, minB, maxB)) {
+                for (int32_t tb = bFirst;; tb += bStep) {
+                    int32_t tx = alongX ? ta : tb;
+                    int32_t ty = alongX ? tb : ta;
+                    if (isSolid(tx, ty)) {
+                        f(tx, ty);
+                    }
+                    if (tb == bLast) {
+                        break;
+                    }
+                }
+            }
+
+            if (ta == last) {
+                break;
+            }
+        }
+    }
+
+    // Calls f(tx0, tx1, ty) for every horizontal run of solid tiles inside a block row, for building geometry
+    template <typename F>
+    void forEachSolidRun(F&& f) const {
+        for (uint32_t row = 0; row < blockRows; row++) {
+            for (uint32_t col = 0; col < blockCols; col++) {
+                uint32_t index = blockIndex[row * blockCols + col];
+                if (index == TILE_BLOCK_EMPTY) {
+                    continue;
+                }
+                int32_t baseX = (blockX0 + static_cast<int32_t>(col)) * TILE_BLOCK_SIZE;
+                int32_t baseY = (blockY0 + static_cast<int32_t>(row)) * TILE_BLOCK_SIZE;
+                for (int32_t y = 0; y < TILE_BLOCK_SIZE; y++) {
+                    uint32_t bits = blocks[index].solidRows[y];
+                    int32_t x = 0;
+                    while (bits != 0) {
+                        while ((bits & 1u) == 0) {
+                            bits >>= 1;
+                            x++;
+                        }
+                        int32_t start = x;
+                        while ((bits & 1u) != 0) {
+                            bits >>= 1;
+                            x++;
+                        }
+                        f(baseX + start, baseX + x - 1, baseY + y);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    // Tile ranges are inclusive at both ends so a tile whose edge the box touches is included. Coordinates are
+    // clamped one tile past the stored range before converting, which also keeps huge or NaN values defined.
+    int32_t lowTile(float v, float origin, int32_t minTile, int32_t maxTile) const noexcept {
+        return toTile(std::ceil((v - origin) / tileSize) - 1.0f, minTile, maxTile);
+    }
+
+    int32_t highTile(float v, float origin, int32_t minTile, int32_t maxTile) const noexcept {
+        return toTile(std::floor((v - origin) / tileSize), minTile, maxTile);
+    }
+
+    static int32_t toTile(float tile, int32_t minTile, int32_t maxTile) noexcept {
+        if (!(tile >= static_cast<float>(minTile - 1))) {
+            return minTile - 1;
+        }
+        if (tile > static_cast<float>(maxTile + 1)) {
+            return maxTile + 1;
+        }
+        return static_cast<int32_t>(tile);
+    }
+
+    // Clips a walk from first to last in direction step to [minTile, maxTile], false when nothing is left
+    static bool clipWalk(int32_t& first, int32_t& last, int32_t step, int32_t minTile, int32_t maxTile) noexcept {
+        int32_t low = step > 0 ? first : last;
+        int32_t high = step > 0 ? last : first;
+        low = std::max(low, minTile);
+        high = std::min(high, maxTile);
+        if (low > high) {
+            return false;
+        }
+        first = step > 0 ? low : high;
+        last = step > 0 ? high : low;
+        return true;
+    }
+};
+
+// Owning storage for a TileMap
+class TileMapBuilder {
+public:
+    std::vector<uint32_t> blockIndex{};
+    std::vector<TileBlock> blocks{};
+
+    float originX = 0.0f;
+    float originY = 0.0f;
+    float tileSize = 1.0f;
+    int32_t blockX0 = 0;
+    int32_t blockY0 = 0;
+    uint32_t blockCols = 0;
+    uint32_t blockRows = 0;
+
+    void build(const std::vector<TilePlacement>& tiles, float tileOriginX, float tileOriginY, float tileSizeValue) {
+        originX = tileOriginX;
+        originY = tileOriginY;
+        tileSize = tileSizeValue;
+        blockIndex.clear();
+        blocks.clear();
+        blockCols = 0;
+        blockRows = 0;
+        if (tiles.empty()) {
+            return;
+        }
+
+        int32_t bx0 = NUM_MAX<int32_t>, by0 = NUM_MAX<int32_t>, bx1 = NUM_MIN<int32_t>, by1 = NUM_MIN<int32_t>;
+        for (const auto& tile : tiles) {
+            bx0 = std::min(bx0, floorDiv(tile.tx, TILE_BLOCK_SIZE));
+            by0 = std::min(by0, floorDiv(tile.ty, TILE_BLOCK_SIZE));
+            bx1 = std::max(bx1, floorDiv(tile.tx, TILE_BLOCK_SIZE));
+            by1 = std::max(by1, floorDiv(tile.ty, TILE_BLOCK_SIZE));
+        }
+
+        blockX0 = bx0;
+        blockY0 = by0;
+        blockCols = static_cast<uint32_t>(bx1 - bx0 + 1);
+        blockRows = static_cast<uint32_t>(by1 - by0 + 1);
+        blockIndex.assign(static_cast<size_t>(blockCols) * blockRows, TILE_BLOCK_EMPTY);
+
+        for (const auto& tile : tiles) {
+            int32_t bx = floorDiv(tile.tx, TILE_BLOCK_SIZE);
+            int32_t by = floorDiv(tile.ty, TILE_BLOCK_SIZE);
+            uint32_t& index = blockIndex[static_cast<size_t>(by - blockY0) * blockCols + (bx - blockX0)];
+            if (index == TILE_BLOCK_EMPTY) {
+                index = static_cast<uint32_t>(blocks.size());
+                TileBlock& block = blocks.emplace_back();
+                memset(&block, 0, sizeof(block));
+            }
+
+            TileBlock& block = blocks[index];
+            int32_t x = tile.tx - bx * TILE_BLOCK_SIZE;
+            int32_t y = tile.ty - by * TILE_BLOCK_SIZE;
+            block.ids[y * TILE_BLOCK_SIZE + x] = tile.id;
+            if (tile.solid) {
+                block.solidRows[y] |= 1u << x;
+            } else {
+                block.solidRows[y] &= ~(1u << x);
+            }
+        }
+    }
+
+    TileMap view() const noexcept {
+        return {originX, originY, tileSize, blockX0, blockY0, blockCols, blockRows, static_cast<uint32_t>(blocks.size()), blockIndex.data(),
+                blocks.data()};
+    }
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "AABB.h"
+#include "entity_store.h"
+#include "solid.h"
+#include "static_geometry.h"
+
+enum class TriggerKind : uint8_t {
+    CHECKPOINT,
+    HAZARD,
+    PICKUP,
+};
+
+template <typename T>
+struct BasicTrigger {
+    BasicAABB<T> aabb;
+    TriggerKind kind;
+    // whatever gameplay wants to know the trigger by, a checkpoint number or a pickup's item
+    uint32_t tag;
+    // inactive triggers overlap nothing, a collected pickup is switched off rather than removed
+    bool active;
+};
+
+enum class TriggerEventType : uint8_t {
+    ENTER,
+    EXIT,
+};
+
+struct TriggerEvent {
+    TriggerEventType type;
+    uint32_t trigger;
+    // World::playerEntity for the player
+    Entity body;
+};
+
+struct TriggerStats {
+    uint64_t enters = 0;
+    uint64_t exits = 0;
+    // events lost because gameplay did not drain the ring in time
+    uint64_t dropped = 0;
+};
+
+// Fixed capacity queue of trigger events, allocated once. Pushing into a full ring drops the event and counts it.
+class TriggerEventRing {
+    std::vector<TriggerEvent> items{};
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+public:
+    // rounded up to a power of two
+    explicit TriggerEventRing(uint32_t capacity) {
+        uint32_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        items.resize(size);
+    }
+
+    bool push(const TriggerEvent& event) noexcept {
+        if (head - tail == items.size()) {
+            return false;
+        }
+        items[head & (items.size() - 1)] = event;
+        head++;
+        return true;
+    }
+
+    bool pop(TriggerEvent& event) noexcept {
+        if (head == tail) {
+            return false;
+        }
+        event = items[tail & (items.size() - 1)];
+        tail++;
+        return true;
+    }
+
+    uint32_t size() const noexcept {
+        return head - tail;
+    }
+
+    uint32_t capacity() const noexcept {
+        return static_cast<uint32_t>(items.size());
+    }
+
+    bool isEmpty() const noexcept {
+        return head == tail;
+    }
+};
+
+// Checkpoint, hazard and pickup zones. Their boxes are indexed by a SpatialGrid like a level's solids, rebuilt when
+// triggers are added. Each detection pass lists the (body, trigger) pairs that overlap, sorted, and walks it against
+// the previous pass's list: pairs only in the new one entered and pairs only in the old one exited. Bodies are told
+// apart by their whole handle, so a body removed inside a trigger exits it on the next pass even when another body took
+// its slot. Both lists and the event ring keep their storage, so a steady state pass does not allocate.
+//
+// Triggers are never tested by the resolvers, they cannot affect movement.
+template <typename T>
+class BasicTriggerSet {
+public:
+    static inline constexpr uint32_t DEFAULT_EVENT_CAPACITY = 1024;
+
+private:
+    struct Overlap {
+        // index << 32 | generation
+        uint64_t body;
+        uint32_t trigger;
+
+        bool operator<(const Overlap& rhs) const noexcept {
+            return body != rhs.body ? body < rhs.body : trigger < rhs.trigger;
+        }
+    };
+
+    std::vector<BasicTrigger<T>> _triggers{};
+    StaticGeometryBuilder index{};
+    bool indexDirty = false;
+    // ascending
+    std::vector<Overlap> overlaps{};
+    std::vector<Overlap> previousOverlaps{};
+    std::vector<uint32_t> candidates{};
+    TriggerEventRing _events;
+    TriggerStats _stats{};
+
+public:
+    explicit BasicTriggerSet(uint32_t eventCapacity = DEFAULT_EVENT_CAPACITY) : _events(eventCapacity) {}
+
+    uint32_t add(const BasicAABB<T>& aabb, TriggerKind kind, uint32_t tag = 0) {
+        _triggers.push_back({aabb, kind, tag, true});
+        indexDirty = true;
+        return static_cast<uint32_t>(_triggers.size() - 1);
+    }
+
+    // Removes every trigger. Bodies inside one get their exit events.
+    void clear() {
+        _triggers.clear();
+        indexDirty = true;
+        overlaps.clear();
+        emitChanges();
+    }
+
+    // Replaces the event ring, events not drained yet are lost
+    void setEventCapacity(uint32_t capacity) {
+        _events = TriggerEventRing(capacity);
+    }
+
+    void setActive(uint32_t i, bool active) {
+        if (i >= _triggers.size()) {
+            throw std::runtime_error("unknown trigger " + std::to_string(i));
+        }
+        _triggers[i].active = active;
+    }
+
+    bool empty() const noexcept {
+        return _triggers.empty();
+    }
+
+    const std::vector<BasicTrigger<T>>& triggers() const noexcept {
+        return _triggers;
+    }
+
+    // Gameplay pops events from here, in the order they happened
+    TriggerEventRing& events() noexcept {
+        return _events;
+    }
+
+    const TriggerStats& stats() const noexcept {
+        return _stats;
+    }
+
+    // Starts a detection pass, followed by detect for every body and then finish
+    void begin() {
+        if (indexDirty) {
+            std::vector<Solid> boxes;
+            boxes.reserve(_triggers.size());
+            for (const auto& trigger : _triggers) {
+                boxes.emplace_back(AABB(trigger.aabb));
+            }
+            index.build(boxes);
+            indexDirty = false;
+        }
+        overlaps.clear();
+    }
+
+    // query is the box to look up in the float grid, conservative for Fixed like World's level lookups
+    void detect(Entity body, const BasicAABB<T>& aabb, const AABB& query) {
+        index.view().grid.query(query, candidates);
+        for (uint32_t i : candidates) {
+            const auto& trigger = _triggers[i];
+            if (trigger.active && overlap(trigger.aabb, aabb)) {
+                overlaps.push_back({static_cast<uint64_t>(body.index) << 32 | body.generation, i});
+            }
+        }
+    }
+
+    void finish() {
+        std::sort(overlaps.begin(), overlaps.end());
+        emitChanges();
+    }
+
+private:
+    // touching counts, like it does for solids
+    static bool overlap(const BasicAABB<T>& a, const BasicAABB<T>& b) noexcept {
+        return a.v0().x <= b.v1().x && b.v0().x <= a.v1().x && a.v0().y <= b.v1().y && b.v0().y <= a.v1().y;
+    }
+
+    void emit(TriggerEventType type, const Overlap& pair) noexcept {
+        TriggerEvent event{type, pair.trigger, {static_cast<uint32_t>(pair.body >> 32), static_cast<uint32_t>(pair.body)}};
+        if (!_events.push(event)) {
+            _stats.dropped++;
+        } else if (type == TriggerEventType::ENTER) {
+            _stats.enters++;
+        } else {
+            _stats.exits++;
+        }
+    }
+
+    // events in (body, trigger) order, then the lists swap
+    void emitChanges() noexcept {
+        size_t i = 0, j = 0;
+        while (i < previousOverlaps.size() || j < overlaps.size()) {
+            if (j == overlaps.size() || (i < previousOverlaps.size() && previousOverlaps[i] < overlaps[j])) {
+                emit(TriggerEventType::EXIT, previousOverlaps[i++]);
+            } else if (i == previousOverlaps.size() || overlaps[j] < previousOverlaps[i]) {
+                emit(TriggerEventType::ENTER, overlaps[j++]);
+            } else {
+                i++;
+                j++;
+            }
+        }
+        std::swap(overlaps, previousOverlaps);
+    }
+};
+
+using Trigger = BasicTrigger<float>;
+using TriggerSet = BasicTriggerSet<float>;
@@ -1,82 +1,875 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 #include "AABB.h"
+#include "entity_store.h"
+#include "kinematic.h"
+#include "level.h"
 #include "player.h"
 #include "raycast.h"
 #include "solid.h"
+#include "sweep_and_prune.h"
+#include "trigger.h"
+#include "../math/fixed.h"
+#include "../platform/time.h"
+#include "../util/object_pool.h"
+#include "../util/profiler.h"
+
+// How far from the origin the levels of a Fixed world may reach. Fixed saturates at about 32767, this leaves room for
+// the bodies moving around a level's edges.
+inline constexpr float FIXED_WORLD_LIMIT = 30000.0f;
+
+// A piece of static geometry resident in a world. Single-file levels are one chunk, streamed levels many.
+struct StaticChunk {
+    uint64_t id = 0;
+    AABB bounds{};
+    std::shared_ptr<const Level> level{};
+};
+
+template <typename T>
+inline bool aabbOverlaps(const BasicAABB<T>& a, const BasicAABB<T>& b) noexcept {
+    return a.v0().x <= b.v1().x && b.v0().x <= a.v1().x && a.v0().y <= b.v1().y && b.v0().y <= a.v1().y;
+}
+
+// The region box covers while moving by move
+template <typename T>
+inline BasicAABB<T> sweptAABB(const BasicAABB<T>& box, BasicVec2<T> move) noexcept {
+    return {
+        std::min(box.v0().x, box.v0().x + move.x),
+        std::max(box.v1().x, box.v1().x + move.x),
+        std::min(box.v0().y, box.v0().y + move.y),
+        std::max(box.v1().y, box.v1().y + move.y),
+    };
+}
+
+// body against body collisions of the last tick
+struct BodyCollisionStats {
+    // broadphase pairs, bodies whose swept boxes overlap
+    uint32_t pairs = 0;
+    // pairs that met during the tick
+    uint32_t contacts = 0;
+    uint64_t broadphaseNs = 0;
+};
+
+// A point flying in a straight line until it hits static geometry or a platform, or its time runs out
+template <typename T>
+struct BasicProjectile {
+    BasicVec2<T> pos;
+    BasicVec2<T> vel;
+    // game time left, in the units of delta
+    T remaining;
+};
+
+enum class ContactResolver {
+    // every contact found scales the move on its axis, in storage order. What WorldBatch replicates.
+    SCALE,
+    // contacts are resolved in time of impact order, the rest of the move slides along the surface hit. Seams
+    // between boxes are passed over, so it is safe with longer substeps.
+    SWEEP,
+};
+
+// Level geometry is stored as float whatever T is. With Fixed it is converted exactly when a body is tested against
+// it, and the float grid and tile lookups only pick candidates from boxes padded by a unit, so the physics itself
+// never depends on float rounding.
+template <typename T>
+class BasicWorld {
+    // scratch for grid queries, kept to avoid allocating every tick
+    std::vector<uint32_t> candidates{};
+    // scratch for the sweep resolver, obstacles grown by the player's half size
+    std::vector<BasicAABB<T>> obstacles{};
+    // per body scratch of tickBodies, in the order entities visits the bodies. The bodies themselves stay in place.
+    std::vector<BasicPlayer<T>*> bodies{};
+    std::vector<BasicVec2<T>> bodyStarts{};
+    std::vector<BasicVec2<T>> bodyMoves{};
+    std::vector<BasicAABB<T>> bodyBoxes{};
+    BasicSweepAndPrune<T> broadphase{};
+
+    struct TriggerStart {
+        Entity entity;
+        BasicVec2<T> pos;
+    };
+
+    // where the bodies started the frame, by entity index, see startTriggerFrame
+    std::vector<TriggerStart> triggerStarts{};
+
+    // The player's component, which never moves: it is alone in its archetype. Looking it up through entities on every
+    // access made a tick a quarter slower, so it is kept here. A copy of a world has chunks of its own and looks its
+    // player up again, moving a world moves the chunks along.
+    struct PlayerBody {
+        BasicPlayer<T>* body = nullptr;
+
+        PlayerBody() = default;
+
+        PlayerBody(const PlayerBody&) noexcept {}
+
+        PlayerBody(PlayerBody&&) noexcept = default;
+
+        PlayerBody& operator=(const PlayerBody&) noexcept {
+            body = nullptr;
+            return *this;
+        }
+
+        PlayerBody& operator=(PlayerBody&&) noexcept = default;
+    };
+
+    Entity _player{};
+    PlayerBody playerBody{};
 
-class World {
 public:
-    Player player;
-    std::vector<Solid> objects{};
+    // passes of the sweep resolver per tick, two contacts are enough for any move and the rest covers seams
+    static inline constexpr uint32_t SWEEP_PASSES = 4;
+    static inline constexpr uint32_t NOT_RIDING = UINT32_MAX;
+    // passes over the body pairs per tick, each settles one more level of a stack
+    static inline constexpr uint32_t BODY_PASSES = 4;
+    // how far the player's feet may be from a kinematic body's top to ride it
+    static inline constexpr T RIDE_TOLERANCE = T(0.01f);
+    static inline constexpr uint32_t MAX_PROJECTILES = 4096;
+    // flat solids are kept by the level bake, for adaptive substeps they count as this thick
+    static inline constexpr T MIN_FEATURE_SIZE = T(1.0f);
+
+    std::vector<BasicSolid<T>> objects{};
+
+    // Gameplay entities. Those with a BasicPlayer component are dynamic bodies, the player first: it is created with
+    // the world, in an archetype of its own. Bodies added with addBody are simulated like the player without its
+    // controls. They collide with the player, each other, the static geometry and platforms, but only the player is
+    // carried by platforms.
+    EntityStore entities{};
+    BodyCollisionStats bodyStats{};
+
+    // moving platforms, elevators and crushers, see stepKinematics. Cleared with clearKinematics, which lets go of
+    // the ridden body.
+    BasicKinematicSet<T> kinematics{};
+    // the kinematic body the player stood on at the end of the last tick, carried along by its next move
+    uint32_t riding = NOT_RIDING;
+
+    // checkpoint, hazard and pickup zones, see detectTriggers
+    BasicTriggerSet<T> triggers{};
+
+    // bullets and thrown things, see stepProjectiles. Gameplay spawns them straight into the pool, which can be
+    // reserved up front so that a session never allocates for them.
+    ObjectPool<BasicProjectile<T>> projectiles{MAX_PROJECTILES};
+
+    // shared immutable geometry sorted by id, tested after objects
+    std::vector<StaticChunk> chunks{};
 
-    World() {
-        player.setPos(0.0f, 0.0f);
+    // changes whenever static geometry changes so that consumers can skip re-uploading it,
+    // unique across worlds so that a reset or a different level is never mistaken for the current one
+    uint64_t levelVersion = 1;
+
+    ContactResolver resolver = ContactResolver::SCALE;
+
+    BasicWorld() {
+        _player = entities.create(BasicPlayer<T>(), PlayerControlled{});
+        playerBody.body = &entities.get<BasicPlayer<T>>(_player);
+    }
+
+    // Stays valid until the world is assigned to, creating and destroying other entities never moves it
+    BasicPlayer<T>& player() {
+        if (playerBody.body == nullptr) {
+            playerBody.body = &entities.get<BasicPlayer<T>>(_player);
+        }
+        return *playerBody.body;
+    }
+
+    const BasicPlayer<T>& player() const {
+        return playerBody.body != nullptr ? *playerBody.body : entities.get<BasicPlayer<T>>(_player);
+    }
+
+    Entity playerEntity() const noexcept {
+        return _player;
+    }
+
+    void markLevelDirty() noexcept {
+        static std::atomic<uint64_t> lastLevelVersion{1};
+        levelVersion = lastLevelVersion.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    void setLevel(std::shared_ptr<const Level> level) {
+        if (level != nullptr) {
+            checkLevelRange(level->bounds());
+        }
+        chunks.clear();
+        if (level != nullptr) {
+            chunks.push_back({0, level->bounds(), std::move(level)});
+        }
+        markLevelDirty();
+    }
+
+    // Replaces a chunk with the same id. Costs one insertion into the chunk list, nothing is rebuilt.
+    void addChunk(StaticChunk chunk) {
+        checkLevelRange(chunk.level->bounds());
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), chunk.id, [](const StaticChunk& c, uint64_t id) { return c.id < id; });
+        if (it != chunks.end() && it->id == chunk.id) {
+            *it = std::move(chunk);
+        } else {
+            chunks.insert(it, std::move(chunk));
+        }
+        markLevelDirty();
+    }
+
+    bool removeChunk(uint64_t id) {
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), id, [](const StaticChunk& c, uint64_t id) { return c.id < id; });
+        if (it == chunks.end() || it->id != id) {
+            return false;
+        }
+        chunks.erase(it);
+        markLevelDirty();
+        return true;
     }
 
-    void tick(float delta) {
+    // Size of the smallest solid, or tile, that overlaps region: the lesser of its width and height, and at least
+    // MIN_FEATURE_SIZE. Zero when there is none.
+    T smallestFeatureNear(const BasicAABB<T>& region) {
+        T smallest = T(0);
+        bool found = false;
+        auto consider = [&](const BasicAABB<T>& object) {
+            BasicVec2<T> size = object.size();
+            T feature = std::max(std::min(size.x, size.y), MIN_FEATURE_SIZE);
+            if (!found || feature < smallest) {
+                smallest = feature;
+                found = true;
+            }
+        };
+        for (const auto& object : objects) {
+            if (aabbOverlaps(object.aabb(), region)) {
+                consider(object.aabb());
+            }
+        }
+
+        AABB query = levelQuery(region);
+        if (!kinematics.empty()) {
+            kinematics.query(query, candidates);
+            for (uint32_t i : candidates) {
+                const auto& body = kinematics.bodies()[i];
+                if (aabbOverlaps(body.aabb, region)) {
+                    consider(body.aabb);
+                }
+            }
+        }
+        for (const auto& chunk : chunks) {
+            if (!aabbOverlaps(chunk.bounds, query)) {
+                continue;
+            }
+            const auto& geometry = chunk.level->geometry();
+            geometry.grid.query(query, candidates);
+            for (uint32_t i : candidates) {
+                BasicAABB<T> object(geometry.solids.aabb(i));
+                if (aabbOverlaps(object, region)) {
+                    consider(object);
+                }
+            }
+            // every tile is the same size, whether one is actually solid near the region is not worth a walk
+            if (!geometry.tiles.isEmpty() && aabbOverlaps(geometry.tiles.bounds(), query)) {
+                T tileSize(geometry.tiles.tileSize);
+                consider({{T(0), T(0)}, {tileSize, tileSize}});
+            }
+        }
+        return smallest;
+    }
+
+    void tick(T delta) {
+        PROFILE_ZONE("World::tick");
+
         // TODO: maybe optimize collision checking if on ground
 //        if (!player.isOnGround()) {
-        addVelocityY(-0.005f * delta);
+        addVelocityY(T(-0.005f) * delta);
 //        }
 
-        if (player.vel() == Vec2(0.0f, 0.0f)) {
-            return;
+        if (entities.count<BasicPlayer<T>>() > 1) {
+            tickBodies(delta);
+        } else if (!(player().vel() == BasicVec2<T>(T(0), T(0)))) {
+            resolveStatic(player(), delta);
+        }
+        if (!kinematics.empty()) {
+            findRide();
+        }
+    }
+
+    void clearKinematics() {
+        kinematics.clear();
+        riding = NOT_RIDING;
+    }
+
+    // Steps the kinematic bodies, carries the player along with the one it rides and pushes it out of the ones that
+    // moved into it. Done once per frame rather than per substep: bodies far from the player cost the same either way,
+    // and within a frame the player collides with them where they ended up.
+    void stepKinematics(T delta) {
+        PROFILE_ZONE("World::stepKinematics");
+
+        kinematics.step(delta);
+        const auto& platforms = kinematics.bodies();
+        BasicPlayer<T>& player = this->player();
+
+        // a body index left over from a set cleared behind the world's back is let go of
+        if (riding >= platforms.size()) {
+            riding = NOT_RIDING;
+        }
+        if (riding != NOT_RIDING) {
+            const auto& body = platforms[riding];
+            player.pos() = player.pos() + body.moved;
+            // put back exactly on top, so that the resolvers see a touching contact rather than a rounding gap
+            if (body.moved.y != T(0)) {
+                player.pos().y = body.aabb.v1().y + BasicPlayer<T>::HALF_SIZE.y;
+            }
+        }
+
+        // the ridden body is left out, being put on its top may round into it
+        kinematics.query(levelQuery(player.aabb()), candidates);
+        for (uint32_t i : candidates) {
+            const auto& body = platforms[i];
+            if (i != riding && !(body.moved == BasicVec2<T>(T(0), T(0))) && aabbPenetrates(player.aabb(), body.aabb)) {
+                pushOut(body);
+            }
+        }
+    }
+
+    // Remembers where every body starts the frame, for detectTriggers
+    void startTriggerFrame() {
+        entities.forEach<BasicPlayer<T>>([&](Entity entity, const BasicPlayer<T>& body) {
+            if (entity.index >= triggerStarts.size()) {
+                triggerStarts.resize(entity.index + 1);
+            }
+            triggerStarts[entity.index] = {entity, body.pos()};
+        });
+    }
+
+    // Tests every body against the triggers and queues the enter and exit events. Done once per frame like
+    // stepKinematics with the box each body covered between its start, as of startTriggerFrame, and its end, so a fast
+    // body cannot pass a trigger unseen. Bodies created since then are tested where they are.
+    void detectTriggers() {
+        PROFILE_ZONE("World::detectTriggers");
+        triggers.begin();
+        entities.forEach<BasicPlayer<T>>([&](Entity entity, const BasicPlayer<T>& body) {
+            BasicAABB<T> box = body.aabb();
+            if (entity.index < triggerStarts.size() && triggerStarts[entity.index].entity == entity) {
+                box = sweptAABB(box, triggerStarts[entity.index].pos - body.pos());
+            }
+            triggers.detect(entity, box, levelQuery(box));
+        });
+        triggers.finish();
+    }
+
+    // Moves the projectiles and despawns those that hit something or ran out of time. Done once per frame like
+    // stepKinematics, a projectile's whole path for the frame is tested so it cannot pass through thin geometry. One
+    // spawned inside a solid flies out of it.
+    void stepProjectiles(T delta) {
+        PROFILE_ZONE("World::stepProjectiles");
+        projectiles.despawnIf([&](BasicProjectile<T>& projectile) {
+            BasicVec2<T> move = projectile.vel * delta;
+            bool hit = !(move == BasicVec2<T>(T(0), T(0))) && pathBlocked(projectile.pos, move);
+            projectile.pos = projectile.pos + move;
+            projectile.remaining -= delta;
+            return hit || projectile.remaining <= T(0);
+        });
+    }
+
+    Entity addBody(BasicVec2<T> pos, BasicVec2<T> vel = {}) {
+        BasicPlayer<T> body;
+        body.setPos(pos);
+        body.setVel(vel);
+        return entities.create(body);
+    }
+
+    // Returns false when body was already removed. The player cannot be.
+    bool removeBody(Entity body) {
+        if (body == _player) {
+            throw std::runtime_error("the player is not a removable body");
+        }
+        return entities.destroy(body);
+    }
+
+    void addVelocityX(T val, T max) {
+        auto& vel = player().vel();
+        vel.x = std::clamp(vel.x + val, -max, max);
+    }
+
+    void slowDown(T val) {
+        slowDown(player(), val);
+    }
+
+    static void slowDown(BasicPlayer<T>& body, T val) {
+        auto& vel = body.vel();
+        if (vel.x < T(0)) {
+            vel.x = std::min(vel.x + val, T(0));
+        } else {
+            vel.x = std::max(vel.x - val, T(0));
+        }
+    }
+
+    void addVelocityY(T val) {
+        addVelocityY(player(), val);
+    }
+
+    // the broadphase of body collisions, for its statistics
+    const BasicSweepAndPrune<T>& bodyBroadphase() const noexcept {
+        return broadphase;
+    }
+
+private:
+    // with Fixed, geometry past FIXED_WORLD_LIMIT would have bodies saturate near it instead of moving
+    static void checkLevelRange(const AABB& bounds) {
+        if constexpr (std::is_same_v<T, Fixed>) {
+            if (!(bounds.v0().x >= -FIXED_WORLD_LIMIT && bounds.v1().x <= FIXED_WORLD_LIMIT && bounds.v0().y >= -FIXED_WORLD_LIMIT
+                  && bounds.v1().y <= FIXED_WORLD_LIMIT)) {
+                throw std::runtime_error("level does not fit in the fixed point range");
+            }
+        }
+    }
+
+    // the box a level lookup needs, conservative for Fixed
+    static AABB levelQuery(const BasicAABB<T>& box) noexcept {
+        if constexpr (std::is_same_v<T, float>) {
+            return box;
+        } else {
+            AABB query(box);
+            return {query.v0().x - 1.0f, query.v1().x + 1.0f, query.v0().y - 1.0f, query.v1().y + 1.0f};
         }
+    }
 
-        Vec2 vel = player.vel();
+    static void addVelocityY(BasicPlayer<T>& body, T val) {
+        const T VELOCITY_MAX = T(5.0f);
+        auto& vel = body.vel();
+        vel.y = std::clamp(vel.y + val, -VELOCITY_MAX, VELOCITY_MAX);
+    }
 
+    // whether a point moving from pos by move touches a solid, a platform or a solid tile on the way
+    bool pathBlocked(BasicVec2<T> pos, BasicVec2<T> move) {
+        auto blocks = [&](const BasicAABB<T>& object) {
+            BasicVec2<T> contactPoint, contactNormal;
+            T t;
+            return doRayCast2D(object, pos, move, contactPoint, contactNormal, t) && t <= T(1);
+        };
         for (const auto& object : objects) {
-            auto playerAABB = player.aabb();
-            Vec2 rayOrigin = (playerAABB.v0() + playerAABB.v1()) * 0.5f;
-            Vec2 rayDirection = {player.vel().x * delta, player.vel().y * delta};
-
-            Vec2 objectSize = playerAABB.size();
-
-            AABB expanded = object.aabb();
-            expanded.v0().x -= objectSize.x / 2;
-            expanded.v1().x += objectSize.x / 2;
-            expanded.v0().y -= objectSize.y / 2;
-            expanded.v1().y += objectSize.y / 2;
-
-            Vec2 contactPoint, contactNormal;
-            float t;
-            if (doRayCast2D(expanded, rayOrigin, rayDirection, contactPoint, contactNormal, t) && t <= 1.0f) {
-                if (contactNormal.x != 0.0f) {
-                    vel.x *= t;
-                } else {
-                    if (contactNormal.y == 1.0f) {
-                        player.setOnGround(true);
-                        player.vel().y = 0.0f;
-                    }
-                    vel.y *= t;
+            if (blocks(object.aabb())) {
+                return true;
+            }
+        }
+
+        BasicAABB<T> path = sweptAABB(BasicAABB<T>(pos, pos), move);
+        AABB swept = levelQuery(path);
+        if (!kinematics.empty()) {
+            kinematics.query(swept, candidates);
+            for (uint32_t i : candidates) {
+                if (blocks(kinematics.bodies()[i].aabb)) {
+                    return true;
                 }
             }
         }
+        AABB start = levelQuery(BasicAABB<T>(pos, pos));
+        Vec2 levelMove = Vec2(move);
+        for (const auto& chunk : chunks) {
+            if (!aabbOverlaps(chunk.bounds, swept)) {
+                continue;
+            }
+            const auto& geometry = chunk.level->geometry();
+            geometry.grid.query(swept, candidates);
+            for (uint32_t i : candidates) {
+                if (blocks(BasicAABB<T>(geometry.solids.aabb(i)))) {
+                    return true;
+                }
+            }
+            bool hit = false;
+            geometry.tiles.sweep(start, levelMove, [&](int32_t tx, int32_t ty) {
+                hit = hit || blocks(BasicAABB<T>(geometry.tiles.tileAABB(tx, ty)));
+            });
+            if (hit) {
+                return true;
+            }
+        }
+        return false;
+    }
 
-        player.pos() = player.pos() + vel * delta;
+    void resolveStatic(BasicPlayer<T>& body, T delta) {
+        if (resolver == ContactResolver::SWEEP) {
+            sweep(body, delta);
+        } else {
+            scale(body, delta);
+        }
     }
 
-    void addVelocityX(float val, float max) {
-        auto& vel = player.vel();
-        vel.x = std::clamp(vel.x + val, -max, max);
+    // Every body resolves its move against the static geometry and platforms alone, in place in entities. Then pairs
+    // whose moves meet are cut back to their time of impact on the contact axis, where both take the mean of their
+    // velocities like equal masses sticking together. Cutting moves back never takes a body into anything, so a few
+    // passes over the pairs settle stacks whatever their order. Bodies that already overlap are not pushed apart.
+    void tickBodies(T delta) {
+        PROFILE_ZONE("World::tickBodies");
+
+        bodies.clear();
+        bodyStarts.clear();
+        bodyMoves.clear();
+        bodyBoxes.clear();
+        entities.forEach<BasicPlayer<T>>([&](Entity entity, BasicPlayer<T>& body) {
+            // the player's velocity rules are Game's
+            if (!(entity == _player)) {
+                addVelocityY(body, T(-0.005f) * delta);
+                if (body.isOnGround()) {
+                    slowDown(body, T(0.005f) * delta);
+                }
+            }
+            BasicVec2<T> start = body.pos();
+            if (!(body.vel() == BasicVec2<T>(T(0), T(0)))) {
+                resolveStatic(body, delta);
+            }
+            BasicVec2<T> move = body.pos() - start;
+            body.pos() = start;
+            bodies.push_back(&body);
+            bodyStarts.push_back(start);
+            bodyMoves.push_back(move);
+            bodyBoxes.push_back(sweptAABB(body.aabb(), move));
+        });
+
+        uint64_t broadphaseStart = monotonicNsecs();
+        broadphase.update(bodyBoxes);
+        bodyStats.broadphaseNs = monotonicNsecs() - broadphaseStart;
+        bodyStats.pairs = broadphase.pairCount();
+        bodyStats.contacts = 0;
+
+        for (uint32_t pass = 0; pass < BODY_PASSES; pass++) {
+            bool cut = false;
+            for (uint32_t k = 0; k < broadphase.pairCount(); k++) {
+                bool met = false;
+                cut = collideBodies(broadphase.pairs()[k], met) || cut;
+                if (met && pass == 0) {
+                    bodyStats.contacts++;
+                }
+            }
+            if (!cut) {
+                break;
+            }
+        }
+
+        for (uint32_t i = 0; i < bodies.size(); i++) {
+            bodies[i]->pos() = bodyStarts[i] + bodyMoves[i];
+        }
     }
 
-    void slowDown(float val) {
-        auto& vel = player.vel();
-        if (vel.x < 0) {
-            vel.x = std::min(vel.x + val, 0.0f);
+    // Returns whether the pair's moves had to be cut, met is set when they touch within them
+    bool collideBodies(const BodyPair& pair, bool& met) {
+        BasicVec2<T> relative = bodyMoves[pair.a] - bodyMoves[pair.b];
+        if (relative == BasicVec2<T>(T(0), T(0))) {
+            return false;
+        }
+        // every body has the player's size, b grown by a's half size is its box grown by a whole size
+        BasicVec2<T> center = bodyStarts[pair.b];
+        BasicAABB<T> expanded(center - BasicPlayer<T>::SIZE, center + BasicPlayer<T>::SIZE);
+        BasicVec2<T> contactPoint, contactNormal;
+        T t;
+        if (!doRayCast2D(expanded, bodyStarts[pair.a], relative, contactPoint, contactNormal, t) || t > T(1)) {
+            return false;
+        }
+        met = true;
+
+        auto& a = *bodies[pair.a];
+        auto& b = *bodies[pair.b];
+        auto& moveA = bodyMoves[pair.a];
+        auto& moveB = bodyMoves[pair.b];
+        if (contactNormal.x != T(0)) {
+            moveA.x *= t;
+            moveB.x *= t;
+            T mean = (a.vel().x + b.vel().x) * T(0.5f);
+            a.vel().x = mean;
+            b.vel().x = mean;
         } else {
-            vel.x = std::max(vel.x - val, 0.0f);
+            moveA.y *= t;
+            moveB.y *= t;
+            T mean = (a.vel().y + b.vel().y) * T(0.5f);
+            a.vel().y = mean;
+            b.vel().y = mean;
+            // the normal points from b to a
+            (contactNormal.y > T(0) ? a : b).setOnGround(true);
         }
+        return t < T(1);
     }
 
-    void addVelocityY(float val) {
-        const float VELOCITY_MAX = 5.0f;
+    static bool aabbPenetrates(const BasicAABB<T>& a, const BasicAABB<T>& b) noexcept {
+        return a.v0().x < b.v1().x && b.v0().x < a.v1().x && a.v0().y < b.v1().y && b.v0().y < a.v1().y;
+    }
+
+    // Pushes the player out of a body along the axis of the body's move that needs the shorter push. Squeezing the
+    // player against static geometry is left to the game to detect.
+    void pushOut(const BasicKinematicBody<T>& body) {
+        BasicPlayer<T>& player = this->player();
+        auto box = player.aabb();
+        T pushX = T(0);
+        if (body.moved.x > T(0)) {
+            pushX = body.aabb.v1().x - box.v0().x;
+        } else if (body.moved.x < T(0)) {
+            pushX = body.aabb.v0().x - box.v1().x;
+        }
+        T pushY = T(0);
+        if (body.moved.y > T(0)) {
+            pushY = body.aabb.v1().y - box.v0().y;
+        } else if (body.moved.y < T(0)) {
+            pushY = body.aabb.v0().y - box.v1().y;
+        }
+
         auto& vel = player.vel();
-        vel.y = std::clamp(vel.y + val, -VELOCITY_MAX, VELOCITY_MAX);
+        if (pushX == T(0) || (pushY != T(0) && std::max(pushY, -pushY) <= std::max(pushX, -pushX))) {
+            player.pos().y += pushY;
+            if (pushY > T(0)) {
+                player.setOnGround(true);
+                vel.y = std::max(vel.y, T(0));
+            } else {
+                vel.y = std::min(vel.y, T(0));
+            }
+        } else {
+            player.pos().x += pushX;
+            vel.x = pushX > T(0) ? std::max(vel.x, T(0)) : std::min(vel.x, T(0));
+        }
+    }
+
+    // The player rides a body whose top its feet rest on, found after the move so that landings by either resolver
+    // count the same
+    void findRide() {
+        riding = NOT_RIDING;
+        const BasicPlayer<T>& player = this->player();
+        if (player.vel().y > T(0)) {
+            return;
+        }
+        auto box = player.aabb();
+        BasicAABB<T> feet(box.v0().x, box.v1().x, box.v0().y - RIDE_TOLERANCE, box.v0().y + RIDE_TOLERANCE);
+        kinematics.query(levelQuery(feet), candidates);
+        for (uint32_t i : candidates) {
+            const auto& aabb = kinematics.bodies()[i].aabb;
+            T gap = box.v0().y - aabb.v1().y;
+            if (box.v0().x < aabb.v1().x && aabb.v0().x < box.v1().x && -RIDE_TOLERANCE <= gap && gap <= RIDE_TOLERANCE) {
+                riding = i;
+                return;
+            }
+        }
+    }
+
+    // the nearest face the body's center ran into on each axis, where scale stops it, and the face's normal. A zero
+    // normal is no contact on the axis.
+    struct ScaleStops {
+        BasicVec2<T> face{};
+        BasicVec2<T> normal{};
+    };
+
+    // every contact found scales the move on its axis, in storage order
+    void scale(BasicPlayer<T>& body, T delta) {
+        BasicVec2<T> vel = body.vel();
+        ScaleStops stops;
+
+        for (const auto& object : objects) {
+            collide(body, object.aabb(), delta, vel, stops);
+        }
+
+        if (!kinematics.empty()) {
+            kinematics.query(levelQuery(sweptAABB(body.aabb(), vel * delta)), candidates);
+            for (uint32_t i : candidates) {
+                collide(body, kinematics.bodies()[i].aabb, delta, vel, stops);
+            }
+        }
+
+        if (!chunks.empty()) {
+            // everything the body can touch this tick lies between its start and end positions
+            auto bodyAABB = body.aabb();
+            BasicVec2<T> move = body.vel() * delta;
+            AABB swept = levelQuery(sweptAABB(bodyAABB, move));
+            AABB start = levelQuery(bodyAABB);
+            Vec2 levelMove = Vec2(move);
+
+            for (const auto& chunk : chunks) {
+                if (!aabbOverlaps(chunk.bounds, swept)) {
+                    continue;
+                }
+                const auto& geometry = chunk.level->geometry();
+                geometry.grid.query(swept, candidates);
+                for (uint32_t i : candidates) {
+                    collide(body, BasicAABB<T>(geometry.solids.aabb(i)), delta, vel, stops);
+                }
+                // tiles are found by walking the path rather than through the grid
+                geometry.tiles.sweep(start, levelMove, [&](int32_t tx, int32_t ty) {
+                    collide(body, BasicAABB<T>(geometry.tiles.tileAABB(tx, ty)), delta, vel, stops);
+                });
+            }
+        }
+
+        // The cut move is rounded, with Fixed it can end a step inside the face it was cut at. The next tick's ray
+        // would then start inside the obstacle and miss it, so the center is put back onto the face.
+        BasicVec2<T> pos = body.pos() + vel * delta;
+        if (stops.normal.x > T(0) ? pos.x < stops.face.x : stops.normal.x < T(0) && pos.x > stops.face.x) {
+            pos.x = stops.face.x;
+        }
+        if (stops.normal.y > T(0) ? pos.y < stops.face.y : stops.normal.y < T(0) && pos.y > stops.face.y) {
+            pos.y = stops.face.y;
+        }
+        body.pos() = pos;
+    }
+
+    struct SweepHit {
+        T t;
+        // the face's coordinate on the axis it blocks
+        T face;
+        bool alongY;
+        // the hit is a corner of the obstacle being entered diagonally
+        bool corner;
+
+        bool before(const SweepHit& rhs) const noexcept {
+            if (t != rhs.t) {
+                return t < rhs.t;
+            }
+            if (corner != rhs.corner) {
+                return !corner;
+            }
+            // landing wins over a wall when both happen at once
+            return alongY && !rhs.alongY;
+        }
+    };
+
+    // A face blocks the point when it is reached within the move at a position strictly inside the face. Reaching
+    // the end of a face only blocks when the point would go on into the obstacle, so sliding along a floor or a wall
+    // never catches on the next box's edge.
+    static bool sweepAxis(T p, T move, T low, T high, T q, T moveQ, T lowQ, T highQ, bool alongY, SweepHit& hit) noexcept {
+        if (move == T(0)) {
+            return false;
+        }
+        T face = move > T(0) ? low : high;
+        T distance = face - p;
+        if (move > T(0) ? distance < T(0) || distance > move : distance > T(0) || distance < move) {
+            return false;
+        }
+        T t = distance / move;
+        T at = q + moveQ * t;
+        bool inside = lowQ < at && at < highQ;
+        bool corner = (at == lowQ && moveQ > T(0)) || (at == highQ && moveQ < T(0));
+        if (!inside && !corner) {
+            return false;
+        }
+        hit = {t, face, alongY, corner};
+        return true;
+    }
+
+    void gatherObstacles(const BasicPlayer<T>& body, BasicVec2<T> move) {
+        obstacles.clear();
+        auto add = [&](const BasicAABB<T>& object) {
+            obstacles.emplace_back(object.v0() - BasicPlayer<T>::HALF_SIZE, object.v1() + BasicPlayer<T>::HALF_SIZE);
+        };
+        for (const auto& object : objects) {
+            add(object.aabb());
+        }
+
+        auto bodyAABB = body.aabb();
+        AABB swept = levelQuery(sweptAABB(bodyAABB, move));
+        if (!kinematics.empty()) {
+            kinematics.query(swept, candidates);
+            for (uint32_t i : candidates) {
+                add(kinematics.bodies()[i].aabb);
+            }
+        }
+        AABB start = levelQuery(bodyAABB);
+        Vec2 levelMove = Vec2(move);
+        for (const auto& chunk : chunks) {
+            if (!aabbOverlaps(chunk.bounds, swept)) {
+                continue;
+            }
+            const auto& geometry = chunk.level->geometry();
+            geometry.grid.query(swept, candidates);
+            for (uint32_t i : candidates) {
+                add(BasicAABB<T>(geometry.solids.aabb(i)));
+            }
+            geometry.tiles.sweep(start, levelMove, [&](int32_t tx, int32_t ty) {
+                add(BasicAABB<T>(geometry.tiles.tileAABB(tx, ty)));
+            });
+        }
+    }
+
+    // Moves the body's center as a point through the grown obstacles, stopping at the earliest contact, dropping the
+    // velocity into it and sliding on with what is left of the move. The result does not depend on obstacle order.
+    void sweep(BasicPlayer<T>& body, T delta) {
+        BasicVec2<T> move = body.vel() * delta;
+        gatherObstacles(body, move);
+
+        BasicVec2<T> pos = body.pos();
+        for (uint32_t pass = 0; pass < SWEEP_PASSES; pass++) {
+            SweepHit first{};
+            bool found = false;
+            for (const auto& box : obstacles) {
+                SweepHit hit{};
+                if (sweepAxis(pos.x, move.x, box.v0().x, box.v1().x, pos.y, move.y, box.v0().y, box.v1().y, false, hit)
+                    && (!found || hit.before(first))) {
+                    first = hit;
+                    found = true;
+                }
+                if (sweepAxis(pos.y, move.y, box.v0().y, box.v1().y, pos.x, move.x, box.v0().x, box.v1().x, true, hit)
+                    && (!found || hit.before(first))) {
+                    first = hit;
+                    found = true;
+                }
+            }
+            if (!found) {
+                pos = pos + move;
+                break;
+            }
+
+            // the point is put exactly on the face, so that the next pass sees it touching rather than inside
+            T left = T(1) - first.t;
+            if (first.alongY) {
+                pos = {pos.x + move.x * first.t, first.face};
+                if (move.y < T(0)) {
+                    body.setOnGround(true);
+                }
+                body.vel().y = T(0);
+                move = {move.x * left, T(0)};
+            } else {
+                pos = {first.face, pos.y + move.y * first.t};
+                body.vel().x = T(0);
+                move = {T(0), move.y * left};
+            }
+            if (move == BasicVec2<T>(T(0), T(0))) {
+                break;
+            }
+        }
+        // out of passes the rest of the move is dropped, stopping short is safer than going through
+        body.pos() = pos;
+    }
+
+    void collide(BasicPlayer<T>& body, const BasicAABB<T>& object, T delta, BasicVec2<T>& vel, ScaleStops& stops) {
+        auto bodyAABB = body.aabb();
+        BasicVec2<T> rayOrigin = (bodyAABB.v0() + bodyAABB.v1()) * T(0.5f);
+        BasicVec2<T> rayDirection = {body.vel().x * delta, body.vel().y * delta};
+
+        BasicVec2<T> objectSize = bodyAABB.size();
+
+        BasicAABB<T> expanded = object;
+        expanded.v0().x -= objectSize.x / T(2);
+        expanded.v1().x += objectSize.x / T(2);
+        expanded.v0().y -= objectSize.y / T(2);
+        expanded.v1().y += objectSize.y / T(2);
+
+        BasicVec2<T> contactPoint, contactNormal;
+        T t;
+        if (doRayCast2D(expanded, rayOrigin, rayDirection, contactPoint, contactNormal, t) && t <= T(1)) {
+            if (contactNormal.x != T(0)) {
+                T face = contactNormal.x > T(0) ? expanded.v1().x : expanded.v0().x;
+                if (stops.normal.x == T(0) || (contactNormal.x > T(0) ? face > stops.face.x : face < stops.face.x)) {
+                    stops.face.x = face;
+                    stops.normal.x = contactNormal.x;
+                }
+                vel.x *= t;
+            } else {
+                if (contactNormal.y == T(1)) {
+                    body.setOnGround(true);
+                    body.vel().y = T(0);
+                }
+                T face = contactNormal.y > T(0) ? expanded.v1().y : expanded.v0().y;
+                if (stops.normal.y == T(0) || (contactNormal.y > T(0) ? face > stops.face.y : face < stops.face.y)) {
+                    stops.face.y = face;
+                    stops.normal.y = contactNormal.y;
+                }
+                vel.y *= t;
+            }
+        }
     }
 };
+
+using Projectile = BasicProjectile<float>;
+using World = BasicWorld<float>;
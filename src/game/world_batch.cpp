@@ -0,0 +1,296 @@
+#include "world_batch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "game.h"
+#include "world.h"
+#include "../math/float4.h"
+#include "../util/profiler.h"
+
+WorldBatch::WorldBatch(std::shared_ptr<const Level> level, uint32_t count)
+    : level(std::move(level)), count(count), padded((count + BLOCK - 1) / BLOCK * BLOCK) {
+    if (this->level == nullptr) {
+        throw std::runtime_error("world batch needs a level");
+    }
+    levelBounds = this->level->bounds();
+
+    // sweep only reports tiles the moving box touches, so boxes well clear of the layer can skip it. The margin keeps
+    // the rounding of its tile coordinates out of the question.
+    const TileMap& tiles = this->level->geometry().tiles;
+    if (!tiles.isEmpty()) {
+        AABB bounds = tiles.bounds();
+        float margin = 2.0f * tiles.tileSize;
+        tileReach = AABB(bounds.v0().x - margin, bounds.v1().x + margin, bounds.v0().y - margin, bounds.v1().y + margin);
+    }
+
+    spawn = this->level->spawnCount() != 0 ? Vec2(this->level->spawns()[0].x, this->level->spawns()[0].y) : Vec2(150, 300);
+    reset();
+
+    moving.assign(BLOCK, 0);
+    stepX.assign(BLOCK, 0.0f);
+    stepY.assign(BLOCK, 0.0f);
+    originX.assign(BLOCK, 0.0f);
+    originY.assign(BLOCK, 0.0f);
+    halfWidth.assign(BLOCK, 0.0f);
+    halfHeight.assign(BLOCK, 0.0f);
+    stopLowX.assign(BLOCK, 0.0f);
+    stopHighX.assign(BLOCK, 0.0f);
+    stopLowY.assign(BLOCK, 0.0f);
+    stopHighY.assign(BLOCK, 0.0f);
+    contactCount.assign(BLOCK, 0.0f);
+    groupContacts.assign(BLOCK / LANES, 0);
+}
+
+void WorldBatch::reset() {
+    posX.assign(padded, spawn.x);
+    posY.assign(padded, spawn.y);
+    velX.assign(padded, 0.0f);
+    velY.assign(padded, 0.0f);
+    onGround.assign(padded, 0);
+    moveLeft.assign(padded, 0);
+    moveRight.assign(padded, 0);
+}
+
+void WorldBatch::process(float delta) {
+    PROFILE_ZONE("WorldBatch::process");
+
+    // same split as Game::process
+    uint32_t substeps = 0;
+    float leftDelta = delta;
+    if (delta > PHYSICS_SUBSTEP_DELTA_MAX) {
+        float wholeSubsteps = std::trunc(delta / PHYSICS_SUBSTEP_DELTA_MAX);
+        leftDelta = delta - wholeSubsteps * PHYSICS_SUBSTEP_DELTA_MAX;
+        substeps = static_cast<uint32_t>(wholeSubsteps);
+    }
+
+    // instances do not interact, so a block can run the whole step before the next one starts
+    uint32_t lanes = (count + LANES - 1) / LANES * LANES;
+    for (uint32_t first = 0; first < lanes; first += BLOCK) {
+        uint32_t blockLanes = std::min(BLOCK, lanes - first);
+        for (uint32_t i = 0; i < substeps; i++) {
+            process_(first, blockLanes, PHYSICS_SUBSTEP_DELTA_MAX);
+        }
+        process_(first, blockLanes, leftDelta);
+    }
+}
+
+void WorldBatch::process_(uint32_t first, uint32_t lanes, float delta) {
+    // the constants Game::process_ and World::tick compute, in the same order
+    const Float4 accelRight = Float4::splat(0.011f * delta);
+    const Float4 accelLeft = Float4::splat(-0.011f * delta);
+    const Float4 friction = Float4::splat(0.005f * delta);
+    const Float4 gravity = Float4::splat(-0.005f * delta);
+    const Float4 maxVelX = Float4::splat(0.8f);
+    const Float4 minVelX = Float4::splat(-0.8f);
+    const Float4 maxVelY = Float4::splat(5.0f);
+    const Float4 minVelY = Float4::splat(-5.0f);
+    const Float4 zero = Float4::splat(0.0f);
+    const Float4 d = Float4::splat(delta);
+
+    // Game::process_ and the start of World::tick
+    uint32_t layers = 0;
+    for (uint32_t group = 0; group < lanes; group += LANES) {
+        uint32_t base = first + group;
+        Float4 vx = Float4::load(&velX[base]);
+        Float4 vy = Float4::load(&velY[base]);
+        Mask4 left = Mask4::load(&moveLeft[base]);
+        Mask4 right = Mask4::load(&moveRight[base]);
+        Mask4 ground = Mask4::load(&onGround[base]);
+
+        Float4 slowed = select(vx < zero, min4(vx + friction, zero), max4(vx - friction, zero));
+        vx = select(left & ~right, clamp4(vx + accelLeft, minVelX, maxVelX), //
+                    select(right & ~left, clamp4(vx + accelRight, minVelX, maxVelX), select(ground, slowed, vx)));
+        vy = clamp4(vy + gravity, minVelY, maxVelY);
+
+        vx.store(&velX[base]);
+        vy.store(&velY[base]);
+        vx.store(&stepX[group]);
+        vy.store(&stepY[group]);
+
+        Mask4 isMoving = (vx != zero) | (vy != zero);
+        isMoving.store(&moving[group]);
+
+        uint32_t longest = 0;
+        if (isMoving.any()) {
+            for (uint32_t i = group; i < group + LANES; i++) {
+                findContacts(first, i, delta);
+                longest = std::max(longest, static_cast<uint32_t>(contactCount[i]));
+            }
+        } else {
+            zero.store(&contactCount[group]);
+        }
+        groupContacts[group / LANES] = longest;
+        layers = std::max(layers, longest);
+
+        // the player box World::collide derives from the position
+        Float4 px = Float4::load(&posX[base]);
+        Float4 py = Float4::load(&posY[base]);
+        Float4 x0 = Float4::splat(-Player::HALF_SIZE.x) + px;
+        Float4 x1 = Float4::splat(Player::HALF_SIZE.x) + px;
+        Float4 y0 = Float4::splat(-Player::HALF_SIZE.y) + py;
+        Float4 y1 = Float4::splat(Player::HALF_SIZE.y) + py;
+        ((x0 + x1) * Float4::splat(0.5f)).store(&originX[group]);
+        ((y0 + y1) * Float4::splat(0.5f)).store(&originY[group]);
+        ((x1 - x0) / Float4::splat(2.0f)).store(&halfWidth[group]);
+        ((y1 - y0) / Float4::splat(2.0f)).store(&halfHeight[group]);
+        Float4::splat(-INFINITY).store(&stopLowX[group]);
+        Float4::splat(INFINITY).store(&stopHighX[group]);
+        Float4::splat(-INFINITY).store(&stopLowY[group]);
+        Float4::splat(INFINITY).store(&stopHighY[group]);
+    }
+
+    // layer by layer rather than instance by instance, so that the groups of one layer are independent of each other
+    // and their divisions overlap
+    for (uint32_t k = 0; k < layers; k++) {
+        collideLayer(first, lanes, k, delta);
+    }
+
+    for (uint32_t group = 0; group < lanes; group += LANES) {
+        uint32_t base = first + group;
+        Mask4 isMoving = Mask4::load(&moving[group]);
+        Float4 px = Float4::load(&posX[base]);
+        Float4 py = Float4::load(&posY[base]);
+        // put back onto the faces the moves were cut at, like World::scale
+        Float4 lowX = Float4::load(&stopLowX[group]);
+        Float4 highX = Float4::load(&stopHighX[group]);
+        Float4 lowY = Float4::load(&stopLowY[group]);
+        Float4 highY = Float4::load(&stopHighY[group]);
+        Float4 nx = px + Float4::load(&stepX[group]) * d;
+        Float4 ny = py + Float4::load(&stepY[group]) * d;
+        nx = select(nx < lowX, lowX, select(nx > highX, highX, nx));
+        ny = select(ny < lowY, lowY, select(ny > highY, highY, ny));
+        select(isMoving, nx, px).store(&posX[base]);
+        select(isMoving, ny, py).store(&posY[base]);
+    }
+}
+
+void WorldBatch::findContacts(uint32_t first, uint32_t i, float delta) {
+    uint32_t found = 0;
+    if (first + i < count && moving[i] != 0) {
+        Vec2 pos(posX[first + i], posY[first + i]);
+        AABB playerAABB(-Player::HALF_SIZE + pos, Player::HALF_SIZE + pos);
+        Vec2 move = Vec2(velX[first + i], velY[first + i]) * delta;
+        AABB swept = sweptAABB(playerAABB, move);
+
+        if (aabbOverlaps(levelBounds, swept)) {
+            auto push = [&](const AABB& box) {
+                if (found == contactLayers) {
+                    contactLayers++;
+                    contactX0.resize(contactLayers * BLOCK);
+                    contactX1.resize(contactLayers * BLOCK);
+                    contactY0.resize(contactLayers * BLOCK);
+                    contactY1.resize(contactLayers * BLOCK);
+                }
+                uint32_t slot = found * BLOCK + i;
+                contactX0[slot] = box.v0().x;
+                contactX1[slot] = box.v1().x;
+                contactY0[slot] = box.v0().y;
+                contactY1[slot] = box.v1().y;
+                found++;
+            };
+
+            const auto& geometry = level->geometry();
+            if (!geometry.grid.isEmpty()) {
+                // a query only depends on the cells it covers, and neighbours usually cover the same ones
+                uint32_t cells[4] = {
+                    geometry.grid.cellX(swept.v0().x),
+                    geometry.grid.cellX(swept.v1().x),
+                    geometry.grid.cellY(swept.v0().y),
+                    geometry.grid.cellY(swept.v1().y),
+                };
+                if (!candidatesValid || !std::equal(cells, cells + 4, candidateCells)) {
+                    geometry.grid.query(swept, candidates);
+                    std::copy(cells, cells + 4, candidateCells);
+                    candidatesValid = true;
+                }
+                for (uint32_t solid : candidates) {
+                    push(geometry.solids.aabb(solid));
+                }
+            }
+            if (aabbOverlaps(tileReach, swept)) {
+                geometry.tiles.sweep(playerAABB, move, [&](int32_t tx, int32_t ty) { push(geometry.tiles.tileAABB(tx, ty)); });
+            }
+        }
+    }
+    contactCount[i] = static_cast<float>(found);
+}
+
+void WorldBatch::collideLayer(uint32_t first, uint32_t lanes, uint32_t k, float delta) {
+    const Float4 d = Float4::splat(delta);
+    const Float4 zero = Float4::splat(0.0f);
+    const Float4 one = Float4::splat(1.0f);
+    const Float4 layer = Float4::splat(static_cast<float>(k));
+    const uint32_t offset = k * BLOCK;
+
+    for (uint32_t group = 0; group < lanes; group += LANES) {
+        if (groupContacts[group / LANES] <= k) {
+            continue;
+        }
+        uint32_t base = first + group;
+        // lanes without a k-th box test whatever the layer holds and ignore the result
+        Mask4 present = layer < Float4::load(&contactCount[group]);
+
+        Float4 halfW = Float4::load(&halfWidth[group]);
+        Float4 halfH = Float4::load(&halfHeight[group]);
+        Float4 ox = Float4::load(&originX[group]);
+        Float4 oy = Float4::load(&originY[group]);
+        // collisions only ever zero the player's y velocity, its x is what the velocity rules left
+        Float4 dirX = Float4::load(&velX[base]) * d;
+        Float4 vy = Float4::load(&velY[base]);
+        Float4 dirY = vy * d;
+
+        // doRayCast2D against the box expanded by the player size
+        Float4 face0X = Float4::load(&contactX0[offset + group]) - halfW;
+        Float4 face0Y = Float4::load(&contactY0[offset + group]) - halfH;
+        Float4 face1X = Float4::load(&contactX1[offset + group]) + halfW;
+        Float4 face1Y = Float4::load(&contactY1[offset + group]) + halfH;
+        Float4 pos0X = face0X - ox;
+        Float4 pos0Y = face0Y - oy;
+        Float4 pos1X = face1X - ox;
+        Float4 pos1Y = face1Y - oy;
+
+        Float4 nearY = pos0X / dirX;
+        Float4 nearX = pos1Y / dirY;
+        Float4 farY = pos1X / dirX;
+        Float4 farX = pos0Y / dirY;
+
+        Mask4 swapX = nearX > farX;
+        Float4 sortedNearX = select(swapX, farX, nearX);
+        farX = select(swapX, nearX, farX);
+        nearX = sortedNearX;
+        Mask4 swapY = nearY > farY;
+        Float4 sortedNearY = select(swapY, farY, nearY);
+        farY = select(swapY, nearY, farY);
+        nearY = sortedNearY;
+
+        Float4 tNear = max4(nearX, nearY);
+        Float4 tFar = min4(farX, farY);
+        Mask4 hit = present & (nearY < farX) & (nearX < farY) & ~((tNear < zero) | (tFar < zero)) & (tNear <= one);
+
+        Mask4 normalX = nearY >= nearX;
+        Mask4 hitX = hit & normalX;
+        Mask4 hitY = hit & ~normalX;
+        Mask4 landed = hitY & (dirY < zero);
+
+        // the nearest face on each side, a move only ever hits faces on one side of an axis
+        Mask4 hitLeft = hitX & (dirX < zero);
+        Mask4 hitRight = hitX & ~(dirX < zero);
+        Float4 lowX = Float4::load(&stopLowX[group]);
+        Float4 highX = Float4::load(&stopHighX[group]);
+        Float4 lowY = Float4::load(&stopLowY[group]);
+        Float4 highY = Float4::load(&stopHighY[group]);
+        select(hitLeft & (face1X > lowX), face1X, lowX).store(&stopLowX[group]);
+        select(hitRight & (face0X < highX), face0X, highX).store(&stopHighX[group]);
+        select(landed & (face1Y > lowY), face1Y, lowY).store(&stopLowY[group]);
+        select(hitY & ~landed & (face0Y < highY), face0Y, highY).store(&stopHighY[group]);
+
+        Float4 sx = Float4::load(&stepX[group]);
+        Float4 sy = Float4::load(&stepY[group]);
+        select(hitX, sx * tNear, sx).store(&stepX[group]);
+        select(hitY, sy * tNear, sy).store(&stepY[group]);
+        select(landed, zero, vy).store(&velY[base]);
+        (Mask4::load(&onGround[base]) | landed).store(&onGround[base]);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AABB.h"
+#include "level.h"
+#include "player.h"
+
+// Many independent players on one shared level, stepped in lockstep. Each instance behaves exactly like a
+// Game(level) with the same inputs: every step is bit-identical to calling Game::process on it alone.
+//
+// Players are stored as structure of arrays and stepped four at a time with Float4, which runs the same IEEE
+// operations in the same order as the scalar code. Finding what a player may hit is still done per instance with the
+// level's grid and tile sweep, only the velocity rules, the ray casts against the found boxes and the integration are
+// vectorized. Instances have no dynamic objects.
+class WorldBatch {
+public:
+    static inline constexpr uint32_t LANES = 4;
+    // instances taken through all substeps of a step together, small enough for their scratch to stay in L1
+    static inline constexpr uint32_t BLOCK = 64;
+
+private:
+    std::shared_ptr<const Level> level;
+    AABB levelBounds;
+    // the tile layer's bounds with a margin, nothing overlaps it when the level has no tiles
+    AABB tileReach{INFINITY, -INFINITY, INFINITY, -INFINITY};
+    uint32_t count;
+    // storage is rounded up to BLOCK, lanes up to the next multiple of LANES are stepped like the others and never read
+    uint32_t padded;
+    Vec2 spawn{};
+
+    // flags are all ones or zero so that they load as Mask4
+    std::vector<float> posX{};
+    std::vector<float> posY{};
+    std::vector<float> velX{};
+    std::vector<float> velY{};
+    std::vector<uint32_t> onGround{};
+    std::vector<uint32_t> moveLeft{};
+    std::vector<uint32_t> moveRight{};
+
+    // per substep scratch for one block, indexed from the block's first instance
+    std::vector<uint32_t> moving{};
+    // World::tick's local vel, scaled down by every hit
+    std::vector<float> stepX{};
+    std::vector<float> stepY{};
+    std::vector<float> originX{};
+    std::vector<float> originY{};
+    std::vector<float> halfWidth{};
+    std::vector<float> halfHeight{};
+    // the faces World::scale stops the move at, infinite when there are none
+    std::vector<float> stopLowX{};
+    std::vector<float> stopHighX{};
+    std::vector<float> stopLowY{};
+    std::vector<float> stopHighY{};
+    // boxes to test, layer k holds the k-th box of every instance at k * BLOCK + i. Counts are floats so that lanes
+    // compare them against k directly.
+    std::vector<float> contactCount{};
+    std::vector<uint32_t> groupContacts{};
+    uint32_t contactLayers = 0;
+    std::vector<float> contactX0{};
+    std::vector<float> contactX1{};
+    std::vector<float> contactY0{};
+    std::vector<float> contactY1{};
+    std::vector<uint32_t> candidates{};
+    // the grid cells candidates were queried for
+    uint32_t candidateCells[4]{};
+    bool candidatesValid = false;
+
+public:
+    // Every instance starts where Game(level) would
+    WorldBatch(std::shared_ptr<const Level> level, uint32_t count);
+
+    // Puts every instance back at the spawn point with no velocity and no input
+    void reset();
+
+    uint32_t size() const noexcept {
+        return count;
+    }
+
+    void setInput(uint32_t i, bool left, bool right) noexcept {
+        moveLeft[i] = left ? 0xffffffff : 0;
+        moveRight[i] = right ? 0xffffffff : 0;
+    }
+
+    // Game::playerJump
+    void jump(uint32_t i) noexcept {
+        velY[i] = 2.5f;
+        onGround[i] = 0;
+    }
+
+    // Game::process on every instance
+    void process(float delta);
+
+    Vec2 pos(uint32_t i) const noexcept {
+        return {posX[i], posY[i]};
+    }
+
+    Vec2 vel(uint32_t i) const noexcept {
+        return {velX[i], velY[i]};
+    }
+
+    bool isOnGround(uint32_t i) const noexcept {
+        return onGround[i] != 0;
+    }
+
+private:
+    // Game::process_ on instances first .. first + lanes - 1
+    void process_(uint32_t first, uint32_t lanes, float delta);
+
+    // Collects what instance first + i can touch this substep, in the order World::tick tests it
+    void findContacts(uint32_t first, uint32_t i, float delta);
+
+    // One World::collide for every instance of the block that has a k-th box
+    void collideLayer(uint32_t first, uint32_t lanes, uint32_t k, float delta);
+};
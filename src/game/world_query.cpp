@@ -0,0 +1,281 @@
+#include "world_query.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "raycast.h"
+#include "../util/profiler.h"
+
+void WorldQuery::update(const World& world) {
+    if (levelVersion != world.levelVersion) {
+        PROFILE_ZONE("WorldQuery::buildStatics");
+        staticBoxes.clear();
+        for (const auto& object : world.objects) {
+            staticBoxes.push_back(object.aabb());
+        }
+        for (const auto& chunk : world.chunks) {
+            const auto& geometry = chunk.level->geometry();
+            for (uint32_t i = 0; i < geometry.solids.count; i++) {
+                staticBoxes.push_back(geometry.solids.aabb(i));
+            }
+            // a run's box has the edges of its first and last tiles, the ones the physics tests
+            const TileMap& tiles = geometry.tiles;
+            tiles.forEachSolidRun([&](int32_t tx0, int32_t tx1, int32_t ty) {
+                AABB first = tiles.tileAABB(tx0, ty);
+                AABB last = tiles.tileAABB(tx1, ty);
+                staticBoxes.emplace_back(first.v0().x, last.v1().x, first.v0().y, first.v1().y);
+            });
+        }
+        statics.build(staticBoxes);
+        levelVersion = world.levelVersion;
+    }
+
+    if (kinematicsVersion != world.kinematics.version()) {
+        PROFILE_ZONE("WorldQuery::refitPlatforms");
+        platformBoxes.clear();
+        for (const auto& body : world.kinematics.bodies()) {
+            platformBoxes.push_back(body.aabb);
+        }
+        if (platformBoxes.size() == platforms.size()) {
+            platforms.refit(platformBoxes);
+        } else {
+            platforms.build(platformBoxes);
+        }
+        kinematicsVersion = world.kinematics.version();
+    }
+}
+
+bool WorldQuery::castFirst(Vec2 origin, Vec2 dir, Vec2 grow, WorldHit& hit) const {
+    float staticT = 1.0f;
+    uint32_t staticHit = statics.raycastFirst(origin, dir, 1.0f, grow, staticT);
+    float platformT = 1.0f;
+    uint32_t platformHit = platforms.raycastFirst(origin, dir, staticT, grow, platformT);
+    return resolveFirst(origin, dir, grow, staticHit, staticT, platformHit, platformT, hit);
+}
+
+bool WorldQuery::resolveFirst(Vec2 origin, Vec2 dir, Vec2 grow, uint32_t staticHit, float staticT, uint32_t platformHit, float platformT,
+                              WorldHit& hit) const {
+    AABB box;
+    if (platformHit != BoxTree::NONE && (staticHit == BoxTree::NONE || platformT < staticT)) {
+        hit.shape = {WorldShapeKind::KINEMATIC, platformHit};
+        box = platformBoxes[platformHit];
+    } else if (staticHit != BoxTree::NONE) {
+        hit.shape = {WorldShapeKind::STATIC, staticHit};
+        box = staticBoxes[staticHit];
+    } else {
+        hit = {};
+        return false;
+    }
+    // the same operations the tree ran, so the same t
+    AABB grown(box.v0() - grow, box.v1() + grow);
+    doRayCast2D(grown, origin, dir, hit.point, hit.normal, hit.t);
+    return true;
+}
+
+void WorldQuery::castFirst(const BoxTree::RayPacket& packet, const uint32_t* slots, WorldHit* hits) const {
+    float maxT[BoxTree::LEAF_SIZE] = {1.0f, 1.0f, 1.0f, 1.0f};
+    uint32_t staticHits[BoxTree::LEAF_SIZE];
+    float staticT[BoxTree::LEAF_SIZE];
+    statics.raycastFirst(packet, maxT, staticHits, staticT);
+    uint32_t platformHits[BoxTree::LEAF_SIZE];
+    float platformT[BoxTree::LEAF_SIZE];
+    platforms.raycastFirst(packet, staticT, platformHits, platformT);
+    for (uint32_t k = 0; k < packet.count; k++) {
+        resolveFirst(packet.origin[k], packet.dir[k], packet.grow[k], staticHits[k], staticT[k], platformHits[k], platformT[k],
+                     hits[slots[k]]);
+    }
+}
+
+// The order to cast count rays in, by where they start along a Z curve and then by the quadrant they point into, so
+// that the rays grouped into a packet start near each other
+template <typename R>
+static std::vector<uint32_t> coherentOrder(uint32_t count, R&& ray) {
+    float minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY;
+    for (uint32_t i = 0; i < count; i++) {
+        Vec2 origin = ray(i).origin;
+        minX = std::min(minX, origin.x);
+        maxX = std::max(maxX, origin.x);
+        minY = std::min(minY, origin.y);
+        maxY = std::max(maxY, origin.y);
+    }
+    // origins are quantized to 15 bits a side, 30 bits of curve and 2 of quadrant
+    float scaleX = maxX > minX ? 32767.0f / (maxX - minX) : 0.0f;
+    float scaleY = maxY > minY ? 32767.0f / (maxY - minY) : 0.0f;
+    auto spread = [](uint32_t v) {
+        v = (v | v << 8) & 0x00ff00ffu;
+        v = (v | v << 4) & 0x0f0f0f0fu;
+        v = (v | v << 2) & 0x33333333u;
+        return (v | v << 1) & 0x55555555u;
+    };
+    // NaN and infinite origins land at the ends of the curve
+    auto cell = [](float v) {
+        return v > 0.0f ? static_cast<uint32_t>(std::min(v, 32767.0f)) : 0u;
+    };
+    std::vector<uint64_t> keys(count);
+    for (uint32_t i = 0; i < count; i++) {
+        WorldRay r = ray(i);
+        uint32_t quadrant = (r.dir.x < 0.0f ? 1u : 0u) | (r.dir.y < 0.0f ? 2u : 0u);
+        uint32_t key = (spread(cell((r.origin.x - minX) * scaleX)) | spread(cell((r.origin.y - minY) * scaleY)) << 1) << 2 | quadrant;
+        keys[i] = static_cast<uint64_t>(key) << 32 | i;
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<uint32_t> order(count);
+    for (uint32_t i = 0; i < count; i++) {
+        order[i] = static_cast<uint32_t>(keys[i]);
+    }
+    return order;
+}
+
+// Lays results found query by query in some order out as out[start[i]] .. out[start[i + 1]] in query order, those of
+// query i are found[foundStart[i]] .. found[foundStart[i] + foundCount[i]]
+template <typename T>
+static void layOut(const std::vector<T>& found, const std::vector<uint32_t>& foundStart, const std::vector<uint32_t>& foundCount,
+                   std::vector<T>& out, std::vector<uint32_t>& start) {
+    auto count = static_cast<uint32_t>(foundStart.size());
+    out.resize(found.size());
+    start.resize(static_cast<size_t>(count) + 1);
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        start[i] = next;
+        std::copy_n(found.begin() + foundStart[i], foundCount[i], out.begin() + next);
+        next += foundCount[i];
+    }
+    start[count] = next;
+}
+
+template <typename R>
+void WorldQuery::castFirst(uint32_t count, R&& ray, WorldHit* hits) const {
+    std::vector<uint32_t> order = coherentOrder(count, [&](uint32_t i) { return ray(i).first; });
+    BoxTree::RayPacket packet;
+    for (uint32_t begin = 0; begin < count; begin += BoxTree::LEAF_SIZE) {
+        packet.count = std::min(count - begin, BoxTree::LEAF_SIZE);
+        for (uint32_t k = 0; k < packet.count; k++) {
+            auto [r, grow] = ray(order[begin + k]);
+            packet.origin[k] = r.origin;
+            packet.dir[k] = r.dir;
+            packet.grow[k] = grow;
+        }
+        castFirst(packet, &order[begin], hits);
+    }
+}
+
+static WorldHit hitOf(WorldShapeKind kind, const AABB& box, uint32_t index, Vec2 origin, Vec2 dir) {
+    WorldHit hit;
+    hit.shape = {kind, index};
+    doRayCast2D(box, origin, dir, hit.point, hit.normal, hit.t);
+    return hit;
+}
+
+static void sortHits(std::vector<WorldHit>::iterator begin, std::vector<WorldHit>::iterator end) {
+    std::sort(begin, end, [](const WorldHit& a, const WorldHit& b) {
+        if (a.t != b.t) {
+            return a.t < b.t;
+        }
+        if (a.shape.kind != b.shape.kind) {
+            return a.shape.kind < b.shape.kind;
+        }
+        return a.shape.index < b.shape.index;
+    });
+}
+
+void WorldQuery::castAll(Vec2 origin, Vec2 dir, std::vector<WorldHit>& out) const {
+    auto first = out.size();
+    statics.raycastAll(origin, dir, 1.0f, {0.0f, 0.0f}, [&](uint32_t i, float) {
+        out.push_back(hitOf(WorldShapeKind::STATIC, staticBoxes[i], i, origin, dir));
+    });
+    platforms.raycastAll(origin, dir, 1.0f, {0.0f, 0.0f}, [&](uint32_t i, float) {
+        out.push_back(hitOf(WorldShapeKind::KINEMATIC, platformBoxes[i], i, origin, dir));
+    });
+    sortHits(out.begin() + static_cast<ptrdiff_t>(first), out.end());
+}
+
+void WorldQuery::overlapAll(const AABB& box, std::vector<WorldShape>& out) const {
+    auto first = out.size();
+    statics.overlap(box, [&](uint32_t i) { out.push_back({WorldShapeKind::STATIC, i}); });
+    auto platformFirst = out.size();
+    platforms.overlap(box, [&](uint32_t i) { out.push_back({WorldShapeKind::KINEMATIC, i}); });
+    auto byIndex = [](const WorldShape& a, const WorldShape& b) { return a.index < b.index; };
+    std::sort(out.begin() + static_cast<ptrdiff_t>(first), out.begin() + static_cast<ptrdiff_t>(platformFirst), byIndex);
+    std::sort(out.begin() + static_cast<ptrdiff_t>(platformFirst), out.end(), byIndex);
+}
+
+bool WorldQuery::raycastFirst(const WorldRay& ray, WorldHit& hit) const {
+    return castFirst(ray.origin, ray.dir, {0.0f, 0.0f}, hit);
+}
+
+void WorldQuery::raycastAll(const WorldRay& ray, std::vector<WorldHit>& out) const {
+    out.clear();
+    castAll(ray.origin, ray.dir, out);
+}
+
+void WorldQuery::overlapBox(const AABB& box, std::vector<WorldShape>& out) const {
+    out.clear();
+    overlapAll(box, out);
+}
+
+bool WorldQuery::sweepBox(const WorldSweep& sweep, WorldHit& hit) const {
+    Vec2 center = (sweep.box.v0() + sweep.box.v1()) * 0.5f;
+    Vec2 halfSize = sweep.box.size() * 0.5f;
+    return castFirst(center, sweep.move, halfSize, hit);
+}
+
+void WorldQuery::raycastFirst(const WorldRay* rays, uint32_t count, WorldHit* hits) const {
+    PROFILE_ZONE("WorldQuery::raycastFirst");
+    castFirst(count, [&](uint32_t i) { return std::pair(rays[i], Vec2(0.0f, 0.0f)); }, hits);
+}
+
+void WorldQuery::raycastAll(const WorldRay* rays, uint32_t count, std::vector<WorldHit>& hits, std::vector<uint32_t>& hitStart) const {
+    PROFILE_ZONE("WorldQuery::raycastAll");
+    std::vector<uint32_t> order = coherentOrder(count, [&](uint32_t i) { return rays[i]; });
+    std::vector<WorldHit> found;
+    std::vector<uint32_t> foundStart(count);
+    std::vector<uint32_t> foundCount(count);
+    std::vector<WorldHit> laneHits[BoxTree::LEAF_SIZE];
+    const float maxT[BoxTree::LEAF_SIZE] = {1.0f, 1.0f, 1.0f, 1.0f};
+    BoxTree::RayPacket packet;
+    for (uint32_t begin = 0; begin < count; begin += BoxTree::LEAF_SIZE) {
+        packet.count = std::min(count - begin, BoxTree::LEAF_SIZE);
+        for (uint32_t k = 0; k < packet.count; k++) {
+            packet.origin[k] = rays[order[begin + k]].origin;
+            packet.dir[k] = rays[order[begin + k]].dir;
+            laneHits[k].clear();
+        }
+        statics.raycastAll(packet, maxT, [&](uint32_t k, uint32_t i, float) {
+            laneHits[k].push_back(hitOf(WorldShapeKind::STATIC, staticBoxes[i], i, packet.origin[k], packet.dir[k]));
+        });
+        platforms.raycastAll(packet, maxT, [&](uint32_t k, uint32_t i, float) {
+            laneHits[k].push_back(hitOf(WorldShapeKind::KINEMATIC, platformBoxes[i], i, packet.origin[k], packet.dir[k]));
+        });
+        for (uint32_t k = 0; k < packet.count; k++) {
+            uint32_t i = order[begin + k];
+            sortHits(laneHits[k].begin(), laneHits[k].end());
+            foundStart[i] = static_cast<uint32_t>(found.size());
+            foundCount[i] = static_cast<uint32_t>(laneHits[k].size());
+            found.insert(found.end(), laneHits[k].begin(), laneHits[k].end());
+        }
+    }
+    layOut(found, foundStart, foundCount, hits, hitStart);
+}
+
+void WorldQuery::overlapBox(const AABB* boxes, uint32_t count, std::vector<WorldShape>& shapes, std::vector<uint32_t>& shapeStart) const {
+    PROFILE_ZONE("WorldQuery::overlapBox");
+    std::vector<uint32_t> order = coherentOrder(count, [&](uint32_t i) { return WorldRay{boxes[i].v0(), {0.0f, 0.0f}}; });
+    std::vector<WorldShape> found;
+    std::vector<uint32_t> foundStart(count);
+    std::vector<uint32_t> foundCount(count);
+    for (uint32_t i : order) {
+        foundStart[i] = static_cast<uint32_t>(found.size());
+        overlapAll(boxes[i], found);
+        foundCount[i] = static_cast<uint32_t>(found.size()) - foundStart[i];
+    }
+    layOut(found, foundStart, foundCount, shapes, shapeStart);
+}
+
+void WorldQuery::sweepBox(const WorldSweep* sweeps, uint32_t count, WorldHit* hits) const {
+    PROFILE_ZONE("WorldQuery::sweepBox");
+    // a sweep is the ray of the box's centre against every shape grown by half the box
+    castFirst(count, [&](uint32_t i) {
+        const AABB& box = sweeps[i].box;
+        return std::pair(WorldRay{(box.v0() + box.v1()) * 0.5f, sweeps[i].move}, box.size() * 0.5f);
+    }, hits);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "AABB.h"
+#include "box_tree.h"
+#include "world.h"
+
+enum class WorldShapeKind : uint8_t {
+    // an index into WorldQuery::staticBox: objects, chunk solids and runs of solid tiles
+    STATIC,
+    // an index into World::kinematics
+    KINEMATIC,
+};
+
+struct WorldShape {
+    WorldShapeKind kind;
+    uint32_t index;
+};
+
+// origin + dir * t for t in [0, 1]
+struct WorldRay {
+    Vec2 origin;
+    Vec2 dir;
+};
+
+struct WorldSweep {
+    AABB box;
+    Vec2 move;
+};
+
+struct WorldHit {
+    WorldShape shape{};
+    // INFINITY for a miss in the batched queries
+    float t = INFINITY;
+    // where the ray is at t, for sweeps where the box's centre is
+    Vec2 point{};
+    Vec2 normal{};
+
+    bool isHit() const noexcept {
+        return t <= 1.0f;
+    }
+};
+
+// Ray, box and sweep queries against a World's solids, for line of sight, ledge detection and AI sensing. Static
+// geometry is kept in a BoxTree rebuilt when the level changes and platforms in another one refit as they move.
+// Rays hit boxes under doRayCast2D's rule, a ray starting inside a box does not hit it.
+//
+// Queries are const and keep no scratch, so any number of threads may run them at once while nothing calls update.
+// The batched variants take a range of queries, so threads can split one batch between them. They run the queries in
+// the order of where they start along a Z curve, so that neighbouring queries find the same nodes in cache, and the
+// first hit ones walk the trees four rays at a time. For thousands of queries spread over a level that is cheaper
+// than running them one by one, and the results are the same.
+class WorldQuery {
+    BoxTree statics{};
+    BoxTree platforms{};
+    std::vector<AABB> staticBoxes{};
+    // where the platforms were at the last update
+    std::vector<AABB> platformBoxes{};
+    uint64_t levelVersion = 0;
+    uint64_t kinematicsVersion = 0;
+
+public:
+    // Brings the trees up to date with world: the static one is rebuilt when its levelVersion changed, the platform one
+    // refit when a platform moved and rebuilt when platforms were added or removed. Call it between ticks.
+    void update(const World& world);
+
+    const AABB& staticBox(uint32_t i) const noexcept {
+        return staticBoxes[i];
+    }
+
+    uint32_t staticCount() const noexcept {
+        return static_cast<uint32_t>(staticBoxes.size());
+    }
+
+    // The nearest hit, ties going to static shapes and then to lower indices
+    bool raycastFirst(const WorldRay& ray, WorldHit& hit) const;
+
+    // Replaces out with every hit, nearest first
+    void raycastAll(const WorldRay& ray, std::vector<WorldHit>& out) const;
+
+    // Replaces out with every shape that overlaps or touches box, statics first and by index
+    void overlapBox(const AABB& box, std::vector<WorldShape>& out) const;
+
+    // Where box moving by move first touches a shape, the same contact World's sweep resolver finds
+    bool sweepBox(const WorldSweep& sweep, WorldHit& hit) const;
+
+    // hits[i] is the first hit of rays[i]
+    void raycastFirst(const WorldRay* rays, uint32_t count, WorldHit* hits) const;
+
+    // Replaces hits with the hits of every ray, nearest first. The hits of rays[i] are hits[hitStart[i]] ..
+    // hits[hitStart[i + 1]].
+    void raycastAll(const WorldRay* rays, uint32_t count, std::vector<WorldHit>& hits, std::vector<uint32_t>& hitStart) const;
+
+    // Replaces shapes with what every box overlaps, those of boxes[i] are shapes[shapeStart[i]] .. shapes[shapeStart[i + 1]]
+    void overlapBox(const AABB* boxes, uint32_t count, std::vector<WorldShape>& shapes, std::vector<uint32_t>& shapeStart) const;
+
+    // hits[i] is the first contact of sweeps[i]
+    void sweepBox(const WorldSweep* sweeps, uint32_t count, WorldHit* hits) const;
+
+private:
+    bool castFirst(Vec2 origin, Vec2 dir, Vec2 grow, WorldHit& hit) const;
+
+    // the nearer of the static and platform hits, or a miss
+    bool resolveFirst(Vec2 origin, Vec2 dir, Vec2 grow, uint32_t staticHit, float staticT, uint32_t platformHit, float platformT,
+                      WorldHit& hit) const;
+
+    // ray k of packet writes hits[slots[k]]
+    void castFirst(const BoxTree::RayPacket& packet, const uint32_t* slots, WorldHit* hits) const;
+
+    // casts the rays ray(i) returns as (ray, grow) pairs in packets, hits[i] is the first hit of ray(i)
+    template <typename R>
+    void castFirst(uint32_t count, R&& ray, WorldHit* hits) const;
+
+    void castAll(Vec2 origin, Vec2 dir, std::vector<WorldHit>& out) const;
+
+    void overlapAll(const AABB& box, std::vector<WorldShape>& out) const;
+};
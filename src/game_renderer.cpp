@@ -1,14 +1,11 @@
 #include "game_renderer.h"
 
-static void copyBuffer(
-    const PhysicalDevice& physicalDevice, //
-    Device device,
-    VkCommandPool commandPool,
-    VkQueue graphicsQueue,
-    VkBuffer srcBuffer,
-    VkBuffer dstBuffer,
-    VkDeviceSize size
-) {
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+static VkCommandBuffer beginSingleTimeCommands(Device device, VkCommandPool commandPool) {
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -23,11 +20,10 @@ static void copyBuffer(
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    return commandBuffer;
+}
 
-    VkBufferCopy copyRegion{};
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
+static void endSingleTimeCommands(Device device, VkCommandPool commandPool, VkQueue graphicsQueue, VkCommandBuffer commandBuffer) {
     vkEndCommandBuffer(commandBuffer);
 
     VkSubmitInfo submitInfo{};
@@ -41,6 +37,172 @@ static void copyBuffer(
     vkFreeCommandBuffers(device.getHandle(), commandPool, 1, &commandBuffer);
 }
 
+static void copyBuffer(
+    const PhysicalDevice& physicalDevice, //
+    Device device,
+    VkCommandPool commandPool,
+    VkQueue graphicsQueue,
+    VkBuffer srcBuffer,
+    VkBuffer dstBuffer,
+    VkDeviceSize size
+) {
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
+
+    VkBufferCopy copyRegion{};
+    copyRegion.size = size;
+    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+
+    endSingleTimeCommands(device, commandPool, graphicsQueue, commandBuffer);
+}
+
+static void transitionImage(VkCommandBuffer commandBuffer, const MemImage& image, VkImageLayout oldLayout, VkImageLayout newLayout) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.image();
+    barrier.subresourceRange = MemImage::fullRange();
+
+    VkPipelineStageFlags srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    if (newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    } else {
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+// Copies regions of data into image and leaves it ready for sampling. A cleared image is zeroed before the copy.
+static void copyToImage(
+    const PhysicalDevice& physicalDevice, //
+    Device device,
+    VkCommandPool commandPool,
+    VkQueue graphicsQueue,
+    const MemImage& image,
+    VkImageLayout oldLayout,
+    bool clear,
+    const std::vector<uint8_t>& data,
+    const std::vector<VkBufferImageCopy>& regions
+) {
+    MemBuffer stagingBuffer{};
+    if (!data.empty()) {
+        stagingBuffer = MemBuffer::create(
+            physicalDevice.handle, //
+            device,
+            data.size(),
+            MemBufferTransferDir::SOURCE,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        void* mapped = stagingBuffer.mapMemory(device);
+        memcpy(mapped, data.data(), data.size());
+        stagingBuffer.unmapMemory(device);
+    }
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
+
+    transitionImage(commandBuffer, image, oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    if (clear) {
+        VkClearColorValue zero{};
+        VkImageSubresourceRange range = MemImage::fullRange();
+        vkCmdClearColorImage(commandBuffer, image.image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &zero, 1, &range);
+        if (!regions.empty()) {
+            transitionImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        }
+    }
+    if (!regions.empty()) {
+        vkCmdCopyBufferToImage(
+            commandBuffer, //
+            stagingBuffer.buffer(),
+            image.image(),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(regions.size()),
+            regions.data()
+        );
+    }
+    transitionImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    endSingleTimeCommands(device, commandPool, graphicsQueue, commandBuffer);
+
+    if (stagingBuffer.buffer() != VK_NULL_HANDLE) {
+        stagingBuffer.destroy(device);
+    }
+}
+
+static VkBufferImageCopy imageRegion(VkDeviceSize bufferOffset, int32_t x, int32_t y, uint32_t width, uint32_t height) {
+    VkBufferImageCopy region{};
+    region.bufferOffset = bufferOffset;
+    region.bufferRowLength = width;
+    region.bufferImageHeight = height;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageOffset = {x, y, 0};
+    region.imageExtent = {width, height, 1};
+    return region;
+}
+
+// Stand-in for a missing tile atlas: ids the level text format uses for solid tiles are black, the others grey
+static ImageRGBA placeholderTileAtlas(uint32_t columns) {
+    static constexpr uint32_t TILE_PIXELS = 8;
+
+    ImageRGBA atlas;
+    atlas.width = columns * TILE_PIXELS;
+    atlas.height = columns * TILE_PIXELS;
+    atlas.pixels.resize(4 * static_cast<size_t>(atlas.width) * atlas.height);
+    for (uint32_t y = 0; y < atlas.height; y++) {
+        for (uint32_t x = 0; x < atlas.width; x++) {
+            uint32_t id = (y / TILE_PIXELS) * columns + x / TILE_PIXELS;
+            bool solid = (id >= 'A' && id <= 'Z') || (id >= '0' && id <= '9');
+            uint8_t* pixel = &atlas.pixels[4 * (static_cast<size_t>(y) * atlas.width + x)];
+            pixel[0] = pixel[1] = pixel[2] = solid ? 0 : 128;
+            pixel[3] = 255;
+        }
+    }
+    return atlas;
+}
+
+using CreateMemBuffer = MemBuffer (*)(VkPhysicalDevice, Device, VkDeviceSize, MemBufferTransferDir, VkMemoryPropertyFlags);
+
+static MemBuffer createDeviceLocalBuffer(
+    const PhysicalDevice& physicalDevice, //
+    Device device,
+    VkCommandPool commandPool,
+    VkQueue graphicsQueue,
+    CreateMemBuffer create,
+    const void* data,
+    VkDeviceSize size
+) {
+    auto stagingBuffer = MemBuffer::create(
+        physicalDevice.handle, //
+        device,
+        size,
+        MemBufferTransferDir::SOURCE,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+
+    {
+        void* mapped = stagingBuffer.mapMemory(device);
+        memcpy(mapped, data, static_cast<size_t>(size));
+        stagingBuffer.unmapMemory(device);
+    }
+
+    auto buffer = create(physicalDevice.handle, device, size, MemBufferTransferDir::DESTINATION, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    copyBuffer(physicalDevice, device, commandPool, graphicsQueue, stagingBuffer.buffer(), buffer.buffer(), size);
+
+    stagingBuffer.destroy(device);
+    return buffer;
+}
+
 GameRenderer GameRenderer::initialize(Window window) {
     GameRenderer self;
 
@@ -65,19 +227,17 @@ GameRenderer GameRenderer::initialize(Window window) {
     self.graphicsQueue = self.device.getDeviceQueue(self.physicalDevice.familyIndices.graphicsFamily);
     self.presentQueue = self.device.getDeviceQueue(self.physicalDevice.familyIndices.presentFamily);
 
-    self.shaders = Shaders::loadShaders(self.device, "vert.spv", "frag.spv");
-    self.shaders1 = Shaders::loadShaders(self.device, "line_vert.spv", "line_frag.spv");
+    auto assets = AssetArchive::open(ASSET_ARCHIVE_PATH);
+    self.shaders = Shaders::loadShaders(self.device, *assets, "shaders/triangle.vert.spv", "shaders/triangle.frag.spv");
+    self.shaders1 = Shaders::loadShaders(self.device, *assets, "shaders/line.vert.spv", "shaders/line.frag.spv");
+    self.tilemapShaders = Shaders::loadShaders(self.device, *assets, "shaders/tilemap.vert.spv", "shaders/tilemap.frag.spv");
+    self.spriteShaders = Shaders::loadShaders(self.device, *assets, "shaders/sprite.vert.spv", "shaders/sprite.frag.spv");
 
     self.commandPool = self.device.createCommandPool(self.physicalDevice.familyIndices.graphicsFamily);
     if (self.commandPool == VK_NULL_HANDLE) {
         throw std::runtime_error("failed to create command pool");
     }
 
-    self.commandBuffer = self.device.allocateCommandBuffer(self.commandPool);
-    if (self.commandBuffer == VK_NULL_HANDLE) {
-        throw std::runtime_error("failed to allocate command buffer");
-    }
-
     self.imageAvailableSemaphore = self.device.createSemaphore();
     self.renderFinishedSemaphore = self.device.createSemaphore();
     self.inFlightFence = self.device.createFence();
@@ -125,76 +285,235 @@ GameRenderer GameRenderer::initialize(Window window) {
 
     stagingBuffer.destroy(self.device);
 
+    self.createTilemapResources();
+    self.createSpriteResources();
     self.recreateSwapChain();
 
     return self;
 }
 
-bool GameRenderer::render(const World& world) {
+static void pushQuad(std::vector<Vertex>& vertices, const AABB& object, Vec3 fillColor) {
+    auto _x0 = static_cast<float>(object.v0().x);
+    auto _x1 = static_cast<float>(object.v1().x);
+    auto _y0 = static_cast<float>(object.v0().y);
+    auto _y1 = static_cast<float>(object.v1().y);
+
+    auto x0 = 2.0f / 1000.0f * _x0 - 1.0f;
+    auto x1 = 2.0f / 1000.0f * _x1 - 1.0f;
+    auto y0 = 1.0f - 2.0f / 1000.0f * _y1;
+    auto y1 = 1.0f - 2.0f / 1000.0f * _y0;
+
+    vertices.emplace_back(Vec2{x0, y0}, fillColor);
+    vertices.emplace_back(Vec2{x1, y0}, fillColor);
+    vertices.emplace_back(Vec2{x1, y1}, fillColor);
+    vertices.emplace_back(Vec2{x0, y1}, fillColor);
+}
+
+// pushQuad in place, for buffers that are updated quad by quad
+static void writeQuad(Vertex* out, const AABB& object, Vec3 fillColor) {
+    auto x0 = 2.0f / 1000.0f * object.v0().x - 1.0f;
+    auto x1 = 2.0f / 1000.0f * object.v1().x - 1.0f;
+    auto y0 = 1.0f - 2.0f / 1000.0f * object.v1().y;
+    auto y1 = 1.0f - 2.0f / 1000.0f * object.v0().y;
+
+    out[0] = Vertex(Vec2{x0, y0}, fillColor);
+    out[1] = Vertex(Vec2{x1, y0}, fillColor);
+    out[2] = Vertex(Vec2{x1, y1}, fillColor);
+    out[3] = Vertex(Vec2{x0, y1}, fillColor);
+}
+
+static void pushSpriteQuad(std::vector<SpriteVertex>& vertices, const AABB& object, const SpriteRegion& region) {
+    // same world to clip space mapping as pushQuad, world y goes up and image rows go down
+    auto x0 = 2.0f / 1000.0f * object.v0().x - 1.0f;
+    auto x1 = 2.0f / 1000.0f * object.v1().x - 1.0f;
+    auto y0 = 1.0f - 2.0f / 1000.0f * object.v1().y;
+    auto y1 = 1.0f - 2.0f / 1000.0f * object.v0().y;
+
+    vertices.emplace_back(Vec2{x0, y0}, Vec2{region.u0, region.v0});
+    vertices.emplace_back(Vec2{x1, y0}, Vec2{region.u1, region.v0});
+    vertices.emplace_back(Vec2{x1, y1}, Vec2{region.u1, region.v1});
+    vertices.emplace_back(Vec2{x0, y1}, Vec2{region.u0, region.v1});
+}
+
+static TilemapQuad tilemapQuad(const TileMap& tiles) {
+    // same world to clip space mapping as pushQuad
+    AABB bounds = tiles.bounds();
+    TilemapQuad quad{};
+    quad.clipRect[0] = 2.0f / 1000.0f * bounds.v0().x - 1.0f;
+    quad.clipRect[1] = 1.0f - 2.0f / 1000.0f * bounds.v0().y;
+    quad.clipRect[2] = 2.0f / 1000.0f * bounds.v1().x - 1.0f;
+    quad.clipRect[3] = 1.0f - 2.0f / 1000.0f * bounds.v1().y;
+    quad.tileExtent[0] = static_cast<float>(tiles.blockCols * TILE_BLOCK_SIZE);
+    quad.tileExtent[1] = static_cast<float>(tiles.blockRows * TILE_BLOCK_SIZE);
+    return quad;
+}
+
+static uint64_t hashScene(const RenderSnapshot& snapshot) {
+    // there is no camera yet, the world to clip space mapping is fixed
+    uint64_t hash = fnv1aValue(snapshot.levelVersion);
+    hash = fnv1aValue(snapshot.objects.get(), hash);
+    hash = fnv1aValue(snapshot.chunks.get(), hash);
+    hash = fnv1a(snapshot.bodies.data(), sizeof(AABB) * snapshot.bodies.size(), hash);
+    return fnv1a(snapshot.projectiles.data(), sizeof(AABB) * snapshot.projectiles.size(), hash);
+}
+
+bool GameRenderer::render(const RenderSnapshot& snapshot) {
+    PROFILE_ZONE("GameRenderer::render");
+
+    uint64_t sceneKey = hashScene(snapshot);
+    bool sceneChanged = sceneKey != lastSceneKey;
+
+    bool kinematicsChanged = snapshot.kinematicsVersion != uploadedKinematicsVersion;
+    if (!sceneChanged && !kinematicsChanged && !staticGeometryPending && idleSettings.mode == IdleMode::SKIP_PRESENT &&
+        !window.wasResized() && monotonicNsecs() - lastPresentNs < idleSettings.heartbeatNs) {
+        renderStats.skippedFrames++;
+        return true;
+    }
+
     device.waitForFence(inFlightFence);
 
-    vertices.clear();
+    bool staticChanged = syncStaticGeometry(snapshot);
+    // moved platforms are rewritten in place, the command buffers only change with their number
+    bool kinematicBuffersChanged = syncKinematics(snapshot);
+    if (sceneChanged || staticChanged || idleSettings.mode == IdleMode::ALWAYS_REDRAW) {
+        uploadScene(snapshot);
+        lastSceneKey = sceneKey;
+        sceneVersion++;
+    } else if (kinematicBuffersChanged) {
+        sceneVersion++;
+    }
 
-    Vec3 fillColor = {0.0f, 1.0f, 0.0f};
+renderStart:
+    VkExtent2D windowExtent = window.getWindowExtent();
+    if (windowExtent.width == 0 || windowExtent.height == 0) {
+        return false;
+    }
 
+    uint32_t imageIndex;
+    VkResult result;
     {
-        auto object = world.player.aabb();
-        auto _x0 = static_cast<float>(object.v0().x);
-        auto _x1 = static_cast<float>(object.v1().x);
-        auto _y0 = static_cast<float>(object.v0().y);
-        auto _y1 = static_cast<float>(object.v1().y);
-
-        auto x0 = 2.0f / 1000.0f * _x0 - 1.0f;
-        auto x1 = 2.0f / 1000.0f * _x1 - 1.0f;
-        auto y0 = 1.0f - 2.0f / 1000.0f * _y1;
-        auto y1 = 1.0f - 2.0f / 1000.0f * _y0;
-
-        auto x0y0 = Vertex({x0, y0}, fillColor);
-        auto x1y0 = Vertex({x1, y0}, fillColor);
-        auto x1y1 = Vertex({x1, y1}, fillColor);
-        auto x0y1 = Vertex({x0, y1}, fillColor);
-        vertices.push_back(x0y0);
-        vertices.push_back(x1y0);
-        vertices.push_back(x1y1);
-        vertices.push_back(x0y1);
-    }
-
-    fillColor = {0.0f, 0.0f, 0.0f};
-
-    for (const auto& object : world.objects) {
-        auto _x0 = static_cast<float>(object.v0().x);
-        auto _x1 = static_cast<float>(object.v1().x);
-        auto _y0 = static_cast<float>(object.v0().y);
-        auto _y1 = static_cast<float>(object.v1().y);
-
-        auto x0 = 2.0f / 1000.0f * _x0 - 1.0f;
-        auto x1 = 2.0f / 1000.0f * _x1 - 1.0f;
-        auto y0 = 1.0f - 2.0f / 1000.0f * _y1;
-        auto y1 = 1.0f - 2.0f / 1000.0f * _y0;
-
-        auto x0y0 = Vertex({x0, y0}, fillColor);
-        auto x1y0 = Vertex({x1, y0}, fillColor);
-        auto x1y1 = Vertex({x1, y1}, fillColor);
-        auto x0y1 = Vertex({x0, y1}, fillColor);
-        vertices.push_back(x0y0);
-        vertices.push_back(x1y0);
-        vertices.push_back(x1y1);
-        vertices.push_back(x0y1);
+        PROFILE_ZONE("vkAcquireNextImageKHR");
+        result = vkAcquireNextImageKHR(
+            device.getHandle(),
+            swapChain.getSwapChainHandle(),
+            NUM_MAX<uint64_t>,
+            imageAvailableSemaphore,
+            VK_NULL_HANDLE,
+            &imageIndex
+        ); //
+    }
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        recreateSwapChain();
+        goto renderStart;
+    } else if (!(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)) {
+        throw std::runtime_error("failed to recreate swapchain");
     }
 
+    device.resetFence(inFlightFence);
+
+    // command buffers stay valid while the scene, vertex buffer and swapchain are unchanged
+    VkCommandBuffer commandBuffer = imageCommandBuffers[imageIndex];
+    if (recordedSceneVersions[imageIndex] != sceneVersion) {
+        vkResetCommandBuffer(commandBuffer, 0);
+        recordCommandBuffer(commandBuffer, imageIndex, sceneObjectCount, 0);
+        recordedSceneVersions[imageIndex] = sceneVersion;
+    } else {
+        renderStats.resubmittedFrames++;
+    }
+
+    VkSemaphore waitSemaphores[] = {imageAvailableSemaphore};
+    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+
+    VkSemaphore signalSemaphores[] = {renderFinishedSemaphore};
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = signalSemaphores;
+
+    graphicsQueue.submit(submitInfo, inFlightFence);
+
+    VkSwapchainKHR swapChains[] = {swapChain.getSwapChainHandle()};
+
+    VkPresentInfoKHR presentInfo{};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = swapChains;
+    presentInfo.pImageIndices = &imageIndex;
+    presentInfo.pResults = nullptr;
+
+    {
+        PROFILE_ZONE("vkQueuePresentKHR");
+        result = presentQueue.present(presentInfo);
+    }
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.wasResized()) {
+        window.resetResized();
+        recreateSwapChain();
+        goto renderStart;
+    } else if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to present swap chain image!");
+    }
+
+    lastPresentNs = monotonicNsecs();
+    renderStats.presentedFrames++;
+
+    return true;
+}
+
+void GameRenderer::uploadScene(const RenderSnapshot& snapshot) {
+    PROFILE_ZONE("GameRenderer::uploadScene");
+
+    vertices.clear();
+    spriteVertices.clear();
+    spriteBatches.clear();
+
+    const SpriteRegion* playerSprite = spriteAtlases.find(PLAYER_SPRITE);
+    std::vector<std::pair<const SpriteRegion*, AABB>> sprites;
+    for (size_t i = 0; i < snapshot.bodies.size(); i++) {
+        if (i == 0 && playerSprite != nullptr) {
+            sprites.emplace_back(playerSprite, snapshot.bodies[i]);
+        } else {
+            pushQuad(vertices, snapshot.bodies[i], {0.0f, 1.0f, 0.0f});
+        }
+    }
+    for (const auto& projectile : snapshot.projectiles) {
+        pushQuad(vertices, projectile, {1.0f, 0.5f, 0.0f});
+    }
+
+    // sprites sharing a page are made adjacent so that every page is a single draw
+    std::stable_sort(sprites.begin(), sprites.end(), [](const auto& a, const auto& b) { return a.first->page < b.first->page; });
+    for (const auto& [region, aabb] : sprites) {
+        if (spriteBatches.empty() || spriteBatches.back().page != region->page) {
+            spriteBatches.push_back({region->page, static_cast<uint32_t>(spriteVertices.size() / 4), 0});
+        }
+        pushSpriteQuad(spriteVertices, aabb, *region);
+        spriteBatches.back().quadCount++;
+    }
+    uploadSprites();
+
+    sceneObjectCount = vertices.size() / 4;
+
     if (vertexBuffer.buffer() != VK_NULL_HANDLE) {
         vertexBuffer.destroy(device);
+        vertexBuffer = {};
     }
 
-    vertexBuffer = MemBuffer::createVertex(
-        physicalDevice.handle,
-        device,
-        sizeof(Vertex) * vertices.size(),
-        MemBufferTransferDir::NONE,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
+    if (!vertices.empty()) {
+        vertexBuffer = MemBuffer::createVertex(
+            physicalDevice.handle,
+            device,
+            sizeof(Vertex) * vertices.size(),
+            MemBufferTransferDir::NONE,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
 
-    {
         void* data = vertexBuffer.mapMemory(device);
         memcpy(data, vertices.data(), static_cast<size_t>(vertexBuffer.size()));
         vertexBuffer.unmapMemory(device);
@@ -233,71 +552,511 @@ bool GameRenderer::render(const World& world) {
             vertexBuffer1.unmapMemory(device);
         }
     }
+}
 
-renderStart:
-    VkExtent2D windowExtent = window.getWindowExtent();
-    if (windowExtent.width == 0 || windowExtent.height == 0) {
+bool GameRenderer::syncStaticGeometry(const RenderSnapshot& snapshot) {
+    // the in-flight fence has been waited on, nothing references buffers freed here anymore
+    bool changed = false;
+
+    if (snapshot.objects != uploadedObjects) {
+        PROFILE_ZONE("upload static objects");
+
+        destroyStaticSlot(objectsSlot);
+        staticVertices.clear();
+        if (snapshot.objects != nullptr) {
+            for (const auto& object : *snapshot.objects) {
+                pushQuad(staticVertices, object.aabb(), {0.0f, 0.0f, 0.0f});
+            }
+        }
+        uploadStaticSlot(objectsSlot);
+        uploadedObjects = snapshot.objects;
+        changed = true;
+    }
+
+    if (snapshot.chunks == syncedChunks && !staticGeometryPending) {
+        return changed;
+    }
+
+    PROFILE_ZONE("GameRenderer::syncStaticGeometry");
+
+    // both lists are sorted by id: keep matching slots, free the ones that streamed out, upload new ones within budget
+    static const std::vector<StaticChunk> noChunks{};
+    const auto& chunks = snapshot.chunks != nullptr ? *snapshot.chunks : noChunks;
+
+    std::vector<StaticGeometrySlot> slots;
+    slots.reserve(chunks.size());
+    uint32_t uploads = 0;
+    staticGeometryPending = false;
+
+    size_t old = 0;
+    for (const auto& chunk : chunks) {
+        while (old < chunkSlots.size() && chunkSlots[old].id < chunk.id) {
+            destroyStaticSlot(chunkSlots[old++]);
+            changed = true;
+        }
+        StaticGeometrySlot previous{};
+        if (old < chunkSlots.size() && chunkSlots[old].id == chunk.id) {
+            if (chunkSlots[old].level == chunk.level) {
+                slots.push_back(std::move(chunkSlots[old++]));
+                continue;
+            }
+            previous = std::move(chunkSlots[old++]);
+            changed = true;
+        }
+
+        if (uploads == MAX_CHUNK_UPLOADS_PER_FRAME) {
+            destroyStaticSlot(previous);
+            staticGeometryPending = true;
+            continue;
+        }
+
+        auto& slot = slots.emplace_back();
+        slot.id = chunk.id;
+        slot.level = chunk.level;
+
+        // a chunk replaced by a level with the same tile layout keeps its texture and only uploads changed blocks
+        const auto& tiles = chunk.level->geometry().tiles;
+        const TileMap* previousTiles = nullptr;
+        if (previous.tileDescriptorSet != VK_NULL_HANDLE) {
+            const auto& oldTiles = previous.level->geometry().tiles;
+            if (oldTiles.blockX0 == tiles.blockX0 && oldTiles.blockY0 == tiles.blockY0 && oldTiles.blockCols == tiles.blockCols &&
+                oldTiles.blockRows == tiles.blockRows) {
+                slot.tileIds = previous.tileIds;
+                slot.tileDescriptorSet = previous.tileDescriptorSet;
+                previous.tileIds = {};
+                previous.tileDescriptorSet = VK_NULL_HANDLE;
+                previousTiles = &oldTiles;
+            }
+        }
+        bool texturedTiles = tiles.isEmpty() || uploadTileIds(slot, previousTiles);
+
+        staticVertices.clear();
+        const auto& solids = chunk.level->geometry().solids;
+        staticVertices.reserve(4 * static_cast<size_t>(solids.count));
+        for (uint32_t i = 0; i < solids.count; i++) {
+            pushQuad(staticVertices, solids.aabb(i), {0.0f, 0.0f, 0.0f});
+        }
+        if (!texturedTiles) {
+            tiles.forEachSolidRun([&](int32_t tx0, int32_t tx1, int32_t ty) {
+                pushQuad(staticVertices, AABB(tiles.tileAABB(tx0, ty).v0(), tiles.tileAABB(tx1, ty).v1()), {0.0f, 0.0f, 0.0f});
+            });
+        }
+        uploadStaticSlot(slot);
+        destroyStaticSlot(previous);
+        uploads++;
+        changed = true;
+    }
+    while (old < chunkSlots.size()) {
+        destroyStaticSlot(chunkSlots[old++]);
+        changed = true;
+    }
+
+    chunkSlots = std::move(slots);
+    syncedChunks = snapshot.chunks;
+    return changed;
+}
+
+void GameRenderer::uploadStaticSlot(StaticGeometrySlot& slot) {
+    uint32_t quadCount = static_cast<uint32_t>(staticVertices.size() / 4);
+    staticIndices.clear();
+    staticIndices.reserve(6 * static_cast<size_t>(quadCount));
+    for (uint32_t quad = 0; quad < quadCount; quad++) {
+        uint32_t base = 4 * quad;
+        staticIndices.insert(staticIndices.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+    }
+
+    slot.indexCount = static_cast<uint32_t>(staticIndices.size());
+    if (quadCount == 0) {
+        return;
+    }
+
+    slot.vertexBuffer = createDeviceLocalBuffer(
+        physicalDevice, //
+        device,
+        commandPool,
+        graphicsQueue.getHandle(),
+        MemBuffer::createVertex,
+        staticVertices.data(),
+        sizeof(Vertex) * staticVertices.size()
+    );
+    slot.indexBuffer = createDeviceLocalBuffer(
+        physicalDevice, //
+        device,
+        commandPool,
+        graphicsQueue.getHandle(),
+        MemBuffer::createIndex,
+        staticIndices.data(),
+        sizeof(uint32_t) * staticIndices.size()
+    );
+}
+
+void GameRenderer::destroyStaticSlot(StaticGeometrySlot& slot) {
+    if (slot.vertexBuffer.buffer() != VK_NULL_HANDLE) {
+        slot.vertexBuffer.destroy(device);
+        slot.indexBuffer.destroy(device);
+    }
+    if (slot.tileDescriptorSet != VK_NULL_HANDLE) {
+        vkFreeDescriptorSets(device.getHandle(), tilemapDescriptorPool, 1, &slot.tileDescriptorSet);
+        slot.tileIds.destroy(device);
+    }
+    slot = {};
+}
+
+void GameRenderer::createTilemapResources() {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice.handle, &properties);
+    maxImageDimension = properties.limits.maxImageDimension2D;
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(device.getHandle(), &layoutInfo, nullptr, &tilemapSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create tilemap descriptor set layout");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = static_cast<uint32_t>(bindings.size()) * MAX_TILEMAP_TEXTURES;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.maxSets = MAX_TILEMAP_TEXTURES;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device.getHandle(), &poolInfo, nullptr, &tilemapDescriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create tilemap descriptor pool");
+    }
+
+    nearestSampler = createNearestSampler(device);
+
+    ImageRGBA atlas;
+    try {
+        atlas = loadImageRGBA(TILE_ATLAS_PATH);
+    } catch (std::runtime_error& error) {
+        std::cerr << error.what() << ", using placeholder tiles" << std::endl;
+        atlas = placeholderTileAtlas(TILE_ATLAS_COLUMNS);
+    }
+
+    tileAtlas = MemImage::create2D(
+        physicalDevice.handle, //
+        device,
+        atlas.width,
+        atlas.height,
+        VK_FORMAT_R8G8B8A8_SRGB,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+    );
+    copyToImage(
+        physicalDevice, //
+        device,
+        commandPool,
+        graphicsQueue.getHandle(),
+        tileAtlas,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        false,
+        atlas.pixels,
+        {imageRegion(0, 0, 0, atlas.width, atlas.height)}
+    );
+}
+
+void GameRenderer::createSpriteResources() {
+    PROFILE_ZONE("GameRenderer::createSpriteResources");
+
+    uint64_t start = monotonicNsecs();
+    auto paths = listSpriteFiles(SPRITE_DIRECTORY);
+    auto decoded = decodeSprites(paths, std::max(std::thread::hardware_concurrency(), 1u));
+    uint64_t decodeNs = monotonicNsecs() - start;
+
+    spriteAtlases = packSpriteAtlases(decoded, std::min(SPRITE_ATLAS_SIZE, maxImageDimension));
+    printSpriteAtlasReport(std::cout, decoded, spriteAtlases);
+    std::cout << "sprites decoded in " << std::fixed << std::setprecision(2) << static_cast<double>(decodeNs) / NSECS_PER_MSEC << " ms"
+              << std::defaultfloat << std::endl;
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device.getHandle(), &layoutInfo, nullptr, &spriteSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create sprite descriptor set layout");
+    }
+
+    if (spriteAtlases.pages.empty()) {
+        return;
+    }
+
+    auto pageCount = static_cast<uint32_t>(spriteAtlases.pages.size());
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = pageCount;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = pageCount;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device.getHandle(), &poolInfo, nullptr, &spriteDescriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create sprite descriptor pool");
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayouts(pageCount, spriteSetLayout);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = spriteDescriptorPool;
+    allocInfo.descriptorSetCount = pageCount;
+    allocInfo.pSetLayouts = setLayouts.data();
+    spriteDescriptorSets.resize(pageCount);
+    if (vkAllocateDescriptorSets(device.getHandle(), &allocInfo, spriteDescriptorSets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate sprite descriptor sets");
+    }
+
+    for (uint32_t i = 0; i < pageCount; i++) {
+        auto& page = spriteAtlases.pages[i].image;
+        auto& image = spritePages.emplace_back(MemImage::create2D(
+            physicalDevice.handle, //
+            device,
+            page.width,
+            page.height,
+            VK_FORMAT_R8G8B8A8_SRGB,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+        ));
+        copyToImage(
+            physicalDevice, //
+            device,
+            commandPool,
+            graphicsQueue.getHandle(),
+            image,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            false,
+            page.pixels,
+            {imageRegion(0, 0, 0, page.width, page.height)}
+        );
+        // the device copy is all that is needed from here on
+        page.pixels = {};
+
+        VkDescriptorImageInfo imageInfo{nearestSampler, image.view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = spriteDescriptorSets[i];
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(device.getHandle(), 1, &write, 0, nullptr);
+    }
+}
+
+void GameRenderer::uploadSprites() {
+    if (spriteVertexBuffer.buffer() != VK_NULL_HANDLE) {
+        spriteVertexBuffer.destroy(device);
+        spriteVertexBuffer = {};
+    }
+    if (spriteVertices.empty()) {
+        return;
+    }
+
+    spriteVertexBuffer = MemBuffer::createVertex(
+        physicalDevice.handle, //
+        device,
+        sizeof(SpriteVertex) * spriteVertices.size(),
+        MemBufferTransferDir::NONE,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    {
+        void* data = spriteVertexBuffer.mapMemory(device);
+        memcpy(data, spriteVertices.data(), static_cast<size_t>(spriteVertexBuffer.size()));
+        spriteVertexBuffer.unmapMemory(device);
+    }
+
+    // every batch indexes the same quad pattern, only its first index differs
+    reserveQuadIndices(static_cast<uint32_t>(spriteVertices.size() / 4));
+}
+
+bool GameRenderer::reserveQuadIndices(uint32_t quadCount) {
+    if (quadCount <= quadIndexCapacity) {
         return false;
     }
+    if (quadIndexBuffer.buffer() != VK_NULL_HANDLE) {
+        quadIndexBuffer.destroy(device);
+    }
 
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(
-        device.getHandle(),
-        swapChain.getSwapChainHandle(),
-        NUM_MAX<uint64_t>,
-        imageAvailableSemaphore,
-        VK_NULL_HANDLE,
-        &imageIndex
-    ); //
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreateSwapChain();
-        goto renderStart;
-    } else if (!(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)) {
-        throw std::runtime_error("failed to recreate swapchain");
+    quadIndexCapacity = std::max(quadCount, 2 * quadIndexCapacity);
+    std::vector<uint32_t> indices;
+    indices.reserve(6 * static_cast<size_t>(quadIndexCapacity));
+    for (uint32_t quad = 0; quad < quadIndexCapacity; quad++) {
+        uint32_t base = 4 * quad;
+        indices.insert(indices.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
     }
+    quadIndexBuffer = createDeviceLocalBuffer(
+        physicalDevice, //
+        device,
+        commandPool,
+        graphicsQueue.getHandle(),
+        MemBuffer::createIndex,
+        indices.data(),
+        sizeof(uint32_t) * indices.size()
+    );
+    return true;
+}
 
-    device.resetFence(inFlightFence);
+bool GameRenderer::syncKinematics(const RenderSnapshot& snapshot) {
+    PROFILE_ZONE("GameRenderer::syncKinematics");
+
+    auto count = static_cast<uint32_t>(snapshot.kinematics.size());
+    if (snapshot.kinematicsVersion == uploadedKinematicsVersion && count == uploadedKinematics.size()) {
+        return false;
+    }
+    uploadedKinematicsVersion = snapshot.kinematicsVersion;
+
+    bool changed = count != uploadedKinematics.size();
+    size_t kept = std::min(uploadedKinematics.size(), snapshot.kinematics.size());
+    if (count > kinematicCapacity) {
+        if (kinematicVertexBuffer.buffer() != VK_NULL_HANDLE) {
+            kinematicVertexBuffer.unmapMemory(device);
+            kinematicVertexBuffer.destroy(device);
+        }
+        kinematicCapacity = std::max(count, 2 * kinematicCapacity);
+        kinematicVertexBuffer = MemBuffer::createVertex(
+            physicalDevice.handle, //
+            device,
+            sizeof(Vertex) * 4 * kinematicCapacity,
+            MemBufferTransferDir::NONE,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        kinematicVertices = static_cast<Vertex*>(kinematicVertexBuffer.mapMemory(device));
+        reserveQuadIndices(kinematicCapacity);
+        // the new buffer holds nothing yet
+        kept = 0;
+        changed = true;
+    }
 
-    vkResetCommandBuffer(commandBuffer, 0);
-    recordCommandBuffer(imageIndex, world.objects.size() + 1, 0);
+    // the previous frame is done with the buffer, render waited for its fence
+    uploadedKinematics.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const AABB& box = snapshot.kinematics[i];
+        AABB& uploaded = uploadedKinematics[i];
+        if (i < kept && box.v0() == uploaded.v0() && box.v1() == uploaded.v1()) {
+            continue;
+        }
+        uploaded = box;
+        writeQuad(kinematicVertices + 4 * static_cast<size_t>(i), box, {0.4f, 0.4f, 0.8f});
+        renderStats.kinematicQuadWrites++;
+    }
+    return changed;
+}
 
-    VkSemaphore waitSemaphores[] = {imageAvailableSemaphore};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+bool GameRenderer::uploadTileIds(StaticGeometrySlot& slot, const TileMap* previous) {
+    PROFILE_ZONE("GameRenderer::uploadTileIds");
 
-    VkSemaphore signalSemaphores[] = {renderFinishedSemaphore};
+    const auto& tiles = slot.level->geometry().tiles;
+    uint32_t width = tiles.blockCols * TILE_BLOCK_SIZE;
+    uint32_t height = tiles.blockRows * TILE_BLOCK_SIZE;
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    bool fresh = slot.tileDescriptorSet == VK_NULL_HANDLE;
+    if (fresh) {
+        if (width > maxImageDimension || height > maxImageDimension) {
+            return false;
+        }
 
-    graphicsQueue.submit(submitInfo, inFlightFence);
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = tilemapDescriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &tilemapSetLayout;
+        if (vkAllocateDescriptorSets(device.getHandle(), &allocInfo, &slot.tileDescriptorSet) != VK_SUCCESS) {
+            slot.tileDescriptorSet = VK_NULL_HANDLE;
+            return false;
+        }
 
-    VkSwapchainKHR swapChains[] = {swapChain.getSwapChainHandle()};
+        // tile ids are bytes, R8 covers every id
+        slot.tileIds = MemImage::create2D(
+            physicalDevice.handle, //
+            device,
+            width,
+            height,
+            VK_FORMAT_R8_UINT,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+        );
 
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
-    presentInfo.pImageIndices = &imageIndex;
-    presentInfo.pResults = nullptr;
+        VkDescriptorImageInfo imageInfos[2] = {
+            {nearestSampler, slot.tileIds.view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+            {nearestSampler, tileAtlas.view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        };
+        VkWriteDescriptorSet writes[2]{};
+        for (uint32_t i = 0; i < 2; i++) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = slot.tileDescriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[i].pImageInfo = &imageInfos[i];
+        }
+        vkUpdateDescriptorSets(device.getHandle(), 2, writes, 0, nullptr);
+    }
 
-    result = presentQueue.present(presentInfo);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.wasResized()) {
-        window.resetResized();
-        recreateSwapChain();
-        goto renderStart;
-    } else if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to present swap chain image!");
+    // one region per 32x32 block: a new texture is cleared and gets its stored blocks, an updated one only the
+    // blocks whose ids changed, with blocks that were removed copied from a zeroed block
+    static constexpr size_t BLOCK_BYTES = sizeof(TileBlock::ids);
+    static const uint8_t emptyIds[BLOCK_BYTES] = {};
+
+    tileStaging.clear();
+    std::vector<VkBufferImageCopy> regions;
+    for (uint32_t row = 0; row < tiles.blockRows; row++) {
+        for (uint32_t col = 0; col < tiles.blockCols; col++) {
+            uint32_t cell = row * tiles.blockCols + col;
+            const uint8_t* ids = tiles.blockIndex[cell] != TILE_BLOCK_EMPTY ? tiles.blocks[tiles.blockIndex[cell]].ids : nullptr;
+            if (fresh) {
+                if (ids == nullptr) {
+                    continue;
+                }
+            } else {
+                uint32_t oldIndex = previous->blockIndex[cell];
+                const uint8_t* oldIds = oldIndex != TILE_BLOCK_EMPTY ? previous->blocks[oldIndex].ids : nullptr;
+                if (ids == oldIds || (ids != nullptr && oldIds != nullptr && memcmp(ids, oldIds, BLOCK_BYTES) == 0)) {
+                    continue;
+                }
+                if (ids == nullptr) {
+                    ids = emptyIds;
+                }
+            }
+
+            int32_t x = static_cast<int32_t>(col) * TILE_BLOCK_SIZE;
+            int32_t y = static_cast<int32_t>(row) * TILE_BLOCK_SIZE;
+            regions.push_back(imageRegion(tileStaging.size(), x, y, TILE_BLOCK_SIZE, TILE_BLOCK_SIZE));
+            tileStaging.insert(tileStaging.end(), ids, ids + BLOCK_BYTES);
+        }
     }
 
+    if (!fresh && regions.empty()) {
+        return true;
+    }
+
+    copyToImage(
+        physicalDevice, //
+        device,
+        commandPool,
+        graphicsQueue.getHandle(),
+        slot.tileIds,
+        fresh ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        fresh,
+        tileStaging,
+        regions
+    );
     return true;
 }
 
@@ -311,10 +1070,33 @@ void GameRenderer::destroy() {
     vertexBuffer1.destroy(device);
     vertexBuffer.destroy(device);
     indexBuffer.destroy(device);
+    destroyStaticSlot(objectsSlot);
+    for (auto& slot : chunkSlots) {
+        destroyStaticSlot(slot);
+    }
+    tilemapPipeline.destroy(device);
+    tileAtlas.destroy(device);
+    spritePipeline.destroy(device);
+    spriteVertexBuffer.destroy(device);
+    if (kinematicVertexBuffer.buffer() != VK_NULL_HANDLE) {
+        kinematicVertexBuffer.unmapMemory(device);
+        kinematicVertexBuffer.destroy(device);
+    }
+    quadIndexBuffer.destroy(device);
+    for (const auto& page : spritePages) {
+        page.destroy(device);
+    }
+    vkDestroyDescriptorPool(device.getHandle(), spriteDescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device.getHandle(), spriteSetLayout, nullptr);
+    vkDestroySampler(device.getHandle(), nearestSampler, nullptr);
+    vkDestroyDescriptorPool(device.getHandle(), tilemapDescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device.getHandle(), tilemapSetLayout, nullptr);
     device.destroySemaphore(imageAvailableSemaphore);
     device.destroySemaphore(renderFinishedSemaphore);
     device.destroyFence(inFlightFence);
     device.destroyCommandPool(commandPool);
+    spriteShaders.destroy(device);
+    tilemapShaders.destroy(device);
     shaders1.destroy(device);
     shaders.destroy(device);
     vkDestroySurfaceKHR(instance, surface, nullptr);
@@ -323,9 +1105,13 @@ void GameRenderer::destroy() {
 }
 
 void GameRenderer::recreateSwapChain() {
+    PROFILE_ZONE("GameRenderer::recreateSwapChain");
+
     device.waitIdle();
 
     if (swapChain.getSwapChainHandle() != VK_NULL_HANDLE) {
+        spritePipeline.destroy(device);
+        tilemapPipeline.destroy(device);
         graphicsPipeline1.destroy(device);
         graphicsPipeline.destroy(device);
         renderPass.destroy(device);
@@ -335,6 +1121,18 @@ void GameRenderer::recreateSwapChain() {
     swapChain = SwapChain::create(physicalDevice, device, window, surface);
     renderPass = RenderPass::create(device, swapChain);
 
+    // recorded command buffers reference the old framebuffers and pipelines
+    device.freeCommandBuffers(commandPool, imageCommandBuffers);
+    imageCommandBuffers.clear();
+    for (size_t i = 0; i < swapChain.getImageViews().size(); i++) {
+        VkCommandBuffer commandBuffer = device.allocateCommandBuffer(commandPool);
+        if (commandBuffer == VK_NULL_HANDLE) {
+            throw std::runtime_error("failed to allocate command buffer");
+        }
+        imageCommandBuffers.push_back(commandBuffer);
+    }
+    recordedSceneVersions.assign(imageCommandBuffers.size(), 0);
+
     {
         auto bindingDescription = Vertex::getBindingDescription();
         auto attributeDescriptions = Vertex::getAttributeDescriptions();
@@ -367,12 +1165,45 @@ void GameRenderer::recreateSwapChain() {
                                 .withRasterizerLineWidth(2.5f)
                                 .create();
     }
+
+    {
+        // the quad corners come from the vertex index, there are no vertex inputs
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        tilemapPipeline = GraphicsPipelineBuilder(device, tilemapShaders, swapChain, renderPass)
+                              .withVertexInputStateInfo(vertexInputInfo)
+                              .withInputAssemblyStateInfo(createInputAssemblyStateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST))
+                              .withDescriptorSetLayout(tilemapSetLayout)
+                              .withPushConstants(VK_SHADER_STAGE_VERTEX_BIT, sizeof(TilemapQuad))
+                              .create();
+    }
+
+    {
+        auto bindingDescription = SpriteVertex::getBindingDescription();
+        auto attributeDescriptions = SpriteVertex::getAttributeDescriptions();
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.vertexBindingDescriptionCount = 1;
+        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+        spritePipeline = GraphicsPipelineBuilder(device, spriteShaders, swapChain, renderPass)
+                             .withVertexInputStateInfo(vertexInputInfo)
+                             .withInputAssemblyStateInfo(createInputAssemblyStateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST))
+                             .withDescriptorSetLayout(spriteSetLayout)
+                             .create();
+    }
 }
 
-void GameRenderer::recordCommandBuffer(uint32_t imageIndex, size_t objectCount, size_t lineCount) {
+void GameRenderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, size_t objectCount, size_t lineCount) {
+    PROFILE_ZONE("GameRenderer::recordCommandBuffer");
+
+    // not one time submit: idle frames re-submit the buffer recorded for this image
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.flags = 0;
 
     if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("failed to begin recording command buffer");
@@ -394,23 +1225,99 @@ void GameRenderer::recordCommandBuffer(uint32_t imageIndex, size_t objectCount,
 
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.pipeline());
 
-    vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer(), 0, VK_INDEX_TYPE_UINT16);
+    auto drawStaticSlot = [&](const StaticGeometrySlot& slot) {
+        if (slot.indexCount == 0) {
+            return;
+        }
+        VkBuffer vertexBuffers[] = {slot.vertexBuffer.buffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, slot.indexBuffer.buffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexed(commandBuffer, slot.indexCount, 1, 0, 0, 0);
+    };
+    drawStaticSlot(objectsSlot);
+    for (const auto& slot : chunkSlots) {
+        drawStaticSlot(slot);
+    }
+
+    // tile layers, one quad per chunk whatever the number of tiles
+    bool tilemapBound = false;
+    for (const auto& slot : chunkSlots) {
+        if (slot.tileDescriptorSet == VK_NULL_HANDLE) {
+            continue;
+        }
+        if (!tilemapBound) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tilemapPipeline.pipeline());
+            tilemapBound = true;
+        }
+        TilemapQuad quad = tilemapQuad(slot.level->geometry().tiles);
+        vkCmdBindDescriptorSets(
+            commandBuffer, //
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            tilemapPipeline.pipelineLayout(),
+            0,
+            1,
+            &slot.tileDescriptorSet,
+            0,
+            nullptr
+        );
+        vkCmdPushConstants(commandBuffer, tilemapPipeline.pipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(quad), &quad);
+        vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+    }
+    if (tilemapBound) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.pipeline());
+    }
+
+    // moving platforms, one draw for all of them
+    if (!uploadedKinematics.empty()) {
+        VkBuffer vertexBuffers[] = {kinematicVertexBuffer.buffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, quadIndexBuffer.buffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexed(commandBuffer, 6 * static_cast<uint32_t>(uploadedKinematics.size()), 1, 0, 0, 0);
+    }
+
+    if (objectCount != 0) {
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer(), 0, VK_INDEX_TYPE_UINT16);
 
-    {
         VkBuffer vertexBuffers[] = {vertexBuffer.buffer()};
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+        std::vector<VkMultiDrawIndexedInfoEXT> draws{};
+        for (int i = 0; i < objectCount; i++) {
+            VkMultiDrawIndexedInfoEXT info{};
+            info.firstIndex = 0;
+            info.indexCount = 6;
+            info.vertexOffset = 4 * i;
+            draws.push_back(info);
+        }
+        cmdDrawMultiIndexed(commandBuffer, draws.size(), draws.data(), 1, 0, sizeof(VkMultiDrawIndexedInfoEXT), nullptr);
     }
 
-    std::vector<VkMultiDrawIndexedInfoEXT> draws{};
-    for (int i = 0; i < objectCount; i++) {
-        VkMultiDrawIndexedInfoEXT info{};
-        info.firstIndex = 0;
-        info.indexCount = 6;
-        info.vertexOffset = 4 * i;
-        draws.push_back(info);
+    // sprites, one draw per atlas page
+    if (!spriteBatches.empty()) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, spritePipeline.pipeline());
+
+        VkBuffer vertexBuffers[] = {spriteVertexBuffer.buffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, quadIndexBuffer.buffer(), 0, VK_INDEX_TYPE_UINT32);
+
+        for (const auto& batch : spriteBatches) {
+            vkCmdBindDescriptorSets(
+                commandBuffer, //
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                spritePipeline.pipelineLayout(),
+                0,
+                1,
+                &spriteDescriptorSets[batch.page],
+                0,
+                nullptr
+            );
+            vkCmdDrawIndexed(commandBuffer, 6 * batch.quadCount, 1, 6 * batch.firstQuad, 0, 0);
+        }
     }
-    cmdDrawMultiIndexed(commandBuffer, draws.size(), draws.data(), 1, 0, sizeof(VkMultiDrawIndexedInfoEXT), nullptr);
 
     if (lineCount != 0) {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline1.pipeline());
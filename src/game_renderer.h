@@ -1,15 +1,25 @@
 #pragma once
 
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
 #include "glfw.h"
 
 #include "debug.h"
 #include "game/AABB.h"
 #include "game/player.h"
+#include "game/render_snapshot.h"
 #include "game/world.h"
 #include "math/vec.h"
 #include "platform/thread.h"
 #include "platform/time.h"
+#include "util/hash.h"
+#include "util/profiler.h"
+#include "sys/image_file.h"
+#include "sys/sprite_atlas.h"
 #include "sys/vulkan/device.h"
+#include "sys/vulkan/image.h"
 #include "sys/vulkan/instance.h"
 #include "sys/vulkan/mem_buffer.h"
 #include "sys/vulkan/pipeline.h"
@@ -51,7 +61,124 @@ struct Vertex {
     }
 };
 
+struct SpriteVertex {
+    Vec2 pos;
+    Vec2 uv;
+
+    SpriteVertex(Vec2 pos, Vec2 uv) : pos(pos), uv(uv) {}
+
+    static constexpr VkVertexInputBindingDescription getBindingDescription() {
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = 0;
+        bindingDescription.stride = sizeof(SpriteVertex);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return bindingDescription;
+    }
+
+    static constexpr std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(SpriteVertex, pos);
+
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
+        attributeDescriptions[1].offset = offsetof(SpriteVertex, uv);
+
+        return attributeDescriptions;
+    }
+};
+
+// Consecutive sprite quads sampling the same atlas page, drawn with one indexed draw
+struct SpriteBatch {
+    uint32_t page;
+    uint32_t firstQuad;
+    uint32_t quadCount;
+};
+
+// Push constants of the tilemap pipeline, see shaders/tilemap.vert
+struct TilemapQuad {
+    float clipRect[4];
+    float tileExtent[2];
+};
+
+enum class IdleMode {
+    // rebuild, record and present every frame
+    ALWAYS_REDRAW,
+    // skip CPU work for an unchanged scene and re-submit the command buffer recorded for the acquired image
+    RESUBMIT,
+    // do not present at all while the scene is unchanged, except for a periodic heartbeat
+    SKIP_PRESENT,
+};
+
+struct IdleSettings {
+    IdleMode mode = IdleMode::RESUBMIT;
+    uint64_t heartbeatNs = NSECS_PER_SEC;
+
+    // RENDER_IDLE_MODE=redraw|resubmit|skip, RENDER_HEARTBEAT_MS=<milliseconds>
+    static IdleSettings fromEnv() {
+        IdleSettings settings;
+        const char* mode = std::getenv("RENDER_IDLE_MODE");
+        if (mode != nullptr) {
+            if (strcmp(mode, "redraw") == 0) {
+                settings.mode = IdleMode::ALWAYS_REDRAW;
+            } else if (strcmp(mode, "skip") == 0) {
+                settings.mode = IdleMode::SKIP_PRESENT;
+            }
+        }
+        const char* heartbeat = std::getenv("RENDER_HEARTBEAT_MS");
+        if (heartbeat != nullptr) {
+            settings.heartbeatNs = std::strtoull(heartbeat, nullptr, 10) * NSECS_PER_MSEC;
+        }
+        return settings;
+    }
+};
+
+// Device buffers of one piece of static geometry, drawn with a single indexed draw
+struct StaticGeometrySlot {
+    uint64_t id = 0;
+    std::shared_ptr<const Level> level{};
+    MemBuffer vertexBuffer{};
+    MemBuffer indexBuffer{};
+    uint32_t indexCount = 0;
+
+    // tile ids of the level's tile layer, one texel per tile, drawn as a single quad
+    MemImage tileIds{};
+    VkDescriptorSet tileDescriptorSet = VK_NULL_HANDLE;
+};
+
+struct RenderStats {
+    uint64_t presentedFrames = 0;
+    uint64_t resubmittedFrames = 0;
+    uint64_t skippedFrames = 0;
+    uint64_t kinematicQuadWrites = 0;
+};
+
 class GameRenderer {
+public:
+    // built by the assets target, see CMakeLists.txt
+    static inline constexpr const char* ASSET_ARCHIVE_PATH = "assets.pak";
+
+    static inline constexpr uint32_t MAX_CHUNK_UPLOADS_PER_FRAME = 2;
+
+    // chunks beyond this many fall back to drawing tiles as quads
+    static inline constexpr uint32_t MAX_TILEMAP_TEXTURES = 256;
+
+    // 16x16 tiles indexed by tile id, see shaders/tilemap.frag
+    static inline constexpr uint32_t TILE_ATLAS_COLUMNS = 16;
+    static inline constexpr const char* TILE_ATLAS_PATH = "tiles.png";
+
+    // every .png in the directory becomes a sprite named after the file, packed into atlas pages of this size
+    static inline constexpr const char* SPRITE_DIRECTORY = "sprites";
+    static inline constexpr uint32_t SPRITE_ATLAS_SIZE = 2048;
+    // drawn in place of the player's colored quad when present
+    static inline constexpr const char* PLAYER_SPRITE = "player";
+
+private:
     Window window;
 
     VkInstance instance;
@@ -66,9 +193,12 @@ class GameRenderer {
 
     Shaders shaders;
     Shaders shaders1;
+    Shaders tilemapShaders;
+    Shaders spriteShaders;
 
     VkCommandPool commandPool;
-    VkCommandBuffer commandBuffer;
+    std::vector<VkCommandBuffer> imageCommandBuffers;
+    std::vector<uint64_t> recordedSceneVersions;
 
     VkSemaphore imageAvailableSemaphore;
     VkSemaphore renderFinishedSemaphore;
@@ -81,22 +211,106 @@ class GameRenderer {
     MemBuffer vertexBuffer;
     MemBuffer indexBuffer;
 
+    // Static geometry lives in device local memory, one slot for the freeform objects and one per level chunk.
+    // Chunks are uploaded and freed one by one as they stream, at most MAX_CHUNK_UPLOADS_PER_FRAME per frame.
+    StaticGeometrySlot objectsSlot{};
+    std::shared_ptr<const std::vector<Solid>> uploadedObjects{};
+    std::vector<StaticGeometrySlot> chunkSlots{};
+    std::shared_ptr<const std::vector<StaticChunk>> syncedChunks{};
+    bool staticGeometryPending = false;
+    std::vector<Vertex> staticVertices{};
+    std::vector<uint32_t> staticIndices{};
+
+    VkDescriptorSetLayout tilemapSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool tilemapDescriptorPool = VK_NULL_HANDLE;
+    VkSampler nearestSampler = VK_NULL_HANDLE;
+    MemImage tileAtlas{};
+    uint32_t maxImageDimension = 0;
+    std::vector<uint8_t> tileStaging{};
+
+    // sprite atlas pages live for the whole run, only the per frame sprite quads change
+    SpriteAtlasSet spriteAtlases{};
+    std::vector<MemImage> spritePages{};
+    std::vector<VkDescriptorSet> spriteDescriptorSets{};
+    VkDescriptorSetLayout spriteSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool spriteDescriptorPool = VK_NULL_HANDLE;
+    std::vector<SpriteVertex> spriteVertices{};
+    std::vector<SpriteBatch> spriteBatches{};
+    MemBuffer spriteVertexBuffer{};
+
+    // Moving platforms keep one quad each in a persistently mapped buffer. Only quads whose box changed are rewritten,
+    // the recorded draw stays valid until the number of platforms changes.
+    MemBuffer kinematicVertexBuffer{};
+    Vertex* kinematicVertices = nullptr;
+    uint32_t kinematicCapacity = 0;
+    std::vector<AABB> uploadedKinematics{};
+    uint64_t uploadedKinematicsVersion = 0;
+
+    // the quad index pattern drawn by sprites and moving platforms
+    MemBuffer quadIndexBuffer{};
+    uint32_t quadIndexCapacity = 0;
+
     SwapChain swapChain;
     RenderPass renderPass;
     GraphicsPipeline graphicsPipeline;
     GraphicsPipeline graphicsPipeline1;
+    GraphicsPipeline tilemapPipeline;
+    GraphicsPipeline spritePipeline;
+
+    IdleSettings idleSettings{};
+    RenderStats renderStats{};
+    uint64_t lastSceneKey = 0;
+    uint64_t sceneVersion = 0;
+    size_t sceneObjectCount = 0;
+    uint64_t lastPresentNs = 0;
 
 public:
     static GameRenderer initialize(Window window);
 
-    bool render(const World& world);
+    bool render(const RenderSnapshot& snapshot);
+
+    void setIdleSettings(IdleSettings settings) noexcept {
+        idleSettings = settings;
+    }
+
+    const RenderStats& stats() const noexcept {
+        return renderStats;
+    }
 
     void destroy();
 
 private:
     void recreateSwapChain();
 
-    void recordCommandBuffer(uint32_t imageIndex, size_t objectCount, size_t lineCount);
+    void uploadScene(const RenderSnapshot& snapshot);
+
+    // Returns whether any static buffer changed
+    bool syncStaticGeometry(const RenderSnapshot& snapshot);
+
+    void uploadStaticSlot(StaticGeometrySlot& slot);
+
+    void destroyStaticSlot(StaticGeometrySlot& slot);
+
+    void createTilemapResources();
+
+    // Decodes the sprite directory in parallel, packs it into atlas pages and uploads them
+    void createSpriteResources();
+
+    // Copies spriteVertices into the sprite vertex buffer, growing the shared quad index buffer when needed
+    void uploadSprites();
+
+    // Rewrites the quads of platforms that moved. Returns whether the buffers changed and have to be recorded again.
+    bool syncKinematics(const RenderSnapshot& snapshot);
+
+    // Makes the quad index buffer cover quadCount quads. Returns whether it was replaced.
+    bool reserveQuadIndices(uint32_t quadCount);
+
+    // Uploads the slot level's tile ids into its tile texture, creating it when the slot has none. previous is the
+    // tile layer the existing texture holds, only blocks that differ from it are copied. Returns false when the layer
+    // cannot be textured and has to be drawn as quads.
+    bool uploadTileIds(StaticGeometrySlot& slot, const TileMap* previous);
+
+    void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, size_t objectCount, size_t lineCount);
 
     void cmdDrawMultiIndexed(
         VkCommandBuffer commandBuffer, //
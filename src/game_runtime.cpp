@@ -0,0 +1,188 @@
+#include "game_runtime.h"
+
+#include <thread>
+
+#include "platform/frame_pacer.h"
+#include "platform/thread.h"
+#include "platform/time.h"
+#include "util/profiler.h"
+
+static void printTiming(std::ostream& out, const char* name, const ThreadTiming& timing) {
+    out << '\t' << name << ": frames " << timing.frames.load(std::memory_order_relaxed) //
+        << ", avg " << nsecsToMillis(timing.averageFrameNs()) << " ms"
+        << ", max " << nsecsToMillis(timing.maxFrameNs.load(std::memory_order_relaxed)) << " ms"
+        << ", last " << nsecsToMillis(timing.lastFrameNs.load(std::memory_order_relaxed)) << " ms\n";
+}
+
+void FrameStats::print(std::ostream& out) const {
+    out << "frame stats:\n";
+    printTiming(out, "input", input);
+    printTiming(out, "simulation", simulation);
+    printTiming(out, "render", render);
+    out << "\tsimulation missed deadlines: " << simulationMissedDeadlines.load(std::memory_order_relaxed) << '\n';
+    out << "\tdropped input events: " << droppedInputEvents.load(std::memory_order_relaxed) << std::endl;
+}
+
+GameRuntime::GameRuntime(Window window, GameRenderer& renderer, std::shared_ptr<const ChunkedLevelIndex> chunkedLevel)
+    : window(window), renderer(renderer), chunkedLevel(std::move(chunkedLevel)), game(newGame()) {
+    streamer = std::make_unique<ChunkStreamer>(this->chunkedLevel);
+    streamer->prime(game.world, game.world.player().pos());
+}
+
+Game GameRuntime::newGame() const {
+    if (chunkedLevel != nullptr) {
+        const auto& spawns = chunkedLevel->spawns();
+        return Game(nullptr, !spawns.empty() ? Vec2(spawns[0].x, spawns[0].y) : Vec2(0.0f, 0.0f));
+    }
+    return level != nullptr ? Game(level) : Game();
+}
+
+void GameRuntime::run() {
+    PROFILE_THREAD_NAME("input");
+
+    running.store(true, std::memory_order_release);
+
+    if (streamer != nullptr) {
+        streamer->start();
+    }
+
+    std::thread simulationThread([this] { simulationLoop(); });
+    std::thread renderThread([this] { renderLoop(); });
+
+    while (running.load(std::memory_order_acquire) && !window.shouldClose()) {
+        uint64_t frameStart = monotonicNsecs();
+        {
+            PROFILE_ZONE("glfwWaitEventsTimeout");
+            glfwWaitEventsTimeout(INPUT_POLL_TIMEOUT_SECONDS);
+        }
+        frameStats.droppedInputEvents.store(window.droppedInputEvents(), std::memory_order_relaxed);
+        frameStats.input.record(monotonicNsecs() - frameStart);
+    }
+
+    running.store(false, std::memory_order_release);
+    simulationThread.join();
+    renderThread.join();
+    if (streamer != nullptr) {
+        streamer->stop();
+    }
+
+    if (workerException != nullptr) {
+        std::rethrow_exception(workerException);
+    }
+}
+
+void GameRuntime::simulationLoop() {
+    PROFILE_THREAD_NAME("simulation");
+
+    try {
+        const float tickDelta = 1000.0f / static_cast<float>(SIMULATION_TICK_RATE); // game time is in milliseconds
+
+        FramePacer pacer = FramePacer::fromRate(SIMULATION_TICK_RATE);
+        RenderSnapshotBuilder snapshotBuilder;
+        uint64_t tick = 0;
+
+        while (running.load(std::memory_order_acquire)) {
+            uint64_t tickStart = monotonicNsecs();
+            {
+                PROFILE_ZONE("simulation tick");
+
+                InputEvent event{};
+                while (window.pollInputEventUntil(tickStart, event)) {
+                    applyInput(event);
+                }
+
+                if (resetRequested) {
+                    // resident chunks do not depend on the game state, keep them instead of streaming them in again
+                    auto chunks = std::move(game.world.chunks);
+                    game = newGame();
+                    if (streamer != nullptr) {
+                        game.world.chunks = std::move(chunks);
+                        game.world.markLevelDirty();
+                    }
+                    resetRequested = false;
+                }
+                if (jumpRequested) {
+                    game.playerJump();
+                    jumpRequested = false;
+                }
+                game.moveLeft = moveLeftPressed;
+                game.moveRight = moveRightPressed;
+
+                game.process(tickDelta);
+
+                if (streamer != nullptr) {
+                    streamer->setFocus(game.world.player().pos());
+                    streamer->update(game.world);
+                }
+
+                snapshotBuilder.build(game.world, tick, tickStart, snapshots.writeBuffer());
+                snapshots.publish();
+                tick++;
+            }
+            frameStats.simulation.record(monotonicNsecs() - tickStart);
+
+            pacer.wait();
+            frameStats.simulationMissedDeadlines.store(pacer.stats().missedDeadlines, std::memory_order_relaxed);
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+void GameRuntime::renderLoop() {
+    PROFILE_THREAD_NAME("render");
+
+    try {
+        while (running.load(std::memory_order_acquire)) {
+            if (!snapshots.update()) {
+                // nothing new to show: sleep instead of spinning so an idle scene costs almost no CPU
+                threadSleepNsecs(RENDER_IDLE_POLL_NS);
+                continue;
+            }
+
+            uint64_t frameStart = monotonicNsecs();
+            bool rendered = renderer.render(snapshots.readBuffer());
+            frameStats.render.record(monotonicNsecs() - frameStart);
+
+            if (!rendered) {
+                // minimized, nothing to present to
+                threadSleepNsecs(10 * NSECS_PER_MSEC);
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+void GameRuntime::applyInput(const InputEvent& event) {
+    if (event.type != InputEventType::KEY) {
+        return;
+    }
+
+    const auto& key = event.key;
+    if (key.key == GLFW_KEY_A) {
+        if (key.action == GLFW_PRESS) {
+            moveLeftPressed = true;
+        } else if (key.action == GLFW_RELEASE) {
+            moveLeftPressed = false;
+        }
+    } else if (key.key == GLFW_KEY_D) {
+        if (key.action == GLFW_PRESS) {
+            moveRightPressed = true;
+        } else if (key.action == GLFW_RELEASE) {
+            moveRightPressed = false;
+        }
+    } else if (key.key == GLFW_KEY_W && key.action == GLFW_PRESS) {
+        jumpRequested = true;
+    } else if (key.key == GLFW_KEY_X && key.action == GLFW_PRESS) {
+        resetRequested = true;
+    }
+}
+
+void GameRuntime::fail(std::exception_ptr exception) {
+    if (!workerExceptionSet.test_and_set()) {
+        workerException = exception;
+    }
+    running.store(false, std::memory_order_release);
+    glfwPostEmptyEvent();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <ostream>
+
+#include "game/chunk_streamer.h"
+#include "game/chunked_level.h"
+#include "game/game.h"
+#include "game/render_snapshot.h"
+#include "game_renderer.h"
+#include "input_event.h"
+#include "platform/time.h"
+#include "util/triple_buffer.h"
+#include "window.h"
+
+struct ThreadTiming {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> lastFrameNs{0};
+    std::atomic<uint64_t> maxFrameNs{0};
+    std::atomic<uint64_t> totalFrameNs{0};
+
+    void record(uint64_t frameNs) noexcept {
+        frames.fetch_add(1, std::memory_order_relaxed);
+        lastFrameNs.store(frameNs, std::memory_order_relaxed);
+        totalFrameNs.fetch_add(frameNs, std::memory_order_relaxed);
+        uint64_t max = maxFrameNs.load(std::memory_order_relaxed);
+        while (max < frameNs && !maxFrameNs.compare_exchange_weak(max, frameNs, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t averageFrameNs() const noexcept {
+        uint64_t count = frames.load(std::memory_order_relaxed);
+        return count != 0 ? totalFrameNs.load(std::memory_order_relaxed) / count : 0;
+    }
+};
+
+struct FrameStats {
+    ThreadTiming input;
+    ThreadTiming simulation;
+    ThreadTiming render;
+
+    std::atomic<uint64_t> simulationMissedDeadlines{0};
+    std::atomic<uint64_t> droppedInputEvents{0};
+
+    void print(std::ostream& out) const;
+};
+
+// Runs input, simulation and rendering on separate threads. The simulation ticks at a fixed rate and
+// publishes RenderSnapshots through a triple buffer, so a slow present never stalls physics and a slow
+// tick never stalls presenting.
+class GameRuntime {
+public:
+    static inline constexpr uint32_t SIMULATION_TICK_RATE = 120;
+    static inline constexpr double INPUT_POLL_TIMEOUT_SECONDS = 0.001;
+    static inline constexpr uint64_t RENDER_IDLE_POLL_NS = 500 * NSECS_PER_USEC;
+
+private:
+    Window window;
+    GameRenderer& renderer;
+
+    std::shared_ptr<const Level> level;
+    std::shared_ptr<const ChunkedLevelIndex> chunkedLevel;
+    std::unique_ptr<ChunkStreamer> streamer{};
+    Game game;
+    TripleBuffer<RenderSnapshot> snapshots{};
+
+    std::atomic<bool> running{false};
+    std::exception_ptr workerException{};
+    std::atomic_flag workerExceptionSet = ATOMIC_FLAG_INIT;
+
+    FrameStats frameStats{};
+
+    // owned by the simulation thread
+    bool moveLeftPressed = false;
+    bool moveRightPressed = false;
+    bool jumpRequested = false;
+    bool resetRequested = false;
+
+public:
+    // Without a level the built-in one is played
+    GameRuntime(Window window, GameRenderer& renderer, std::shared_ptr<const Level> level = nullptr)
+        : window(window), renderer(renderer), level(level), game(newGame()) {}
+
+    // Streams the static geometry of a chunked level around the player
+    GameRuntime(Window window, GameRenderer& renderer, std::shared_ptr<const ChunkedLevelIndex> chunkedLevel);
+
+    // Blocks until the window is closed. The calling thread becomes the input thread, GLFW requires it to be the main one.
+    void run();
+
+    const FrameStats& stats() const noexcept {
+        return frameStats;
+    }
+
+private:
+    Game newGame() const;
+
+    void simulationLoop();
+
+    void renderLoop();
+
+    void applyInput(const InputEvent& event);
+
+    void fail(std::exception_ptr exception);
+};
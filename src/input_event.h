@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+enum class InputEventType : uint8_t {
+    KEY,
+    CURSOR,
+    RESIZE,
+};
+
+struct KeyInput {
+    int key;
+    int scancode;
+    int action;
+    int mods;
+};
+
+struct CursorInput {
+    double x;
+    double y;
+};
+
+struct ResizeInput {
+    int width;
+    int height;
+};
+
+// Timestamps come from monotonicNsecs() so consumers can replay events at the tick they occurred
+struct InputEvent {
+    InputEventType type;
+    uint64_t timestampNs;
+    union {
+        KeyInput key;
+        CursorInput cursor;
+        ResizeInput resize;
+    };
+
+    static InputEvent makeKey(uint64_t timestampNs, int key, int scancode, int action, int mods) noexcept {
+        InputEvent event{InputEventType::KEY, timestampNs, {}};
+        event.key = {key, scancode, action, mods};
+        return event;
+    }
+
+    static InputEvent makeCursor(uint64_t timestampNs, double x, double y) noexcept {
+        InputEvent event{InputEventType::CURSOR, timestampNs, {}};
+        event.cursor = {x, y};
+        return event;
+    }
+
+    static InputEvent makeResize(uint64_t timestampNs, int width, int height) noexcept {
+        InputEvent event{InputEventType::RESIZE, timestampNs, {}};
+        event.resize = {width, height};
+        return event;
+    }
+};
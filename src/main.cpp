@@ -5,19 +5,17 @@
 #include "glfw.h"
 
 #include "debug.h"
-#include "game/game.h"
+#include "game/chunked_level.h"
+#include "game/level.h"
 #include "game_renderer.h"
-#include "platform/time.h"
+#include "game_runtime.h"
 #include "sys/vulkan/instance.h"
+#include "util/profiler.h"
 #include "window.h"
 
-#include "render_device.h"
-
 // TODO: refactor physics
 // TODO: add rendering fallback if multidraw is not available
 
-static uint64_t appStartMs;
-
 void cleanup() {
     terminateGlfw();
 }
@@ -32,120 +30,62 @@ void printVulkanAvailableExtensions() {
     }
 }
 
-int main() {
-    setupDebug();
+// usage: MyTarget [level file]
+int main(int argc, char** argv) {
+    try {
+        setupDebug();
+        setupProfiler();
 
-    printVulkanAvailableExtensions();
+        std::shared_ptr<const Level> level{};
+        std::shared_ptr<const ChunkedLevelIndex> chunkedLevel{};
+        if (argc > 1 && ChunkedLevelIndex::isChunkedLevel(argv[1])) {
+            chunkedLevel = ChunkedLevelIndex::open(argv[1]);
+            std::cout << "streaming level " << argv[1] << ": " << chunkedLevel->chunks().size() << " chunks" << std::endl;
+        } else if (argc > 1) {
+            level = Level::map(argv[1]);
+            std::cout << "loaded level " << argv[1] << ": " << level->geometry().solids.count << " solids" << std::endl;
+        }
 
-    Window window = Window::create(800, 600, "Vulkan sample", true);
+        printVulkanAvailableExtensions();
 
-    if (debugEnabled && !checkValidationLayerSupport()) {
-        throw std::runtime_error("validation layers requested, but not available!");
-    }
+        Window window = Window::create(800, 600, "Vulkan sample", true);
 
-    RenderDevice device = RenderDevice::create(window);
-    device.destroy();
-}
+        if (debugEnabled && !checkValidationLayerSupport()) {
+            throw std::runtime_error("validation layers requested, but not available!");
+        }
+
+        std::cout << "initializing renderer" << std::endl;
+
+        GameRenderer renderer = GameRenderer::initialize(window);
+        renderer.setIdleSettings(IdleSettings::fromEnv());
+
+        std::cout << "renderer initialized" << std::endl;
+
+        {
+            auto runtime = chunkedLevel != nullptr ? std::make_unique<GameRuntime>(window, renderer, chunkedLevel)
+                                                   : std::make_unique<GameRuntime>(window, renderer, level);
+            runtime->run();
 
-//int main() {
-//    try {
-//        appStartMs = unixUsecs();
-//
-//        setupDebug();
-//
-//        printVulkanAvailableExtensions();
-//
-//        Window window = Window::create(800, 600, "Vulkan sample", true);
-//
-//        if (debugEnabled && !checkValidationLayerSupport()) {
-//            throw std::runtime_error("validation layers requested, but not available!");
-//        }
-//
-//        Game game{};
-//        auto& player = game.world.player;
-//
-//        std::cout << "initializing renderer" << std::endl;
-//
-//        GameRenderer renderer = GameRenderer::initialize(window);
-//
-//        std::cout << "renderer initialized" << std::endl;
-//
-//        bool aKeyPressed = false;
-//        bool dKeyPressed = false;
-//
-//        uint64_t lFrameDelta = 0;
-//        uint64_t frameCount = 0;
-//        uint64_t gameLoopStart = unixUsecs();
-////        uint64_t gameStart = gameLoopStart;
-//        float frameDeltas = 0.0f;
-//        while (!window.shouldClose()) {
-//            uint64_t frameStart = unixUsecs();
-//            glfwPollEvents();
-//
-//            bool wPressed = false;
-//            for (const auto& event : window.keyEvents()) {
-//                if (event.key == GLFW_KEY_A) {
-//                    if (event.action == GLFW_PRESS) {
-//                        aKeyPressed = true;
-//                    } else if (event.action == GLFW_RELEASE) {
-//                        aKeyPressed = false;
-//                    }
-//                } else if (event.key == GLFW_KEY_D) {
-//                    if (event.action == GLFW_PRESS) {
-//                        dKeyPressed = true;
-//                    } else if (event.action == GLFW_RELEASE) {
-//                        dKeyPressed = false;
-//                    }
-//                } else if (event.key == GLFW_KEY_X && event.action == GLFW_PRESS) {
-//                    game = Game{};
-//                }
-//
-//                if (event.action == GLFW_PRESS && event.key == GLFW_KEY_W) {
-//                    wPressed = true;
-//                }
-//            }
-//            window.keyEvents().clear();
-//
-//            float fFrameDelta = static_cast<float>(lFrameDelta) / 1000.0f;
-//
-////            if (player.vel() == VEC2_ZEROED) {
-////                std::cout << "x: " << player.pos().x << " y: " << player.pos().y << std::endl;
-//////                std::cout << "time passed: " << static_cast<float>((unixUsecs() - gameStart) / 1000) / 1000.0f << std::endl;
-////                double fps = static_cast<double>(frameCount) / (static_cast<double>(unixUsecs() - gameLoopStart) / (1000.0 * 1000.0f));
-////                std::cout << "avg fps: " << fps << std::endl;
-//////                std::cout << "avg frame delta: " << static_cast<double>(frameDeltas) / static_cast<double>(frameCount) << std::endl;
-////
-////                gameStart = unixUsecs();
-////                gameLoopStart = unixUsecs();
-////                frameCount = 0;
-////                frameDeltas = 0.0f;
-////                game = Game{};
-////            }
-//
-//            if (wPressed) {
-//                game.playerJump();
-//            }
-//            game.moveLeft = aKeyPressed;
-//            game.moveRight = dKeyPressed;
-//
-//            game.process(fFrameDelta);
-//            renderer.render(game.world);
-//
-//            frameDeltas += fFrameDelta;
-//
-//            lFrameDelta = unixUsecs() - frameStart;
-//            frameCount++;
-//        }
-//
-//        renderer.destroy();
-//
-//        window.destroy();
-//
-//        cleanup();
-//
-//        return EXIT_SUCCESS;
-//    } catch (std::exception& exception) {
-//        std::cout << exception.what() << std::endl;
-//        return EXIT_FAILURE;
-//    }
-//}
+            if (debugEnabled) {
+                runtime->stats().print(std::cout);
+
+                const auto& renderStats = renderer.stats();
+                std::cout << "render stats: presented " << renderStats.presentedFrames //
+                          << ", re-submitted " << renderStats.resubmittedFrames
+                          << ", skipped " << renderStats.skippedFrames
+                          << ", platform quads written " << renderStats.kinematicQuadWrites << std::endl;
+            }
+        }
+
+        renderer.destroy();
+
+        window.destroy();
+
+        cleanup();
+
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cout << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../util/numbers.h"
+
+// Q16.16 fixed point: 16 integer bits, so values are limited to about +-32767, and a resolution of 1/65536. Only
+// integer arithmetic is involved, so every build on every platform computes the same bits. Results that do not fit
+// saturate instead of wrapping, and dividing by zero saturates like an infinity would (0 / 0 gives 0).
+class Fixed {
+    int32_t _raw = 0;
+
+public:
+    static inline constexpr int32_t FRACTION_BITS = 16;
+    static inline constexpr int32_t ONE = 1 << FRACTION_BITS;
+
+    constexpr Fixed() = default;
+
+    explicit constexpr Fixed(int32_t value) : _raw(saturate(static_cast<int64_t>(value) * ONE)) {}
+
+    // Rounds to the nearest step. Exact for floats that fit, done in double so that it is never contracted into
+    // something build dependent.
+    explicit constexpr Fixed(float value) : _raw(fromDouble(static_cast<double>(value))) {}
+
+    static constexpr Fixed fromRaw(int32_t raw) noexcept {
+        Fixed fixed;
+        fixed._raw = raw;
+        return fixed;
+    }
+
+    constexpr int32_t raw() const noexcept {
+        return _raw;
+    }
+
+    explicit constexpr operator float() const noexcept {
+        return static_cast<float>(static_cast<double>(_raw) / ONE);
+    }
+
+    // Rounds towards zero
+    explicit constexpr operator uint32_t() const noexcept {
+        return _raw < 0 ? 0 : static_cast<uint32_t>(_raw / ONE);
+    }
+
+    constexpr Fixed operator+(Fixed rhs) const noexcept {
+        return fromRaw(saturate(static_cast<int64_t>(_raw) + rhs._raw));
+    }
+
+    constexpr Fixed operator-() const noexcept {
+        return fromRaw(saturate(-static_cast<int64_t>(_raw)));
+    }
+
+    constexpr Fixed operator-(Fixed rhs) const noexcept {
+        return fromRaw(saturate(static_cast<int64_t>(_raw) - rhs._raw));
+    }
+
+    // rounds to nearest, halves away from zero
+    constexpr Fixed operator*(Fixed rhs) const noexcept {
+        int64_t product = static_cast<int64_t>(_raw) * rhs._raw;
+        int64_t half = int64_t{1} << (FRACTION_BITS - 1);
+        return fromRaw(saturate(product >= 0 ? (product + half) / ONE : (product - half) / ONE));
+    }
+
+    // rounds towards zero
+    constexpr Fixed operator/(Fixed rhs) const noexcept {
+        if (rhs._raw == 0) {
+            return fromRaw(_raw > 0 ? NUM_MAX<int32_t> : _raw < 0 ? -NUM_MAX<int32_t> : 0);
+        }
+        return fromRaw(saturate(static_cast<int64_t>(_raw) * ONE / rhs._raw));
+    }
+
+    constexpr Fixed& operator+=(Fixed rhs) noexcept {
+        return *this = *this + rhs;
+    }
+
+    constexpr Fixed& operator-=(Fixed rhs) noexcept {
+        return *this = *this - rhs;
+    }
+
+    constexpr Fixed& operator*=(Fixed rhs) noexcept {
+        return *this = *this * rhs;
+    }
+
+    constexpr Fixed& operator/=(Fixed rhs) noexcept {
+        return *this = *this / rhs;
+    }
+
+    constexpr bool operator==(Fixed rhs) const noexcept {
+        return _raw == rhs._raw;
+    }
+
+    constexpr bool operator!=(Fixed rhs) const noexcept {
+        return _raw != rhs._raw;
+    }
+
+    constexpr bool operator<(Fixed rhs) const noexcept {
+        return _raw < rhs._raw;
+    }
+
+    constexpr bool operator<=(Fixed rhs) const noexcept {
+        return _raw <= rhs._raw;
+    }
+
+    constexpr bool operator>(Fixed rhs) const noexcept {
+        return _raw > rhs._raw;
+    }
+
+    constexpr bool operator>=(Fixed rhs) const noexcept {
+        return _raw >= rhs._raw;
+    }
+
+private:
+    // the most negative value is left out so that negating never overflows
+    static constexpr int32_t saturate(int64_t value) noexcept {
+        if (value > NUM_MAX<int32_t>) {
+            return NUM_MAX<int32_t>;
+        }
+        if (value < -NUM_MAX<int32_t>) {
+            return -NUM_MAX<int32_t>;
+        }
+        return static_cast<int32_t>(value);
+    }
+
+    static constexpr int32_t fromDouble(double value) noexcept {
+        double scaled = value * ONE;
+        if (!(scaled > -static_cast<double>(NUM_MAX<int32_t>))) {
+            return scaled < 0.0 ? -NUM_MAX<int32_t> : 0; // NaN becomes 0
+        }
+        if (scaled >= static_cast<double>(NUM_MAX<int32_t>)) {
+            return NUM_MAX<int32_t>;
+        }
+        return static_cast<int32_t>(scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5);
+    }
+};
+
+// rounds towards zero, like std::trunc for the float builds of templated code
+inline constexpr Fixed trunc(Fixed value) noexcept {
+    return Fixed::fromRaw(value.raw() / Fixed::ONE * Fixed::ONE);
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define APP_FLOAT4_SSE
+#include <emmintrin.h>
+#endif
+
+// Four float lanes. Every operation is the lane-wise IEEE single precision one, so lane results are bit-identical to
+// the same scalar expressions as long as the compiler does not contract those into FMAs. Without SSE2 the lanes are
+// plain arrays.
+struct Mask4;
+
+#if defined(APP_FLOAT4_SSE)
+struct Float4 {
+    __m128 v;
+
+    static Float4 splat(float x) noexcept {
+        return {_mm_set1_ps(x)};
+    }
+
+    static Float4 set(float a, float b, float c, float d) noexcept {
+        return {_mm_setr_ps(a, b, c, d)};
+    }
+
+    static Float4 load(const float* p) noexcept {
+        return {_mm_loadu_ps(p)};
+    }
+
+    void store(float* p) const noexcept {
+        _mm_storeu_ps(p, v);
+    }
+
+    friend Float4 operator+(Float4 a, Float4 b) noexcept {
+        return {_mm_add_ps(a.v, b.v)};
+    }
+
+    friend Float4 operator-(Float4 a, Float4 b) noexcept {
+        return {_mm_sub_ps(a.v, b.v)};
+    }
+
+    friend Float4 operator*(Float4 a, Float4 b) noexcept {
+        return {_mm_mul_ps(a.v, b.v)};
+    }
+
+    friend Float4 operator/(Float4 a, Float4 b) noexcept {
+        return {_mm_div_ps(a.v, b.v)};
+    }
+};
+
+// all ones or all zeros per lane
+struct Mask4 {
+    __m128 v;
+
+    static Mask4 load(const uint32_t* p) noexcept {
+        return {_mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))};
+    }
+
+    static Mask4 set(bool a, bool b, bool c, bool d) noexcept {
+        return {_mm_castsi128_ps(_mm_setr_epi32(-static_cast<int>(a), -static_cast<int>(b), -static_cast<int>(c), -static_cast<int>(d)))};
+    }
+
+    void store(uint32_t* p) const noexcept {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_castps_si128(v));
+    }
+
+    bool any() const noexcept {
+        return _mm_movemask_ps(v) != 0;
+    }
+
+    // bit k set for lane k
+    uint32_t bits() const noexcept {
+        return static_cast<uint32_t>(_mm_movemask_ps(v));
+    }
+
+    friend Mask4 operator&(Mask4 a, Mask4 b) noexcept {
+        return {_mm_and_ps(a.v, b.v)};
+    }
+
+    friend Mask4 operator|(Mask4 a, Mask4 b) noexcept {
+        return {_mm_or_ps(a.v, b.v)};
+    }
+
+    friend Mask4 operator~(Mask4 a) noexcept {
+        return {_mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1)))};
+    }
+};
+
+// ordered comparisons are false for NaN lanes like their scalar counterparts, != is true for them
+inline Mask4 operator<(Float4 a, Float4 b) noexcept {
+    return {_mm_cmplt_ps(a.v, b.v)};
+}
+
+inline Mask4 operator>(Float4 a, Float4 b) noexcept {
+    return {_mm_cmpgt_ps(a.v, b.v)};
+}
+
+inline Mask4 operator<=(Float4 a, Float4 b) noexcept {
+    return {_mm_cmple_ps(a.v, b.v)};
+}
+
+inline Mask4 operator>=(Float4 a, Float4 b) noexcept {
+    return {_mm_cmpge_ps(a.v, b.v)};
+}
+
+inline Mask4 operator==(Float4 a, Float4 b) noexcept {
+    return {_mm_cmpeq_ps(a.v, b.v)};
+}
+
+inline Mask4 operator!=(Float4 a, Float4 b) noexcept {
+    return {_mm_cmpneq_ps(a.v, b.v)};
+}
+
+// mask ? a : b
+inline Float4 select(Mask4 mask, Float4 a, Float4 b) noexcept {
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+#else
+struct Float4 {
+    float v[4];
+
+    static Float4 splat(float x) noexcept {
+        return {{x, x, x, x}};
+    }
+
+    static Float4 set(float a, float b, float c, float d) noexcept {
+        return {{a, b, c, d}};
+    }
+
+    static Float4 load(const float* p) noexcept {
+        return {{p[0], p[1], p[2], p[3]}};
+    }
+
+    void store(float* p) const noexcept {
+        for (int i = 0; i < 4; i++) {
+            p[i] = v[i];
+        }
+    }
+
+    friend Float4 operator+(Float4 a, Float4 b) noexcept {
+        return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+    }
+
+    friend Float4 operator-(Float4 a, Float4 b) noexcept {
+        return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+    }
+
+    friend Float4 operator*(Float4 a, Float4 b) noexcept {
+        return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+    }
+
+    friend Float4 operator/(Float4 a, Float4 b) noexcept {
+        return {{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}};
+    }
+};
+
+struct Mask4 {
+    bool v[4];
+
+    static Mask4 load(const uint32_t* p) noexcept {
+        return {{p[0] != 0, p[1] != 0, p[2] != 0, p[3] != 0}};
+    }
+
+    static Mask4 set(bool a, bool b, bool c, bool d) noexcept {
+        return {{a, b, c, d}};
+    }
+
+    void store(uint32_t* p) const noexcept {
+        for (int i = 0; i < 4; i++) {
+            p[i] = v[i] ? 0xffffffff : 0;
+        }
+    }
+
+    bool any() const noexcept {
+        return v[0] || v[1] || v[2] || v[3];
+    }
+
+    uint32_t bits() const noexcept {
+        return static_cast<uint32_t>(v[0]) | static_cast<uint32_t>(v[1]) << 1 | static_cast<uint32_t>(v[2]) << 2 | static_cast<uint32_t>(v[3]) << 3;
+    }
+
+    friend Mask4 operator&(Mask4 a, Mask4 b) noexcept {
+        return {{a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2], a.v[3] && b.v[3]}};
+    }
+
+    friend Mask4 operator|(Mask4 a, Mask4 b) noexcept {
+        return {{a.v[0] || b.v[0], a.v[1] || b.v[1], a.v[2] || b.v[2], a.v[3] || b.v[3]}};
+    }
+
+    friend Mask4 operator~(Mask4 a) noexcept {
+        return {{!a.v[0], !a.v[1], !a.v[2], !a.v[3]}};
+    }
+};
+
+#define APP_FLOAT4_COMPARE(op)                                                                 \
+    inline Mask4 operator op(Float4 a, Float4 b) noexcept {                                    \
+        return {{a.v[0] op b.v[0], a.v[1] op b.v[1], a.v[2] op b.v[2], a.v[3] op b.v[3]}};     \
+    }
+APP_FLOAT4_COMPARE(<)
+APP_FLOAT4_COMPARE(>)
+APP_FLOAT4_COMPARE(<=)
+APP_FLOAT4_COMPARE(>=)
+APP_FLOAT4_COMPARE(==)
+APP_FLOAT4_COMPARE(!=)
+#undef APP_FLOAT4_COMPARE
+
+inline Float4 select(Mask4 mask, Float4 a, Float4 b) noexcept {
+    Float4 result;
+    for (int i = 0; i < 4; i++) {
+        result.v[i] = mask.v[i] ? a.v[i] : b.v[i];
+    }
+    return result;
+}
+#endif
+
+// std::min, std::max and std::clamp, including which operand wins for equal values and signed zeros
+inline Float4 min4(Float4 a, Float4 b) noexcept {
+    return select(b < a, b, a);
+}
+
+inline Float4 max4(Float4 a, Float4 b) noexcept {
+    return select(a < b, b, a);
+}
+
+inline Float4 clamp4(Float4 v, Float4 lo, Float4 hi) noexcept {
+    return select(v < lo, lo, select(hi < v, hi, v));
+}
@@ -1,51 +1,58 @@
 #pragma once
 
-class Vec2 {
+// Scalar is float for everything but the deterministic physics mode, which uses Fixed
+template <typename T>
+class BasicVec2 {
 public:
-    float x, y;
+    T x, y;
 
-    constexpr Vec2(float x, float y) : x(x), y(y) {}
+    constexpr BasicVec2(T x, T y) : x(x), y(y) {}
 
-    constexpr Vec2();
+    constexpr BasicVec2() : x(0), y(0) {}
 
-    constexpr Vec2(const Vec2&) = default;
+    constexpr BasicVec2(const BasicVec2&) = default;
 
-    Vec2 operator+(const Vec2& rhs) const noexcept {
+    template <typename U>
+    explicit constexpr BasicVec2(const BasicVec2<U>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)) {}
+
+    BasicVec2& operator=(const BasicVec2&) = default;
+
+    BasicVec2 operator+(const BasicVec2& rhs) const noexcept {
         return {this->x + rhs.x, this->y + rhs.y};
     }
 
-    Vec2 operator-() const noexcept {
+    BasicVec2 operator-() const noexcept {
         return {-this->x, -this->y};
     }
 
-    Vec2 operator-(const Vec2& rhs) const noexcept {
+    BasicVec2 operator-(const BasicVec2& rhs) const noexcept {
         return *this + (-rhs);
     }
 
-    Vec2 operator*(const float scalar) const noexcept {
+    BasicVec2 operator*(const T scalar) const noexcept {
         return {this->x * scalar, this->y * scalar};
     }
 
-    Vec2 operator/(const float scalar) const noexcept {
+    BasicVec2 operator/(const T scalar) const noexcept {
         return {this->x / scalar, this->y / scalar};
     }
 
-    bool operator==(const Vec2& rhs) const noexcept {
+    bool operator==(const BasicVec2& rhs) const noexcept {
         return this->x == rhs.x && this->y == rhs.y;
     }
 
-    Vec2 onlyX() const noexcept {
-        return {x, 0.0f};
+    BasicVec2 onlyX() const noexcept {
+        return {x, T(0)};
     }
 
-    Vec2 onlyY() const noexcept {
-        return {0.0f, y};
+    BasicVec2 onlyY() const noexcept {
+        return {T(0), y};
     }
 };
 
-inline constexpr Vec2 VEC2_ZEROED{0.0f, 0.0f};
+using Vec2 = BasicVec2<float>;
 
-constexpr Vec2::Vec2() : Vec2(VEC2_ZEROED) {}
+inline constexpr Vec2 VEC2_ZEROED{0.0f, 0.0f};
 
 class Vec3 {
 public:
@@ -0,0 +1,156 @@
+#include "net_client.h"
+
+#include <algorithm>
+
+#include "util/profiler.h"
+
+NetClient::NetClient(std::shared_ptr<const Level> level, NetLink link, NetAddress server, uint32_t tickRate)
+    : link(std::move(link)),
+      server(server),
+      periodNs(NSECS_PER_SEC / std::max<uint32_t>(tickRate, 1)),
+      tickDelta(1000.0f / static_cast<float>(std::max<uint32_t>(tickRate, 1))), // game time is in milliseconds
+      _game(std::move(level)) {
+    snapPlayer(_game.world.player());
+}
+
+void NetClient::update(uint64_t nowNs) {
+    receive();
+    if (!connected()) {
+        if (nowNs >= nextConnectNs) {
+            uint8_t packet[8];
+            BitWriter writer(packet, sizeof(packet));
+            writePacketHeader(writer, NET_PACKET_CONNECT);
+            link.send(nowNs, server, packet, writer.size());
+            nextConnectNs = nowNs + CONNECT_INTERVAL_NS;
+        }
+    } else {
+        if (nextTickNs == 0) {
+            nextTickNs = nowNs;
+        }
+        while (nowNs >= nextTickNs) {
+            step(nowNs);
+            nextTickNs += periodNs;
+        }
+    }
+    link.flush(nowNs);
+}
+
+void NetClient::receive() {
+    uint8_t buffer[NET_MAX_PACKET_SIZE];
+    size_t size;
+    NetAddress from;
+    while (link.receive(buffer, sizeof(buffer), size, from)) {
+        if (from != server) {
+            continue;
+        }
+        BitReader reader(buffer, size);
+        NetPacketType type = readPacketHeader(reader);
+        if (type == NET_PACKET_ACCEPT && !connected()) {
+            uint32_t id = reader.read(32);
+            if (!reader.overflowed() && id != 0) {
+                _id = id;
+            }
+        } else if (type == NET_PACKET_SNAPSHOT && connected()) {
+            onSnapshot(reader);
+        }
+    }
+}
+
+void NetClient::onSnapshot(BitReader& reader) {
+    PROFILE_ZONE("NetClient::onSnapshot");
+
+    uint32_t tick, baselineTick, lastInput;
+    readSnapshotHeader(reader, tick, baselineTick, lastInput);
+    // older snapshots carry nothing new, and their baseline may already be overwritten
+    if (reader.overflowed() || tick <= newestSnapshot) {
+        _stats.snapshotsIgnored++;
+        return;
+    }
+    const NetSnapshot* baseline = nullptr;
+    if (baselineTick != 0) {
+        baseline = &received[baselineTick % SNAPSHOT_HISTORY];
+        if (baseline->tick != baselineTick) {
+            _stats.snapshotsIgnored++;
+            return;
+        }
+    }
+
+    NetSnapshot snapshot;
+    if (!readSnapshotBodies(reader, baseline, snapshot.bodies)) {
+        _stats.snapshotsIgnored++;
+        return;
+    }
+    snapshot.tick = tick;
+    snapshot.lastInput = lastInput;
+    newestSnapshot = tick;
+    _stats.snapshots++;
+
+    _remoteBodies.clear();
+    const NetBody* own = nullptr;
+    for (const auto& body : snapshot.bodies) {
+        if (body.id == _id) {
+            own = &body;
+        } else {
+            _remoteBodies.push_back(body);
+        }
+    }
+
+    if (own != nullptr) {
+        // the server processed everything up to lastInput, the rest still has to be predicted on top of it
+        auto confirmed = std::find_if(pending.begin(), pending.end(), [&](const PendingInput& p) { return p.seq > lastInput; });
+        bool mispredicted = confirmed != pending.begin() && (confirmed - 1)->predicted != *own;
+        pending.erase(pending.begin(), confirmed);
+
+        if (mispredicted) {
+            _stats.corrections++;
+            applyBody(*own, _game.world.player());
+            for (auto& p : pending) {
+                applyInput(p.bits);
+                p.predicted = quantizeBody(_id, _game.world.player());
+            }
+        }
+    }
+
+    received[tick % SNAPSHOT_HISTORY] = std::move(snapshot);
+}
+
+void NetClient::applyInput(uint8_t bits) {
+    if ((bits & NET_INPUT_JUMP) != 0) {
+        _game.playerJump();
+    }
+    _game.moveLeft = (bits & NET_INPUT_LEFT) != 0;
+    _game.moveRight = (bits & NET_INPUT_RIGHT) != 0;
+    _game.process(tickDelta);
+    snapPlayer(_game.world.player());
+}
+
+void NetClient::step(uint64_t nowNs) {
+    PROFILE_ZONE("NetClient::step");
+
+    if (pending.size() < MAX_PENDING_INPUTS) {
+        uint8_t bits = static_cast<uint8_t>((input & (NET_INPUT_LEFT | NET_INPUT_RIGHT)) | (jumpLatched ? NET_INPUT_JUMP : 0));
+        jumpLatched = false;
+        applyInput(bits);
+        pending.push_back({nextInput++, bits, quantizeBody(_id, _game.world.player())});
+    }
+    sendInputs(nowNs);
+}
+
+void NetClient::sendInputs(uint64_t nowNs) {
+    NetInputPacket packet;
+    packet.ackedSnapshot = newestSnapshot;
+    if (!pending.empty()) {
+        packet.firstInput = pending.front().seq;
+        packet.count = std::min<uint32_t>(static_cast<uint32_t>(pending.size()), NET_MAX_INPUTS_PER_PACKET);
+        for (uint32_t i = 0; i < packet.count; i++) {
+            packet.inputs[i] = pending[i].bits;
+        }
+    }
+
+    uint8_t buffer[NET_MAX_PACKET_SIZE];
+    BitWriter writer(buffer, sizeof(buffer));
+    writePacketHeader(writer, NET_PACKET_INPUT);
+    writeInputPacket(writer, packet);
+    link.send(nowNs, server, buffer, writer.size());
+    _stats.inputPackets++;
+}
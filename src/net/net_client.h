@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "game/game.h"
+#include "game/level.h"
+#include "net_link.h"
+#include "net_protocol.h"
+#include "platform/time.h"
+
+struct NetClientStats {
+    uint64_t snapshots = 0;
+    // snapshots that arrived after a newer one, or whose baseline was no longer remembered
+    uint64_t snapshotsIgnored = 0;
+    // snapshots that disagreed with what was predicted for the same input
+    uint64_t corrections = 0;
+    uint64_t inputPackets = 0;
+};
+
+// Predicting side. Every tick the current input is applied to the local Game right away and queued for the server.
+// When a snapshot says which input the server processed last, the player is put where the server had it and the
+// newer inputs are replayed on top.
+class NetClient {
+public:
+    // snapshots remembered as baselines, must cover the server's history
+    static inline constexpr uint32_t SNAPSHOT_HISTORY = 32;
+    // inputs the server has not confirmed yet, the client stops predicting when that many are waiting
+    static inline constexpr uint32_t MAX_PENDING_INPUTS = 256;
+    static inline constexpr uint64_t CONNECT_INTERVAL_NS = 250 * NSECS_PER_MSEC;
+
+private:
+    struct PendingInput {
+        uint32_t seq;
+        uint8_t bits;
+        // the body predicted after this input, compared with the server's once it is confirmed
+        NetBody predicted;
+    };
+
+    NetLink link;
+    NetAddress server;
+    uint64_t periodNs;
+    float tickDelta;
+    uint64_t nextTickNs = 0;
+    uint64_t nextConnectNs = 0;
+    uint32_t _id = 0;
+
+    Game _game;
+    uint8_t input = 0;
+    bool jumpLatched = false;
+    uint32_t nextInput = 1;
+    std::vector<PendingInput> pending{};
+
+    // indexed by tick % SNAPSHOT_HISTORY
+    NetSnapshot received[SNAPSHOT_HISTORY]{};
+    uint32_t newestSnapshot = 0;
+    // other bodies as of the newest snapshot
+    std::vector<NetBody> _remoteBodies{};
+    NetClientStats _stats{};
+
+public:
+    NetClient(std::shared_ptr<const Level> level, NetLink link, NetAddress server, uint32_t tickRate);
+
+    NetLink& netLink() noexcept {
+        return link;
+    }
+
+    bool connected() const noexcept {
+        return _id != 0;
+    }
+
+    uint32_t id() const noexcept {
+        return _id;
+    }
+
+    // NetInputBits held from now on. A jump is kept until the next tick consumes it.
+    void setInput(uint8_t bits) noexcept {
+        input = bits;
+        jumpLatched = jumpLatched || (bits & NET_INPUT_JUMP) != 0;
+    }
+
+    // Receives, predicts the ticks that are due and sends the inputs. Call it often, at least once per tick.
+    void update(uint64_t nowNs);
+
+    const Game& game() const noexcept {
+        return _game;
+    }
+
+    const std::vector<NetBody>& remoteBodies() const noexcept {
+        return _remoteBodies;
+    }
+
+    uint32_t pendingInputs() const noexcept {
+        return static_cast<uint32_t>(pending.size());
+    }
+
+    const NetClientStats& stats() const noexcept {
+        return _stats;
+    }
+
+private:
+    void receive();
+
+    void onSnapshot(BitReader& reader);
+
+    void applyInput(uint8_t bits);
+
+    void step(uint64_t nowNs);
+
+    void sendInputs(uint64_t nowNs);
+};
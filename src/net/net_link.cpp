@@ -0,0 +1,53 @@
+#include "net_link.h"
+
+#include <algorithm>
+
+NetLink::NetLink(UdpSocket socket, uint32_t seed) noexcept : socket(std::move(socket)), random(seed != 0 ? seed : 1) {}
+
+void NetLink::send(uint64_t nowNs, const NetAddress& to, const uint8_t* data, size_t size) {
+    _stats.datagramsSent++;
+    _stats.bytesSent += size + IP_UDP_HEADER_SIZE;
+
+    if (conditions.loss > 0.0f && static_cast<float>(nextRandom() % 1000000) < conditions.loss * 1000000.0f) {
+        _stats.datagramsDropped++;
+        return;
+    }
+    if (conditions.latencyNs == 0 && conditions.jitterNs == 0) {
+        socket.send(to, data, size);
+        return;
+    }
+
+    uint64_t jitter = conditions.jitterNs != 0 ? nextRandom() % (conditions.jitterNs + 1) : 0;
+    delayed.push_back({nowNs + conditions.latencyNs + jitter, sendOrder++, to, std::vector<uint8_t>(data, data + size)});
+    std::push_heap(delayed.begin(), delayed.end(), laterDatagram);
+}
+
+void NetLink::flush(uint64_t nowNs) {
+    while (!delayed.empty() && delayed.front().dueNs <= nowNs) {
+        std::pop_heap(delayed.begin(), delayed.end(), laterDatagram);
+        const Delayed& datagram = delayed.back();
+        socket.send(datagram.to, datagram.data.data(), datagram.data.size());
+        delayed.pop_back();
+    }
+}
+
+bool NetLink::receive(uint8_t* buffer, size_t capacity, size_t& size, NetAddress& from) noexcept {
+    if (!socket.receive(buffer, capacity, size, from)) {
+        return false;
+    }
+    _stats.datagramsReceived++;
+    _stats.bytesReceived += size + IP_UDP_HEADER_SIZE;
+    return true;
+}
+
+// xorshift, the conditions only need to look random
+uint32_t NetLink::nextRandom() noexcept {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+}
+
+bool NetLink::laterDatagram(const Delayed& a, const Delayed& b) noexcept {
+    return a.dueNs != b.dueNs ? a.dueNs > b.dueNs : a.order > b.order;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "platform/udp_socket.h"
+
+// Simulated network impairments, applied to outgoing datagrams
+struct NetConditions {
+    uint64_t latencyNs = 0;
+    // every datagram is delayed by an extra random 0 .. jitterNs, so datagrams may arrive out of order
+    uint64_t jitterNs = 0;
+    // probability of dropping a datagram, 0 .. 1
+    float loss = 0.0f;
+};
+
+struct NetLinkStats {
+    uint64_t datagramsSent = 0;
+    // payload plus the IPv4 and UDP headers
+    uint64_t bytesSent = 0;
+    uint64_t datagramsDropped = 0;
+    uint64_t datagramsReceived = 0;
+    uint64_t bytesReceived = 0;
+};
+
+// A UDP socket that can pretend to be a bad network. Without conditions datagrams go out immediately, otherwise they
+// wait in a queue until flush() is called past their due time.
+class NetLink {
+public:
+    static inline constexpr uint32_t IP_UDP_HEADER_SIZE = 28;
+
+private:
+    struct Delayed {
+        uint64_t dueNs;
+        uint64_t order;
+        NetAddress to;
+        std::vector<uint8_t> data;
+    };
+
+    UdpSocket socket;
+    NetConditions conditions{};
+    uint32_t random;
+    // min-heap by due time, then by send order
+    std::vector<Delayed> delayed{};
+    uint64_t sendOrder = 0;
+    NetLinkStats _stats{};
+
+public:
+    explicit NetLink(UdpSocket socket, uint32_t seed = 1) noexcept;
+
+    void setConditions(const NetConditions& value) noexcept {
+        conditions = value;
+    }
+
+    NetAddress localAddress() const {
+        return socket.localAddress();
+    }
+
+    void send(uint64_t nowNs, const NetAddress& to, const uint8_t* data, size_t size);
+
+    // Sends the delayed datagrams that are due
+    void flush(uint64_t nowNs);
+
+    bool receive(uint8_t* buffer, size_t capacity, size_t& size, NetAddress& from) noexcept;
+
+    const NetLinkStats& stats() const noexcept {
+        return _stats;
+    }
+
+private:
+    uint32_t nextRandom() noexcept;
+
+    static bool laterDatagram(const Delayed& a, const Delayed& b) noexcept;
+};
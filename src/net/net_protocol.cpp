@@ -0,0 +1,166 @@
+#include "net_protocol.h"
+
+#include <algorithm>
+#include <cmath>
+
+static int32_t quantize(float value, float scale) noexcept {
+    float scaled = std::round(value * scale);
+    // far outside any level, only keeps the conversion defined
+    scaled = std::clamp(scaled, -2147483520.0f, 2147483520.0f);
+    return static_cast<int32_t>(scaled);
+}
+
+NetBody quantizeBody(uint32_t id, const Player& player) noexcept {
+    NetBody body;
+    body.id = id;
+    body.x = quantize(player.pos().x, NET_POSITION_SCALE);
+    body.y = quantize(player.pos().y, NET_POSITION_SCALE);
+    body.vx = quantize(player.vel().x, NET_VELOCITY_SCALE);
+    body.vy = quantize(player.vel().y, NET_VELOCITY_SCALE);
+    body.onGround = player.isOnGround();
+    return body;
+}
+
+void applyBody(const NetBody& body, Player& player) noexcept {
+    player.setPos(static_cast<float>(body.x) / NET_POSITION_SCALE, static_cast<float>(body.y) / NET_POSITION_SCALE);
+    player.setVel({static_cast<float>(body.vx) / NET_VELOCITY_SCALE, static_cast<float>(body.vy) / NET_VELOCITY_SCALE});
+    player.setOnGround(body.onGround);
+}
+
+void snapPlayer(Player& player) noexcept {
+    applyBody(quantizeBody(0, player), player);
+}
+
+const NetBody* NetSnapshot::find(uint32_t id) const noexcept {
+    auto it = std::lower_bound(bodies.begin(), bodies.end(), id, [](const NetBody& body, uint32_t id) { return body.id < id; });
+    return it != bodies.end() && it->id == id ? &*it : nullptr;
+}
+
+void writePacketHeader(BitWriter& writer, NetPacketType type) noexcept {
+    writer.write(NET_PROTOCOL_MAGIC, 16);
+    writer.write(type, 8);
+}
+
+NetPacketType readPacketHeader(BitReader& reader) noexcept {
+    uint32_t magic = reader.read(16);
+    auto type = static_cast<NetPacketType>(reader.read(8));
+    return magic == NET_PROTOCOL_MAGIC && !reader.overflowed() ? type : static_cast<NetPacketType>(0);
+}
+
+// Differences are zigzag coded and sent with a 2 bit size class: 4, 8, 14 or 32 bits. Zero costs a single bit.
+// Wrapping arithmetic keeps any pair of values representable.
+static void writeDelta(BitWriter& writer, int32_t value, int32_t base) noexcept {
+    uint32_t delta = static_cast<uint32_t>(value) - static_cast<uint32_t>(base);
+    if (delta == 0) {
+        writer.write(0, 1);
+        return;
+    }
+    writer.write(1, 1);
+    uint32_t zigzag = (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31);
+    if (zigzag < (1u << 4)) {
+        writer.write(0, 2);
+        writer.write(zigzag, 4);
+    } else if (zigzag < (1u << 8)) {
+        writer.write(1, 2);
+        writer.write(zigzag, 8);
+    } else if (zigzag < (1u << 14)) {
+        writer.write(2, 2);
+        writer.write(zigzag, 14);
+    } else {
+        writer.write(3, 2);
+        writer.write(zigzag, 32);
+    }
+}
+
+static int32_t readDelta(BitReader& reader, int32_t base) noexcept {
+    if (reader.read(1) == 0) {
+        return base;
+    }
+    static constexpr uint32_t CLASS_BITS[4] = {4, 8, 14, 32};
+    uint32_t zigzag = reader.read(CLASS_BITS[reader.read(2)]);
+    uint32_t delta = (zigzag >> 1) ^ (0u - (zigzag & 1));
+    return static_cast<int32_t>(static_cast<uint32_t>(base) + delta);
+}
+
+void writeSnapshot(BitWriter& writer, const NetSnapshot& snapshot, const NetSnapshot* baseline) noexcept {
+    writer.write(snapshot.tick, 32);
+    writer.write(baseline != nullptr ? baseline->tick : 0, 32);
+    writer.write(snapshot.lastInput, 32);
+    writer.write(static_cast<uint32_t>(snapshot.bodies.size()), 8);
+
+    uint32_t previousId = 0;
+    for (const auto& body : snapshot.bodies) {
+        writeDelta(writer, static_cast<int32_t>(body.id), static_cast<int32_t>(previousId));
+        previousId = body.id;
+
+        const NetBody* found = baseline != nullptr ? baseline->find(body.id) : nullptr;
+        NetBody base = found != nullptr ? *found : NetBody{body.id};
+        if (body == base) {
+            writer.write(0, 1);
+            continue;
+        }
+        writer.write(1, 1);
+        writeDelta(writer, body.x, base.x);
+        writeDelta(writer, body.y, base.y);
+        writeDelta(writer, body.vx, base.vx);
+        writeDelta(writer, body.vy, base.vy);
+        writer.writeBool(body.onGround);
+    }
+}
+
+void readSnapshotHeader(BitReader& reader, uint32_t& tick, uint32_t& baselineTick, uint32_t& lastInput) noexcept {
+    tick = reader.read(32);
+    baselineTick = reader.read(32);
+    lastInput = reader.read(32);
+}
+
+bool readSnapshotBodies(BitReader& reader, const NetSnapshot* baseline, std::vector<NetBody>& bodies) {
+    uint32_t count = reader.read(8);
+    if (count > NET_MAX_BODIES) {
+        return false;
+    }
+
+    bodies.clear();
+    uint32_t previousId = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        auto id = static_cast<uint32_t>(readDelta(reader, static_cast<int32_t>(previousId)));
+        if (i != 0 && id <= previousId) {
+            return false;
+        }
+        previousId = id;
+
+        const NetBody* found = baseline != nullptr ? baseline->find(id) : nullptr;
+        NetBody body = found != nullptr ? *found : NetBody{id};
+        if (reader.readBool()) {
+            body.x = readDelta(reader, body.x);
+            body.y = readDelta(reader, body.y);
+            body.vx = readDelta(reader, body.vx);
+            body.vy = readDelta(reader, body.vy);
+            body.onGround = reader.readBool();
+        }
+        bodies.push_back(body);
+    }
+    return !reader.overflowed();
+}
+
+void writeInputPacket(BitWriter& writer, const NetInputPacket& packet) noexcept {
+    writer.write(packet.ackedSnapshot, 32);
+    writer.write(packet.firstInput, 32);
+    writer.write(packet.count, 6);
+    for (uint32_t i = 0; i < packet.count; i++) {
+        writer.write(packet.inputs[i], NET_INPUT_BITS);
+    }
+}
+
+bool readInputPacket(BitReader& reader, NetInputPacket& packet) noexcept {
+    packet.ackedSnapshot = reader.read(32);
+    packet.firstInput = reader.read(32);
+    packet.count = reader.read(6);
+    if (packet.count > NET_MAX_INPUTS_PER_PACKET) {
+        return false;
+    }
+    for (uint32_t i = 0; i < packet.count; i++) {
+        packet.inputs[i] = static_cast<uint8_t>(reader.read(NET_INPUT_BITS));
+    }
+    return !reader.overflowed();
+}
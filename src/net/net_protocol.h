@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game/player.h"
+#include "util/bit_stream.h"
+
+// Wire format shared by NetServer and NetClient. Every packet starts with NET_PROTOCOL_MAGIC and a NetPacketType, the
+// rest is bit packed:
+//   CONNECT   client -> server, nothing else
+//   ACCEPT    server -> client: the client's body id
+//   INPUT     client -> server: newest snapshot tick received, then the oldest unacknowledged inputs with their
+//             sequence numbers, so that a lost packet is covered by the next one
+//   SNAPSHOT  server -> client: tick, the tick of the baseline it is delta coded against (0 for none), the client's
+//             last processed input and every body, see writeSnapshot()
+inline constexpr uint32_t NET_PROTOCOL_MAGIC = 0x504c; // "PL"
+inline constexpr size_t NET_MAX_PACKET_SIZE = 1200;
+
+enum NetPacketType : uint8_t {
+    NET_PACKET_CONNECT = 1,
+    NET_PACKET_ACCEPT = 2,
+    NET_PACKET_INPUT = 3,
+    NET_PACKET_SNAPSHOT = 4,
+};
+
+enum NetInputBits : uint8_t {
+    NET_INPUT_LEFT = 1 << 0,
+    NET_INPUT_RIGHT = 1 << 1,
+    NET_INPUT_JUMP = 1 << 2,
+};
+
+inline constexpr uint32_t NET_INPUT_BITS = 3;
+inline constexpr uint32_t NET_MAX_INPUTS_PER_PACKET = 32;
+// a full snapshot of this many bodies still fits in one packet
+inline constexpr uint32_t NET_MAX_BODIES = 48;
+
+// Positions travel in 1/64 units and velocities in 1/4096 units per millisecond. Both ends snap the simulated player
+// to these steps after every tick, so a client replaying its inputs from a snapshot arrives exactly where the server is.
+inline constexpr float NET_POSITION_SCALE = 64.0f;
+inline constexpr float NET_VELOCITY_SCALE = 4096.0f;
+
+struct NetBody {
+    uint32_t id = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t vx = 0;
+    int32_t vy = 0;
+    bool onGround = false;
+
+    bool operator==(const NetBody& rhs) const noexcept {
+        return id == rhs.id && x == rhs.x && y == rhs.y && vx == rhs.vx && vy == rhs.vy && onGround == rhs.onGround;
+    }
+
+    bool operator!=(const NetBody& rhs) const noexcept {
+        return !(*this == rhs);
+    }
+};
+
+NetBody quantizeBody(uint32_t id, const Player& player) noexcept;
+
+void applyBody(const NetBody& body, Player& player) noexcept;
+
+// Rounds the player's state to what a NetBody can carry
+void snapPlayer(Player& player) noexcept;
+
+struct NetSnapshot {
+    uint32_t tick = 0;
+    uint32_t lastInput = 0;
+    // ascending by id
+    std::vector<NetBody> bodies{};
+
+    const NetBody* find(uint32_t id) const noexcept;
+};
+
+void writePacketHeader(BitWriter& writer, NetPacketType type) noexcept;
+
+// Returns 0 when the packet is not ours
+NetPacketType readPacketHeader(BitReader& reader) noexcept;
+
+// Bodies that did not change since the baseline cost one bit, changed fields are sent as variable length differences
+// and bodies missing from the baseline are coded against zero. Without a baseline the snapshot is complete.
+void writeSnapshot(BitWriter& writer, const NetSnapshot& snapshot, const NetSnapshot* baseline) noexcept;
+
+// Reads up to the baseline tick, the caller then looks the baseline up and calls readSnapshotBodies
+void readSnapshotHeader(BitReader& reader, uint32_t& tick, uint32_t& baselineTick, uint32_t& lastInput) noexcept;
+
+// Returns false for a malformed snapshot
+bool readSnapshotBodies(BitReader& reader, const NetSnapshot* baseline, std::vector<NetBody>& bodies);
+
+struct NetInputPacket {
+    uint32_t ackedSnapshot = 0;
+    uint32_t firstInput = 0;
+    uint32_t count = 0;
+    uint8_t inputs[NET_MAX_INPUTS_PER_PACKET]{};
+};
+
+void writeInputPacket(BitWriter& writer, const NetInputPacket& packet) noexcept;
+
+bool readInputPacket(BitReader& reader, NetInputPacket& packet) noexcept;
@@ -0,0 +1,134 @@
+#include "net_server.h"
+
+#include <algorithm>
+
+#include "util/profiler.h"
+
+NetServer::NetServer(std::shared_ptr<const Level> level, NetLink link, uint32_t tickRate)
+    : level(std::move(level)),
+      link(std::move(link)),
+      periodNs(NSECS_PER_SEC / std::max<uint32_t>(tickRate, 1)),
+      tickDelta(1000.0f / static_cast<float>(std::max<uint32_t>(tickRate, 1))) {} // game time is in milliseconds
+
+void NetServer::update(uint64_t nowNs) {
+    receive(nowNs);
+    if (nextTickNs == 0) {
+        nextTickNs = nowNs;
+    }
+    while (nowNs >= nextTickNs) {
+        step(nowNs);
+        nextTickNs += periodNs;
+    }
+    link.flush(nowNs);
+}
+
+void NetServer::receive(uint64_t nowNs) {
+    uint8_t buffer[NET_MAX_PACKET_SIZE];
+    size_t size;
+    NetAddress from;
+    while (link.receive(buffer, sizeof(buffer), size, from)) {
+        BitReader reader(buffer, size);
+        NetPacketType type = readPacketHeader(reader);
+        Client* client = findClient(from);
+
+        if (type == NET_PACKET_CONNECT) {
+            if (client == nullptr) {
+                if (clients.size() == NET_MAX_BODIES) {
+                    continue;
+                }
+                clients.push_back(std::make_unique<Client>(from, nextClientId++, level));
+                client = clients.back().get();
+                snapPlayer(client->game.world.player());
+            }
+            client->lastHeardNs = nowNs;
+            // repeated connects are answered again, the first answer may have been lost
+            uint8_t reply[16];
+            BitWriter writer(reply, sizeof(reply));
+            writePacketHeader(writer, NET_PACKET_ACCEPT);
+            writer.write(client->id, 32);
+            link.send(nowNs, from, reply, writer.size());
+        } else if (type == NET_PACKET_INPUT && client != nullptr) {
+            NetInputPacket packet;
+            if (!readInputPacket(reader, packet)) {
+                continue;
+            }
+            client->lastHeardNs = nowNs;
+            // only a snapshot still in the history can be a baseline
+            if (packet.ackedSnapshot > client->ackedSnapshot && packet.ackedSnapshot + SNAPSHOT_HISTORY > tick) {
+                client->ackedSnapshot = packet.ackedSnapshot;
+            }
+            for (uint32_t i = 0; i < packet.count; i++) {
+                uint32_t seq = packet.firstInput + i;
+                if (seq >= client->nextInput && seq - client->nextInput < INPUT_BUFFER) {
+                    client->inputs[seq % INPUT_BUFFER] = {seq, packet.inputs[i]};
+                }
+            }
+        }
+    }
+}
+
+void NetServer::step(uint64_t nowNs) {
+    PROFILE_ZONE("NetServer::step");
+
+    tick++;
+    clients.erase(std::remove_if(clients.begin(), clients.end(), [&](const auto& client) { return nowNs - client->lastHeardNs > CLIENT_TIMEOUT_NS; }),
+                  clients.end());
+
+    // a client's game only moves with its inputs: the same ones, in the same order, as the client predicted with
+    snapshot.bodies.clear();
+    for (auto& client : clients) {
+        for (uint32_t i = 0; i < MAX_INPUTS_PER_TICK; i++) {
+            const BufferedInput& input = client->inputs[client->nextInput % INPUT_BUFFER];
+            if (input.seq != client->nextInput) {
+                break;
+            }
+            Game& game = client->game;
+            if ((input.bits & NET_INPUT_JUMP) != 0) {
+                game.playerJump();
+            }
+            game.moveLeft = (input.bits & NET_INPUT_LEFT) != 0;
+            game.moveRight = (input.bits & NET_INPUT_RIGHT) != 0;
+            game.process(tickDelta);
+            snapPlayer(game.world.player());
+            client->nextInput++;
+            client->stats.inputsProcessed++;
+        }
+        snapshot.bodies.push_back(quantizeBody(client->id, client->game.world.player()));
+    }
+    // ids grow with every connect, so the bodies are already in id order
+
+    snapshot.tick = tick;
+    for (auto& client : clients) {
+        uint64_t cpuStart = threadCpuNsecs();
+
+        NetSnapshot& sent = client->history[tick % SNAPSHOT_HISTORY];
+        sent.tick = tick;
+        sent.lastInput = client->nextInput - 1;
+        sent.bodies = snapshot.bodies;
+
+        const NetSnapshot* baseline = nullptr;
+        if (client->ackedSnapshot != 0 && client->ackedSnapshot + SNAPSHOT_HISTORY > tick) {
+            baseline = &client->history[client->ackedSnapshot % SNAPSHOT_HISTORY];
+        }
+
+        uint8_t packet[NET_MAX_PACKET_SIZE];
+        BitWriter writer(packet, sizeof(packet));
+        writePacketHeader(writer, NET_PACKET_SNAPSHOT);
+        writeSnapshot(writer, sent, baseline);
+
+        client->stats.snapshotCpuNs += threadCpuNsecs() - cpuStart;
+        client->stats.snapshots++;
+        client->stats.fullSnapshots += baseline == nullptr ? 1 : 0;
+        client->stats.snapshotBytes += writer.size() + NetLink::IP_UDP_HEADER_SIZE;
+        link.send(nowNs, client->address, packet, writer.size());
+    }
+}
+
+NetServer::Client* NetServer::findClient(const NetAddress& address) noexcept {
+    for (auto& client : clients) {
+        if (client->address == address) {
+            return client.get();
+        }
+    }
+    return nullptr;
+}
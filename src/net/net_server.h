@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "game/game.h"
+#include "game/level.h"
+#include "net_link.h"
+#include "net_protocol.h"
+#include "platform/time.h"
+
+struct NetServerClientStats {
+    uint64_t snapshots = 0;
+    // snapshots sent without a baseline, because the client had not acknowledged one that is still remembered
+    uint64_t fullSnapshots = 0;
+    uint64_t snapshotBytes = 0;
+    // thread CPU time spent building and encoding this client's snapshots
+    uint64_t snapshotCpuNs = 0;
+    uint64_t inputsProcessed = 0;
+};
+
+// Authoritative side. Every client plays its own Game on the shared level; the server only advances it with the
+// inputs the client sent, in order, so a client predicting with the same inputs never disagrees with it. Snapshots
+// carry every client's body, delta coded against the newest snapshot the receiving client acknowledged.
+class NetServer {
+public:
+    // snapshots remembered per client as possible baselines, a client acknowledging an older one gets a full snapshot
+    static inline constexpr uint32_t SNAPSHOT_HISTORY = 32;
+    // inputs buffered ahead of the next one to process
+    static inline constexpr uint32_t INPUT_BUFFER = 64;
+    // a client that fell behind catches up by processing more than one input per tick
+    static inline constexpr uint32_t MAX_INPUTS_PER_TICK = 2;
+    static inline constexpr uint64_t CLIENT_TIMEOUT_NS = 5 * NSECS_PER_SEC;
+
+private:
+    struct BufferedInput {
+        uint32_t seq = 0;
+        uint8_t bits = 0;
+    };
+
+    struct Client {
+        NetAddress address;
+        uint32_t id;
+        Game game;
+        uint32_t nextInput = 1;
+        BufferedInput inputs[INPUT_BUFFER]{};
+        uint32_t ackedSnapshot = 0;
+        // indexed by tick % SNAPSHOT_HISTORY
+        NetSnapshot history[SNAPSHOT_HISTORY]{};
+        uint64_t lastHeardNs = 0;
+        NetServerClientStats stats{};
+
+        Client(NetAddress address, uint32_t id, std::shared_ptr<const Level> level) : address(address), id(id), game(std::move(level)) {}
+    };
+
+    std::shared_ptr<const Level> level;
+    NetLink link;
+    uint64_t periodNs;
+    float tickDelta;
+    uint64_t nextTickNs = 0;
+    uint32_t tick = 0;
+    uint32_t nextClientId = 1;
+    std::vector<std::unique_ptr<Client>> clients{};
+    NetSnapshot snapshot{};
+
+public:
+    NetServer(std::shared_ptr<const Level> level, NetLink link, uint32_t tickRate);
+
+    NetAddress localAddress() const {
+        return link.localAddress();
+    }
+
+    NetLink& netLink() noexcept {
+        return link;
+    }
+
+    // Receives, runs the ticks that are due and sends their snapshots. Call it often, at least once per tick.
+    void update(uint64_t nowNs);
+
+    uint32_t clientCount() const noexcept {
+        return static_cast<uint32_t>(clients.size());
+    }
+
+    uint32_t clientId(uint32_t client) const noexcept {
+        return clients[client]->id;
+    }
+
+    const NetServerClientStats& clientStats(uint32_t client) const noexcept {
+        return clients[client]->stats;
+    }
+
+    const Player& clientPlayer(uint32_t client) const noexcept {
+        return clients[client]->game.world.player();
+    }
+
+private:
+    void receive(uint64_t nowNs);
+
+    void step(uint64_t nowNs);
+
+    Client* findClient(const NetAddress& address) noexcept;
+};
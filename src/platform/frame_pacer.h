@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "thread.h"
+#include "time.h"
+
+struct FramePacerStats {
+    uint64_t frames = 0;
+    uint64_t missedDeadlines = 0;
+
+    // distance between the deadline and the actual wake up time, over the frames that made their deadline. A missed
+    // one has no wake up to measure and would only pull the mean down, its lateness is below.
+    uint64_t lastJitterNs = 0;
+    uint64_t maxJitterNs = 0;
+    double meanJitterNs = 0.0;
+
+    // how far past the deadline the frame work itself finished
+    uint64_t maxLatenessNs = 0;
+};
+
+// Paces a loop to a fixed frame time: sleeps the bulk of the remaining time, then spins the last
+// stretch so the wake up does not depend on the OS timer granularity.
+class FramePacer {
+public:
+    static inline constexpr uint64_t DEFAULT_SPIN_THRESHOLD_NS = 2 * NSECS_PER_MSEC;
+
+private:
+    uint64_t targetFrameNs;
+    uint64_t spinThresholdNs;
+    uint64_t nextDeadline = 0;
+    FramePacerStats _stats{};
+
+public:
+    explicit FramePacer(uint64_t targetFrameNs, uint64_t spinThresholdNs = DEFAULT_SPIN_THRESHOLD_NS) noexcept
+        : targetFrameNs(targetFrameNs), spinThresholdNs(spinThresholdNs) {}
+
+    static FramePacer fromRate(uint32_t framesPerSecond) noexcept {
+        return FramePacer(NSECS_PER_SEC / std::max<uint32_t>(framesPerSecond, 1));
+    }
+
+    uint64_t getTargetFrameNs() const noexcept {
+        return targetFrameNs;
+    }
+
+    void setTargetFrameNs(uint64_t nsecs) noexcept {
+        targetFrameNs = nsecs;
+        nextDeadline = 0;
+    }
+
+    const FramePacerStats& stats() const noexcept {
+        return _stats;
+    }
+
+    void resetStats() noexcept {
+        _stats = {};
+    }
+
+    // Blocks until the end of the current frame, returns the wake up time.
+    uint64_t wait() noexcept {
+        uint64_t now = monotonicNsecs();
+        if (nextDeadline == 0) {
+            nextDeadline = now + targetFrameNs;
+        }
+
+        if (now > nextDeadline) {
+            // the frame overran: do not try to catch up with a burst of short frames, start over from now
+            _stats.frames++;
+            _stats.missedDeadlines++;
+            _stats.maxLatenessNs = std::max(_stats.maxLatenessNs, now - nextDeadline);
+            nextDeadline = now + targetFrameNs;
+            return now;
+        }
+
+        if (nextDeadline - now > spinThresholdNs) {
+            threadSleepNsecs(nextDeadline - now - spinThresholdNs);
+        }
+
+        now = monotonicNsecs();
+        while (now < nextDeadline) {
+            threadYield();
+            now = monotonicNsecs();
+        }
+
+        recordFrame(now - nextDeadline);
+        nextDeadline += targetFrameNs;
+        return now;
+    }
+
+private:
+    void recordFrame(uint64_t jitterNs) noexcept {
+        _stats.frames++;
+        _stats.lastJitterNs = jitterNs;
+        _stats.maxJitterNs = std::max(_stats.maxJitterNs, jitterNs);
+        auto onTime = static_cast<double>(_stats.frames - _stats.missedDeadlines);
+        _stats.meanJitterNs += (static_cast<double>(jitterNs) - _stats.meanJitterNs) / onTime;
+    }
+};
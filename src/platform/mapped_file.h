@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "os_type.h"
+
+#if defined(__COMPILES_WINDOWS__)
+#include "windows/win_api.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+
+#if defined(__COMPILES_WINDOWS__)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    MappedFile() noexcept = default;
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            _data = other._data;
+            _size = other._size;
+            other._data = nullptr;
+            other._size = 0;
+#if defined(__COMPILES_WINDOWS__)
+            file = other.file;
+            mapping = other.mapping;
+            other.file = INVALID_HANDLE_VALUE;
+            other.mapping = nullptr;
+#endif
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+#if defined(__COMPILES_WINDOWS__)
+    static MappedFile open(const std::string& path) {
+        MappedFile self;
+        self.file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (self.file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("failed to open file " + path);
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(self.file, &fileSize)) {
+            throw std::runtime_error("failed to get size of " + path);
+        }
+        self._size = static_cast<size_t>(fileSize.QuadPart);
+        if (self._size == 0) {
+            return self;
+        }
+
+        self.mapping = CreateFileMappingA(self.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (self.mapping == nullptr) {
+            throw std::runtime_error("failed to map file " + path);
+        }
+        self._data = static_cast<const uint8_t*>(MapViewOfFile(self.mapping, FILE_MAP_READ, 0, 0, 0));
+        if (self._data == nullptr) {
+            throw std::runtime_error("failed to map file " + path);
+        }
+        return self;
+    }
+
+    void close() noexcept {
+        if (_data != nullptr) {
+            UnmapViewOfFile(_data);
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        _data = nullptr;
+        _size = 0;
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+    }
+#else
+    static MappedFile open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("failed to open file " + path);
+        }
+
+        struct stat st {};
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("failed to get size of " + path);
+        }
+
+        MappedFile self;
+        self._size = static_cast<size_t>(st.st_size);
+        if (self._size != 0) {
+            void* data = mmap(nullptr, self._size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("failed to map file " + path);
+            }
+            self._data = static_cast<const uint8_t*>(data);
+        }
+
+        // the mapping keeps its own reference to the file
+        ::close(fd);
+        return self;
+    }
+
+    void close() noexcept {
+        if (_data != nullptr) {
+            munmap(const_cast<uint8_t*>(_data), _size);
+        }
+        _data = nullptr;
+        _size = 0;
+    }
+#endif
+
+    const uint8_t* data() const noexcept {
+        return _data;
+    }
+
+    size_t size() const noexcept {
+        return _size;
+    }
+};
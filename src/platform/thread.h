@@ -1,19 +1,79 @@
 #pragma once
 
+#include <cstdint>
+
 #include "os_type.h"
 
 #if defined(__COMPILES_LINUX__)
 #include <sched.h>
+#include <time.h>
 
 inline void threadYield() noexcept {
     sched_yield();
 }
+
+inline void threadSleepNsecs(uint64_t nsecs) noexcept {
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(nsecs / 1000000000);
+    ts.tv_nsec = static_cast<long>(nsecs % 1000000000);
+    clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, nullptr);
+}
 #elif defined(__COMPILES_WINDOWS__)
 #include "windows/win_api.h"
 
 inline void threadYield() noexcept {
     SwitchToThread();
 }
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// Sleep() rounds up to the system timer period, 15.6 ms unless something raised it, which overshoots any frame
+// deadline. A high resolution waitable timer wakes up within about half a millisecond. Windows before 10 1803 refuses
+// the flag and gets a plain timer, as coarse as Sleep().
+struct ThreadSleepTimer {
+    HANDLE handle;
+
+    ThreadSleepTimer() noexcept {
+        handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (handle == nullptr) {
+            handle = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        }
+    }
+
+    ThreadSleepTimer(const ThreadSleepTimer&) = delete;
+    ThreadSleepTimer& operator=(const ThreadSleepTimer&) = delete;
+
+    ~ThreadSleepTimer() {
+        if (handle != nullptr) {
+            CloseHandle(handle);
+        }
+    }
+};
+
+// anything below the timer's 100 ns unit is left to the caller to spin
+inline void threadSleepNsecs(uint64_t nsecs) noexcept {
+    thread_local ThreadSleepTimer timer;
+    if (nsecs < 100) {
+        return;
+    }
+    // negative due times are relative
+    LARGE_INTEGER due;
+    due.QuadPart = -static_cast<LONGLONG>(nsecs / 100);
+    if (timer.handle != nullptr && SetWaitableTimer(timer.handle, &due, 0, nullptr, nullptr, FALSE)) {
+        WaitForSingleObject(timer.handle, INFINITE);
+    } else {
+        Sleep(static_cast<DWORD>(nsecs / 1000000));
+    }
+}
 #else
+#include <chrono>
+#include <thread>
+
 inline void threadYield() noexcept {}
+
+inline void threadSleepNsecs(uint64_t nsecs) noexcept {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(nsecs));
+}
 #endif
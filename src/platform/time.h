@@ -3,9 +3,67 @@
 #include <chrono>
 #include <cstdint>
 
+#include "os_type.h"
+
+#if defined(__COMPILES_LINUX__)
+#include <time.h>
+#elif defined(__COMPILES_WINDOWS__)
+#include "windows/win_api.h"
+#endif
+
+inline constexpr uint64_t NSECS_PER_USEC = 1000;
+inline constexpr uint64_t NSECS_PER_MSEC = 1000 * NSECS_PER_USEC;
+inline constexpr uint64_t NSECS_PER_SEC = 1000 * NSECS_PER_MSEC;
+
 // Returns microseconds since unix epoch
+// Wall clock, may jump on time adjustments: use monotonicNsecs() to measure intervals
 inline uint64_t unixUsecs() {
     auto clock = std::chrono::system_clock::now();
     auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(clock.time_since_epoch()).count();
     return static_cast<uint64_t>(usecs);
 }
+
+// Returns nanoseconds since an unspecified point, never goes backwards
+#if defined(__COMPILES_LINUX__)
+inline uint64_t monotonicNsecs() noexcept {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * NSECS_PER_SEC + static_cast<uint64_t>(ts.tv_nsec);
+}
+#elif defined(__COMPILES_WINDOWS__)
+inline uint64_t monotonicNsecs() noexcept {
+    static const uint64_t frequency = [] {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return static_cast<uint64_t>(value.QuadPart);
+    }();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    auto ticks = static_cast<uint64_t>(counter.QuadPart);
+    return ticks / frequency * NSECS_PER_SEC + ticks % frequency * NSECS_PER_SEC / frequency;
+}
+#else
+inline uint64_t monotonicNsecs() noexcept {
+    auto clock = std::chrono::steady_clock::now();
+    auto nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(clock.time_since_epoch()).count();
+    return static_cast<uint64_t>(nsecs);
+}
+#endif
+
+// Returns CPU time consumed by the calling thread. Falls back to monotonicNsecs() where there is no precise per thread clock:
+// Windows only counts thread time in scheduler quanta.
+#if defined(__COMPILES_LINUX__)
+inline uint64_t threadCpuNsecs() noexcept {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * NSECS_PER_SEC + static_cast<uint64_t>(ts.tv_nsec);
+}
+#else
+inline uint64_t threadCpuNsecs() noexcept {
+    return monotonicNsecs();
+}
+#endif
+
+inline float nsecsToMillis(uint64_t nsecs) noexcept {
+    return static_cast<float>(static_cast<double>(nsecs) / static_cast<double>(NSECS_PER_MSEC));
+}
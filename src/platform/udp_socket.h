@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "os_type.h"
+
+#if defined(__COMPILES_WINDOWS__)
+// before anything pulls in Windows.h, which would bring the old winsock.h along
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// IPv4 address and port, both in host byte order
+struct NetAddress {
+    uint32_t ip = 0;
+    uint16_t port = 0;
+
+    static NetAddress loopback(uint16_t port) noexcept {
+        return {0x7f000001, port};
+    }
+
+    bool operator==(const NetAddress& rhs) const noexcept {
+        return ip == rhs.ip && port == rhs.port;
+    }
+
+    bool operator!=(const NetAddress& rhs) const noexcept {
+        return !(*this == rhs);
+    }
+};
+
+// Non-blocking IPv4 UDP socket
+class UdpSocket {
+#if defined(__COMPILES_WINDOWS__)
+    using Handle = SOCKET;
+    static inline const Handle INVALID = INVALID_SOCKET;
+#else
+    using Handle = int;
+    static inline constexpr Handle INVALID = -1;
+#endif
+
+    Handle handle = INVALID;
+
+public:
+    UdpSocket() noexcept = default;
+
+    UdpSocket(const UdpSocket&) = delete;
+
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    UdpSocket(UdpSocket&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    UdpSocket& operator=(UdpSocket&& other) noexcept {
+        if (this != &other) {
+            close();
+            handle = other.handle;
+            other.handle = INVALID;
+        }
+        return *this;
+    }
+
+    ~UdpSocket() {
+        close();
+    }
+
+    // Port 0 picks a free one, see localAddress()
+    static UdpSocket bind(NetAddress address) {
+        startup();
+
+        UdpSocket self;
+        self.handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (self.handle == INVALID) {
+            throw std::runtime_error("failed to create socket");
+        }
+        sockaddr_in addr = toSockaddr(address);
+        if (::bind(self.handle, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            throw std::runtime_error("failed to bind socket to port " + std::to_string(address.port));
+        }
+#if defined(__COMPILES_WINDOWS__)
+        u_long nonBlocking = 1;
+        if (ioctlsocket(self.handle, FIONBIO, &nonBlocking) != 0) {
+#else
+        if (fcntl(self.handle, F_SETFL, fcntl(self.handle, F_GETFL, 0) | O_NONBLOCK) != 0) {
+#endif
+            throw std::runtime_error("failed to make socket non-blocking");
+        }
+        return self;
+    }
+
+    NetAddress localAddress() const {
+        sockaddr_in addr{};
+#if defined(__COMPILES_WINDOWS__)
+        int length = sizeof(addr);
+#else
+        socklen_t length = sizeof(addr);
+#endif
+        if (getsockname(handle, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+            throw std::runtime_error("failed to get socket address");
+        }
+        return fromSockaddr(addr);
+    }
+
+    // Returns false when the datagram was not sent, which UDP allows anyway
+    bool send(const NetAddress& to, const uint8_t* data, size_t size) noexcept {
+        sockaddr_in addr = toSockaddr(to);
+#if defined(__COMPILES_WINDOWS__)
+        int sent = sendto(handle, reinterpret_cast<const char*>(data), static_cast<int>(size), 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+#else
+        ssize_t sent = sendto(handle, data, size, 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+#endif
+        return sent == static_cast<decltype(sent)>(size);
+    }
+
+    // Returns false when no datagram is pending. Datagrams larger than capacity are truncated.
+    bool receive(uint8_t* buffer, size_t capacity, size_t& size, NetAddress& from) noexcept {
+        sockaddr_in addr{};
+#if defined(__COMPILES_WINDOWS__)
+        int length = sizeof(addr);
+        int received = recvfrom(handle, reinterpret_cast<char*>(buffer), static_cast<int>(capacity), 0, reinterpret_cast<sockaddr*>(&addr), &length);
+#else
+        socklen_t length = sizeof(addr);
+        ssize_t received = recvfrom(handle, buffer, capacity, 0, reinterpret_cast<sockaddr*>(&addr), &length);
+#endif
+        if (received < 0) {
+            return false;
+        }
+        size = static_cast<size_t>(received);
+        from = fromSockaddr(addr);
+        return true;
+    }
+
+    void close() noexcept {
+        if (handle != INVALID) {
+#if defined(__COMPILES_WINDOWS__)
+            closesocket(handle);
+#else
+            ::close(handle);
+#endif
+        }
+        handle = INVALID;
+    }
+
+private:
+    static void startup() {
+#if defined(__COMPILES_WINDOWS__)
+        // never cleaned up, sockets are used until exit
+        static const bool started = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if (!started) {
+            throw std::runtime_error("failed to initialize winsock");
+        }
+#endif
+    }
+
+    static sockaddr_in toSockaddr(const NetAddress& address) noexcept {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(address.ip);
+        addr.sin_port = htons(address.port);
+        return addr;
+    }
+
+    static NetAddress fromSockaddr(const sockaddr_in& addr) noexcept {
+        return {ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port)};
+    }
+};
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "game/level.h"
+#include "platform/thread.h"
+#include "platform/time.h"
+#include "session_host.h"
+#include "util/profiler.h"
+
+// usage: platformer_server [--sessions N] [--workers N] [--rate HZ] [--seconds S] [level file]
+//
+// Hosts N sessions of one level, all sharing the same mapped level data. There is no networking yet: every session is
+// driven by a scripted bot so that the tick cost is representative.
+
+static constexpr uint64_t STATS_INTERVAL_NS = 5 * NSECS_PER_SEC;
+static constexpr uint64_t BOT_INTERVAL_NS = 100 * NSECS_PER_MSEC;
+
+static std::atomic<bool> stopRequested{false};
+
+static void requestStop(int) {
+    stopRequested.store(true, std::memory_order_relaxed);
+}
+
+struct ServerOptions {
+    uint32_t sessions = 1000;
+    uint32_t workers = std::max(std::thread::hardware_concurrency(), 1u);
+    uint32_t tickRate = 60;
+    uint64_t seconds = 0;
+    std::string levelPath{};
+};
+
+static ServerOptions parseOptions(int argc, char** argv) {
+    ServerOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> uint64_t {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return std::strtoull(argv[++i], nullptr, 10);
+        };
+        if (strcmp(argv[i], "--sessions") == 0) {
+            options.sessions = static_cast<uint32_t>(value());
+        } else if (strcmp(argv[i], "--workers") == 0) {
+            options.workers = static_cast<uint32_t>(value());
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.tickRate = static_cast<uint32_t>(value());
+        } else if (strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = value();
+        } else if (argv[i][0] == '-') {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        } else {
+            options.levelPath = argv[i];
+        }
+    }
+    return options;
+}
+
+// walks back and forth and jumps now and then, different per session so that sessions do not run in lockstep
+static uint32_t botInput(uint32_t sessionId, uint64_t step) {
+    uint64_t phase = (step + sessionId * 7) % 40;
+    uint32_t bits = phase < 20 ? SESSION_INPUT_RIGHT : SESSION_INPUT_LEFT;
+    if ((step + sessionId) % 13 == 0) {
+        bits |= SESSION_INPUT_JUMP;
+    }
+    return bits;
+}
+
+static void printStats(SessionHost& host, uint64_t elapsedNs) {
+    auto sessions = host.sessions();
+
+    uint64_t ticks = 0;
+    uint64_t cpuNs = 0;
+    uint64_t dropped = 0;
+    uint64_t worstTickNs = 0;
+    uint32_t worstSession = 0;
+    for (const auto& session : sessions) {
+        const auto& stats = session->stats();
+        ticks += stats.ticks.load(std::memory_order_relaxed);
+        cpuNs += stats.cpuNs.load(std::memory_order_relaxed);
+        dropped += stats.droppedTicks.load(std::memory_order_relaxed);
+        uint64_t maxTickNs = stats.maxTickCpuNs.load(std::memory_order_relaxed);
+        if (maxTickNs > worstTickNs) {
+            worstTickNs = maxTickNs;
+            worstSession = session->id();
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "sessions " << sessions.size() << ", ticks " << ticks << ", dropped " << dropped //
+              << ", avg tick " << (ticks != 0 ? static_cast<double>(cpuNs) / ticks / NSECS_PER_USEC : 0.0) << " us cpu"
+              << ", worst tick " << static_cast<double>(worstTickNs) / NSECS_PER_USEC << " us (session " << worstSession << ")\n";
+    for (uint32_t i = 0; i < host.workerCount(); i++) {
+        const auto& stats = host.workerStats(i);
+        std::cout << "\tworker " << i << ": sessions " << stats.sessions.load(std::memory_order_relaxed) //
+                  << ", ticks " << stats.ticks.load(std::memory_order_relaxed) << ", busy "
+                  << 100.0 * static_cast<double>(stats.busyCpuNs.load(std::memory_order_relaxed)) / static_cast<double>(elapsedNs) << "%\n";
+    }
+    std::cout << std::defaultfloat << std::flush;
+}
+
+int main(int argc, char** argv) {
+    try {
+        setupProfiler();
+        ServerOptions options = parseOptions(argc, argv);
+
+        std::shared_ptr<const Level> level = options.levelPath.empty() ? Level::builtIn() : Level::map(options.levelPath);
+        std::cout << "level: " << (options.levelPath.empty() ? "built-in" : options.levelPath) << ", " << level->geometry().solids.count
+                  << " solids" << std::endl;
+
+        SessionHost host(options.workers);
+        for (uint32_t i = 0; i < options.sessions; i++) {
+            host.addSession(level, options.tickRate);
+        }
+        std::cout << "hosting " << options.sessions << " sessions at " << options.tickRate << " Hz on " << host.workerCount() << " workers, "
+                  << sizeof(Session) << " bytes per session plus the shared level" << std::endl;
+
+        std::signal(SIGINT, requestStop);
+        std::signal(SIGTERM, requestStop);
+
+        host.start();
+
+        uint64_t startNs = monotonicNsecs();
+        uint64_t nextStatsNs = startNs + STATS_INTERVAL_NS;
+        uint64_t step = 0;
+        while (!stopRequested.load(std::memory_order_relaxed)) {
+            uint64_t now = monotonicNsecs();
+            if (options.seconds != 0 && now - startNs >= options.seconds * NSECS_PER_SEC) {
+                break;
+            }
+
+            for (const auto& session : host.sessions()) {
+                session->setInput(botInput(session->id(), step));
+            }
+            step++;
+
+            if (now >= nextStatsNs) {
+                printStats(host, now - startNs);
+                nextStatsNs += STATS_INTERVAL_NS;
+            }
+            threadSleepNsecs(BOT_INTERVAL_NS);
+        }
+
+        host.stop();
+        printStats(host, monotonicNsecs() - startNs);
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
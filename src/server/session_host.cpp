@@ -0,0 +1,167 @@
+#include "session_host.h"
+
+#include <algorithm>
+
+#include "platform/thread.h"
+#include "util/profiler.h"
+
+Session::Session(uint32_t id, std::shared_ptr<const Level> level, uint32_t tickRate)
+    : _id(id),
+      game(std::move(level)),
+      _tickRate(std::max<uint32_t>(tickRate, 1)),
+      periodNs(NSECS_PER_SEC / _tickRate),
+      tickDelta(1000.0f / static_cast<float>(_tickRate)) {} // game time is in milliseconds
+
+void Session::tick() {
+    uint32_t bits = input.load(std::memory_order_relaxed);
+    if ((bits & SESSION_INPUT_JUMP) != 0) {
+        input.fetch_and(~static_cast<uint32_t>(SESSION_INPUT_JUMP), std::memory_order_relaxed);
+        game.playerJump();
+    }
+    game.moveLeft = (bits & SESSION_INPUT_LEFT) != 0;
+    game.moveRight = (bits & SESSION_INPUT_RIGHT) != 0;
+
+    game.process(tickDelta);
+}
+
+SessionHost::SessionHost(uint32_t workerCount) {
+    for (uint32_t i = 0; i < std::max<uint32_t>(workerCount, 1); i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+}
+
+SessionHost::~SessionHost() {
+    stop();
+}
+
+void SessionHost::start() {
+    if (running.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    for (auto& worker : workers) {
+        Worker* w = worker.get();
+        worker->thread = std::thread([this, w] { workerLoop(*w); });
+    }
+}
+
+void SessionHost::stop() {
+    if (!running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+std::shared_ptr<Session> SessionHost::addSession(std::shared_ptr<const Level> level, uint32_t tickRate) {
+    std::shared_ptr<Session> session;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        session = std::make_shared<Session>(nextSessionId++, std::move(level), tickRate);
+        _sessions.push_back(session);
+    }
+
+    auto& worker = **std::min_element(workers.begin(), workers.end(), [](const auto& a, const auto& b) {
+        return a->stats.sessions.load(std::memory_order_relaxed) < b->stats.sessions.load(std::memory_order_relaxed);
+    });
+    worker.stats.sessions.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(worker.inboxMutex);
+        worker.inbox.push_back(session);
+    }
+    return session;
+}
+
+void SessionHost::removeSession(const std::shared_ptr<Session>& session) {
+    session->closed.store(true, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    auto it = std::find(_sessions.begin(), _sessions.end(), session);
+    if (it != _sessions.end()) {
+        _sessions.erase(it);
+    }
+}
+
+std::vector<std::shared_ptr<Session>> SessionHost::sessions() {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    return _sessions;
+}
+
+void SessionHost::workerLoop(Worker& worker) {
+    PROFILE_THREAD_NAME("session worker");
+
+    auto& schedule = worker.schedule;
+    // earliest deadline on top
+    auto laterTick = [](const std::shared_ptr<Session>& a, const std::shared_ptr<Session>& b) { return a->nextTickNs > b->nextTickNs; };
+    std::vector<std::shared_ptr<Session>> added;
+
+    // time stood still while the host was stopped, do not count it as a backlog
+    uint64_t startNs = monotonicNsecs();
+    for (auto& session : schedule) {
+        session->nextTickNs = startNs + session->periodNs;
+    }
+    std::make_heap(schedule.begin(), schedule.end(), laterTick);
+
+    while (running.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(worker.inboxMutex);
+            added.swap(worker.inbox);
+        }
+        if (!added.empty()) {
+            uint64_t now = monotonicNsecs();
+            for (auto& session : added) {
+                session->nextTickNs = now + session->periodNs;
+                schedule.push_back(std::move(session));
+                std::push_heap(schedule.begin(), schedule.end(), laterTick);
+            }
+            added.clear();
+        }
+
+        if (schedule.empty()) {
+            threadSleepNsecs(INBOX_POLL_NS);
+            continue;
+        }
+
+        uint64_t now = monotonicNsecs();
+        uint64_t deadline = schedule.front()->nextTickNs;
+        if (deadline > now) {
+            threadSleepNsecs(std::min(deadline - now, INBOX_POLL_NS));
+            continue;
+        }
+
+        std::pop_heap(schedule.begin(), schedule.end(), laterTick);
+        auto& session = schedule.back();
+        if (session->closed.load(std::memory_order_relaxed)) {
+            schedule.pop_back();
+            worker.stats.sessions.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // a session that fell behind catches up with a bounded burst, the rest of the backlog is dropped
+        uint64_t due = 1 + (now - deadline) / session->periodNs;
+        uint64_t ticks = std::min<uint64_t>(due, MAX_CATCH_UP_TICKS);
+
+        uint64_t cpuStart = threadCpuNsecs();
+        {
+            PROFILE_ZONE("session tick");
+            for (uint64_t i = 0; i < ticks; i++) {
+                session->tick();
+            }
+        }
+        uint64_t cpuNs = threadCpuNsecs() - cpuStart;
+
+        auto& stats = session->_stats;
+        stats.ticks.fetch_add(ticks, std::memory_order_relaxed);
+        stats.cpuNs.fetch_add(cpuNs, std::memory_order_relaxed);
+        stats.droppedTicks.fetch_add(due - ticks, std::memory_order_relaxed);
+        uint64_t tickCpuNs = cpuNs / ticks;
+        if (tickCpuNs > stats.maxTickCpuNs.load(std::memory_order_relaxed)) {
+            stats.maxTickCpuNs.store(tickCpuNs, std::memory_order_relaxed);
+        }
+        worker.stats.ticks.fetch_add(ticks, std::memory_order_relaxed);
+        worker.stats.busyCpuNs.fetch_add(cpuNs, std::memory_order_relaxed);
+
+        session->nextTickNs = deadline + due * session->periodNs;
+        std::push_heap(schedule.begin(), schedule.end(), laterTick);
+    }
+}
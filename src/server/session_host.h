@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "game/game.h"
+#include "game/level.h"
+#include "platform/time.h"
+
+enum SessionInputBits : uint32_t {
+    SESSION_INPUT_LEFT = 1 << 0,
+    SESSION_INPUT_RIGHT = 1 << 1,
+    // consumed by the next tick
+    SESSION_INPUT_JUMP = 1 << 2,
+};
+
+struct SessionStats {
+    std::atomic<uint64_t> ticks{0};
+    // thread CPU time spent ticking this session
+    std::atomic<uint64_t> cpuNs{0};
+    std::atomic<uint64_t> maxTickCpuNs{0};
+    // ticks skipped because the session fell more than SessionHost::MAX_CATCH_UP_TICKS behind
+    std::atomic<uint64_t> droppedTicks{0};
+};
+
+// One independent game. The Game is only touched by the worker owning the session, other threads talk to it through
+// the atomic input bits and read the stats.
+class Session {
+    friend class SessionHost;
+
+    uint32_t _id;
+    Game game;
+    uint32_t _tickRate;
+    uint64_t periodNs;
+    float tickDelta;
+    uint64_t nextTickNs = 0;
+
+    std::atomic<uint32_t> input{0};
+    std::atomic<bool> closed{false};
+    SessionStats _stats{};
+
+public:
+    Session(uint32_t id, std::shared_ptr<const Level> level, uint32_t tickRate);
+
+    uint32_t id() const noexcept {
+        return _id;
+    }
+
+    uint32_t tickRate() const noexcept {
+        return _tickRate;
+    }
+
+    // Replaces the held movement keys, jump is latched until the next tick
+    void setInput(uint32_t bits) noexcept {
+        uint32_t current = input.load(std::memory_order_relaxed);
+        while (!input.compare_exchange_weak(current, bits | (current & SESSION_INPUT_JUMP), std::memory_order_relaxed)) {
+        }
+    }
+
+    const SessionStats& stats() const noexcept {
+        return _stats;
+    }
+
+private:
+    void tick();
+};
+
+struct SessionWorkerStats {
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> busyCpuNs{0};
+    std::atomic<uint32_t> sessions{0};
+};
+
+// Ticks sessions on a fixed pool of worker threads. Every session belongs to one worker, which keeps its sessions in a
+// min-heap by next tick time and sleeps until the earliest one is due, so a worker costs nothing between ticks.
+// Sessions are placed on the worker with the fewest sessions and never migrate.
+class SessionHost {
+public:
+    static inline constexpr uint32_t MAX_CATCH_UP_TICKS = 4;
+    // upper bound on how long a worker sleeps before looking at newly added sessions
+    static inline constexpr uint64_t INBOX_POLL_NS = NSECS_PER_MSEC;
+
+private:
+    struct Worker {
+        std::thread thread{};
+        std::mutex inboxMutex{};
+        std::vector<std::shared_ptr<Session>> inbox{};
+        // min-heap by next tick time, owned by the worker thread
+        std::vector<std::shared_ptr<Session>> schedule{};
+        SessionWorkerStats stats{};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers{};
+    std::atomic<bool> running{false};
+
+    std::mutex sessionsMutex{};
+    std::vector<std::shared_ptr<Session>> _sessions{};
+    uint32_t nextSessionId = 1;
+
+public:
+    explicit SessionHost(uint32_t workerCount);
+
+    SessionHost(const SessionHost&) = delete;
+
+    SessionHost& operator=(const SessionHost&) = delete;
+
+    ~SessionHost();
+
+    void start();
+
+    // Joins the workers, sessions keep their state and resume on the next start()
+    void stop();
+
+    // Thread safe. The level is shared, not copied: any number of sessions can play the same one.
+    std::shared_ptr<Session> addSession(std::shared_ptr<const Level> level, uint32_t tickRate);
+
+    // Thread safe, the owning worker drops the session before its next tick
+    void removeSession(const std::shared_ptr<Session>& session);
+
+    std::vector<std::shared_ptr<Session>> sessions();
+
+    uint32_t workerCount() const noexcept {
+        return static_cast<uint32_t>(workers.size());
+    }
+
+    const SessionWorkerStats& workerStats(uint32_t worker) const noexcept {
+        return workers[worker]->stats;
+    }
+
+private:
+    void workerLoop(Worker& worker);
+};
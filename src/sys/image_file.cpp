@@ -0,0 +1,23 @@
+#include "image_file.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+ImageRGBA loadImageRGBA(const std::string& path) {
+    int width, height, channels;
+    stbi_uc* data = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (data == nullptr) {
+        throw std::runtime_error("failed to load image " + path + ": " + stbi_failure_reason());
+    }
+
+    ImageRGBA image;
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixels.resize(4 * static_cast<size_t>(width) * static_cast<size_t>(height));
+    memcpy(image.pixels.data(), data, image.pixels.size());
+    stbi_image_free(data);
+    return image;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 8-bit RGBA pixels, rows top to bottom
+struct ImageRGBA {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels{};
+};
+
+ImageRGBA loadImageRGBA(const std::string& path);
@@ -0,0 +1,147 @@
+#include "sprite_atlas.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+#include "platform/time.h"
+#include "util/profiler.h"
+
+// empty texels between sprites, keeps linear filtering or rounding from picking up a neighbour
+static constexpr uint32_t SPRITE_PADDING = 1;
+
+std::vector<std::string> listSpriteFiles(const std::string& directory) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".png") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+std::vector<DecodedSprite> decodeSprites(const std::vector<std::string>& paths, uint32_t threadCount) {
+    std::vector<DecodedSprite> sprites(paths.size());
+    std::atomic<size_t> next{0};
+
+    // workers claim files one at a time, sizes vary too much for a static split
+    auto work = [&] {
+        PROFILE_THREAD_NAME("sprite decode");
+        for (size_t i = next.fetch_add(1); i < paths.size(); i = next.fetch_add(1)) {
+            PROFILE_ZONE("decode sprite");
+            auto& sprite = sprites[i];
+            sprite.path = paths[i];
+            sprite.name = std::filesystem::path(paths[i]).stem().string();
+
+            uint64_t start = monotonicNsecs();
+            try {
+                sprite.image = loadImageRGBA(paths[i]);
+            } catch (std::runtime_error& error) {
+                sprite.error = error.what();
+            }
+            sprite.decodeNs = monotonicNsecs() - start;
+        }
+    };
+
+    size_t workerCount = std::min<size_t>(std::max<uint32_t>(threadCount, 1), paths.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return sprites;
+}
+
+SpriteAtlasSet packSpriteAtlases(std::vector<DecodedSprite>& sprites, uint32_t pageSize) {
+    PROFILE_FUNCTION();
+
+    std::vector<size_t> order;
+    for (size_t i = 0; i < sprites.size(); i++) {
+        if (sprites[i].error.empty()) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return sprites[a].image.height > sprites[b].image.height;
+    });
+
+    SpriteAtlasSet atlases;
+    for (size_t i : order) {
+        auto& sprite = sprites[i];
+        uint32_t width = sprite.image.width + SPRITE_PADDING;
+        uint32_t height = sprite.image.height + SPRITE_PADDING;
+        if (width > pageSize || height > pageSize) {
+            sprite.error = "larger than a " + std::to_string(pageSize) + "x" + std::to_string(pageSize) + " atlas";
+            sprite.image = {};
+            continue;
+        }
+
+        // first fit over the pages, opening a new one when none has room
+        uint32_t x = 0;
+        uint32_t y = 0;
+        size_t page = 0;
+        while (page < atlases.pages.size() && !atlases.pages[page].packer.pack(width, height, x, y)) {
+            page++;
+        }
+        if (page == atlases.pages.size()) {
+            auto& created = atlases.pages.emplace_back();
+            created.packer = SkylinePacker(pageSize, pageSize);
+            created.image.width = pageSize;
+            created.image.height = pageSize;
+            created.image.pixels.assign(4 * static_cast<size_t>(pageSize) * pageSize, 0);
+            created.packer.pack(width, height, x, y);
+        }
+
+        auto& target = atlases.pages[page].image;
+        size_t rowBytes = 4 * static_cast<size_t>(sprite.image.width);
+        for (uint32_t row = 0; row < sprite.image.height; row++) {
+            memcpy(
+                &target.pixels[4 * ((static_cast<size_t>(y) + row) * pageSize + x)], //
+                &sprite.image.pixels[row * rowBytes],
+                rowBytes
+            );
+        }
+
+        float scale = 1.0f / static_cast<float>(pageSize);
+        SpriteRegion region;
+        region.page = static_cast<uint32_t>(page);
+        region.u0 = static_cast<float>(x) * scale;
+        region.v0 = static_cast<float>(y) * scale;
+        region.u1 = static_cast<float>(x + sprite.image.width) * scale;
+        region.v1 = static_cast<float>(y + sprite.image.height) * scale;
+        atlases.sprites[sprite.name] = region;
+
+        sprite.image.pixels = {};
+    }
+    return atlases;
+}
+
+void printSpriteAtlasReport(std::ostream& out, const std::vector<DecodedSprite>& sprites, const SpriteAtlasSet& atlases) {
+    uint64_t totalNs = 0;
+    for (const auto& sprite : sprites) {
+        totalNs += sprite.decodeNs;
+        out << "sprite " << sprite.name << ": " << std::fixed << std::setprecision(2) << static_cast<double>(sprite.decodeNs) / NSECS_PER_MSEC << " ms";
+        if (!sprite.error.empty()) {
+            out << ", skipped: " << sprite.error;
+        }
+        out << '\n';
+    }
+    out << "decoded " << sprites.size() << " sprites in " << std::fixed << std::setprecision(2) << static_cast<double>(totalNs) / NSECS_PER_MSEC
+        << " ms of decode time\n";
+
+    for (size_t i = 0; i < atlases.pages.size(); i++) {
+        const auto& packer = atlases.pages[i].packer;
+        out << "sprite atlas " << i << ": " << packer.width() << "x" << packer.height() << ", " << std::setprecision(1)
+            << 100.0f * packer.occupancy() << "% occupied\n";
+    }
+    out << std::defaultfloat << std::flush;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "image_file.h"
+#include "util/skyline_packer.h"
+
+struct DecodedSprite {
+    // file name without the extension
+    std::string name;
+    std::string path;
+    ImageRGBA image{};
+    uint64_t decodeNs = 0;
+    // empty when the image decoded
+    std::string error{};
+};
+
+// Location of a sprite inside an atlas page, uv rows go down like the image rows
+struct SpriteRegion {
+    uint32_t page = 0;
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    float u1 = 0.0f;
+    float v1 = 0.0f;
+};
+
+struct SpriteAtlasPage {
+    ImageRGBA image{};
+    SkylinePacker packer{};
+};
+
+struct SpriteAtlasSet {
+    std::vector<SpriteAtlasPage> pages{};
+    std::unordered_map<std::string, SpriteRegion> sprites{};
+
+    const SpriteRegion* find(const std::string& name) const {
+        auto it = sprites.find(name);
+        return it != sprites.end() ? &it->second : nullptr;
+    }
+};
+
+// .png files of directory sorted by name, empty when the directory does not exist
+std::vector<std::string> listSpriteFiles(const std::string& directory);
+
+// Decodes the files on up to threadCount worker threads. Failures are reported in DecodedSprite::error instead of thrown.
+std::vector<DecodedSprite> decodeSprites(const std::vector<std::string>& paths, uint32_t threadCount);
+
+// Packs the decoded sprites into as many pageSize x pageSize pages as needed, tallest first. The pixels are moved out of
+// sprites. Sprites that failed to decode or are larger than a page are left out and get an error.
+SpriteAtlasSet packSpriteAtlases(std::vector<DecodedSprite>& sprites, uint32_t pageSize);
+
+// Per sprite decode time and per page occupancy
+void printSpriteAtlasReport(std::ostream& out, const std::vector<DecodedSprite>& sprites, const SpriteAtlasSet& atlases);
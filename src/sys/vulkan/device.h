@@ -68,15 +68,16 @@ public:
         return handle;
     }
 
-    VkShaderModule createShaderModule(const std::vector<char>& code) const {
-        if (code.size() % 4 != 0) {
+    // code has to be 4 byte aligned, which archive blobs and heap buffers are
+    VkShaderModule createShaderModule(const uint8_t* code, size_t size) const {
+        if (size % 4 != 0) {
             throw std::runtime_error("failed to create shader module: code size does not divide by 4");
         }
 
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        createInfo.codeSize = size;
+        createInfo.pCode = reinterpret_cast<const uint32_t*>(code);
 
         VkShaderModule shaderModule;
         if (vkCreateShaderModule(handle, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
@@ -118,6 +119,12 @@ public:
         return commandBuffer;
     }
 
+    void freeCommandBuffers(VkCommandPool commandPool, const std::vector<VkCommandBuffer>& commandBuffers) const noexcept {
+        if (!commandBuffers.empty()) {
+            vkFreeCommandBuffers(handle, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+        }
+    }
+
     VkFence createFence() const noexcept {
         VkFenceCreateInfo fenceInfo{};
         fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "mem_buffer.h"
+
+// Single mip, single layer 2D image with its own memory and a full view
+class MemImage {
+    VkImage hImage = VK_NULL_HANDLE;
+    VkDeviceMemory hMemory = VK_NULL_HANDLE;
+    VkImageView hView = VK_NULL_HANDLE;
+    uint32_t imageWidth = 0;
+    uint32_t imageHeight = 0;
+
+public:
+    constexpr MemImage() noexcept = default;
+
+    static MemImage create2D(
+        VkPhysicalDevice physicalDevice, //
+        Device device,
+        uint32_t width,
+        uint32_t height,
+        VkFormat format,
+        VkImageUsageFlags usage
+    ) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = format;
+        imageInfo.extent = {width, height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = usage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        MemImage image;
+        image.imageWidth = width;
+        image.imageHeight = height;
+        if (vkCreateImage(device.getHandle(), &imageInfo, nullptr, &image.hImage) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device.getHandle(), image.hImage, &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (vkAllocateMemory(device.getHandle(), &allocInfo, nullptr, &image.hMemory) != VK_SUCCESS) {
+            image.destroy(device);
+            throw std::runtime_error("failed to allocate image memory");
+        }
+        vkBindImageMemory(device.getHandle(), image.hImage, image.hMemory, 0);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image.hImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange = fullRange();
+
+        if (vkCreateImageView(device.getHandle(), &viewInfo, nullptr, &image.hView) != VK_SUCCESS) {
+            image.destroy(device);
+            throw std::runtime_error("failed to create image view");
+        }
+
+        return image;
+    }
+
+    static constexpr VkImageSubresourceRange fullRange() noexcept {
+        return {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    }
+
+    VkImage image() const noexcept {
+        return hImage;
+    }
+
+    VkImageView view() const noexcept {
+        return hView;
+    }
+
+    uint32_t width() const noexcept {
+        return imageWidth;
+    }
+
+    uint32_t height() const noexcept {
+        return imageHeight;
+    }
+
+    void destroy(Device device) const noexcept {
+        vkDestroyImageView(device.getHandle(), hView, nullptr);
+        vkDestroyImage(device.getHandle(), hImage, nullptr);
+        device.freeMemory(hMemory);
+    }
+};
+
+inline VkSampler createNearestSampler(Device device) {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    if (vkCreateSampler(device.getHandle(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create sampler");
+    }
+    return sampler;
+}
@@ -17,17 +17,28 @@ struct GraphicsPipelineCreateInfo {
 
     float lineWidth = 1.0f;
 
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkPushConstantRange pushConstantRange{};
+
     GraphicsPipelineCreateInfo() noexcept {
         vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     }
 };
 
-inline VkPipelineLayout createPipelineLayout(VkDevice device) {
+inline VkPipelineLayout createPipelineLayout(VkDevice device, VkDescriptorSetLayout setLayout, const VkPushConstantRange& pushConstantRange) {
     VkPipelineLayout pipelineLayout;
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    if (setLayout != VK_NULL_HANDLE) {
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &setLayout;
+    }
+    if (pushConstantRange.size != 0) {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    }
 
     if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout");
@@ -179,8 +190,18 @@ public:
         return *this;
     }
 
+    GraphicsPipelineBuilder withDescriptorSetLayout(VkDescriptorSetLayout setLayout) noexcept {
+        info.descriptorSetLayout = setLayout;
+        return *this;
+    }
+
+    GraphicsPipelineBuilder withPushConstants(VkShaderStageFlags stages, uint32_t size) noexcept {
+        info.pushConstantRange = {stages, 0, size};
+        return *this;
+    }
+
     GraphicsPipeline create() const {
-        auto pipelineLayout = createPipelineLayout(info.device.getHandle());
+        auto pipelineLayout = createPipelineLayout(info.device.getHandle(), info.descriptorSetLayout, info.pushConstantRange);
         auto pipeline = createVkPipeline(info, info.renderPass->renderPass(), pipelineLayout);
         return {pipelineLayout, pipeline};
     }
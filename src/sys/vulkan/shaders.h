@@ -1,26 +1,9 @@
 #pragma once
 
-#include <fstream>
-#include <vector>
+#include <string>
 
 #include "device.h"
-
-inline std::vector<char> readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open()) {
-        throw std::runtime_error("failed to open file");
-    }
-
-    size_t fileSize = (size_t)file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), static_cast<std::streamsize>(fileSize));
-    file.close();
-
-    return buffer;
-}
+#include "util/asset_archive.h"
 
 struct Shaders {
     VkShaderModule vertShader;
@@ -30,11 +13,12 @@ struct Shaders {
 
     Shaders(VkShaderModule vertShader, VkShaderModule fragShader) noexcept : vertShader(vertShader), fragShader(fragShader) {}
 
-    static Shaders loadShaders(Device device, const std::string& vertexShaderFileName, const std::string& fragmentShaderFileName) {
-        auto vertShaderCode = readFile(vertexShaderFileName);
-        VkShaderModule vertShader = device.createShaderModule(vertShaderCode);
-        auto fragShaderCode = readFile(fragmentShaderFileName);
-        VkShaderModule fragShader = device.createShaderModule(fragShaderCode);
+    // SPIR-V is read straight from the archive mapping unless the asset is compressed
+    static Shaders loadShaders(Device device, const AssetArchive& assets, const std::string& vertexShaderName, const std::string& fragmentShaderName) {
+        auto vertShaderCode = assets.read(vertexShaderName);
+        VkShaderModule vertShader = device.createShaderModule(vertShaderCode.data, vertShaderCode.size);
+        auto fragShaderCode = assets.read(fragmentShaderName);
+        VkShaderModule fragShader = device.createShaderModule(fragShaderCode.data, fragShaderCode.size);
         return {vertShader, fragShader};
     }
 
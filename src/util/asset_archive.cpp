@@ -0,0 +1,214 @@
+#include "asset_archive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "../platform/mapped_file.h"
+#include "hash.h"
+#include "lz4.h"
+
+static bool littleEndianHost() noexcept {
+    uint16_t probe = 1;
+    uint8_t firstByte;
+    memcpy(&firstByte, &probe, 1);
+    return firstByte == 1;
+}
+
+static uint64_t hashName(std::string_view name) noexcept {
+    return fnv1a(name.data(), name.size());
+}
+
+void AssetArchiveBuilder::add(std::string name, const std::vector<uint8_t>& bytes, bool compress) {
+    for (const auto& asset : assets) {
+        if (asset.name == name) {
+            throw std::runtime_error("duplicate asset " + name);
+        }
+    }
+
+    PendingAsset asset{std::move(name), {}, bytes.size(), ASSET_COMPRESSION_NONE};
+    if (compress && !bytes.empty()) {
+        lz4Compress(bytes.data(), bytes.size(), asset.stored);
+        if (asset.stored.size() < bytes.size()) {
+            asset.compression = ASSET_COMPRESSION_LZ4;
+        }
+    }
+    if (asset.compression == ASSET_COMPRESSION_NONE) {
+        asset.stored = bytes;
+    }
+    assets.push_back(std::move(asset));
+}
+
+std::vector<uint8_t> AssetArchiveBuilder::serialize() const {
+    if (!littleEndianHost()) {
+        throw std::runtime_error("asset archives can only be written on little-endian hosts");
+    }
+
+    auto entryCount = static_cast<uint32_t>(assets.size());
+    uint32_t slotCount = 1;
+    while (slotCount < 2 * entryCount) {
+        slotCount *= 2;
+    }
+
+    AssetArchiveHeader header{};
+    memcpy(header.magic, ASSET_ARCHIVE_MAGIC, sizeof(ASSET_ARCHIVE_MAGIC));
+    header.version = ASSET_ARCHIVE_VERSION;
+    header.entryCount = entryCount;
+    header.slotCount = slotCount;
+    header.entriesOffset = alignBlob(sizeof(AssetArchiveHeader));
+    header.slotsOffset = alignBlob(header.entriesOffset + sizeof(AssetEntry) * entryCount);
+    header.namesOffset = alignBlob(header.slotsOffset + sizeof(uint32_t) * slotCount);
+
+    std::vector<AssetEntry> entries(entryCount);
+    std::vector<uint32_t> slots(slotCount, ASSET_SLOT_EMPTY);
+    std::string names;
+    for (uint32_t i = 0; i < entryCount; i++) {
+        const auto& asset = assets[i];
+        auto& entry = entries[i];
+        entry.nameHash = hashName(asset.name);
+        entry.nameOffset = static_cast<uint32_t>(names.size());
+        entry.nameSize = static_cast<uint32_t>(asset.name.size());
+        entry.storedSize = asset.stored.size();
+        entry.size = asset.size;
+        entry.compression = asset.compression;
+        names += asset.name;
+
+        uint32_t slot = static_cast<uint32_t>(entry.nameHash) & (slotCount - 1);
+        while (slots[slot] != ASSET_SLOT_EMPTY) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = i;
+    }
+    header.namesSize = names.size();
+
+    uint64_t offset = alignBlob(header.namesOffset + header.namesSize);
+    for (auto& entry : entries) {
+        entry.offset = offset;
+        offset = alignBlob(offset + entry.storedSize);
+    }
+    header.fileSize = offset;
+
+    std::vector<uint8_t> bytes(offset, 0);
+    memcpy(bytes.data(), &header, sizeof(header));
+    if (entryCount != 0) {
+        memcpy(bytes.data() + header.entriesOffset, entries.data(), sizeof(AssetEntry) * entryCount);
+    }
+    memcpy(bytes.data() + header.slotsOffset, slots.data(), sizeof(uint32_t) * slotCount);
+    memcpy(bytes.data() + header.namesOffset, names.data(), names.size());
+    for (uint32_t i = 0; i < entryCount; i++) {
+        if (!assets[i].stored.empty()) {
+            memcpy(bytes.data() + entries[i].offset, assets[i].stored.data(), assets[i].stored.size());
+        }
+    }
+    return bytes;
+}
+
+std::shared_ptr<const AssetArchive> AssetArchive::open(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(MappedFile::open(path));
+    const uint8_t* data = file->data();
+    size_t size = file->size();
+    try {
+        return fromMemory(std::move(file), data, size);
+    } catch (const std::runtime_error& error) {
+        throw std::runtime_error(path + ": " + error.what());
+    }
+}
+
+std::shared_ptr<const AssetArchive> AssetArchive::fromBytes(std::vector<uint8_t> bytes) {
+    auto owned = std::make_shared<std::vector<uint8_t>>(std::move(bytes));
+    const uint8_t* data = owned->data();
+    size_t size = owned->size();
+    return fromMemory(std::move(owned), data, size);
+}
+
+std::shared_ptr<const AssetArchive> AssetArchive::fromMemory(std::shared_ptr<const void> backing, const uint8_t* data, size_t size) {
+    if (!littleEndianHost()) {
+        throw std::runtime_error("asset archives can only be loaded on little-endian hosts");
+    }
+    if (size < sizeof(AssetArchiveHeader)) {
+        throw std::runtime_error("asset archive is truncated");
+    }
+
+    AssetArchiveHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, ASSET_ARCHIVE_MAGIC, sizeof(ASSET_ARCHIVE_MAGIC)) != 0) {
+        throw std::runtime_error("not an asset archive");
+    }
+    if (header.version != ASSET_ARCHIVE_VERSION) {
+        throw std::runtime_error("unsupported asset archive version " + std::to_string(header.version));
+    }
+    if (header.fileSize != size) {
+        throw std::runtime_error("asset archive size does not match its header");
+    }
+    if (header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0 || header.slotCount < header.entryCount) {
+        throw std::runtime_error("asset archive has a malformed table of contents");
+    }
+
+    auto inBounds = [&](uint64_t offset, uint64_t length) { return offset % ASSET_BLOB_ALIGNMENT == 0 && offset <= size && length <= size - offset; };
+    if (!inBounds(header.entriesOffset, sizeof(AssetEntry) * static_cast<uint64_t>(header.entryCount)) ||
+        !inBounds(header.slotsOffset, sizeof(uint32_t) * static_cast<uint64_t>(header.slotCount)) || !inBounds(header.namesOffset, header.namesSize)) {
+        throw std::runtime_error("asset archive table of contents is out of bounds");
+    }
+
+    std::shared_ptr<AssetArchive> archive(new AssetArchive());
+    archive->backing = std::move(backing);
+    archive->base = data;
+    archive->entries = reinterpret_cast<const AssetEntry*>(data + header.entriesOffset);
+    archive->slots = reinterpret_cast<const uint32_t*>(data + header.slotsOffset);
+    archive->names = reinterpret_cast<const char*>(data + header.namesOffset);
+    archive->entryCount = header.entryCount;
+    archive->slotMask = header.slotCount - 1;
+
+    // the table of contents is small, check all of it so that lookups and reads can trust it
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        const AssetEntry& entry = archive->entries[i];
+        if (static_cast<uint64_t>(entry.nameOffset) + entry.nameSize > header.namesSize || !inBounds(entry.offset, entry.storedSize) ||
+            entry.compression > ASSET_COMPRESSION_LZ4 || (entry.compression == ASSET_COMPRESSION_NONE && entry.storedSize != entry.size)) {
+            throw std::runtime_error("asset archive entry " + std::to_string(i) + " is malformed");
+        }
+    }
+    for (uint32_t slot = 0; slot <= archive->slotMask; slot++) {
+        if (archive->slots[slot] != ASSET_SLOT_EMPTY && archive->slots[slot] >= header.entryCount) {
+            throw std::runtime_error("asset archive slot " + std::to_string(slot) + " is out of range");
+        }
+    }
+    return archive;
+}
+
+const AssetEntry* AssetArchive::find(std::string_view name) const noexcept {
+    uint64_t hash = hashName(name);
+    // at least half the slots are empty, probing always terminates
+    for (uint32_t slot = static_cast<uint32_t>(hash) & slotMask, probes = 0; probes <= slotMask; slot = (slot + 1) & slotMask, probes++) {
+        uint32_t index = slots[slot];
+        if (index == ASSET_SLOT_EMPTY) {
+            return nullptr;
+        }
+        const AssetEntry& entry = entries[index];
+        if (entry.nameHash == hash && this->name(entry) == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+AssetData AssetArchive::read(std::string_view name) const {
+    const AssetEntry* entry = find(name);
+    if (entry == nullptr) {
+        throw std::runtime_error("asset not found: " + std::string(name));
+    }
+    return read(*entry);
+}
+
+AssetData AssetArchive::read(const AssetEntry& entry) const {
+    const uint8_t* stored = base + entry.offset;
+    if (entry.compression == ASSET_COMPRESSION_NONE) {
+        return {stored, static_cast<size_t>(entry.size), backing};
+    }
+
+    auto buffer = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(entry.size));
+    if (!lz4Decompress(stored, static_cast<size_t>(entry.storedSize), buffer->data(), buffer->size())) {
+        throw std::runtime_error("asset " + std::string(name(entry)) + " is corrupted");
+    }
+    return {buffer->data(), buffer->size(), std::move(buffer)};
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Asset archive, version 1. All values are little-endian, blobs start on ASSET_BLOB_ALIGNMENT boundaries so that
+// uncompressed assets can be used in place from a memory mapping.
+//
+//   AssetArchiveHeader
+//   ENTRIES   AssetEntry[entryCount]
+//   SLOTS     uint32[slotCount], open addressing table of entry indices keyed by the name hash, linear probing
+//   NAMES     char[namesSize], entry names without terminators
+//   blobs
+
+inline constexpr char ASSET_ARCHIVE_MAGIC[4] = {'P', 'A', 'S', 'T'};
+inline constexpr uint32_t ASSET_ARCHIVE_VERSION = 1;
+inline constexpr uint64_t ASSET_BLOB_ALIGNMENT = 64;
+inline constexpr uint32_t ASSET_SLOT_EMPTY = 0xffffffff;
+
+enum AssetCompression : uint32_t {
+    ASSET_COMPRESSION_NONE,
+    ASSET_COMPRESSION_LZ4,
+};
+
+struct AssetArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t fileSize;
+
+    uint32_t entryCount;
+    // power of two, at least twice the entry count
+    uint32_t slotCount;
+    uint64_t entriesOffset;
+    uint64_t slotsOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+};
+
+struct AssetEntry {
+    uint64_t nameHash;
+    uint32_t nameOffset;
+    uint32_t nameSize;
+    uint64_t offset;
+    // bytes in the archive, equal to size when uncompressed
+    uint64_t storedSize;
+    uint64_t size;
+    uint32_t compression;
+    uint32_t reserved;
+};
+
+inline uint64_t alignBlob(uint64_t offset) noexcept {
+    return (offset + ASSET_BLOB_ALIGNMENT - 1) & ~(ASSET_BLOB_ALIGNMENT - 1);
+}
+
+// Contents of one asset. Points into the archive mapping for stored assets, into a private buffer for compressed
+// ones, either way owner keeps the memory alive.
+struct AssetData {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> owner{};
+};
+
+class AssetArchiveBuilder {
+    struct PendingAsset {
+        std::string name;
+        std::vector<uint8_t> stored;
+        uint64_t size;
+        AssetCompression compression;
+    };
+
+    std::vector<PendingAsset> assets{};
+
+public:
+    // LZ4 is only kept when it makes the asset smaller
+    void add(std::string name, const std::vector<uint8_t>& bytes, bool compress);
+
+    std::vector<uint8_t> serialize() const;
+};
+
+class AssetArchive {
+    std::shared_ptr<const void> backing{};
+    const uint8_t* base = nullptr;
+    const AssetEntry* entries = nullptr;
+    const uint32_t* slots = nullptr;
+    const char* names = nullptr;
+    uint32_t entryCount = 0;
+    uint32_t slotMask = 0;
+
+    AssetArchive() = default;
+
+public:
+    // Maps the file and validates the table of contents. Blobs are not touched until read.
+    static std::shared_ptr<const AssetArchive> open(const std::string& path);
+
+    static std::shared_ptr<const AssetArchive> fromBytes(std::vector<uint8_t> bytes);
+
+    uint32_t size() const noexcept {
+        return entryCount;
+    }
+
+    const AssetEntry& entry(uint32_t i) const noexcept {
+        return entries[i];
+    }
+
+    std::string_view name(const AssetEntry& entry) const noexcept {
+        return {names + entry.nameOffset, entry.nameSize};
+    }
+
+    // nullptr when there is no such asset
+    const AssetEntry* find(std::string_view name) const noexcept;
+
+    // Throws when the asset is missing or does not decompress
+    AssetData read(std::string_view name) const;
+
+    AssetData read(const AssetEntry& entry) const;
+
+private:
+    static std::shared_ptr<const AssetArchive> fromMemory(std::shared_ptr<const void> backing, const uint8_t* data, size_t size);
+};
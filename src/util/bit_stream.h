@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Packs values of up to 32 bits into a fixed buffer, least significant bit first. Writing past the end sets
+// overflowed() instead of failing, callers check it once at the end.
+class BitWriter {
+    uint8_t* data;
+    size_t capacity;
+    size_t bitPos = 0;
+    bool _overflowed = false;
+
+public:
+    BitWriter(uint8_t* data, size_t capacity) noexcept : data(data), capacity(capacity) {}
+
+    void write(uint32_t value, uint32_t bits) noexcept {
+        if (bitPos + bits > capacity * 8) {
+            _overflowed = true;
+            return;
+        }
+        for (uint32_t i = 0; i < bits;) {
+            size_t byte = bitPos / 8;
+            uint32_t offset = bitPos % 8;
+            uint32_t chunk = bits - i < 8 - offset ? bits - i : 8 - offset;
+            uint32_t mask = (1u << chunk) - 1;
+            if (offset == 0) {
+                data[byte] = 0;
+            }
+            data[byte] = static_cast<uint8_t>(data[byte] | (((value >> i) & mask) << offset));
+            i += chunk;
+            bitPos += chunk;
+        }
+    }
+
+    void writeBool(bool value) noexcept {
+        write(value ? 1 : 0, 1);
+    }
+
+    bool overflowed() const noexcept {
+        return _overflowed;
+    }
+
+    // bytes used so far, the last one padded with zeros
+    size_t size() const noexcept {
+        return (bitPos + 7) / 8;
+    }
+};
+
+// Reads what BitWriter wrote. Reading past the end returns zeros and sets overflowed(), so a truncated or malicious
+// packet can be parsed to the end and rejected once.
+class BitReader {
+    const uint8_t* data;
+    size_t size;
+    size_t bitPos = 0;
+    bool _overflowed = false;
+
+public:
+    BitReader(const uint8_t* data, size_t size) noexcept : data(data), size(size) {}
+
+    uint32_t read(uint32_t bits) noexcept {
+        if (bitPos + bits > size * 8) {
+            _overflowed = true;
+            return 0;
+        }
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits;) {
+            size_t byte = bitPos / 8;
+            uint32_t offset = bitPos % 8;
+            uint32_t chunk = bits - i < 8 - offset ? bits - i : 8 - offset;
+            uint32_t mask = (1u << chunk) - 1;
+            value |= ((static_cast<uint32_t>(data[byte]) >> offset) & mask) << i;
+            i += chunk;
+            bitPos += chunk;
+        }
+        return value;
+    }
+
+    bool readBool() noexcept {
+        return read(1) != 0;
+    }
+
+    bool overflowed() const noexcept {
+        return _overflowed;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+inline constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+inline constexpr uint64_t FNV1A_PRIME = 0x100000001b3ull;
+
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS) noexcept {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+template <typename T>
+inline uint64_t fnv1aValue(const T& value, uint64_t hash = FNV1A_OFFSET_BASIS) noexcept {
+    return fnv1a(&value, sizeof(T), hash);
+}
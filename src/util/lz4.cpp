@@ -0,0 +1,150 @@
+#include "lz4.h"
+
+#include <cstring>
+
+static constexpr size_t MIN_MATCH = 4;
+// the format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end
+static constexpr size_t LAST_LITERALS = 5;
+static constexpr size_t MATCH_FIND_LIMIT = 12;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr uint32_t HASH_BITS = 12;
+
+static uint32_t read32(const uint8_t* p) noexcept {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t hashSequence(uint32_t sequence) noexcept {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void writeLength(std::vector<uint8_t>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+static void writeSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength != 0 ? matchLength - MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+    if (matchLength != 0) {
+        token |= static_cast<uint8_t>(matchCode < 15 ? matchCode : 15);
+    }
+
+    out.push_back(token);
+    if (literalCount >= 15) {
+        writeLength(out, literalCount - 15);
+    }
+    out.insert(out.end(), literals, literals + literalCount);
+
+    // a sequence without a match ends the block
+    if (matchLength == 0) {
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(offset & 0xff));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchCode >= 15) {
+        writeLength(out, matchCode - 15);
+    }
+}
+
+void lz4Compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(size + size / 255 + 16);
+
+    size_t anchor = 0;
+    if (size > MATCH_FIND_LIMIT) {
+        // positions are stored + 1 so that zero means empty
+        std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+        size_t matchEnd = size - LAST_LITERALS;
+
+        size_t i = 0;
+        while (i + MATCH_FIND_LIMIT <= size) {
+            uint32_t sequence = read32(src + i);
+            uint32_t& slot = table[hashSequence(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(i + 1);
+
+            if (candidate == 0 || i - (candidate - 1) > MAX_OFFSET || read32(src + candidate - 1) != sequence) {
+                i++;
+                continue;
+            }
+            candidate--;
+
+            size_t length = MIN_MATCH;
+            while (i + length < matchEnd && src[candidate + length] == src[i + length]) {
+                length++;
+            }
+
+            writeSequence(out, src + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        }
+    }
+    writeSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+bool lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) noexcept {
+    size_t in = 0;
+    size_t out = 0;
+
+    auto readLength = [&](size_t& length) {
+        uint8_t byte;
+        do {
+            if (in == srcSize) {
+                return false;
+            }
+            byte = src[in++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (in < srcSize) {
+        uint8_t token = src[in++];
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(literalCount)) {
+            return false;
+        }
+        if (literalCount > srcSize - in || literalCount > dstSize - out) {
+            return false;
+        }
+        memcpy(dst + out, src + in, literalCount);
+        in += literalCount;
+        out += literalCount;
+
+        if (in == srcSize) {
+            break;
+        }
+
+        if (srcSize - in < 2) {
+            return false;
+        }
+        size_t offset = src[in] | (static_cast<size_t>(src[in + 1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > out) {
+            return false;
+        }
+
+        size_t matchLength = token & 0x0f;
+        if (matchLength == 15 && !readLength(matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > dstSize - out) {
+            return false;
+        }
+
+        // matches may overlap their own output, copy forward byte by byte
+        const uint8_t* match = dst + out - offset;
+        for (size_t i = 0; i < matchLength; i++) {
+            dst[out + i] = match[i];
+        }
+        out += matchLength;
+    }
+    return out == dstSize;
+}
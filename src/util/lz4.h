@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LZ4 block format (no frame header), compatible with LZ4_compress_default / LZ4_decompress_safe.
+// The compressor is a plain greedy single hash table matcher: fast, not the best ratio.
+
+// Replaces out with the compressed block
+void lz4Compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+// Decompresses a block whose decompressed size is known up front. Returns false for malformed input or a size mismatch,
+// never reads or writes out of bounds.
+bool lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) noexcept;
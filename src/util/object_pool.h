@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "spsc_ring.h"
+
+// Stays valid until the object is despawned, a despawned slot is reused with the next generation
+struct PoolHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const PoolHandle& rhs) const noexcept {
+        return index == rhs.index && generation == rhs.generation;
+    }
+};
+
+struct PoolStats {
+    uint32_t live = 0;
+    // slots in the blocks allocated so far, live / capacity is the occupancy
+    uint32_t capacity = 0;
+    uint32_t maxCapacity = 0;
+    // the most objects live at once
+    uint32_t peak = 0;
+    uint32_t blocks = 0;
+    uint64_t spawns = 0;
+    uint64_t despawns = 0;
+    // spawns refused because every slot up to maxCapacity was taken
+    uint64_t overflows = 0;
+};
+
+// Pool of short lived objects, projectiles and the like, in fixed size blocks of BLOCK_SIZE slots. Blocks are
+// allocated as the pool fills up, or all at once by reserve, and only freed with the pool, so after warm-up spawning
+// and despawning never call the allocator. Free slots are chained into a list through the slots themselves and the
+// last one freed is the first reused, while its cache lines are still warm.
+//
+// Objects never move: pointers from find and get stay valid until the object is despawned. Iteration walks the slots
+// in index order up to the highest one ever used and skips the free ones.
+template <typename T, uint32_t BLOCK_SIZE = 256>
+class ObjectPool {
+    static_assert(std::is_trivially_copyable_v<T>, "objects are copied into their slots");
+    static_assert(std::is_default_constructible_v<T>, "free slots hold a default constructed object");
+
+    static inline constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    struct Slot {
+        T value;
+        uint32_t generation;
+        // the next free slot while this one is free
+        uint32_t nextFree;
+        bool alive;
+    };
+
+    struct BlockDeleter {
+        void operator()(Slot* p) const noexcept {
+            ::operator delete[](p, std::align_val_t(CACHE_LINE_SIZE));
+        }
+    };
+    using Block = std::unique_ptr<Slot[], BlockDeleter>;
+
+    std::vector<Block> blocks{};
+    uint32_t freeHead = NO_SLOT;
+    // slots at and past used were never handed out, they are not on the free list
+    uint32_t used = 0;
+    PoolStats _stats{};
+
+public:
+    explicit ObjectPool(uint32_t maxCapacity) {
+        if (maxCapacity == 0) {
+            throw std::runtime_error("an object pool needs room for one object");
+        }
+        _stats.maxCapacity = (maxCapacity + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+        blocks.reserve(_stats.maxCapacity / BLOCK_SIZE);
+    }
+
+    ObjectPool(const ObjectPool& other) : freeHead(other.freeHead), used(other.used), _stats(other._stats) {
+        blocks.reserve(_stats.maxCapacity / BLOCK_SIZE);
+        for (const auto& block : other.blocks) {
+            blocks.push_back(allocateBlock());
+            std::copy(block.get(), block.get() + BLOCK_SIZE, blocks.back().get());
+        }
+    }
+
+    ObjectPool(ObjectPool&&) noexcept = default;
+
+    ObjectPool& operator=(const ObjectPool& other) {
+        if (this != &other) {
+            *this = ObjectPool(other);
+        }
+        return *this;
+    }
+
+    ObjectPool& operator=(ObjectPool&&) noexcept = default;
+
+    // Allocates blocks until count objects fit, at most maxCapacity. Warm-up, so that spawning never has to.
+    void reserve(uint32_t count) {
+        count = std::min(count, _stats.maxCapacity);
+        while (_stats.capacity < count) {
+            addBlock();
+        }
+    }
+
+    // Returns a handle that is not alive when the pool is full
+    PoolHandle spawn(const T& value) {
+        uint32_t index;
+        if (freeHead != NO_SLOT) {
+            index = freeHead;
+            freeHead = slotAt(index).nextFree;
+        } else if (used < _stats.maxCapacity) {
+            if (used == _stats.capacity) {
+                addBlock();
+            }
+            index = used++;
+        } else {
+            _stats.overflows++;
+            return {};
+        }
+        Slot& slot = slotAt(index);
+        slot.value = value;
+        slot.alive = true;
+        _stats.live++;
+        _stats.peak = std::max(_stats.peak, _stats.live);
+        _stats.spawns++;
+        return {index, slot.generation};
+    }
+
+    // Spawns values[0] .. values[count - 1] and, unless handles is null, writes their handles. Returns how many fit,
+    // the first ones get the slots and the rest count as overflows.
+    uint32_t spawn(const T* values, uint32_t count, PoolHandle* handles = nullptr) {
+        for (uint32_t i = 0; i < count; i++) {
+            PoolHandle handle = spawn(values[i]);
+            if (handle.index == UINT32_MAX) {
+                _stats.overflows += count - i - 1;
+                return i;
+            }
+            if (handles != nullptr) {
+                handles[i] = handle;
+            }
+        }
+        return count;
+    }
+
+    // Returns false when the object was already despawned
+    bool despawn(PoolHandle handle) noexcept {
+        if (!isAlive(handle)) {
+            return false;
+        }
+        release(handle.index);
+        return true;
+    }
+
+    // Returns how many of the handles were alive
+    uint32_t despawn(const PoolHandle* handles, uint32_t count) noexcept {
+        uint32_t despawned = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            despawned += despawn(handles[i]) ? 1 : 0;
+        }
+        return despawned;
+    }
+
+    // Calls f(object) for every live object and despawns those it returns true for, the way a tick retires expired
+    // objects in the same pass that moves them. Returns how many were despawned.
+    template <typename F>
+    uint32_t despawnIf(F&& f) {
+        uint32_t despawned = 0;
+        for (uint32_t i = 0; i < used; i++) {
+            Slot& slot = slotAt(i);
+            if (slot.alive && f(slot.value)) {
+                release(i);
+                despawned++;
+            }
+        }
+        return despawned;
+    }
+
+    // Despawns every object, the blocks are kept
+    void clear() noexcept {
+        despawnIf([](const T&) { return true; });
+    }
+
+    bool isAlive(PoolHandle handle) const noexcept {
+        if (handle.index >= used) {
+            return false;
+        }
+        const Slot& slot = slotAt(handle.index);
+        return slot.alive && slot.generation == handle.generation;
+    }
+
+    // Null when the object was despawned
+    T* find(PoolHandle handle) noexcept {
+        return isAlive(handle) ? &slotAt(handle.index).value : nullptr;
+    }
+
+    const T* find(PoolHandle handle) const noexcept {
+        return isAlive(handle) ? &slotAt(handle.index).value : nullptr;
+    }
+
+    T& get(PoolHandle handle) {
+        T* value = find(handle);
+        if (value == nullptr) {
+            throw std::runtime_error("pool object " + std::to_string(handle.index) + " was despawned");
+        }
+        return *value;
+    }
+
+    const T& get(PoolHandle handle) const {
+        return const_cast<ObjectPool*>(this)->get(handle);
+    }
+
+    // Calls f(handle, object) for every live object in slot order
+    template <typename F>
+    void forEach(F&& f) {
+        for (uint32_t i = 0; i < used; i++) {
+            Slot& slot = slotAt(i);
+            if (slot.alive) {
+                f(PoolHandle{i, slot.generation}, slot.value);
+            }
+        }
+    }
+
+    template <typename F>
+    void forEach(F&& f) const {
+        const_cast<ObjectPool*>(this)->forEach([&](PoolHandle handle, T& value) { f(handle, static_cast<const T&>(value)); });
+    }
+
+    uint32_t size() const noexcept {
+        return _stats.live;
+    }
+
+    bool empty() const noexcept {
+        return _stats.live == 0;
+    }
+
+    const PoolStats& stats() const noexcept {
+        return _stats;
+    }
+
+private:
+    static Block allocateBlock() {
+        auto* slots = static_cast<Slot*>(::operator new[](sizeof(Slot) * BLOCK_SIZE, std::align_val_t(CACHE_LINE_SIZE)));
+        std::uninitialized_fill_n(slots, BLOCK_SIZE, Slot{T{}, 0, NO_SLOT, false});
+        return Block(slots);
+    }
+
+    void addBlock() {
+        blocks.push_back(allocateBlock());
+        _stats.capacity += BLOCK_SIZE;
+        _stats.blocks++;
+    }
+
+    Slot& slotAt(uint32_t index) noexcept {
+        return blocks[index / BLOCK_SIZE][index % BLOCK_SIZE];
+    }
+
+    const Slot& slotAt(uint32_t index) const noexcept {
+        return blocks[index / BLOCK_SIZE][index % BLOCK_SIZE];
+    }
+
+    void release(uint32_t index) noexcept {
+        Slot& slot = slotAt(index);
+        slot.alive = false;
+        slot.generation++;
+        slot.nextFree = freeHead;
+        freeHead = index;
+        _stats.live--;
+        _stats.despawns++;
+    }
+};
@@ -0,0 +1,151 @@
+#include "profiler.h"
+
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "../platform/time.h"
+
+std::atomic<bool> profilerRunning{false};
+
+static std::mutex registryMutex;
+static std::vector<ProfilerThreadBuffer*> registry{};
+static uint32_t nextThreadId = 1;
+
+static std::mutex fileMutex;
+static FILE* traceFile = nullptr;
+static bool firstEvent = true;
+static uint64_t traceStartNs = 0;
+
+static thread_local ProfilerThreadBuffer* threadBuffer = nullptr;
+
+uint64_t profilerNowNs() noexcept {
+    return monotonicNsecs();
+}
+
+ProfilerThreadBuffer& profilerThreadBuffer() {
+    if (threadBuffer == nullptr) {
+        // buffers are never freed so that zones of exited threads can still be flushed
+        auto* buffer = new ProfilerThreadBuffer;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->threadId = nextThreadId++;
+        registry.push_back(buffer);
+        threadBuffer = buffer;
+    }
+    return *threadBuffer;
+}
+
+void profilerSetThreadName(const char* name) {
+    ProfilerThreadBuffer& buffer = profilerThreadBuffer();
+    // profilerStop reads names from another thread, under the same lock
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.threadName = name;
+}
+
+static void writeSeparator() {
+    if (firstEvent) {
+        firstEvent = false;
+    } else {
+        std::fputs(",\n", traceFile);
+    }
+}
+
+static void writeThreadName(const ProfilerThreadBuffer& buffer) {
+    writeSeparator();
+    std::fprintf(
+        traceFile,
+        R"({"name":"thread_name","ph":"M","pid":1,"tid":%u,"args":{"name":"%s"}})",
+        buffer.threadId,
+        buffer.threadName != nullptr ? buffer.threadName : "thread"
+    );
+}
+
+static void drainBuffer(ProfilerThreadBuffer& buffer) {
+    uint64_t t = buffer.tail.load(std::memory_order_relaxed);
+    uint64_t h = buffer.head.load(std::memory_order_acquire);
+    for (; t != h; t++) {
+        const ProfileZoneRecord& record = buffer.records[t % ProfilerThreadBuffer::CAPACITY];
+        if (record.beginNs < traceStartNs) {
+            continue;
+        }
+        writeSeparator();
+        std::fprintf(
+            traceFile,
+            R"({"name":"%s","ph":"X","pid":1,"tid":%u,"ts":%.3f,"dur":%.3f})",
+            record.name,
+            buffer.threadId,
+            static_cast<double>(record.beginNs - traceStartNs) / 1000.0,
+            static_cast<double>(record.endNs - record.beginNs) / 1000.0
+        );
+    }
+    buffer.tail.store(h, std::memory_order_release);
+}
+
+bool profilerStart(const char* tracePath) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (traceFile != nullptr) {
+        return true;
+    }
+
+    traceFile = std::fopen(tracePath, "w");
+    if (traceFile == nullptr) {
+        return false;
+    }
+
+    // JSON array trace format, the closing bracket is written by profilerStop
+    std::fputs("[\n", traceFile);
+    firstEvent = true;
+    traceStartNs = profilerNowNs();
+
+    static bool exitHandlerRegistered = false;
+    if (!exitHandlerRegistered) {
+        std::atexit(profilerStop);
+        exitHandlerRegistered = true;
+    }
+
+    profilerRunning.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void profilerFlush() {
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    if (traceFile == nullptr) {
+        return;
+    }
+
+    std::vector<ProfilerThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers = registry;
+    }
+
+    for (auto* buffer : buffers) {
+        drainBuffer(*buffer);
+    }
+    std::fflush(traceFile);
+}
+
+void profilerStop() {
+    profilerRunning.store(false, std::memory_order_relaxed);
+    profilerFlush();
+
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    if (traceFile == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto* buffer : registry) {
+            writeThreadName(*buffer);
+            uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+            if (dropped != 0) {
+                std::fprintf(stderr, "profiler: thread %u dropped %llu zones\n", buffer->threadId, static_cast<unsigned long long>(dropped));
+            }
+        }
+    }
+
+    std::fputs("\n]\n", traceFile);
+    std::fclose(traceFile);
+    traceFile = nullptr;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+// Zones are compiled in for debug builds and for release builds configured with APP_PROFILING.
+#if !defined(NDEBUG) || defined(APP_PROFILING)
+#define APP_PROFILER_ENABLED
+#endif
+
+struct ProfileZoneRecord {
+    const char* name;
+    uint64_t beginNs;
+    uint64_t endNs;
+};
+
+// Single producer (owning thread) / single consumer (flusher) ring of finished zones.
+// When the ring is full new zones are dropped and counted instead of blocking the producer.
+class ProfilerThreadBuffer {
+public:
+    static inline constexpr uint32_t CAPACITY = 1 << 15;
+
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+
+    uint32_t threadId = 0;
+    // written and read under the registry lock
+    const char* threadName = nullptr;
+
+    ProfileZoneRecord records[CAPACITY];
+
+    void push(const char* name, uint64_t beginNs, uint64_t endNs) noexcept {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        records[h % CAPACITY] = {name, beginNs, endNs};
+        head.store(h + 1, std::memory_order_release);
+    }
+};
+
+extern std::atomic<bool> profilerRunning;
+
+uint64_t profilerNowNs() noexcept;
+
+ProfilerThreadBuffer& profilerThreadBuffer();
+
+// Opens the trace file and starts recording. Flushes automatically at exit.
+bool profilerStart(const char* tracePath);
+
+// Drains every thread buffer into the trace file.
+void profilerFlush();
+
+void profilerStop();
+
+void profilerSetThreadName(const char* name);
+
+// Starts recording into $PROFILE_TRACE if it is set. No-op when zones are compiled out.
+inline void setupProfiler() {
+#ifdef APP_PROFILER_ENABLED
+    const char* tracePath = std::getenv("PROFILE_TRACE");
+    if (tracePath != nullptr && tracePath[0] != '\0') {
+        profilerStart(tracePath);
+    }
+#endif
+}
+
+class ProfileZone {
+    const char* name;
+    uint64_t beginNs;
+
+public:
+    explicit ProfileZone(const char* name) noexcept : name(name), beginNs(0) {
+        if (profilerRunning.load(std::memory_order_relaxed)) {
+            beginNs = profilerNowNs();
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+    ~ProfileZone() {
+        if (beginNs != 0 && profilerRunning.load(std::memory_order_relaxed)) {
+            profilerThreadBuffer().push(name, beginNs, profilerNowNs());
+        }
+    }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef APP_PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(_profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+#define PROFILE_THREAD_NAME(name) profilerSetThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bottom-left skyline rectangle packer. The skyline is the top edge of everything placed so far, stored as
+// horizontal segments from left to right that always cover the full width.
+class SkylinePacker {
+    struct Segment {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+    };
+
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    uint64_t _usedArea = 0;
+    std::vector<Segment> skyline{};
+
+public:
+    SkylinePacker() = default;
+
+    SkylinePacker(uint32_t width, uint32_t height) : _width(width), _height(height) {
+        skyline.push_back({0, 0, width});
+    }
+
+    uint32_t width() const noexcept {
+        return _width;
+    }
+
+    uint32_t height() const noexcept {
+        return _height;
+    }
+
+    // Fraction of the area covered by packed rectangles
+    float occupancy() const noexcept {
+        if (_width == 0 || _height == 0) {
+            return 0.0f;
+        }
+        return static_cast<float>(static_cast<double>(_usedArea) / (static_cast<double>(_width) * _height));
+    }
+
+    // Places a width x height rectangle where its top ends lowest, leftmost on ties. Returns false when it does not fit.
+    bool pack(uint32_t width, uint32_t height, uint32_t& outX, uint32_t& outY) {
+        if (width == 0 || height == 0 || width > _width || height > _height) {
+            return false;
+        }
+
+        size_t best = skyline.size();
+        uint32_t bestY = 0;
+        for (size_t i = 0; i < skyline.size(); i++) {
+            uint32_t y;
+            if (fits(i, width, height, y) && (best == skyline.size() || y < bestY)) {
+                best = i;
+                bestY = y;
+            }
+        }
+        if (best == skyline.size()) {
+            return false;
+        }
+
+        outX = skyline[best].x;
+        outY = bestY;
+        place(best, width, bestY + height);
+        _usedArea += static_cast<uint64_t>(width) * height;
+        return true;
+    }
+
+private:
+    // y is the lowest position a rectangle starting at segment index can rest on
+    bool fits(size_t index, uint32_t width, uint32_t height, uint32_t& y) const noexcept {
+        if (skyline[index].x + width > _width) {
+            return false;
+        }
+
+        y = 0;
+        uint32_t remaining = width;
+        for (size_t i = index; remaining > 0; i++) {
+            y = std::max(y, skyline[i].y);
+            if (y + height > _height) {
+                return false;
+            }
+            remaining -= std::min(remaining, skyline[i].width);
+        }
+        return true;
+    }
+
+    void place(size_t index, uint32_t width, uint32_t top) {
+        uint32_t x = skyline[index].x;
+        uint32_t end = x + width;
+        skyline.insert(skyline.begin() + static_cast<ptrdiff_t>(index), {x, top, width});
+
+        // cut the segments now below the new one
+        size_t i = index + 1;
+        while (i < skyline.size() && skyline[i].x < end) {
+            uint32_t segmentEnd = skyline[i].x + skyline[i].width;
+            if (segmentEnd <= end) {
+                skyline.erase(skyline.begin() + static_cast<ptrdiff_t>(i));
+            } else {
+                skyline[i].width = segmentEnd - end;
+                skyline[i].x = end;
+                break;
+            }
+        }
+
+        for (size_t j = 0; j + 1 < skyline.size();) {
+            if (skyline[j].y == skyline[j + 1].y) {
+                skyline[j].width += skyline[j + 1].width;
+                skyline.erase(skyline.begin() + static_cast<ptrdiff_t>(j + 1));
+            } else {
+                j++;
+            }
+        }
+    }
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Fixed capacity single producer / single consumer queue. Never allocates, push fails when full.
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "elements are copied in and out of the ring");
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> head{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> tail{0};
+    alignas(CACHE_LINE_SIZE) T items[N];
+
+public:
+    static inline constexpr uint32_t CAPACITY = N;
+
+    // producer side
+    bool push(const T& item) noexcept {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        items[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    bool pop(T& item) noexcept {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, does not remove the element
+    const T* peek() const noexcept {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &items[t & (N - 1)];
+    }
+
+    uint32_t size() const noexcept {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const noexcept {
+        return size() == 0;
+    }
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single writer / single reader triple buffer. The writer always has a private slot to fill,
+// the reader always gets the most recently published slot, and neither side ever waits for the other.
+template <typename T>
+class TripleBuffer {
+    static inline constexpr uint8_t INDEX_MASK = 0b011;
+    static inline constexpr uint8_t FRESH_BIT = 0b100;
+
+    T slots[3]{};
+
+    // index of the slot between writer and reader, FRESH_BIT is set when the reader has not seen it yet
+    std::atomic<uint8_t> middle{1};
+    uint8_t back = 0;
+    uint8_t front = 2;
+
+public:
+    // writer side
+    T& writeBuffer() noexcept {
+        return slots[back];
+    }
+
+    void publish() noexcept {
+        uint8_t previous = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel);
+        back = previous & INDEX_MASK;
+    }
+
+    // reader side: swaps in the latest published slot, returns false if nothing new was published
+    bool update() noexcept {
+        if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0) {
+            return false;
+        }
+        uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const noexcept {
+        return slots[front];
+    }
+};
@@ -1,50 +1,60 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <vector>
 
 #include "glfw.h"
+#include "input_event.h"
+#include "platform/time.h"
+#include "util/spsc_ring.h"
 
-class KeyPressEvent {
-public:
-    int key;
-    int scancode;
-    int action;
-    int mods;
-
-    KeyPressEvent(int key, int scancode, int action, int mods) : key(key), scancode(scancode), action(action), mods(mods) {}
-};
+inline constexpr uint32_t INPUT_QUEUE_CAPACITY = 1024;
 
 class WindowData {
 public:
-    bool resized = false;
-    std::vector<KeyPressEvent> keyPressEvents;
+    std::atomic<bool> resized{false};
+    SpscRing<InputEvent, INPUT_QUEUE_CAPACITY> inputEvents;
+    std::atomic<uint64_t> droppedInputEvents{0};
 
     double cursorPosX = 0.0;
     double cursorPosY = 0.0;
 
-    void emitKeyPress(int key, int scancode, int action, int mods) {
-        if (keyPressEvents.size() > 50) { // TODO: fix
-            return;
+    // window size packed as (width << 32 | height), written by the event thread and read by the renderer
+    std::atomic<uint64_t> windowExtent{0};
+
+    void setWindowExtent(int width, int height) noexcept {
+        windowExtent.store(static_cast<uint64_t>(static_cast<uint32_t>(width)) << 32 | static_cast<uint32_t>(height), std::memory_order_release);
+    }
+
+    void emit(const InputEvent& event) noexcept {
+        if (!inputEvents.push(event)) {
+            droppedInputEvents.fetch_add(1, std::memory_order_relaxed);
         }
-        keyPressEvents.emplace_back(key, scancode, action, mods);
     }
 };
 
 inline void framebufferSizeCallback(GLFWwindow* window, int width, int height) noexcept {
     auto* data = reinterpret_cast<WindowData*>(glfwGetWindowUserPointer(window));
-    data->resized = true;
+    data->resized.store(true, std::memory_order_release);
+    data->emit(InputEvent::makeResize(monotonicNsecs(), width, height));
+}
+
+inline void windowSizeCallback(GLFWwindow* window, int width, int height) noexcept {
+    auto* data = reinterpret_cast<WindowData*>(glfwGetWindowUserPointer(window));
+    data->setWindowExtent(width, height);
 }
 
 inline void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) noexcept {
     auto* data = reinterpret_cast<WindowData*>(glfwGetWindowUserPointer(window));
-    data->emitKeyPress(key, scancode, action, mods);
+    data->emit(InputEvent::makeKey(monotonicNsecs(), key, scancode, action, mods));
 }
 
 inline void cursorPosCallback(GLFWwindow* window, double xPos, double yPos) {
     auto* data = reinterpret_cast<WindowData*>(glfwGetWindowUserPointer(window));
     data->cursorPosX = xPos;
     data->cursorPosY = yPos;
+    data->emit(InputEvent::makeCursor(monotonicNsecs(), xPos, yPos));
 }
 
 class CursorCoords {
@@ -75,8 +85,13 @@ public:
             throw std::runtime_error("failed to create window");
         }
 
+        int windowWidth, windowHeight;
+        glfwGetWindowSize(handle, &windowWidth, &windowHeight);
+        data->setWindowExtent(windowWidth, windowHeight);
+
         glfwSetWindowUserPointer(handle, data);
         glfwSetFramebufferSizeCallback(handle, framebufferSizeCallback);
+        glfwSetWindowSizeCallback(handle, windowSizeCallback);
         glfwSetKeyCallback(handle, keyCallback);
         glfwSetCursorPosCallback(handle, cursorPosCallback);
 
@@ -96,20 +111,37 @@ public:
     }
 
     bool wasResized() const noexcept {
-        return data != nullptr && data->resized;
+        return data != nullptr && data->resized.load(std::memory_order_acquire);
     }
 
     void resetResized() noexcept {
         if (data != nullptr) {
-            data->resized = false;
+            data->resized.store(false, std::memory_order_release);
         }
     }
 
-    std::vector<KeyPressEvent>& keyEvents() {
+    // Consumer side of the input queue, may be called from a thread other than the one polling events
+    bool pollInputEvent(InputEvent& event) {
         if (data == nullptr) {
             throw std::runtime_error("window data is not initialized");
         }
-        return data->keyPressEvents;
+        return data->inputEvents.pop(event);
+    }
+
+    // Same as pollInputEvent, but leaves events that happened after timestampNs in the queue
+    bool pollInputEventUntil(uint64_t timestampNs, InputEvent& event) {
+        if (data == nullptr) {
+            throw std::runtime_error("window data is not initialized");
+        }
+        const InputEvent* next = data->inputEvents.peek();
+        if (next == nullptr || next->timestampNs > timestampNs) {
+            return false;
+        }
+        return data->inputEvents.pop(event);
+    }
+
+    uint64_t droppedInputEvents() const noexcept {
+        return data != nullptr ? data->droppedInputEvents.load(std::memory_order_relaxed) : 0;
     }
 
     CursorCoords cursor() {
@@ -119,10 +151,15 @@ public:
         return {data->cursorPosX, data->cursorPosY};
     }
 
+    // Safe to call from any thread, glfwGetWindowSize is restricted to the main thread
     VkExtent2D getWindowExtent() const noexcept {
-        int width, height;
-        glfwGetWindowSize(handle, &width, &height);
-        return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        if (data == nullptr) {
+            int width, height;
+            glfwGetWindowSize(handle, &width, &height);
+            return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        }
+        uint64_t extent = data->windowExtent.load(std::memory_order_acquire);
+        return {static_cast<uint32_t>(extent >> 32), static_cast<uint32_t>(extent)};
     }
 
     std::vector<const char*> getRequiredVulkanExtensions() const {
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "agent/platformer_agent.h"
+#include "platform/time.h"
+
+// usage: agent_bench [--agents N] [--steps N] [--steps-per-call N] [level file]
+//
+// Drives the agent C interface the way a training loop would: random actions, every observation written. Runs once
+// with a single agent and once with N batched agents and prints steps per second for both, where a step is one tick
+// of one agent including its observation.
+
+struct BenchOptions {
+    uint32_t agents = 256;
+    uint32_t steps = 20000;
+    uint32_t stepsPerCall = 64;
+    std::string levelPath{};
+};
+
+static BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> uint32_t {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        };
+        if (strcmp(argv[i], "--agents") == 0) {
+            options.agents = std::max<uint32_t>(value(), 1);
+        } else if (strcmp(argv[i], "--steps") == 0) {
+            options.steps = value();
+        } else if (strcmp(argv[i], "--steps-per-call") == 0) {
+            options.stepsPerCall = std::max<uint32_t>(value(), 1);
+        } else if (argv[i][0] == '-') {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        } else {
+            options.levelPath = argv[i];
+        }
+    }
+    return options;
+}
+
+static void check(int result) {
+    if (result != 0) {
+        throw std::runtime_error(platformerAgentLastError());
+    }
+}
+
+// returns agent steps per second
+static double run(const BenchOptions& options, uint32_t agents, uint32_t ticks) {
+    PlatformerAgentConfig config;
+    check(platformerAgentDefaultConfig(&config));
+    config.agents = agents;
+    PlatformerAgentEnv* env = platformerAgentCreate(options.levelPath.empty() ? nullptr : options.levelPath.c_str(), &config);
+    if (env == nullptr) {
+        throw std::runtime_error(platformerAgentLastError());
+    }
+
+    PlatformerAgentLayout layout;
+    check(platformerAgentGetLayout(env, &layout));
+    std::vector<uint8_t> actions(static_cast<size_t>(options.stepsPerCall) * agents);
+    std::vector<float> observations(static_cast<size_t>(options.stepsPerCall) * agents * layout.size);
+
+    uint32_t random = 0x2545f491;
+    uint64_t elapsedNs = 0;
+    check(platformerAgentReset(env, observations.data()));
+    for (uint32_t done = 0; done < ticks;) {
+        uint32_t steps = std::min(options.stepsPerCall, ticks - done);
+        // held keys with the occasional jump, produced outside the timed call like a policy would be
+        for (size_t i = 0; i < static_cast<size_t>(steps) * agents; i++) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            actions[i] = static_cast<uint8_t>(random % 3 == 0 ? PLATFORMER_AGENT_LEFT : PLATFORMER_AGENT_RIGHT);
+            if (random % 29 == 0) {
+                actions[i] |= PLATFORMER_AGENT_JUMP;
+            }
+        }
+
+        uint64_t start = monotonicNsecs();
+        check(platformerAgentStep(env, actions.data(), steps, observations.data()));
+        elapsedNs += monotonicNsecs() - start;
+        done += steps;
+    }
+    platformerAgentDestroy(env);
+
+    return static_cast<double>(agents) * ticks / (static_cast<double>(elapsedNs) / NSECS_PER_SEC);
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options = parseOptions(argc, argv);
+
+        PlatformerAgentConfig config;
+        check(platformerAgentDefaultConfig(&config));
+        std::cout << "observation: " << config.maxSolids << " solids within " << config.solidRadius << ", " << config.gridSize << "x"
+                  << config.gridSize << " occupancy, " << options.stepsPerCall << " steps per call" << std::endl;
+
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "single agent: " << run(options, 1, options.steps) << " steps/s" << std::endl;
+        // roughly the same amount of work as the single agent run
+        uint32_t batchedTicks = std::max<uint32_t>(options.steps / options.agents, 1);
+        std::cout << options.agents << " batched agents: " << run(options, options.agents, batchedTicks) << " steps/s" << std::endl;
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
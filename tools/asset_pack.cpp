@@ -0,0 +1,89 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "util/asset_archive.h"
+
+// usage:
+//   asset_pack [--lz4] <archive> <name>=<path>...
+//   asset_pack --list <archive>
+//
+// Assets are looked up by name at runtime, the path is only where the packer reads them from.
+
+static std::vector<uint8_t> readBytes(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("failed to open file " + path);
+    }
+    return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+}
+
+static void pack(const std::string& outputPath, bool compress, const std::vector<std::string>& assets) {
+    AssetArchiveBuilder builder;
+    uint64_t inputBytes = 0;
+    for (const auto& asset : assets) {
+        size_t separator = asset.find('=');
+        if (separator == std::string::npos || separator == 0) {
+            throw std::runtime_error("expected <name>=<path>, got " + asset);
+        }
+        auto bytes = readBytes(asset.substr(separator + 1));
+        inputBytes += bytes.size();
+        builder.add(asset.substr(0, separator), bytes, compress);
+    }
+    std::vector<uint8_t> bytes = builder.serialize();
+
+    // every asset has to read back
+    auto archive = AssetArchive::fromBytes(bytes);
+    for (uint32_t i = 0; i < archive->size(); i++) {
+        archive->read(archive->entry(i));
+    }
+
+    std::ofstream output(outputPath, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!output) {
+        throw std::runtime_error("failed to write file " + outputPath);
+    }
+
+    std::cout << outputPath << ": " << assets.size() << " assets, " << inputBytes << " bytes packed into " << bytes.size() << " bytes" << std::endl;
+}
+
+static void list(const std::string& path) {
+    auto archive = AssetArchive::open(path);
+    for (uint32_t i = 0; i < archive->size(); i++) {
+        const AssetEntry& entry = archive->entry(i);
+        std::cout << archive->name(entry) << ": " << entry.size << " bytes";
+        if (entry.compression == ASSET_COMPRESSION_LZ4) {
+            std::cout << ", lz4 " << entry.storedSize << " bytes";
+        }
+        std::cout << '\n';
+    }
+    std::cout << std::flush;
+}
+
+int main(int argc, char** argv) {
+    try {
+        if (argc == 3 && strcmp(argv[1], "--list") == 0) {
+            list(argv[2]);
+        } else if (argc >= 2) {
+            bool compress = strcmp(argv[1], "--lz4") == 0;
+            int first = compress ? 2 : 1;
+            if (argc <= first) {
+                throw std::runtime_error("missing archive path");
+            }
+            pack(argv[first], compress, std::vector<std::string>(argv + first + 1, argv + argc));
+        } else {
+            std::cerr << "usage: asset_pack [--lz4] <archive> <name>=<path>...\n"
+                      << "       asset_pack --list <archive>" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
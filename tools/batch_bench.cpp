@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench_arena.h"
+#include "game/game.h"
+#include "game/level.h"
+#include "game/world_batch.h"
+#include "platform/time.h"
+
+// usage: batch_bench [--instances N] [--ticks N] [--rate HZ] [--no-verify] [level file]
+//
+// Steps N players on one level with random inputs, once as N separate Games and once as a WorldBatch, checks that
+// both end up with bit-identical players after every tick and prints the throughput of each in instance-ticks per
+// second.
+
+struct BenchOptions {
+    uint32_t instances = 4096;
+    uint32_t ticks = 600;
+    uint32_t tickRate = 60;
+    bool verify = true;
+    std::string levelPath{};
+};
+
+static BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> uint32_t {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        };
+        if (strcmp(argv[i], "--instances") == 0) {
+            options.instances = value();
+        } else if (strcmp(argv[i], "--ticks") == 0) {
+            options.ticks = value();
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.tickRate = std::max<uint32_t>(value(), 1);
+        } else if (strcmp(argv[i], "--no-verify") == 0) {
+            options.verify = false;
+        } else if (argv[i][0] == '-') {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        } else {
+            options.levelPath = argv[i];
+        }
+    }
+    return options;
+}
+
+static bool sameBits(float a, float b) {
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options = parseOptions(argc, argv);
+        std::shared_ptr<const Level> level = options.levelPath.empty() ? arenaLevel() : Level::map(options.levelPath);
+        float delta = 1000.0f / static_cast<float>(options.tickRate);
+
+        std::vector<Game> games;
+        games.reserve(options.instances);
+        for (uint32_t i = 0; i < options.instances; i++) {
+            games.emplace_back(level);
+        }
+        WorldBatch batch(level, options.instances);
+
+        std::vector<uint32_t> seeds(options.instances);
+        for (uint32_t i = 0; i < options.instances; i++) {
+            seeds[i] = 0x9e3779b9u * (i + 1);
+        }
+        std::vector<uint32_t> inputs(options.instances);
+
+        uint64_t gameNs = 0;
+        uint64_t batchNs = 0;
+        for (uint32_t tick = 0; tick < options.ticks; tick++) {
+            // inputs are held for a few ticks like real key presses
+            for (uint32_t i = 0; i < options.instances; i++) {
+                uint32_t r = nextRandom(seeds[i]);
+                if (r % 8 == 0) {
+                    inputs[i] = (r >> 8) % 4;
+                }
+                bool left = (inputs[i] & 1) != 0;
+                bool right = (inputs[i] & 2) != 0;
+                bool jump = (r >> 16) % 24 == 0;
+
+                games[i].moveLeft = left;
+                games[i].moveRight = right;
+                batch.setInput(i, left, right);
+                if (jump) {
+                    games[i].playerJump();
+                    batch.jump(i);
+                }
+            }
+
+            uint64_t start = monotonicNsecs();
+            for (auto& game : games) {
+                game.process(delta);
+            }
+            uint64_t middle = monotonicNsecs();
+            batch.process(delta);
+            uint64_t end = monotonicNsecs();
+            gameNs += middle - start;
+            batchNs += end - middle;
+
+            if (!options.verify) {
+                continue;
+            }
+            for (uint32_t i = 0; i < options.instances; i++) {
+                const Player& player = games[i].world.player();
+                Vec2 pos = batch.pos(i);
+                Vec2 vel = batch.vel(i);
+                if (!sameBits(player.pos().x, pos.x) || !sameBits(player.pos().y, pos.y) || !sameBits(player.vel().x, vel.x)
+                    || !sameBits(player.vel().y, vel.y) || player.isOnGround() != batch.isOnGround(i)) {
+                    std::cerr << std::setprecision(9) << "instance " << i << " diverged at tick " << tick << ": game pos (" << player.pos().x
+                              << ", " << player.pos().y << ") vel (" << player.vel().x << ", " << player.vel().y << "), batch pos (" << pos.x
+                              << ", " << pos.y << ") vel (" << vel.x << ", " << vel.y << ")" << std::endl;
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+
+        double instanceTicks = static_cast<double>(options.instances) * options.ticks;
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << options.instances << " instances, " << options.ticks << " ticks at " << options.tickRate << " Hz, "
+                  << level->geometry().solids.count << " solids" << (options.verify ? ", bit-identical" : "") << "\n";
+        std::cout << "games: " << instanceTicks / (static_cast<double>(gameNs) / NSECS_PER_SEC) << " instance-ticks/s\n";
+        std::cout << "batch: " << instanceTicks / (static_cast<double>(batchNs) / NSECS_PER_SEC) << " instance-ticks/s" << std::endl;
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
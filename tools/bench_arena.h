@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "game/level.h"
+
+// What the benches that step many players on one level share.
+
+// floor, walls, ledges and a tile staircase, so that players hit every kind of contact
+inline std::shared_ptr<const Level> arenaLevel() {
+    LevelDescription description;
+    description.solids.emplace_back(-1000, 3000, 0, 100);
+    description.solids.emplace_back(-1100, -1000, 0, 2000);
+    description.solids.emplace_back(3000, 3100, 0, 2000);
+    description.solids.emplace_back(200, 600, 350, 400);
+    description.solids.emplace_back(900, 1000, 100, 500);
+    description.solids.emplace_back(1400, 2000, 300, 340);
+    description.tileOriginX = 2000.0f;
+    description.tileOriginY = 100.0f;
+    description.tileSize = 50.0f;
+    for (int32_t step = 0; step < 10; step++) {
+        for (int32_t ty = 0; ty <= step; ty++) {
+            description.tiles.push_back({step * 2, ty, 'A', true});
+            description.tiles.push_back({step * 2 + 1, ty, 'A', true});
+        }
+    }
+    description.spawns.push_back({150, 300});
+    return Level::build(description);
+}
+
+// xorshift, seeded per instance so that every run sees the same inputs
+inline uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
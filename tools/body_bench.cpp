@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "game/game.h"
+#include "game/sweep_and_prune.h"
+
+// usage: body_bench [--bodies N] [--ticks N] [--rate HZ] [--triggers N]
+//
+// Drops N bodies in a grid into a walled arena with random pushes, so that they pile up and keep bumping into each
+// other, and reports the broadphase pairs, contacts and sort-and-sweep time per tick. Every second of game time the
+// pairs are checked against testing every two boxes. Trigger zones scattered over the arena report their enter and
+// exit events, drained every tick like gameplay would.
+
+struct BenchOptions {
+    uint32_t bodies = 1000;
+    uint32_t ticks = 600;
+    uint32_t tickRate = 60;
+    uint32_t triggers = 200;
+};
+
+static BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> const char* {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return argv[++i];
+        };
+        if (strcmp(argv[i], "--bodies") == 0) {
+            options.bodies = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--ticks") == 0) {
+            options.ticks = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.tickRate = std::max<uint32_t>(static_cast<uint32_t>(std::strtoul(value(), nullptr, 10)), 1);
+        } else if (strcmp(argv[i], "--triggers") == 0) {
+            options.triggers = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        }
+    }
+    return options;
+}
+
+// a floor and two walls around columns of bodies 150 apart, the player stands in the bottom left corner
+static void populate(World& world, uint32_t count, uint32_t triggers) {
+    const uint32_t COLUMNS = 40;
+    float width = COLUMNS * 150.0f + 100.0f;
+    world.objects.clear();
+    world.objects.emplace_back(-1000.0f, width + 1000.0f, -1000.0f, 0.0f);
+    world.objects.emplace_back(-1000.0f, 0.0f, 0.0f, 100000.0f);
+    world.objects.emplace_back(width, width + 1000.0f, 0.0f, 100000.0f);
+    world.player().setPos(100.0f, 50.0f);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> push(-0.5f, 0.5f);
+    for (uint32_t i = 0; i < count; i++) {
+        Vec2 pos(static_cast<float>(i % COLUMNS) * 150.0f + 200.0f, static_cast<float>(i / COLUMNS) * 150.0f + 250.0f);
+        Vec2 vel(push(random), push(random));
+        world.addBody(pos, vel);
+    }
+
+    std::uniform_real_distribution<float> x(0.0f, width - 300.0f);
+    std::uniform_real_distribution<float> y(0.0f, static_cast<float>(count / COLUMNS) * 150.0f + 300.0f);
+    // bodies start inside triggers, a few each
+    world.triggers.setEventCapacity((count + 1) * 4);
+    for (uint32_t i = 0; i < triggers; i++) {
+        Vec2 corner(x(random), y(random));
+        world.triggers.add({corner, corner + Vec2(300, 300)}, static_cast<TriggerKind>(i % 3), i);
+    }
+}
+
+// the broadphase's pairs have to be exactly the boxes that overlap or touch
+static void validatePairs(const SweepAndPrune& broadphase) {
+    const auto& boxes = broadphase.boxes();
+    std::vector<std::pair<uint32_t, uint32_t>> expected;
+    for (uint32_t a = 0; a < boxes.size(); a++) {
+        for (uint32_t b = a + 1; b < boxes.size(); b++) {
+            if (boxes[a].v0().x <= boxes[b].v1().x && boxes[b].v0().x <= boxes[a].v1().x && boxes[a].v0().y <= boxes[b].v1().y &&
+                boxes[b].v0().y <= boxes[a].v1().y) {
+                expected.emplace_back(a, b);
+            }
+        }
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> found;
+    for (uint32_t i = 0; i < broadphase.pairCount(); i++) {
+        found.emplace_back(broadphase.pairs()[i].a, broadphase.pairs()[i].b);
+    }
+    std::sort(found.begin(), found.end());
+    if (found != expected) {
+        throw std::runtime_error("broadphase found " + std::to_string(found.size()) + " pairs, brute force " + std::to_string(expected.size()));
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options = parseOptions(argc, argv);
+        float delta = 1000.0f / static_cast<float>(options.tickRate);
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << options.bodies << " bodies, " << options.ticks << " ticks at " << options.tickRate << " Hz" << std::endl;
+
+        for (ContactResolver resolver : {ContactResolver::SCALE, ContactResolver::SWEEP}) {
+            Game game(nullptr, {100, 50});
+            game.world.resolver = resolver;
+            populate(game.world, options.bodies, options.triggers);
+            const auto& broadphase = game.world.bodyBroadphase();
+
+            uint64_t pairs = 0, contacts = 0, broadphaseNs = 0, maxBroadphaseNs = 0;
+            uint32_t maxPairs = 0, validated = 0;
+            uint64_t start = monotonicNsecs();
+            for (uint32_t tick = 0; tick < options.ticks; tick++) {
+                game.process(delta);
+                // the last substep's tick
+                const auto& stats = game.world.bodyStats;
+                pairs += stats.pairs;
+                contacts += stats.contacts;
+                broadphaseNs += stats.broadphaseNs;
+                maxPairs = std::max(maxPairs, stats.pairs);
+                maxBroadphaseNs = std::max(maxBroadphaseNs, stats.broadphaseNs);
+                TriggerEvent event;
+                while (game.world.triggers.events().pop(event)) {
+                }
+                if (tick % options.tickRate == 0) {
+                    validatePairs(broadphase);
+                    validated++;
+                }
+            }
+            uint64_t ns = monotonicNsecs() - start;
+
+            std::cout << (resolver == ContactResolver::SCALE ? "scale: " : "sweep: ") << static_cast<double>(ns) / options.ticks / NSECS_PER_MSEC
+                      << " ms per tick, " << static_cast<double>(pairs) / options.ticks << " pairs (max " << maxPairs << "), "
+                      << static_cast<double>(contacts) / options.ticks << " contacts, broadphase "
+                      << static_cast<double>(broadphaseNs) / options.ticks / NSECS_PER_USEC << " us (max "
+                      << static_cast<double>(maxBroadphaseNs) / NSECS_PER_USEC << " us)\n";
+            std::cout << "  " << broadphase.stats().swaps << " endpoint swaps, " << broadphase.stats().pairBufferGrowths
+                      << " pair buffer growths, pairs matched brute force on " << validated << " ticks\n";
+            const TriggerStats& triggers = game.world.triggers.stats();
+            std::cout << "  " << options.triggers << " triggers: " << static_cast<double>(triggers.enters) / options.ticks << " enters, "
+                      << static_cast<double>(triggers.exits) / options.ticks << " exits per tick, " << triggers.dropped << " dropped\n";
+        }
+        std::cout.flush();
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
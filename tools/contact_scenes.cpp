@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "game/game.h"
+#include "game/level.h"
+#include "platform/time.h"
+
+// usage: contact_scenes
+//
+// Plays short scripted scenes that used to go wrong at box seams and corners, with each contact resolver and its
+// substep size, with and without adaptive substeps, and checks where the player ends up. Also checks after every tick
+// that the player never overlaps a solid, moving platforms included. Fails when the sweep resolver gets a scene wrong, the scale resolver's
+// failures are only reported. A fixed point landing has to succeed with every resolver.
+
+static constexpr float TICK_DELTA = 1000.0f / 60.0f;
+// how deep an overlap has to be to count, contacts themselves are touching
+static constexpr float OVERLAP_TOLERANCE = 0.01f;
+
+struct SceneInput {
+    bool left = false;
+    bool right = false;
+    bool jump = false;
+};
+
+struct Scene {
+    const char* name;
+    std::vector<Solid> objects;
+    std::shared_ptr<const Level> level;
+    Vec2 spawn;
+    uint32_t ticks;
+    // none for standing still
+    std::function<SceneInput(uint32_t tick, const Game& game)> input;
+    // nullptr when the player ended up where it should
+    std::function<const char*(const Game& game)> check;
+    // adds kinematic bodies or triggers, none when empty
+    std::function<void(World& world)> setup{};
+};
+
+static bool near(float a, float b) {
+    return std::abs(a - b) <= OVERLAP_TOLERANCE;
+}
+
+static SceneInput holdRight(uint32_t, const Game&) {
+    return {false, true, false};
+}
+
+static SceneInput holdLeft(uint32_t, const Game&) {
+    return {true, false, false};
+}
+
+// one row of tiles from x 0 to 2000, its top at y 100
+static std::shared_ptr<const Level> tileFloor() {
+    LevelDescription description;
+    description.tileOriginX = 0.0f;
+    description.tileOriginY = 50.0f;
+    description.tileSize = 50.0f;
+    for (int32_t tx = 0; tx < 40; tx++) {
+        description.tiles.push_back({tx, 0, 'A', true});
+    }
+    return Level::build(description);
+}
+
+// a single body waiting at its rest box for SHUTTLE_PAUSE, then moving to offset in duration milliseconds and back.
+// The pause lets a rider standing on it from the start be found before it moves.
+static constexpr float SHUTTLE_PAUSE = 250.0f;
+
+static std::function<void(World&)> shuttle(AABB rest, Vec2 offset, float duration) {
+    return [=](World& world) {
+        KinematicPath path;
+        path.waypoints = {{{0, 0}, SHUTTLE_PAUSE}, {{0, 0}, duration}, {offset, duration}};
+        world.kinematics.add(rest, world.kinematics.addPath(std::move(path)));
+    };
+}
+
+static const char* ridingCheck(const Game& game, Vec2 expectedOffset) {
+    const World& world = game.world;
+    if (world.riding != 0) {
+        return "not riding";
+    }
+    Vec2 offset = world.player().pos() - world.kinematics.bodies()[0].aabb.v0();
+    return near(offset.x, expectedOffset.x) && near(offset.y, expectedOffset.y) ? nullptr : "slid on the platform";
+}
+
+static std::vector<Scene> scenes() {
+    std::vector<Scene> scenes;
+
+    auto acrossSeam = [](const Game& game) -> const char* {
+        const Player& player = game.world.player();
+        if (player.pos().x < 1500.0f) {
+            return "stopped at the seam";
+        }
+        return near(player.pos().y, 150.0f) && player.isOnGround() ? nullptr : "left the floor";
+    };
+    scenes.push_back({"floor seam", {{0, 1000, 0, 100}, {1000, 3000, 0, 100}}, nullptr, {300, 150}, 120, holdRight, acrossSeam});
+    scenes.push_back({"floor seam, reversed order", {{1000, 3000, 0, 100}, {0, 1000, 0, 100}}, nullptr, {300, 150}, 120, holdRight, acrossSeam});
+    scenes.push_back({"floor seam, falling onto it", {{0, 1000, 0, 100}, {1000, 3000, 0, 100}}, nullptr, {700, 400}, 120, holdRight, acrossSeam});
+
+    scenes.push_back({"tile floor", {}, tileFloor(), {100, 150}, 120, holdRight, [](const Game& game) -> const char* {
+                          const Player& player = game.world.player();
+                          if (player.pos().x < 1400.0f) {
+                              return "stopped at a tile edge";
+                          }
+                          return near(player.pos().y, 150.0f) ? nullptr : "left the floor";
+                      }});
+    scenes.push_back({"tile floor, walking left", {}, tileFloor(), {1900, 150}, 120, holdLeft, [](const Game& game) -> const char* {
+                          return game.world.player().pos().x > 600.0f ? "stopped at a tile edge" : nullptr;
+                      }});
+
+    // stacked wall boxes with a seam at y 300, jumping while pressing into them
+    scenes.push_back({"wall seam", {{-1000, 3000, 0, 100}, {500, 600, 100, 300}, {500, 600, 300, 1000}}, nullptr, {449, 150}, 90,
+                      [](uint32_t tick, const Game&) { return SceneInput{false, true, tick == 1}; },
+                      [](const Game& game) -> const char* {
+                          const Player& player = game.world.player();
+                          if (!near(player.pos().x, 450.0f)) {
+                              return "not against the wall";
+                          }
+                          return near(player.pos().y, 150.0f) ? nullptr : "did not land";
+                      }});
+    scenes.push_back({"wall seam, peak", {{-1000, 3000, 0, 100}, {500, 600, 100, 300}, {500, 600, 300, 1000}}, nullptr, {449, 150}, 28,
+                      [](uint32_t tick, const Game&) { return SceneInput{false, true, tick == 1}; },
+                      [](const Game& game) -> const char* {
+                          // a free jump peaks about 625 above the floor
+                          return game.world.player().pos().y < 700.0f ? "caught on the seam" : nullptr;
+                      }});
+
+    scenes.push_back({"inner corner", {{-1000, 3000, 0, 100}, {800, 900, 100, 1000}}, nullptr, {300, 150}, 120, holdRight,
+                      [](const Game& game) -> const char* {
+                          const Player& player = game.world.player();
+                          if (!near(player.pos().x, 750.0f)) {
+                              return "not against the wall";
+                          }
+                          return near(player.pos().y, 150.0f) && player.isOnGround() ? nullptr : "not on the floor";
+                      }});
+
+    // jumping right at a ledge whose top is lower than the peak, the player has to get on top of it
+    scenes.push_back({"ledge corner", {{-1000, 3000, 0, 100}, {600, 3000, 100, 400}}, nullptr, {300, 150}, 120,
+                      [](uint32_t tick, const Game& game) {
+                          const Player& player = game.world.player();
+                          return SceneInput{false, true, tick > 10 && player.isOnGround() && player.pos().x < 600.0f};
+                      },
+                      [](const Game& game) -> const char* {
+                          const Player& player = game.world.player();
+                          if (player.pos().x < 1000.0f) {
+                              return "did not get onto the ledge";
+                          }
+                          return near(player.pos().y, 450.0f) ? nullptr : "not on the ledge";
+                      }});
+
+    // falling straight down with the player's side exactly in line with a box's side, it only touches the box
+    auto fallAlongside = [](const Game& game) -> const char* {
+        return near(game.world.player().pos().y, 50.0f) ? nullptr : "caught on the corner";
+    };
+    scenes.push_back({"outer corner, falling past the left", {{-1000, 3000, -100, 0}, {500, 700, 0, 200}}, nullptr, {450, 400}, 60, {},
+                      fallAlongside});
+    scenes.push_back({"outer corner, falling past the right", {{-1000, 3000, -100, 0}, {500, 700, 0, 200}}, nullptr, {750, 400}, 60, {},
+                      fallAlongside});
+    // one unit further in and it lands on the box
+    scenes.push_back({"outer corner, landing on the edge", {{-1000, 3000, -100, 0}, {500, 700, 0, 200}}, nullptr, {451, 400}, 60, {},
+                      [](const Game& game) -> const char* {
+                          return near(game.world.player().pos().y, 250.0f) ? nullptr : "slipped off the edge";
+                      }});
+
+    // a 1 unit thick platform hit at the fastest fall
+    scenes.push_back({"thin platform", {{-1000, 3000, 0, 1}}, nullptr, {300, 3000}, 240, {},
+                      [](const Game& game) -> const char* { return near(game.world.player().pos().y, 51.0f) ? nullptr : "fell through"; }});
+
+    scenes.push_back({"elevator", {}, nullptr, {400, 100}, 90, {},
+                      [](const Game& game) { return ridingCheck(game, {200, 100}); }, shuttle({200, 600, 0, 50}, {0, 600}, 2000)});
+    scenes.push_back({"elevator, landing while it rises", {}, nullptr, {400, 700}, 90, {},
+                      [](const Game& game) { return ridingCheck(game, {200, 100}); }, shuttle({200, 600, 0, 50}, {0, 600}, 2000)});
+    scenes.push_back({"sideways platform", {}, nullptr, {200, 100}, 150, {},
+                      [](const Game& game) { return ridingCheck(game, {200, 100}); }, shuttle({0, 400, 0, 50}, {1000, 0}, 1500)});
+    scenes.push_back({"platform pushing", {{-1000, 3000, -100, 0}}, nullptr, {300, 50}, 75, {},
+                      [](const Game& game) -> const char* {
+                          const Player& player = game.world.player();
+                          float pushed = game.world.kinematics.bodies()[0].aabb.v1().x + 50.0f;
+                          return near(player.pos().x, pushed) && near(player.pos().y, 50.0f) ? nullptr : "not pushed";
+                      },
+                      shuttle({-400, 0, 0, 200}, {600, 0}, 2000)});
+
+    // walking through a checkpoint and into a hazard has to go exactly like the floor seam scene without them
+    scenes.push_back({"trigger zones", {{0, 1000, 0, 100}, {1000, 3000, 0, 100}}, nullptr, {300, 150}, 120, holdRight,
+                      [acrossSeam](const Game& game) -> const char* {
+                          const TriggerStats& stats = game.world.triggers.stats();
+                          if (stats.enters != 2 || stats.exits != 1) {
+                              return "wrong trigger events";
+                          }
+                          return acrossSeam(game);
+                      },
+                      [](World& world) {
+                          world.triggers.add({500, 700, 100, 400}, TriggerKind::CHECKPOINT);
+                          world.triggers.add({1300, 5000, 100, 400}, TriggerKind::HAZARD);
+                          // never reached
+                          world.triggers.add({-500, -400, 100, 400}, TriggerKind::PICKUP);
+                      }});
+
+    return scenes;
+}
+
+static bool overlapsDeeply(const AABB& a, const AABB& b) {
+    float x = std::min(a.v1().x, b.v1().x) - std::max(a.v0().x, b.v0().x);
+    float y = std::min(a.v1().y, b.v1().y) - std::max(a.v0().y, b.v0().y);
+    return x > OVERLAP_TOLERANCE && y > OVERLAP_TOLERANCE;
+}
+
+static const char* play(const Scene& scene, ContactResolver resolver, bool adaptiveSubsteps, std::string& detail) {
+    Game game(scene.level, scene.spawn);
+    game.world.objects = scene.objects;
+    game.world.resolver = resolver;
+    game.adaptiveSubsteps = adaptiveSubsteps;
+    if (scene.setup) {
+        scene.setup(game.world);
+    }
+
+    for (uint32_t tick = 0; tick < scene.ticks; tick++) {
+        SceneInput input = scene.input ? scene.input(tick, game) : SceneInput{};
+        game.moveLeft = input.left;
+        game.moveRight = input.right;
+        if (input.jump) {
+            game.playerJump();
+        }
+        game.process(TICK_DELTA);
+
+        AABB player = game.world.player().aabb();
+        for (const auto& object : scene.objects) {
+            if (overlapsDeeply(player, object.aabb())) {
+                detail = "tick " + std::to_string(tick);
+                return "went into a solid";
+            }
+        }
+        for (const auto& body : game.world.kinematics.bodies()) {
+            if (overlapsDeeply(player, body.aabb)) {
+                detail = "tick " + std::to_string(tick);
+                return "went into a platform";
+            }
+        }
+        if (scene.level != nullptr) {
+            const auto& tiles = scene.level->geometry().tiles;
+            for (int32_t tx = 0; tx < 40; tx++) {
+                if (overlapsDeeply(player, tiles.tileAABB(tx, 0))) {
+                    detail = "tick " + std::to_string(tick);
+                    return "went into a tile";
+                }
+            }
+        }
+    }
+
+    const Player& player = game.world.player();
+    std::ostringstream position;
+    position << std::fixed << std::setprecision(2) << "at (" << player.pos().x << ", " << player.pos().y << ")";
+    detail = position.str();
+    return scene.check(game);
+}
+
+// Fixed rounds the move cut at a contact, the landing has to end exactly on the floor rather than a step into it, or
+// the next tick starts inside the floor and falls through. From this height the scale resolver used to.
+static const char* landFixed(ContactResolver resolver, bool adaptiveSubsteps, std::string& detail) {
+    FixedGame game(nullptr, {300.0f, 857.186f});
+    game.world.objects = {{Fixed(-1000), Fixed(3000), Fixed(0), Fixed(100)}};
+    game.world.resolver = resolver;
+    game.adaptiveSubsteps = adaptiveSubsteps;
+
+    for (uint32_t tick = 0; tick < 120; tick++) {
+        game.process(Fixed(TICK_DELTA));
+        if (game.world.player().pos().y < Fixed(150)) {
+            detail = "tick " + std::to_string(tick);
+            return "went into a solid";
+        }
+    }
+
+    const BasicPlayer<Fixed>& player = game.world.player();
+    std::ostringstream position;
+    position << std::fixed << std::setprecision(2) << "at (" << static_cast<float>(player.pos().x) << ", "
+             << static_cast<float>(player.pos().y) << ")";
+    detail = position.str();
+    return player.pos().y == Fixed(150) && player.isOnGround() ? nullptr : "not on the floor";
+}
+
+int main() {
+    struct Mode {
+        const char* name;
+        ContactResolver resolver;
+        bool adaptiveSubsteps;
+    };
+    const Mode modes[] = {
+        {"scale", ContactResolver::SCALE, false},
+        {"scale, adaptive", ContactResolver::SCALE, true},
+        {"sweep", ContactResolver::SWEEP, false},
+        {"sweep, adaptive", ContactResolver::SWEEP, true},
+    };
+
+    uint32_t sweepFailures = 0;
+    for (const auto& scene : scenes()) {
+        std::cout << scene.name << "\n";
+        for (const auto& mode : modes) {
+            std::string detail;
+            const char* failure = play(scene, mode.resolver, mode.adaptiveSubsteps, detail);
+            std::cout << "\t" << mode.name << ": " << (failure != nullptr ? failure : "ok") << ", " << detail << "\n";
+            if (failure != nullptr && mode.resolver == ContactResolver::SWEEP) {
+                sweepFailures++;
+            }
+        }
+    }
+
+    // every resolver has to get this one right
+    uint32_t fixedFailures = 0;
+    std::cout << "floor landing, fixed point\n";
+    for (const auto& mode : modes) {
+        std::string detail;
+        const char* failure = landFixed(mode.resolver, mode.adaptiveSubsteps, detail);
+        std::cout << "\t" << mode.name << ": " << (failure != nullptr ? failure : "ok") << ", " << detail << "\n";
+        if (failure != nullptr) {
+            fixedFailures++;
+        }
+    }
+
+    std::cout << "substeps per 60 Hz tick: scale " << static_cast<uint32_t>(TICK_DELTA / PHYSICS_SUBSTEP_DELTA_MAX) + 1 << ", sweep "
+              << static_cast<uint32_t>(TICK_DELTA / PHYSICS_SWEEP_SUBSTEP_DELTA_MAX) + 1 << std::endl;
+    if (sweepFailures != 0) {
+        std::cerr << sweepFailures << " scenes failed with the sweep resolver" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (fixedFailures != 0) {
+        std::cerr << fixedFailures << " modes failed the fixed point landing" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game/entity_store.h"
+#include "game/player.h"
+#include "platform/time.h"
+
+// usage: entity_bench [--entities N] [--iterations N] [--threads N]
+//
+// Moves N bodies stored as entities with World's body component, a quarter of them in a second archetype with an
+// extra component, and times it against the same update over a vector of Players, on one thread and split between threads by chunk. Then destroys
+// and recreates a quarter of them to time both and check that stale handles are refused.
+
+struct BenchOptions {
+    uint32_t entities = 1000000;
+    uint32_t iterations = 100;
+    uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+};
+
+static BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> uint32_t {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        };
+        if (strcmp(argv[i], "--entities") == 0) {
+            options.entities = value();
+        } else if (strcmp(argv[i], "--iterations") == 0) {
+            options.iterations = std::max<uint32_t>(value(), 1);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            options.threads = std::max<uint32_t>(value(), 1);
+        } else {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        }
+    }
+    return options;
+}
+
+// what the second archetype has on top of a body's components
+struct Lifetime {
+    float remaining;
+};
+
+static constexpr float DELTA = 1000.0f / 60.0f;
+
+// gravity and a floor at y 0, the same operations for both layouts
+static void move(Player& body) {
+    Vec2& pos = body.pos();
+    Vec2& vel = body.vel();
+    vel.y = std::max(vel.y - 0.005f * DELTA, -5.0f);
+    pos = pos + vel * DELTA;
+    body.setOnGround(pos.y <= 0.0f);
+    if (body.isOnGround()) {
+        pos.y = 0.0f;
+        vel.y = 2.5f;
+    }
+}
+
+static void moveChunk(EntityStore& store, const EntityChunk& chunk) {
+    store.forEach<Player>(chunk, [](Entity, Player& body) { move(body); });
+}
+
+static Vec2 start(uint32_t i) {
+    return {static_cast<float>(i % 1000), static_cast<float>(i % 997) * 3.0f};
+}
+
+static double checksum(const EntityStore& store) {
+    double sum = 0.0;
+    store.forEach<Player>([&](Entity entity, const Player& body) {
+        sum += static_cast<double>(body.pos().x) * (entity.index % 7 + 1) + body.pos().y;
+    });
+    return sum;
+}
+
+static double nsPerEntity(uint64_t ns, uint64_t count) {
+    return static_cast<double>(ns) / static_cast<double>(std::max<uint64_t>(count, 1));
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options = parseOptions(argc, argv);
+        std::cout << std::fixed << std::setprecision(3);
+        uint32_t perChunk = EntityStore::chunkCapacity<Player>();
+        std::cout << options.entities << " entities, " << options.iterations << " iterations, " << perChunk << " bodies per chunk" << std::endl;
+
+        std::vector<Player> players(options.entities);
+        EntityStore serial;
+        std::vector<Entity> entities(options.entities);
+        uint64_t begin = monotonicNsecs();
+        for (uint32_t i = 0; i < options.entities; i++) {
+            players[i].setPos(start(i));
+            players[i].setVel({1.0f, 0.0f});
+            entities[i] = i % 4 == 3 ? serial.create(players[i], Lifetime{1000.0f}) : serial.create(players[i]);
+        }
+        uint64_t createNs = monotonicNsecs() - begin;
+        EntityStore threaded = serial;
+
+        begin = monotonicNsecs();
+        for (uint32_t it = 0; it < options.iterations; it++) {
+            for (auto& player : players) {
+                move(player);
+            }
+        }
+        uint64_t playersNs = monotonicNsecs() - begin;
+
+        begin = monotonicNsecs();
+        for (uint32_t it = 0; it < options.iterations; it++) {
+            serial.forEach<Player>([](Entity, Player& body) { move(body); });
+        }
+        uint64_t serialNs = monotonicNsecs() - begin;
+
+        // workers take every threads-th chunk, chunks are the same size so that is an even split
+        std::vector<EntityChunk> chunks;
+        threaded.chunks<Player>(chunks);
+        begin = monotonicNsecs();
+        for (uint32_t it = 0; it < options.iterations; it++) {
+            std::vector<std::thread> workers;
+            for (uint32_t t = 0; t < options.threads; t++) {
+                workers.emplace_back([&, t] {
+                    for (size_t c = t; c < chunks.size(); c += options.threads) {
+                        moveChunk(threaded, chunks[c]);
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+        uint64_t threadedNs = monotonicNsecs() - begin;
+
+        double expected = 0.0;
+        for (uint32_t i = 0; i < options.entities; i++) {
+            expected += static_cast<double>(players[i].pos().x) * (entities[i].index % 7 + 1) + players[i].pos().y;
+        }
+        if (checksum(serial) != expected || checksum(threaded) != expected) {
+            throw std::runtime_error("entities moved differently from players");
+        }
+
+        uint64_t updates = static_cast<uint64_t>(options.entities) * options.iterations;
+        std::cout << "create: " << nsPerEntity(createNs, options.entities) << " ns per entity\n";
+        std::cout << "players vector: " << nsPerEntity(playersNs, updates) << " ns per update\n";
+        std::cout << "entities: " << nsPerEntity(serialNs, updates) << " ns per update, " << nsPerEntity(threadedNs, updates) << " on "
+                  << options.threads << " threads over " << chunks.size() << " chunks\n";
+
+        // destroying moves other entities around, their handles have to keep finding them
+        begin = monotonicNsecs();
+        for (uint32_t i = 0; i < options.entities; i += 4) {
+            serial.destroy(entities[i]);
+        }
+        uint64_t destroyNs = monotonicNsecs() - begin;
+        for (uint32_t i = 0; i < options.entities; i++) {
+            bool alive = i % 4 != 0;
+            if (serial.isAlive(entities[i]) != alive || (alive && !(serial.get<Player>(entities[i]).pos() == players[i].pos()))) {
+                throw std::runtime_error("entity " + std::to_string(i) + " lost after destroying others");
+            }
+        }
+        begin = monotonicNsecs();
+        uint32_t recreated = 0;
+        for (uint32_t i = 0; i < options.entities; i += 4) {
+            Player body;
+            body.setPos(start(i));
+            Entity entity = serial.create(body);
+            if (serial.isAlive(entities[i]) || !serial.isAlive(entity)) {
+                throw std::runtime_error("a stale handle reached a reused slot");
+            }
+            recreated++;
+        }
+        uint64_t recreateNs = monotonicNsecs() - begin;
+        std::cout << "destroy: " << nsPerEntity(destroyNs, recreated) << " ns, recreate: " << nsPerEntity(recreateNs, recreated)
+                  << " ns per entity, handles checked" << std::endl;
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
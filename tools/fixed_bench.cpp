@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench_arena.h"
+#include "game/game.h"
+#include "game/level.h"
+#include "platform/time.h"
+#include "util/hash.h"
+
+// usage: fixed_bench [--instances N] [--ticks N] [--rate HZ] [level file]
+//
+// Steps N players on one level with the same random inputs, once as float Games and once as FixedGames, and prints
+// the throughput of each in instance-ticks per second together with a hash of the final state. The fixed hash is the
+// same for every build of this tool on every platform, the float one may change with compiler, flags or CPU. Also
+// prints how far the two simulations drifted apart over the run, while both players stayed within FIXED_WORLD_LIMIT.
+
+struct BenchOptions {
+    uint32_t instances = 2048;
+    uint32_t ticks = 600;
+    uint32_t tickRate = 60;
+    std::string levelPath{};
+};
+
+static BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> uint32_t {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        };
+        if (strcmp(argv[i], "--instances") == 0) {
+            options.instances = value();
+        } else if (strcmp(argv[i], "--ticks") == 0) {
+            options.ticks = value();
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.tickRate = std::max<uint32_t>(value(), 1);
+        } else if (argv[i][0] == '-') {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        } else {
+            options.levelPath = argv[i];
+        }
+    }
+    return options;
+}
+
+template <typename T>
+static uint64_t hashPlayer(const BasicPlayer<T>& player, uint64_t hash) {
+    hash = fnv1aValue(player.pos(), hash);
+    hash = fnv1aValue(player.vel(), hash);
+    return fnv1aValue(player.isOnGround(), hash);
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options = parseOptions(argc, argv);
+        std::shared_ptr<const Level> level = options.levelPath.empty() ? arenaLevel() : Level::map(options.levelPath);
+        float delta = 1000.0f / static_cast<float>(options.tickRate);
+        Fixed fixedDelta(delta);
+
+        std::vector<Game> games;
+        std::vector<FixedGame> fixedGames;
+        games.reserve(options.instances);
+        fixedGames.reserve(options.instances);
+        for (uint32_t i = 0; i < options.instances; i++) {
+            games.emplace_back(level);
+            fixedGames.emplace_back(level);
+        }
+
+        std::vector<uint32_t> seeds(options.instances);
+        for (uint32_t i = 0; i < options.instances; i++) {
+            seeds[i] = 0x9e3779b9u * (i + 1);
+        }
+        std::vector<uint32_t> inputs(options.instances);
+        std::vector<bool> inRange(options.instances, true);
+        float maxDrift = 0.0f;
+
+        uint64_t floatNs = 0;
+        uint64_t fixedNs = 0;
+        for (uint32_t tick = 0; tick < options.ticks; tick++) {
+            // inputs are held for a few ticks like real key presses
+            for (uint32_t i = 0; i < options.instances; i++) {
+                uint32_t r = nextRandom(seeds[i]);
+                if (r % 8 == 0) {
+                    inputs[i] = (r >> 8) % 4;
+                }
+                bool left = (inputs[i] & 1) != 0;
+                bool right = (inputs[i] & 2) != 0;
+                bool jump = (r >> 16) % 24 == 0;
+
+                games[i].moveLeft = fixedGames[i].moveLeft = left;
+                games[i].moveRight = fixedGames[i].moveRight = right;
+                // only from the ground, as a player could, so that nobody climbs out of the level
+                if (jump && games[i].world.player().isOnGround()) {
+                    games[i].playerJump();
+                }
+                if (jump && fixedGames[i].world.player().isOnGround()) {
+                    fixedGames[i].playerJump();
+                }
+            }
+
+            uint64_t start = monotonicNsecs();
+            for (auto& game : games) {
+                game.process(delta);
+            }
+            uint64_t middle = monotonicNsecs();
+            for (auto& game : fixedGames) {
+                game.process(fixedDelta);
+            }
+            uint64_t end = monotonicNsecs();
+            floatNs += middle - start;
+            fixedNs += end - middle;
+
+            // past Fixed's range the difference measures saturation rather than rounding
+            for (uint32_t i = 0; i < options.instances; i++) {
+                Vec2 pos = games[i].world.player().pos();
+                Vec2 fixedPos = Vec2(fixedGames[i].world.player().pos());
+                if (!inRange[i] || !(std::max({std::abs(pos.x), std::abs(pos.y), std::abs(fixedPos.x), std::abs(fixedPos.y)}) < FIXED_WORLD_LIMIT)) {
+                    inRange[i] = false;
+                    continue;
+                }
+                Vec2 drift = fixedPos - pos;
+                maxDrift = std::max({maxDrift, std::abs(drift.x), std::abs(drift.y)});
+            }
+        }
+
+        uint64_t floatHash = FNV1A_OFFSET_BASIS;
+        uint64_t fixedHash = FNV1A_OFFSET_BASIS;
+        for (uint32_t i = 0; i < options.instances; i++) {
+            floatHash = hashPlayer(games[i].world.player(), floatHash);
+            fixedHash = hashPlayer(fixedGames[i].world.player(), fixedHash);
+        }
+        auto leftRange = static_cast<uint32_t>(std::count(inRange.begin(), inRange.end(), false));
+
+        double instanceTicks = static_cast<double>(options.instances) * options.ticks;
+        std::cout << options.instances << " instances, " << options.ticks << " ticks at " << options.tickRate << " Hz, "
+                  << level->geometry().solids.count << " solids\n";
+        std::cout << std::hex << std::setfill('0');
+        std::cout << "float: " << std::setw(16) << floatHash << std::dec << std::fixed << std::setprecision(0) << ", "
+                  << instanceTicks / (static_cast<double>(floatNs) / NSECS_PER_SEC) << " instance-ticks/s\n";
+        std::cout << std::hex << "fixed: " << std::setw(16) << fixedHash << std::dec << ", "
+                  << instanceTicks / (static_cast<double>(fixedNs) / NSECS_PER_SEC) << " instance-ticks/s\n";
+        std::cout << std::setprecision(3) << "largest position difference between them: " << maxDrift << ", " << leftRange
+                  << " players left the fixed point range and were not counted after" << std::endl;
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "game/game.h"
+#include "game/kinematic.h"
+#include "platform/time.h"
+
+// usage: kinematic_bench [--platforms N] [--ticks N] [--rate HZ] [--cell SIZE]
+//
+// Fills a world with N moving platforms, elevators and crushers on a square layout and times stepping them with the
+// incremental cell updates against rebuilding the whole index every step, then whole game ticks with the player riding
+// one of them under each contact resolver.
+
+struct BenchOptions {
+    uint32_t platforms = 10000;
+    uint32_t ticks = 600;
+    uint32_t tickRate = 60;
+    float cellSize = KinematicSet::DEFAULT_CELL_SIZE;
+};
+
+static BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> const char* {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return argv[++i];
+        };
+        if (strcmp(argv[i], "--platforms") == 0) {
+            options.platforms = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--ticks") == 0) {
+            options.ticks = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.tickRate = std::max<uint32_t>(static_cast<uint32_t>(std::strtoul(value(), nullptr, 10)), 1);
+        } else if (strcmp(argv[i], "--cell") == 0) {
+            options.cellSize = std::strtof(value(), nullptr);
+        } else {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        }
+    }
+    if (options.platforms == 0) {
+        throw std::runtime_error("platforms must be at least 1");
+    }
+    return options;
+}
+
+// One platform per 500 x 500 square, each kind in turn, with phases spread so that they do not move in lockstep.
+// The first one is a slow sideways platform under the spawn point.
+static void populate(KinematicSet& kinematics, uint32_t count) {
+    KinematicPath sideways;
+    sideways.waypoints = {{{0, 0}, 3000}, {{300, 0}, 3000}};
+    KinematicPath elevator;
+    elevator.waypoints = {{{0, 0}, 500}, {{0, 0}, 2500}, {{0, 350}, 2500}};
+    KinematicPath crusher;
+    crusher.loop = KinematicLoop::CYCLE;
+    crusher.waypoints = {{{0, 300}, 1000}, {{0, 300}, 150}, {{0, 0}, 2000}};
+
+    uint32_t paths[] = {kinematics.addPath(sideways), kinematics.addPath(elevator), kinematics.addPath(crusher)};
+    Vec2 sizes[] = {{200, 40}, {150, 30}, {120, 120}};
+
+    auto columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t kind = i % 3;
+        Vec2 origin(static_cast<float>(i % columns) * 500.0f, static_cast<float>(i / columns) * 500.0f);
+        kinematics.add({origin, origin + sizes[kind]}, paths[kind], static_cast<float>((i * 977) % 6000));
+    }
+}
+
+static double msPerTick(uint64_t ns, uint32_t ticks) {
+    return static_cast<double>(ns) / ticks / NSECS_PER_MSEC;
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options = parseOptions(argc, argv);
+        float delta = 1000.0f / static_cast<float>(options.tickRate);
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << options.platforms << " platforms, " << options.ticks << " ticks at " << options.tickRate << " Hz, cells of "
+                  << options.cellSize << std::endl;
+
+        {
+            KinematicSet incremental(options.cellSize);
+            populate(incremental, options.platforms);
+            uint64_t start = monotonicNsecs();
+            for (uint32_t tick = 0; tick < options.ticks; tick++) {
+                incremental.step(delta);
+            }
+            uint64_t incrementalNs = monotonicNsecs() - start;
+
+            KinematicSet rebuilt(options.cellSize);
+            populate(rebuilt, options.platforms);
+            start = monotonicNsecs();
+            for (uint32_t tick = 0; tick < options.ticks; tick++) {
+                rebuilt.step(delta);
+                rebuilt.rebuildCells();
+            }
+            uint64_t rebuiltNs = monotonicNsecs() - start;
+
+            // a player sized query at every platform, what a body standing on each would cost
+            std::vector<uint32_t> found;
+            uint64_t candidates = 0;
+            start = monotonicNsecs();
+            for (const auto& body : incremental.bodies()) {
+                Vec2 center = (body.aabb.v0() + body.aabb.v1()) * 0.5f;
+                incremental.query({center - Player::SIZE, center + Player::SIZE}, found);
+                candidates += found.size();
+            }
+            uint64_t queryNs = monotonicNsecs() - start;
+
+            double changes = static_cast<double>(incremental.stats().cellRangeChanges) / options.ticks;
+            std::cout << "step, incremental cells: " << msPerTick(incrementalNs, options.ticks) << " ms per tick, " << changes
+                      << " platforms changed cells per tick (" << changes / options.platforms * 100.0 << "%)\n";
+            std::cout << "step, rebuilt cells:     " << msPerTick(rebuiltNs, options.ticks) << " ms per tick\n";
+            std::cout << "queries: " << static_cast<double>(queryNs) / options.platforms << " ns each, "
+                      << static_cast<double>(candidates) / options.platforms << " candidates on average\n";
+        }
+
+        // platforms step once per frame, the substeps only collide with the few near the player
+        for (ContactResolver resolver : {ContactResolver::SCALE, ContactResolver::SWEEP}) {
+            Game game(nullptr, {100, 90});
+            game.world.objects.clear();
+            game.world.resolver = resolver;
+            populate(game.world.kinematics, options.platforms);
+
+            uint32_t ridden = 0;
+            uint64_t start = monotonicNsecs();
+            for (uint32_t tick = 0; tick < options.ticks; tick++) {
+                game.process(delta);
+                ridden += game.world.riding == 0 ? 1 : 0;
+            }
+            uint64_t ns = monotonicNsecs() - start;
+            std::cout << (resolver == ContactResolver::SCALE ? "game, scale: " : "game, sweep: ") << msPerTick(ns, options.ticks)
+                      << " ms per tick, riding the first platform " << ridden << "/" << options.ticks << " ticks\n";
+        }
+        std::cout.flush();
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
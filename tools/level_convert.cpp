@@ -0,0 +1,135 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "game/chunked_level.h"
+#include "game/level.h"
+#include "game/solid_merge.h"
+
+// usage:
+//   level_convert <level.txt> <level.plvl>
+//   level_convert --to-text <level.plvl> <level.txt>
+//   level_convert --chunked <chunk size> <level.txt> <level.pwld>
+//
+// Text levels are baked on the way in: solids are merged into as few boxes as cover the same area.
+
+static LevelDescription describeLevel(const Level& level) {
+    LevelDescription description;
+    const auto& geometry = level.geometry();
+    for (uint32_t i = 0; i < geometry.solids.count; i++) {
+        description.solids.emplace_back(geometry.solids.aabb(i));
+    }
+    description.spawns.assign(level.spawns(), level.spawns() + level.spawnCount());
+    description.gridCellSize = geometry.grid.cellSize;
+
+    const auto& tiles = geometry.tiles;
+    if (!tiles.isEmpty()) {
+        description.tileOriginX = tiles.originX;
+        description.tileOriginY = tiles.originY;
+        description.tileSize = tiles.tileSize;
+        int32_t tx0 = tiles.blockX0 * TILE_BLOCK_SIZE;
+        int32_t ty0 = tiles.blockY0 * TILE_BLOCK_SIZE;
+        for (int32_t ty = ty0; ty < ty0 + static_cast<int32_t>(tiles.blockRows) * TILE_BLOCK_SIZE; ty++) {
+            for (int32_t tx = tx0; tx < tx0 + static_cast<int32_t>(tiles.blockCols) * TILE_BLOCK_SIZE; tx++) {
+                uint8_t id = tiles.tileId(tx, ty);
+                if (id != 0) {
+                    description.tiles.push_back({tx, ty, id, tiles.isSolid(tx, ty)});
+                }
+            }
+        }
+    }
+    return description;
+}
+
+static void bakeLevel(LevelDescription& description) {
+    SolidMergeStats stats = mergeSolids(description.solids);
+    std::cout << "merged " << stats.solidsBefore << " solids into " << stats.solidsAfter << ", " << stats.clusters << " clusters meshed";
+    if (stats.oversized != 0) {
+        std::cout << ", " << stats.oversized << " too large for a grid";
+    }
+    std::cout << std::endl;
+}
+
+static void toBinary(const std::string& inputPath, const std::string& outputPath) {
+    std::ifstream input(inputPath);
+    if (!input) {
+        throw std::runtime_error("failed to open file " + inputPath);
+    }
+
+    LevelDescription description = parseLevelText(input);
+    bakeLevel(description);
+    std::vector<uint8_t> bytes = serializeLevel(description);
+
+    // round trip through the loader, which validates, so that a broken file is never written
+    Level::fromBytes(bytes);
+
+    std::ofstream output(outputPath, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!output) {
+        throw std::runtime_error("failed to write file " + outputPath);
+    }
+
+    std::cout << outputPath << ": " << description.solids.size() << " solids, " << description.spawns.size() << " spawns, "
+              << description.tiles.size() << " tiles, "
+              << bytes.size() << " bytes" << std::endl;
+}
+
+static void toChunked(float chunkSize, const std::string& inputPath, const std::string& outputPath) {
+    std::ifstream input(inputPath);
+    if (!input) {
+        throw std::runtime_error("failed to open file " + inputPath);
+    }
+
+    LevelDescription description = parseLevelText(input);
+    bakeLevel(description);
+
+    std::ofstream output(outputPath, std::ios::binary);
+    writeChunkedLevel(output, description, chunkSize);
+    output.close();
+    if (!output) {
+        throw std::runtime_error("failed to write file " + outputPath);
+    }
+
+    // every chunk has to load back
+    auto index = ChunkedLevelIndex::open(outputPath);
+    std::ifstream check(outputPath, std::ios::binary);
+    for (uint32_t i = 0; i < index->chunks().size(); i++) {
+        index->readChunk(check, i);
+    }
+
+    std::cout << outputPath << ": " << description.solids.size() << " solids in " << index->chunks().size() << " chunks" << std::endl;
+}
+
+static void toText(const std::string& inputPath, const std::string& outputPath) {
+    auto level = Level::map(inputPath);
+
+    std::ofstream output(outputPath);
+    writeLevelText(output, describeLevel(*level));
+    if (!output) {
+        throw std::runtime_error("failed to write file " + outputPath);
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        if (argc == 4 && strcmp(argv[1], "--to-text") == 0) {
+            toText(argv[2], argv[3]);
+        } else if (argc == 5 && strcmp(argv[1], "--chunked") == 0) {
+            toChunked(std::strtof(argv[2], nullptr), argv[3], argv[4]);
+        } else if (argc == 3) {
+            toBinary(argv[1], argv[2]);
+        } else {
+            std::cerr << "usage: level_convert <level.txt> <level.plvl>\n"
+                      << "       level_convert --to-text <level.plvl> <level.txt>\n"
+                      << "       level_convert --chunked <chunk size> <level.txt> <level.pwld>" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
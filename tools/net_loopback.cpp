@@ -0,0 +1,155 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "game/level.h"
+#include "net/net_client.h"
+#include "net/net_server.h"
+#include "platform/time.h"
+
+// usage: net_loopback [--clients N] [--seconds S] [--rate HZ] [--latency MS] [--jitter MS] [--loss PERCENT] [level file]
+//
+// Runs a NetServer and N NetClients in one process, talking over real UDP sockets on 127.0.0.1. Latency, jitter and
+// loss are added to every datagram in both directions. Time is simulated in 1 ms steps, so a run takes as long as the
+// work does rather than S seconds, and is repeatable. Prints bandwidth per client per second, the CPU time spent per
+// snapshot and how often the clients' predictions had to be corrected.
+
+static constexpr uint64_t STEP_NS = NSECS_PER_MSEC;
+static constexpr uint64_t BOT_INTERVAL_NS = 100 * NSECS_PER_MSEC;
+
+struct LoopbackOptions {
+    uint32_t clients = 8;
+    uint32_t seconds = 30;
+    uint32_t tickRate = 60;
+    uint32_t latencyMs = 50;
+    uint32_t jitterMs = 10;
+    float lossPercent = 2.0f;
+    std::string levelPath{};
+};
+
+static LoopbackOptions parseOptions(int argc, char** argv) {
+    LoopbackOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> const char* {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return argv[++i];
+        };
+        if (strcmp(argv[i], "--clients") == 0) {
+            options.clients = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.tickRate = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            options.latencyMs = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--jitter") == 0) {
+            options.jitterMs = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--loss") == 0) {
+            options.lossPercent = std::strtof(value(), nullptr);
+        } else if (argv[i][0] == '-') {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        } else {
+            options.levelPath = argv[i];
+        }
+    }
+    if (options.clients == 0 || options.clients > NET_MAX_BODIES) {
+        throw std::runtime_error("clients must be 1 .. " + std::to_string(NET_MAX_BODIES));
+    }
+    return options;
+}
+
+// walks back and forth and jumps now and then, different per client
+static uint8_t botInput(uint32_t client, uint64_t step) {
+    uint64_t phase = (step + client * 7) % 40;
+    uint8_t bits = phase < 20 ? NET_INPUT_RIGHT : NET_INPUT_LEFT;
+    if ((step + client) % 13 == 0) {
+        bits |= NET_INPUT_JUMP;
+    }
+    return bits;
+}
+
+int main(int argc, char** argv) {
+    try {
+        LoopbackOptions options = parseOptions(argc, argv);
+        std::shared_ptr<const Level> level = options.levelPath.empty() ? Level::builtIn() : Level::map(options.levelPath);
+
+        NetConditions conditions;
+        conditions.latencyNs = options.latencyMs * NSECS_PER_MSEC;
+        conditions.jitterNs = options.jitterMs * NSECS_PER_MSEC;
+        conditions.loss = options.lossPercent / 100.0f;
+
+        NetServer server(level, NetLink(UdpSocket::bind(NetAddress::loopback(0))), options.tickRate);
+        server.netLink().setConditions(conditions);
+
+        std::vector<std::unique_ptr<NetClient>> clients;
+        for (uint32_t i = 0; i < options.clients; i++) {
+            NetLink link(UdpSocket::bind(NetAddress::loopback(0)), i + 2);
+            link.setConditions(conditions);
+            clients.push_back(std::make_unique<NetClient>(level, std::move(link), server.localAddress(), options.tickRate));
+        }
+
+        std::cout << options.clients << " clients at " << options.tickRate << " Hz for " << options.seconds << " s, latency " << options.latencyMs
+                  << " ms, jitter " << options.jitterMs << " ms, loss " << options.lossPercent << "% each way" << std::endl;
+
+        uint64_t endNs = options.seconds * NSECS_PER_SEC;
+        uint64_t wallStart = monotonicNsecs();
+        for (uint64_t now = STEP_NS; now <= endNs; now += STEP_NS) {
+            for (uint32_t i = 0; i < options.clients; i++) {
+                clients[i]->setInput(botInput(i, now / BOT_INTERVAL_NS));
+                clients[i]->update(now);
+            }
+            server.update(now);
+        }
+        uint64_t wallNs = monotonicNsecs() - wallStart;
+
+        NetServerClientStats total{};
+        for (uint32_t i = 0; i < server.clientCount(); i++) {
+            const auto& stats = server.clientStats(i);
+            total.snapshots += stats.snapshots;
+            total.fullSnapshots += stats.fullSnapshots;
+            total.snapshotBytes += stats.snapshotBytes;
+            total.snapshotCpuNs += stats.snapshotCpuNs;
+            total.inputsProcessed += stats.inputsProcessed;
+        }
+        uint64_t upBytes = 0;
+        uint64_t received = 0;
+        uint64_t ignored = 0;
+        uint64_t corrections = 0;
+        uint64_t pending = 0;
+        uint64_t dropped = server.netLink().stats().datagramsDropped;
+        uint64_t sent = server.netLink().stats().datagramsSent;
+        for (auto& client : clients) {
+            upBytes += client->netLink().stats().bytesSent;
+            received += client->stats().snapshots;
+            ignored += client->stats().snapshotsIgnored;
+            corrections += client->stats().corrections;
+            pending += client->pendingInputs();
+            dropped += client->netLink().stats().datagramsDropped;
+            sent += client->netLink().stats().datagramsSent;
+        }
+
+        double clientSeconds = static_cast<double>(options.clients) * options.seconds;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "connected " << server.clientCount() << "/" << options.clients << ", " << total.inputsProcessed << " inputs processed, "
+                  << pending << " still unconfirmed\n";
+        std::cout << "down " << static_cast<double>(total.snapshotBytes) / clientSeconds / 1024.0 << " KiB/s per client, up "
+                  << static_cast<double>(upBytes) / clientSeconds / 1024.0 << " KiB/s per client (including IP and UDP headers)\n";
+        std::cout << "snapshots " << total.snapshots << " sent (" << total.fullSnapshots << " full), " << received << " applied, " << ignored
+                  << " ignored, avg " << (total.snapshots != 0 ? static_cast<double>(total.snapshotBytes) / total.snapshots : 0.0) << " bytes, "
+                  << (total.snapshots != 0 ? static_cast<double>(total.snapshotCpuNs) / total.snapshots / NSECS_PER_USEC : 0.0) << " us cpu each\n";
+        std::cout << "datagrams " << sent << " sent, " << dropped << " dropped\n";
+        std::cout << "mispredictions " << corrections << "\n";
+        std::cout << "simulated in " << static_cast<double>(wallNs) / NSECS_PER_MSEC << " ms" << std::endl;
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
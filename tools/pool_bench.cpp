@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "game/game.h"
+#include "platform/os_type.h"
+#include "platform/time.h"
+#include "util/object_pool.h"
+
+#ifdef __COMPILES_WINDOWS__
+#include <malloc.h>
+#endif
+
+// usage: pool_bench [--spawns N] [--ticks N] [--rate HZ]
+//
+// Fires N projectiles per tick across a walled arena, with lifetimes of half a second to three seconds, and despawns
+// every fourth one in bulk a few ticks after it was fired. Counts the allocator calls the game makes once the first
+// second is over, which have to be none, checks that the handles of the first tick's projectiles are refused once
+// their slots were reused, and reports the pool's occupancy. Then times spawning and despawning straight from a pool
+// against new and delete.
+
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC inlines these into their callers and takes the blocks for the library operator new's, which free must not
+// release, so it warns about every delete. They come from the malloc above.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+// the CRT's aligned blocks have to be freed with their own function
+static void alignedFree(void* p) noexcept {
+#ifdef __COMPILES_WINDOWS__
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    size = (std::max<size_t>(size, 1) + align - 1) / align * align;
+#ifdef __COMPILES_WINDOWS__
+    void* p = _aligned_malloc(size, align);
+#else
+    void* p = std::aligned_alloc(align, size);
+#endif
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    alignedFree(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    alignedFree(p);
+}
+
+struct BenchOptions {
+    uint32_t spawns = 20;
+    uint32_t ticks = 3600;
+    uint32_t tickRate = 60;
+};
+
+static BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> const char* {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return argv[++i];
+        };
+        if (strcmp(argv[i], "--spawns") == 0) {
+            options.spawns = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--ticks") == 0) {
+            options.ticks = static_cast<uint32_t>(std::strtoul(value(), nullptr, 10));
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.tickRate = std::max<uint32_t>(static_cast<uint32_t>(std::strtoul(value(), nullptr, 10)), 1);
+        } else {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        }
+    }
+    return options;
+}
+
+static constexpr float ARENA_SIZE = 4000.0f;
+static constexpr float MAX_LIFETIME = 3000.0f;
+// projectiles despawned in bulk were fired this many ticks before
+static constexpr uint32_t DESPAWN_LAG = 8;
+
+// a floor, a ceiling, two walls and a pillar in the middle
+static void populate(World& world) {
+    world.objects.clear();
+    world.objects.emplace_back(-100.0f, ARENA_SIZE + 100.0f, -100.0f, 0.0f);
+    world.objects.emplace_back(-100.0f, ARENA_SIZE + 100.0f, ARENA_SIZE, ARENA_SIZE + 100.0f);
+    world.objects.emplace_back(-100.0f, 0.0f, 0.0f, ARENA_SIZE);
+    world.objects.emplace_back(ARENA_SIZE, ARENA_SIZE + 100.0f, 0.0f, ARENA_SIZE);
+    world.objects.emplace_back(ARENA_SIZE / 2 - 20.0f, ARENA_SIZE / 2 + 20.0f, 0.0f, ARENA_SIZE / 2);
+    world.markLevelDirty();
+    world.player().setPos(100.0f, 50.0f);
+}
+
+static void printStats(const PoolStats& stats) {
+    std::cout << "  " << stats.live << " live, peak " << stats.peak << ", " << stats.capacity << " of " << stats.maxCapacity << " slots in "
+              << stats.blocks << " blocks, occupancy " << 100.0 * stats.live / std::max<uint32_t>(stats.capacity, 1) << "%, " << stats.spawns
+              << " spawns, " << stats.despawns << " despawns, " << stats.overflows << " overflows\n";
+}
+
+static void runGame(const BenchOptions& options) {
+    float delta = 1000.0f / static_cast<float>(options.tickRate);
+    Game game(nullptr, {100, 50});
+    populate(game.world);
+    auto& pool = game.world.projectiles;
+    pool.reserve(World::MAX_PROJECTILES);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(50.0f, ARENA_SIZE - 50.0f);
+    std::uniform_real_distribution<float> speed(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> lifetime(500.0f, MAX_LIFETIME);
+    std::vector<Projectile> fired(options.spawns);
+    std::vector<PoolHandle> history(static_cast<size_t>(options.spawns) * DESPAWN_LAG);
+    std::vector<PoolHandle> doomed(options.spawns);
+    std::vector<PoolHandle> first;
+    uint32_t warmupTicks = options.tickRate;
+    uint32_t firstExpiredTick = static_cast<uint32_t>(MAX_LIFETIME / delta) + 2;
+    uint64_t allocationsBefore = 0, bulkDespawned = 0, spawnFailures = 0;
+    bool staleChecked = false;
+
+    uint64_t start = monotonicNsecs();
+    for (uint32_t tick = 0; tick < options.ticks; tick++) {
+        if (tick == warmupTicks) {
+            allocationsBefore = allocations.load();
+        }
+        for (auto& projectile : fired) {
+            projectile = {{position(random), position(random)}, {speed(random), speed(random)}, lifetime(random)};
+        }
+        PoolHandle* handles = &history[static_cast<size_t>(tick % DESPAWN_LAG) * options.spawns];
+        // the slots being overwritten were fired DESPAWN_LAG ticks ago
+        uint32_t count = 0;
+        if (tick >= DESPAWN_LAG) {
+            for (uint32_t i = 0; i < options.spawns; i += 4) {
+                doomed[count++] = handles[i];
+            }
+        }
+        bulkDespawned += pool.despawn(doomed.data(), count);
+
+        uint32_t spawned = pool.spawn(fired.data(), options.spawns, handles);
+        spawnFailures += options.spawns - spawned;
+        std::fill(handles + spawned, handles + options.spawns, PoolHandle{});
+        if (tick == 0) {
+            first.assign(handles, handles + spawned);
+        }
+        game.process(delta);
+
+        if (tick == firstExpiredTick) {
+            for (const auto& handle : first) {
+                if (pool.isAlive(handle) || pool.find(handle) != nullptr) {
+                    throw std::runtime_error("a stale handle reached a reused slot");
+                }
+            }
+            staleChecked = true;
+        }
+    }
+    uint64_t ns = monotonicNsecs() - start;
+    uint64_t gameplayAllocations = options.ticks > warmupTicks ? allocations.load() - allocationsBefore : 0;
+
+    std::cout << "game: " << static_cast<double>(ns) / options.ticks / NSECS_PER_USEC << " us per tick, " << bulkDespawned
+              << " despawned in bulk, " << spawnFailures << " spawns refused\n";
+    printStats(pool.stats());
+    std::cout << "  " << gameplayAllocations << " allocator calls after the first " << warmupTicks << " ticks"
+              << (staleChecked ? ", stale handles refused" : "") << "\n";
+    if (gameplayAllocations != 0) {
+        throw std::runtime_error("the game allocated during gameplay");
+    }
+}
+
+// spawns and despawns a whole pool worth of projectiles a number of times
+static void runPool() {
+    const uint32_t COUNT = 1 << 16;
+    const uint32_t ROUNDS = 64;
+    std::vector<Projectile> values(COUNT, Projectile{{1.0f, 2.0f}, {0.5f, 0.5f}, 1000.0f});
+    std::vector<PoolHandle> handles(COUNT);
+    ObjectPool<Projectile> pool(COUNT);
+    pool.reserve(COUNT);
+
+    uint64_t start = monotonicNsecs();
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        if (pool.spawn(values.data(), COUNT, handles.data()) != COUNT) {
+            throw std::runtime_error("a reserved pool refused a spawn");
+        }
+        // every other one first, so that the free list is not in slot order on the next round
+        for (uint32_t i = 0; i < COUNT; i += 2) {
+            pool.despawn(handles[i]);
+        }
+        pool.despawnIf([](const Projectile&) { return true; });
+    }
+    uint64_t poolNs = monotonicNsecs() - start;
+
+    std::vector<std::unique_ptr<Projectile>> objects(COUNT);
+    start = monotonicNsecs();
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        for (uint32_t i = 0; i < COUNT; i++) {
+            objects[i] = std::make_unique<Projectile>(values[i]);
+        }
+        for (uint32_t i = 0; i < COUNT; i += 2) {
+            objects[i].reset();
+        }
+        for (auto& object : objects) {
+            object.reset();
+        }
+    }
+    uint64_t heapNs = monotonicNsecs() - start;
+
+    double operations = static_cast<double>(COUNT) * ROUNDS;
+    std::cout << "pool: " << static_cast<double>(poolNs) / operations << " ns per spawn and despawn, new and delete "
+              << static_cast<double>(heapNs) / operations << " ns\n";
+    printStats(pool.stats());
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options = parseOptions(argc, argv);
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << options.spawns << " projectiles per tick, " << options.ticks << " ticks at " << options.tickRate << " Hz" << std::endl;
+        runGame(options);
+        runPool();
+        std::cout.flush();
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
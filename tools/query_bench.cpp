@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game/game.h"
+#include "game/level.h"
+#include "game/raycast.h"
+#include "game/world_query.h"
+#include "platform/time.h"
+
+// usage: query_bench [--solids N] [--platforms N] [--rays N] [--threads N] [--check N]
+//
+// Scatters solids, a tile field and moving platforms over a large level and times WorldQuery's ray casts, box
+// overlaps and sweeps one at a time, batched and batched across threads. Batches have to give what the queries one at a
+// time did, and the first --check queries of every kind are compared against testing every box, before and after the
+// platforms move and the tree is refit.
+
+struct BenchOptions {
+    uint32_t solids = 20000;
+    uint32_t platforms = 500;
+    uint32_t rays = 100000;
+    uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    uint32_t check = 2000;
+};
+
+static BenchOptions parseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&]() -> uint32_t {
+            if (i + 1 == argc) {
+                throw std::runtime_error(std::string("missing value for ") + argv[i]);
+            }
+            return static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        };
+        if (strcmp(argv[i], "--solids") == 0) {
+            options.solids = value();
+        } else if (strcmp(argv[i], "--platforms") == 0) {
+            options.platforms = value();
+        } else if (strcmp(argv[i], "--rays") == 0) {
+            options.rays = value();
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            options.threads = std::max<uint32_t>(value(), 1);
+        } else if (strcmp(argv[i], "--check") == 0) {
+            options.check = value();
+        } else {
+            throw std::runtime_error(std::string("unknown option ") + argv[i]);
+        }
+    }
+    return options;
+}
+
+static const float LEVEL_SIZE = 50000.0f;
+
+static std::shared_ptr<const Level> scatteredLevel(uint32_t solids, std::mt19937& random) {
+    std::uniform_real_distribution<float> position(0.0f, LEVEL_SIZE);
+    std::uniform_real_distribution<float> size(20.0f, 400.0f);
+    LevelDescription description;
+    for (uint32_t i = 0; i < solids; i++) {
+        float x = position(random);
+        float y = position(random);
+        description.solids.emplace_back(x, x + size(random), y, y + size(random));
+    }
+    // a field of tiles with holes in one corner
+    description.tileSize = 50.0f;
+    for (int32_t ty = 0; ty < 64; ty++) {
+        for (int32_t tx = 0; tx < 64; tx++) {
+            if (random() % 3 == 0) {
+                description.tiles.push_back({tx, ty, 'A', true});
+            }
+        }
+    }
+    return Level::build(description);
+}
+
+static void populatePlatforms(KinematicSet& kinematics, uint32_t count, std::mt19937& random) {
+    KinematicPath sideways;
+    sideways.waypoints = {{{0, 0}, 3000}, {{600, 0}, 3000}};
+    KinematicPath elevator;
+    elevator.waypoints = {{{0, 0}, 2500}, {{0, 800}, 2500}};
+    uint32_t paths[] = {kinematics.addPath(sideways), kinematics.addPath(elevator)};
+    std::uniform_real_distribution<float> position(0.0f, LEVEL_SIZE);
+    for (uint32_t i = 0; i < count; i++) {
+        Vec2 origin(position(random), position(random));
+        kinematics.add({origin, origin + Vec2(200, 40)}, paths[i % 2], static_cast<float>(random() % 6000));
+    }
+}
+
+// every box of the world with its shape, what the brute force checks test
+static std::vector<std::pair<WorldShape, AABB>> allShapes(const WorldQuery& query, const World& world) {
+    std::vector<std::pair<WorldShape, AABB>> shapes;
+    for (uint32_t i = 0; i < query.staticCount(); i++) {
+        shapes.push_back({{WorldShapeKind::STATIC, i}, query.staticBox(i)});
+    }
+    for (uint32_t i = 0; i < world.kinematics.size(); i++) {
+        shapes.push_back({{WorldShapeKind::KINEMATIC, i}, world.kinematics.bodies()[i].aabb});
+    }
+    return shapes;
+}
+
+static bool sameShape(const WorldShape& a, const WorldShape& b) {
+    return a.kind == b.kind && a.index == b.index;
+}
+
+static bool sameHit(const WorldHit& a, const WorldHit& b) {
+    return a.isHit() == b.isHit() && (!a.isHit() || (sameShape(a.shape, b.shape) && a.t == b.t));
+}
+
+// the nearest of shapes under the same rule and tie breaking as WorldQuery, shapes are statics first
+static WorldHit bruteFirst(const std::vector<std::pair<WorldShape, AABB>>& shapes, Vec2 origin, Vec2 dir, Vec2 grow) {
+    WorldHit best;
+    for (const auto& [shape, box] : shapes) {
+        WorldHit hit;
+        AABB grown(box.v0() - grow, box.v1() + grow);
+        if (doRayCast2D(grown, origin, dir, hit.point, hit.normal, hit.t) && hit.t <= 1.0f && hit.t < best.t) {
+            hit.shape = shape;
+            best = hit;
+        }
+    }
+    return best;
+}
+
+static void check(bool ok, const std::string& what, uint32_t i) {
+    if (!ok) {
+        throw std::runtime_error(what + " differs from brute force for query " + std::to_string(i));
+    }
+}
+
+static void validate(const WorldQuery& query, const World& world, const std::vector<WorldRay>& rays, const std::vector<AABB>& boxes,
+                     const std::vector<WorldSweep>& sweeps, uint32_t count) {
+    auto shapes = allShapes(query, world);
+    count = std::min<uint32_t>(count, static_cast<uint32_t>(rays.size()));
+    std::vector<WorldHit> hits;
+    std::vector<WorldShape> overlaps;
+    for (uint32_t i = 0; i < count; i++) {
+        WorldHit hit;
+        query.raycastFirst(rays[i], hit);
+        check(sameHit(hit, bruteFirst(shapes, rays[i].origin, rays[i].dir, {0, 0})), "raycastFirst", i);
+
+        query.raycastAll(rays[i], hits);
+        uint32_t expected = 0;
+        for (const auto& [shape, box] : shapes) {
+            Vec2 point, normal;
+            float t;
+            if (doRayCast2D(box, rays[i].origin, rays[i].dir, point, normal, t) && t <= 1.0f) {
+                expected++;
+                bool found = std::any_of(hits.begin(), hits.end(), [&](const WorldHit& h) { return sameShape(h.shape, shape) && h.t == t; });
+                check(found, "raycastAll", i);
+            }
+        }
+        check(hits.size() == expected, "raycastAll", i);
+        for (size_t k = 1; k < hits.size(); k++) {
+            check(hits[k - 1].t <= hits[k].t, "raycastAll order", i);
+        }
+
+        query.overlapBox(boxes[i], overlaps);
+        expected = 0;
+        for (const auto& [shape, box] : shapes) {
+            if (aabbOverlaps(box, boxes[i])) {
+                expected++;
+                bool found = std::any_of(overlaps.begin(), overlaps.end(), [&](const WorldShape& s) { return sameShape(s, shape); });
+                check(found, "overlapBox", i);
+            }
+        }
+        check(overlaps.size() == expected, "overlapBox", i);
+
+        query.sweepBox(sweeps[i], hit);
+        Vec2 center = (sweeps[i].box.v0() + sweeps[i].box.v1()) * 0.5f;
+        check(sameHit(hit, bruteFirst(shapes, center, sweeps[i].move, sweeps[i].box.size() * 0.5f)), "sweepBox", i);
+    }
+}
+
+static double nsPerQuery(uint64_t ns, uint32_t count) {
+    return static_cast<double>(ns) / std::max<uint32_t>(count, 1);
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options = parseOptions(argc, argv);
+        std::mt19937 random(7);
+        Game game(scatteredLevel(options.solids, random));
+        World& world = game.world;
+        populatePlatforms(world.kinematics, options.platforms, random);
+
+        std::uniform_real_distribution<float> position(0.0f, LEVEL_SIZE);
+        std::uniform_real_distribution<float> reach(-2000.0f, 2000.0f);
+        std::vector<WorldRay> rays(options.rays);
+        std::vector<AABB> boxes(options.rays);
+        std::vector<WorldSweep> sweeps(options.rays);
+        for (uint32_t i = 0; i < options.rays; i++) {
+            Vec2 origin(position(random), position(random));
+            // every eighth ray is axis aligned, where zero directions meet box edges
+            Vec2 dir(reach(random), i % 8 == 0 ? 0.0f : reach(random));
+            rays[i] = {origin, dir};
+            boxes[i] = {origin - Vec2(200, 200), origin + Vec2(200, 200)};
+            sweeps[i] = {{origin - Player::HALF_SIZE, origin + Player::HALF_SIZE}, dir * 0.25f};
+        }
+
+        WorldQuery query;
+        uint64_t start = monotonicNsecs();
+        query.update(world);
+        uint64_t buildNs = monotonicNsecs() - start;
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << query.staticCount() << " static boxes, " << world.kinematics.size() << " platforms, built in "
+                  << static_cast<double>(buildNs) / NSECS_PER_MSEC << " ms" << std::endl;
+
+        validate(query, world, rays, boxes, sweeps, options.check);
+
+        std::vector<WorldHit> singleHits(options.rays);
+        std::vector<WorldHit> hits(options.rays);
+        std::vector<WorldHit> rayHits;
+        std::vector<WorldHit> allHits;
+        std::vector<uint32_t> hitStart;
+        std::vector<WorldShape> boxShapes;
+        std::vector<WorldShape> shapes;
+        std::vector<uint32_t> shapeStart;
+
+        start = monotonicNsecs();
+        uint32_t found = 0;
+        for (uint32_t i = 0; i < options.rays; i++) {
+            found += query.raycastFirst(rays[i], singleHits[i]) ? 1 : 0;
+        }
+        uint64_t singleNs = monotonicNsecs() - start;
+
+        start = monotonicNsecs();
+        query.raycastFirst(rays.data(), options.rays, hits.data());
+        uint64_t batchNs = monotonicNsecs() - start;
+        for (uint32_t i = 0; i < options.rays; i++) {
+            check(sameHit(hits[i], singleHits[i]), "batched raycastFirst", i);
+        }
+
+        // the batch split between threads has to give what one thread did
+        std::vector<WorldHit> threadHits(options.rays);
+        start = monotonicNsecs();
+        {
+            std::vector<std::thread> workers;
+            uint32_t share = (options.rays + options.threads - 1) / options.threads;
+            for (uint32_t t = 0; t < options.threads; t++) {
+                uint32_t first = std::min(t * share, options.rays);
+                uint32_t count = std::min(share, options.rays - first);
+                workers.emplace_back([&, first, count] { query.raycastFirst(rays.data() + first, count, threadHits.data() + first); });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+        uint64_t threadNs = monotonicNsecs() - start;
+        for (uint32_t i = 0; i < options.rays; i++) {
+            check(sameHit(hits[i], threadHits[i]), "threaded raycastFirst", i);
+        }
+
+        start = monotonicNsecs();
+        size_t singleAll = 0;
+        for (uint32_t i = 0; i < options.rays; i++) {
+            query.raycastAll(rays[i], rayHits);
+            singleAll += rayHits.size();
+        }
+        uint64_t allSingleNs = monotonicNsecs() - start;
+
+        start = monotonicNsecs();
+        query.raycastAll(rays.data(), options.rays, allHits, hitStart);
+        uint64_t allNs = monotonicNsecs() - start;
+        for (uint32_t i = 0; i < std::min(options.check, options.rays); i++) {
+            query.raycastAll(rays[i], rayHits);
+            check(rayHits.size() == hitStart[i + 1] - hitStart[i], "batched raycastAll", i);
+            for (size_t k = 0; k < rayHits.size(); k++) {
+                check(sameHit(rayHits[k], allHits[hitStart[i] + k]), "batched raycastAll", i);
+            }
+        }
+        check(singleAll == allHits.size(), "batched raycastAll", options.rays);
+
+        start = monotonicNsecs();
+        size_t singleOverlaps = 0;
+        for (uint32_t i = 0; i < options.rays; i++) {
+            query.overlapBox(boxes[i], boxShapes);
+            singleOverlaps += boxShapes.size();
+        }
+        uint64_t overlapSingleNs = monotonicNsecs() - start;
+
+        start = monotonicNsecs();
+        query.overlapBox(boxes.data(), options.rays, shapes, shapeStart);
+        uint64_t overlapNs = monotonicNsecs() - start;
+        for (uint32_t i = 0; i < std::min(options.check, options.rays); i++) {
+            query.overlapBox(boxes[i], boxShapes);
+            check(boxShapes.size() == shapeStart[i + 1] - shapeStart[i], "batched overlapBox", i);
+            for (size_t k = 0; k < boxShapes.size(); k++) {
+                check(sameShape(boxShapes[k], shapes[shapeStart[i] + k]), "batched overlapBox", i);
+            }
+        }
+        check(singleOverlaps == shapes.size(), "batched overlapBox", options.rays);
+
+        start = monotonicNsecs();
+        for (uint32_t i = 0; i < options.rays; i++) {
+            query.sweepBox(sweeps[i], singleHits[i]);
+        }
+        uint64_t sweepSingleNs = monotonicNsecs() - start;
+
+        start = monotonicNsecs();
+        query.sweepBox(sweeps.data(), options.rays, hits.data());
+        uint64_t sweepNs = monotonicNsecs() - start;
+        for (uint32_t i = 0; i < options.rays; i++) {
+            check(sameHit(hits[i], singleHits[i]), "batched sweepBox", i);
+        }
+
+        std::cout << "raycastFirst: " << nsPerQuery(singleNs, options.rays) << " ns single, " << nsPerQuery(batchNs, options.rays)
+                  << " ns batched, " << nsPerQuery(threadNs, options.rays) << " ns batched on " << options.threads << " threads, "
+                  << found * 100.0 / std::max<uint32_t>(options.rays, 1) << "% hit\n";
+        std::cout << "raycastAll:   " << nsPerQuery(allSingleNs, options.rays) << " ns single, " << nsPerQuery(allNs, options.rays)
+                  << " ns batched, " << static_cast<double>(allHits.size()) / options.rays << " hits per ray\n";
+        std::cout << "overlapBox:   " << nsPerQuery(overlapSingleNs, options.rays) << " ns single, " << nsPerQuery(overlapNs, options.rays)
+                  << " ns batched, " << static_cast<double>(shapes.size()) / options.rays << " shapes per box\n";
+        std::cout << "sweepBox:     " << nsPerQuery(sweepSingleNs, options.rays) << " ns single, " << nsPerQuery(sweepNs, options.rays)
+                  << " ns batched\n";
+
+        // platforms move every tick, the tree follows them by refitting
+        float delta = 1000.0f / 60.0f;
+        uint64_t refitNs = 0;
+        const uint32_t REFIT_TICKS = 120;
+        for (uint32_t tick = 0; tick < REFIT_TICKS; tick++) {
+            world.stepKinematics(delta);
+            start = monotonicNsecs();
+            query.update(world);
+            refitNs += monotonicNsecs() - start;
+        }
+        validate(query, world, rays, boxes, sweeps, options.check);
+        std::cout << std::setprecision(3) << "refit: " << static_cast<double>(refitNs) / REFIT_TICKS / NSECS_PER_USEC
+                  << " us per tick, queries matched brute force on " << std::min(options.check, options.rays)
+                  << " of each kind before and after" << std::endl;
+        return EXIT_SUCCESS;
+    } catch (std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}